@@ -62,6 +62,24 @@ std::string Area::getLocalAuthorityCode() const {
 }
 
 
+/*
+  Change the local authority code of this Area, e.g. to the case it was
+  given in when it was last imported (as combineArea() does).
+
+  @param localAuthorityCode_
+    The new local authority code
+
+  @example
+    Area area("w06000023");
+    area.setLocalAuthorityCode("W06000023");
+*/
+void Area::setLocalAuthorityCode(const std::string& localAuthorityCode_) {
+  if (localAuthorityCode != localAuthorityCode_) {
+    localAuthorityCode = localAuthorityCode_;
+  }
+}
+
+
 /*
   TODO: Area::getName(lang)
 
@@ -217,6 +235,43 @@ void Area::setMeasure(const std::string& measureCode, const Measure& measure) {
 }
 
 
+/*
+  Get the Measure with a codename, creating it if it doesn't exist, so that
+  values can be added to it in place. Unlike setMeasure(), no Measure has to
+  be built (and then copied) just to add a value to one.
+
+  As when setMeasure() combines a Measure into an existing one, the label is
+  set to the one given.
+
+  @param measureCode
+    The codename of the Measure, in any case
+
+  @param label
+    The label of the Measure
+
+  @return
+    A reference to the Measure in this Area
+
+  @example
+    Area area("W06000023");
+    area.upsertMeasure("Pop", "Population").setValue(1999, 12345678.9);
+*/
+Measure& Area::upsertMeasure(const std::string& measureCode, const std::string& label) {
+  const std::string lowerCaseCode = string_operations::stringToLower(measureCode);
+  auto it = measures.lower_bound(lowerCaseCode);
+
+  if (it == measures.end() || it->first != lowerCaseCode) {
+    return measures.emplace_hint(it, lowerCaseCode, Measure(lowerCaseCode, label))->second;
+  }
+
+  if (it->second.getLabel() != label) {
+    it->second.setLabel(label);
+  }
+
+  return it->second;
+}
+
+
 /*
   TODO: Area::size()
 
@@ -296,6 +351,27 @@ void Area::combineArea(const Area& other) {
 }
 
 
+/*
+  Copy the local authority code and names of this area, but none of
+  its measures.
+*/
+Area Area::withoutMeasures() const {
+  Area area(localAuthorityCode);
+  area.names = names;
+  return area;
+}
+
+
+const std::map<std::string, std::string>& Area::getNames() const noexcept {
+  return names;
+}
+
+
+const std::map<std::string, Measure>& Area::getMeasures() const noexcept {
+  return measures;
+}
+
+
 /*
   TODO: operator<<(os, area)
 
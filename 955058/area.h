@@ -55,6 +55,8 @@ public:
 
   std::string getLocalAuthorityCode() const;
 
+  void setLocalAuthorityCode(const std::string& localAuthorityCode_);
+
   std::string getName(const std::string& langCode) const noexcept(false);
 
   void setName(const std::string& langCode, const std::string& name) noexcept(false);
@@ -63,6 +65,11 @@ public:
 
   void setMeasure(const std::string& measureCode, const Measure& measure);
 
+  /* Get the Measure with a codename, creating it if it doesn't exist, and
+  set its label, so that its values can be set in place. The same as
+  setMeasure() with a Measure with that codename and label. */
+  Measure& upsertMeasure(const std::string& measureCode, const std::string& label);
+
   size_t size() const noexcept;
 
   /* Get a name given a lang code or return empty if it doesn't exist. */
@@ -78,6 +85,15 @@ public:
   and adding/keeping non-overlapping ones. */
   void combineArea(const Area& other);
 
+  /* Get a copy of this Area with the same code and names, but no measures. */
+  Area withoutMeasures() const;
+
+  /* Get all the names, keyed by language code. */
+  const std::map<std::string, std::string>& getNames() const noexcept;
+
+  /* Get all the Measures, keyed by their lower case codename. */
+  const std::map<std::string, Measure>& getMeasures() const noexcept;
+
   friend std::ostream& operator<<(std::ostream& os, Area& area);
 
   friend bool operator==(const Area& lhs, const Area& rhs);
@@ -18,17 +18,26 @@
   must implement has a TODO block comment. 
 */
 
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <functional>
 #include <stdexcept>
 #include <iostream>
 #include <string>
 #include <tuple>
 #include <typeinfo>
+#include <utility>
+#include <vector>
 
 #include "lib_json.hpp"
 
 #include "datasets.h"
 #include "areas.h"
+#include "csvscanner.h"
+#include "jsonscanner.h"
 #include "measure.h"
+#include "snapshot.h"
 #include "bethyw.h"
 
 // Anonymous namespace for helper functions. Private to areas.cpp
@@ -126,6 +135,525 @@ namespace {
   bool shouldIncludeArea(const Area& area, const StringFilterSet* const areasFilter) {
     return ::shouldIncludeArea(area.getLocalAuthorityCode(), area.getAllNames(), areasFilter);
   }
+
+
+  /*
+    Check if a lowercase string is a substring of some characters in a
+    case-insensitive way, without copying them.
+  */
+  bool isLowerCaseSubstring(const std::string& lowerCaseSubString, const InputSpan& text) {
+    const size_t length = lowerCaseSubString.size();
+
+    for (size_t start = 0; start + length <= text.size; start++) {
+      size_t i = 0;
+      while (i < length &&
+             static_cast<char>(std::tolower(static_cast<unsigned char>(text.data[start + i]))) ==
+             lowerCaseSubString[i]) {
+        i++;
+      }
+
+      if (i == length) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  /*
+    The same as filterContains(lowerCaseFilter, code), but for the characters
+    of a code, without copying them.
+  */
+  bool filterContains(const StringFilterSet& lowerCaseFilter, const InputSpan& code) {
+    if (lowerCaseFilter.empty()) {
+      return true;
+    }
+
+    for (const std::string& element : lowerCaseFilter) {
+      if (element.size() == code.size && ::isLowerCaseSubstring(element, code)) {
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  /*
+    Decides whether areas should be included from the characters of their
+    codes and names, as they are in a file, so that the lines or records of
+    areas that are filtered out are never copied. The decisions are the same
+    as shouldIncludeArea()'s: an area already in the Areas instance being
+    populated is checked by its names there, and a new one by the names it
+    has in the file.
+  */
+  class AreaFilter {
+  private:
+    const AreasContainer& areas;
+    const StringFilterSet lowerCaseFilter;
+
+    // Reused for each area that is checked
+    std::string lowerCaseCode;
+    std::vector<InputSpan> existingNames;
+
+  public:
+    AreaFilter(const AreasContainer& areas_, const StringFilterSet* const areasFilter) :
+            areas(areas_),
+            lowerCaseFilter(::lowerCaseFilter(areasFilter)),
+            lowerCaseCode(),
+            existingNames() {}
+
+    bool empty() const noexcept {
+      return lowerCaseFilter.empty();
+    }
+
+    // Whether any of the values in the filter is a substring of the code or
+    // one of the names
+    bool matches(const InputSpan& code, const std::vector<InputSpan>& names) const {
+      if (lowerCaseFilter.empty()) {
+        return true;
+      }
+
+      for (const std::string& filterValue : lowerCaseFilter) {
+        if (::isLowerCaseSubstring(filterValue, code)) {
+          return true;
+        }
+
+        for (const InputSpan& name : names) {
+          if (::isLowerCaseSubstring(filterValue, name)) {
+            return true;
+          }
+        }
+      }
+
+      return false;
+    }
+
+    // Whether the area with a code should be included, using the names it
+    // has in the file if it isn't in the Areas instance yet
+    bool includes(const InputSpan& code, const std::vector<InputSpan>& newNames) {
+      if (lowerCaseFilter.empty()) {
+        return true;
+      }
+
+      lowerCaseCode.assign(code.data, code.size);
+      for (char& c : lowerCaseCode) {
+        c = std::tolower(c);
+      }
+
+      const auto existing = areas.find(lowerCaseCode);
+      if (existing == areas.end()) {
+        return matches(code, newNames);
+      }
+
+      existingNames.clear();
+      for (const auto& name : existing->second.getNames()) {
+        existingNames.push_back(InputSpan{name.second.data(), name.second.size()});
+      }
+
+      return matches(code, existingNames);
+    }
+  };
+
+
+  /*
+    The string in a json value, without copying it. Throws the same
+    nlohmann::json::type_error as converting the value to a std::string
+    would, if it isn't a string.
+  */
+  const std::string& stringValue(const json& value) {
+    if (!value.is_string()) {
+      value.get<std::string>();
+    }
+
+    return value.get_ref<const std::string&>();
+  }
+
+
+  /*
+    Thrown for a record that can't be imported because of the value of one
+    of its columns, e.g. a year that isn't a number, so that the column can
+    be given when the record is skipped.
+  */
+  class FieldError : public std::runtime_error {
+  public:
+    const std::string field;
+    const std::string reason;
+
+    FieldError(const std::string& field_, const std::string& reason_) :
+            std::runtime_error(field_ + ": " + reason_),
+            field(field_),
+            reason(reason_) {}
+  };
+
+
+  std::string quoted(const InputSpan& text) {
+    return "\"" + std::string(text.data, text.size) + "\"";
+  }
+
+
+  /*
+    The string in the json value of a column (see stringValue()), throwing a
+    FieldError if it isn't a string.
+  */
+  const std::string& stringField(const json& value, const std::string& field) {
+    if (!value.is_string()) {
+      throw FieldError(field, "expected a string, but got " + std::string(value.type_name()));
+    }
+
+    return value.get_ref<const std::string&>();
+  }
+
+
+  /*
+    Parse the year in a column, throwing a FieldError with the characters
+    that couldn't be parsed.
+  */
+  int parseYearField(const InputSpan& text, const std::string& field) {
+    int year = 0;
+
+    switch (string_operations::parseInteger(text, year)) {
+      case string_operations::ParseError::None:
+        return year;
+      case string_operations::ParseError::Invalid:
+        throw FieldError(field, ::quoted(text) + " is not a year");
+      case string_operations::ParseError::OutOfRange:
+      default:
+        throw FieldError(field, ::quoted(text) + " is out of range for a year");
+    }
+  }
+
+
+  /*
+    The FieldError for the characters of a value in a column that couldn't be
+    parsed.
+  */
+  FieldError valueError(const InputSpan& text, string_operations::ParseError error, const std::string& field) {
+    if (error == string_operations::ParseError::Invalid) {
+      return FieldError(field, ::quoted(text) + " is not a number");
+    }
+
+    return FieldError(field, ::quoted(text) + " is out of range for a number");
+  }
+
+
+  /*
+    Parse the value in a column, throwing a FieldError with the characters
+    that couldn't be parsed.
+  */
+  double parseValueField(const InputSpan& text, const std::string& field) {
+    double value = 0;
+
+    const auto error = string_operations::parseFloatingPointNumber(text, value);
+    if (error != string_operations::ParseError::None) {
+      throw ::valueError(text, error, field);
+    }
+
+    return value;
+  }
+
+
+  /*
+    A handler for nlohmann::json's SAX parser, which picks out the records in
+    the "value" array of a StatsWales JSON document. Only the values of the
+    columns in a JSONColumnPlan are built, in their own (small) json values,
+    which are handed to a callback, and then thrown away, so a whole document
+    is never held in memory. Everything else (e.g. odata.nextLink) is skipped
+    as it is parsed.
+  */
+  class WelshStatsJSONRecords : public nlohmann::json_sax<json> {
+  private:
+    JSONColumnPlan& plan;
+    const std::function<void(const JSONColumnPlan::Values&)>& importRecord;
+
+    // How deeply nested we are in objects and arrays. Records are at a depth
+    // of 3, inside the value array at 2.
+    size_t depth;
+
+    // Whether the last key of the top level object was "value", and whether
+    // we are inside its array
+    bool valueKey;
+    bool inValueArray;
+
+    // The values of the record being built, the column of its last key, and
+    // the objects/arrays in that column's value that are still open
+    JSONColumnPlan::Values values;
+    int column;
+    std::vector<json*> open;
+    std::string lastKey;
+
+    // The characters of the columns of the record that are strings, for the
+    // plan's filter
+    JSONColumnPlan::Strings strings;
+
+    // Add a value to the column being built. Returns the place the value was
+    // put, so that objects and arrays can be opened there.
+    json* add(json&& value) {
+      if (open.empty()) {
+        json& columnValue = values[column];
+        columnValue = std::move(value);
+        return &columnValue;
+      }
+
+      json& parent = *open.back();
+      if (parent.is_array()) {
+        parent.push_back(std::move(value));
+        return &parent.back();
+      }
+
+      json& member = parent[lastKey];
+      member = std::move(value);
+      return &member;
+    }
+
+    bool inRecord() const {
+      return inValueArray && depth >= 3;
+    }
+
+    // Whether a value at the current depth is part of a column's value
+    bool inColumn() const {
+      return inRecord() && (depth == 3 ? column != JSONColumnPlan::SKIP : !open.empty());
+    }
+
+    void rejectRecord(const char* type) const {
+      throw std::runtime_error(
+              "expected each record in the value array to be an object, but got " + std::string(type));
+    }
+
+    // Whether the record that was just built passes the plan's filter
+    bool acceptsRecord() {
+      if (!plan.hasRecordFilter()) {
+        return true;
+      }
+
+      for (size_t i = 0; i < values.size(); i++) {
+        if (values[i].is_string()) {
+          const std::string& str = values[i].get_ref<const std::string&>();
+          strings[i] = InputSpan{str.data(), str.size()};
+        } else {
+          strings[i] = InputSpan{nullptr, 0};
+        }
+      }
+
+      return plan.acceptsRecord(strings);
+    }
+
+    bool scalar(json&& value) {
+      if (inValueArray && depth == 2) {
+        rejectRecord(value.type_name());
+      }
+
+      if (inColumn()) {
+        add(std::move(value));
+      }
+
+      valueKey = false;
+      return true;
+    }
+
+    bool start(json&& container) {
+      if (inValueArray && depth == 2 && !container.is_object()) {
+        rejectRecord(container.type_name());
+      }
+
+      const bool partOfColumn = inColumn();
+      depth++;
+
+      if (depth == 1 && !container.is_object()) {
+        throw std::runtime_error("expected a JSON object with a value array");
+      }
+
+      if (depth == 2 && valueKey && container.is_array()) {
+        inValueArray = true;
+      } else if (inValueArray && depth == 3) {
+        for (auto& value : values) {
+          value = nullptr;
+        }
+        plan.beginRecord();
+      } else if (partOfColumn) {
+        open.push_back(add(std::move(container)));
+      }
+
+      valueKey = false;
+      return true;
+    }
+
+    bool end() {
+      if (inRecord() && depth > 3) {
+        if (!open.empty()) {
+          open.pop_back();
+        }
+      } else if (inRecord()) {
+        plan.endRecord();
+        if (acceptsRecord()) {
+          importRecord(values);
+        }
+      } else if (depth == 2) {
+        inValueArray = false;
+      }
+
+      depth--;
+      return true;
+    }
+
+  public:
+    WelshStatsJSONRecords(JSONColumnPlan& plan_,
+                          const std::function<void(const JSONColumnPlan::Values&)>& importRecord_) :
+            plan(plan_),
+            importRecord(importRecord_),
+            depth(0),
+            valueKey(false),
+            inValueArray(false),
+            values(plan_.size()),
+            column(JSONColumnPlan::SKIP),
+            open(),
+            lastKey(),
+            strings(plan_.size(), InputSpan{nullptr, 0}) {}
+
+    virtual bool null() { return scalar(nullptr); }
+
+    virtual bool boolean(bool val) { return scalar(val); }
+
+    virtual bool number_integer(number_integer_t val) { return scalar(val); }
+
+    virtual bool number_unsigned(number_unsigned_t val) { return scalar(val); }
+
+    virtual bool number_float(number_float_t val, const string_t& s) { return scalar(val); }
+
+    virtual bool string(string_t& val) { return scalar(std::move(val)); }
+
+    virtual bool binary(binary_t& val) { return scalar(json::binary(std::move(val))); }
+
+    virtual bool start_object(std::size_t elements) { return start(json::object()); }
+
+    virtual bool end_object() { return end(); }
+
+    virtual bool start_array(std::size_t elements) { return start(json::array()); }
+
+    virtual bool end_array() { return end(); }
+
+    virtual bool key(string_t& val) {
+      if (depth == 1) {
+        valueKey = (val == "value");
+      }
+
+      if (inRecord() && depth == 3) {
+        column = plan.column(val.data(), val.size());
+      } else {
+        lastKey = std::move(val);
+      }
+
+      return true;
+    }
+
+    // The error is handed over as its base class (as it may be a parse_error
+    // or an out_of_range), so throwing it would slice it. It is thrown as
+    // the std::runtime_error the callers expect instead.
+    virtual bool parse_error(std::size_t position, const std::string& lastToken,
+                             const nlohmann::detail::exception& ex) {
+      throw std::runtime_error(ex.what());
+    }
+  };
+
+
+  /*
+    Call a function with each line of a span of newline-delimited records,
+    without its line ending, and its number, from firstLine. A last line
+    without a line ending is included, unless it is empty.
+  */
+  template <typename LineFunction>
+  void forEachLine(const InputSpan& lines, size_t firstLine, LineFunction function) {
+    const char* const end = lines.data + lines.size;
+    size_t lineNumber = firstLine - 1;
+
+    for (const char* line = lines.data; line < end;) {
+      const void* newline = std::memchr(line, '\n', static_cast<size_t>(end - line));
+      const char* lineEnd = (newline == nullptr) ? end : static_cast<const char*>(newline);
+      const char* next = (newline == nullptr) ? end : lineEnd + 1;
+
+      if (lineEnd > line && lineEnd[-1] == '\r') {
+        lineEnd--;
+      }
+
+      function(InputSpan{line, static_cast<size_t>(lineEnd - line)}, ++lineNumber);
+      line = next;
+    }
+  }
+
+
+  /*
+    Split a span of newline-delimited records into at most count spans of
+    roughly equal size, each ending after a line ending (bar the last).
+  */
+  std::vector<InputSpan> splitLines(const InputSpan& lines, size_t count) {
+    std::vector<InputSpan> spans;
+    const char* const end = lines.data + lines.size;
+    const size_t chunkLength = lines.size / std::max<size_t>(count, 1) + 1;
+
+    for (const char* begin = lines.data; begin < end;) {
+      const char* chunkEnd = end;
+
+      if (static_cast<size_t>(end - begin) > chunkLength) {
+        const void* newline = std::memchr(begin + chunkLength, '\n',
+                                          static_cast<size_t>(end - begin) - chunkLength);
+        chunkEnd = (newline == nullptr) ? end : static_cast<const char*>(newline) + 1;
+      }
+
+      spans.push_back(InputSpan{begin, static_cast<size_t>(chunkEnd - begin)});
+      begin = chunkEnd;
+    }
+
+    return spans;
+  }
+
+
+  /*
+    Scan a line of a newline-delimited StatsWales JSON file, which is a
+    record on its own, unless it is blank. A line that can't be scanned or
+    imported is skipped and added to errors, if given, as the next line
+    starts a record anyway.
+  */
+  void scanNDJSONLine(
+          const InputSpan& line,
+          size_t lineNumber,
+          size_t lineOffset,
+          JSONColumnPlan& plan,
+          const std::function<void(const JSONColumnPlan::Values&)>& importRecord,
+          ParseErrors* const errors) {
+    const bool blank = std::all_of(line.data, line.data + line.size, [](char c) {
+      return std::isspace(static_cast<unsigned char>(c)) != 0;
+    });
+
+    if (blank) {
+      return;
+    }
+
+    try {
+      StatsWalesJSONScanner(line).scanRecord(plan, importRecord);
+    }
+    catch (const FieldError& ex) {
+      if (errors == nullptr) {
+        throw std::runtime_error("line " + std::to_string(lineNumber) + ": " + ex.what());
+      }
+
+      errors->skip("line", lineNumber, ex.reason, lineOffset, ex.field);
+    }
+    catch (const std::exception& ex) {
+      if (errors == nullptr) {
+        throw std::runtime_error("line " + std::to_string(lineNumber) + ": " + ex.what());
+      }
+
+      errors->skip("line", lineNumber, ex.what(), lineOffset);
+    }
+  }
+
+
+  /*
+    The line of a file that an offset is on, from 1, so that records parsed
+    from part of a file are reported with their lines in the whole file.
+  */
+  size_t lineAt(const InputSpan& span, size_t offset) noexcept {
+    return 1 + static_cast<size_t>(std::count(span.data, span.data + std::min(offset, span.size), '\n'));
+  }
 } // end of anonymous namespace
 
 
@@ -134,6 +662,137 @@ namespace {
 */
 using json = nlohmann::json;
 
+const size_t ParseErrors::UNKNOWN_OFFSET = static_cast<size_t>(-1);
+
+
+/*
+  Constructor for the skipped records of a file.
+
+  @param budget_
+    The most records that can be skipped before the file is given up on
+
+  @example
+    ParseErrors errors(100);
+    data.populate(input.span(), BethYw::WelshStatsJSON, cols, nullptr, nullptr, nullptr, &errors);
+*/
+ParseErrors::ParseErrors(size_t budget_) : budget(budget_), errors() {}
+
+
+/*
+  Skip a malformed record, counting it against the budget.
+
+  @param unit
+    What the file's records are, i.e. "line" or "record"
+
+  @param position
+    The number of the record, from 1
+
+  @param what
+    Why the record is malformed, e.g. the value that couldn't be parsed
+
+  @param offset
+    The offset in bytes of the start of the record in the file, if known
+
+  @param field
+    The column whose value couldn't be parsed, if it was one column
+
+  @throws
+    std::runtime_error if that is more records than the budget allows, with
+    the message:
+    More than <budget> malformed records, the last at <description>
+    where <description> is as given by describe()
+*/
+void ParseErrors::skip(const std::string& unit,
+                       size_t position,
+                       const std::string& what,
+                       size_t offset,
+                       const std::string& field) noexcept(false) {
+  errors.push_back(Error{unit, position, offset, field, what});
+
+  if (errors.size() > budget) {
+    throw std::runtime_error("More than " + std::to_string(budget) + " malformed records, the last at " +
+                             describe(errors.back()));
+  }
+}
+
+
+/*
+  Add the records skipped in another part of the same file, counting them
+  against the budget.
+
+  @param other
+    The records skipped in the other part
+
+  @param positionOffset
+    How many records come before the other part, to add to its positions
+
+  @throws
+    std::runtime_error if that is more records than the budget allows
+*/
+void ParseErrors::append(const ParseErrors& other, size_t positionOffset) noexcept(false) {
+  // The offsets are already from the start of the file
+  for (const Error& error : other.errors) {
+    skip(error.unit, error.position + positionOffset, error.what, error.offset, error.field);
+  }
+}
+
+
+size_t ParseErrors::size() const noexcept {
+  return errors.size();
+}
+
+
+bool ParseErrors::empty() const noexcept {
+  return errors.empty();
+}
+
+
+size_t ParseErrors::getBudget() const noexcept {
+  return budget;
+}
+
+
+/*
+  Get the records that were skipped.
+
+  @return
+    The skipped records, in the order they are in the file
+*/
+const std::vector<ParseErrors::Error>& ParseErrors::getErrors() const noexcept {
+  return errors;
+}
+
+
+/*
+  Describe where a skipped record is, and why it was skipped.
+
+  @param error
+    The skipped record
+
+  @return
+    <unit> <position> (byte <offset>): <field>: <what>, leaving out the
+    offset and field if they aren't known
+
+  @example
+    ParseErrors::describe(errors.getErrors()[0]);
+    // record 4 (byte 1298): Data: "n/a" is not a number
+*/
+std::string ParseErrors::describe(const Error& error) {
+  std::string description = error.unit + " " + std::to_string(error.position);
+
+  if (error.offset != UNKNOWN_OFFSET) {
+    description += " (byte " + std::to_string(error.offset) + ")";
+  }
+
+  description += ": ";
+  if (!error.field.empty()) {
+    description += error.field + ": ";
+  }
+
+  return description + error.what;
+}
+
+
 /*
   TODO: Areas::Areas()
 
@@ -219,6 +878,40 @@ void Areas::setArea(const std::string& localAuthorityCode, const Area& area) {
 }
 
 
+/*
+  Get the Area with a local authority code, creating it if it doesn't exist,
+  so that its names and measures can be set in place. The parsers use this
+  for each row of a file, instead of building an Area for the row and
+  combining it into this instance with setArea().
+
+  As when setArea() combines an Area into an existing one, the existing
+  Area's code is set to the one given (which only differs in case).
+
+  @param localAuthorityCode
+    The local authority code of the Area, in any case
+
+  @return
+    A reference to the Area in this instance
+
+  @example
+    Areas data = Areas();
+    Area& area = data.upsertArea("W06000023");
+    area.setName("eng", "Powys");
+    area.upsertMeasure("Pop", "Population").setValue(1999, 12345678.9);
+*/
+Area& Areas::upsertArea(const std::string& localAuthorityCode) {
+  const std::string lowerCaseCode = string_operations::stringToLower(localAuthorityCode);
+  auto it = areas.lower_bound(lowerCaseCode);
+
+  if (it == areas.end() || it->first != lowerCaseCode) {
+    return areas.emplace_hint(it, lowerCaseCode, Area(localAuthorityCode))->second;
+  }
+
+  it->second.setLocalAuthorityCode(localAuthorityCode);
+  return it->second;
+}
+
+
 /*
   TODO: Areas::size()
 
@@ -242,6 +935,246 @@ size_t Areas::size() const noexcept {
 }
 
 
+/*
+  Combine all the Area objects of another Areas instance into this one, as if
+  setArea() was called for each of them in order. This is used to merge
+  the results of datasets (or parts of datasets) parsed in parallel.
+
+  @param other
+    The Areas instance to copy the areas from
+
+  @example
+    Areas data = Areas();
+    Areas part = Areas();
+    ...
+    data.combineAreas(part);
+*/
+void Areas::combineAreas(const Areas& other) {
+  for (const auto& codeAreaPair : other.areas) {
+    setArea(codeAreaPair.first, codeAreaPair.second);
+  }
+}
+
+
+/*
+  Copy all the areas of this instance, with their names but none of their
+  measures. A parser populating the copy filters areas by name exactly as it
+  would when populating this instance, so the copy is used as the starting
+  point for datasets parsed in parallel.
+
+  @return
+    A new Areas instance with the areas and names of this one
+*/
+Areas Areas::withoutMeasures() const {
+  Areas copy = Areas();
+
+  for (const auto& codeAreaPair : areas) {
+    copy.areas.emplace(codeAreaPair.first, codeAreaPair.second.withoutMeasures());
+  }
+
+  return copy;
+}
+
+
+const AreasContainer& Areas::getAllAreas() const noexcept {
+  return areas;
+}
+
+
+/*
+  Import the areas of another instance, which were parsed from a file of the
+  given type without any filters, applying the filters as the parser for that
+  type would have done had it parsed the file into this instance. This lets
+  the result of parsing a file be reused (e.g. from a cache) with different
+  filters, or after different datasets have been imported.
+
+  The parsers check the area filter per row, against the names of the row if
+  the area is new. Here, the check is made per area against the names the
+  area was parsed with, which only differs for files that give one area
+  different names on different rows.
+
+  @param parsed
+    The areas parsed from the file, without filters
+
+  @param type
+    The type of file the areas were parsed from
+
+  @param areasFilter
+    An umodifiable pointer to set of umodifiable strings for areas to import,
+    or an empty set if all areas should be imported
+
+  @param measuresFilter
+    An umodifiable pointer to set of umodifiable strings for measures to import,
+    or an empty set if all measures should be imported
+
+  @param yearsFilter
+    An umodifiable pointer to an umodifiable tuple of two unsigned integers,
+    where if both values are 0, then all years should be imported, otherwise
+    they should be treated as the range of years to be imported
+
+  @example
+    Areas parsed = Areas();
+    parsed.populate(input.open(), BethYw::WelshStatsJSON, cols);
+
+    Areas data = Areas();
+    data.populateFromParsed(parsed, BethYw::WelshStatsJSON, &areasFilter);
+*/
+void Areas::populateFromParsed(
+        const Areas& parsed,
+        const BethYw::SourceDataType& type,
+        const StringFilterSet* const areasFilter,
+        const StringFilterSet* const measuresFilter,
+        const YearFilterTuple* const yearsFilter) noexcept(false) {
+  StringFilterSet measuresFilterLowercase = ::lowerCaseFilter(measuresFilter);
+
+  for (const auto& codeAreaPair : parsed.areas) {
+    const Area& parsedArea = codeAreaPair.second;
+
+    // Only areas.csv ignores the names of the areas we already have
+    auto existing = areas.find(codeAreaPair.first);
+    bool shouldAddArea = (type != BethYw::SourceDataType::AuthorityCodeCSV && existing != areas.end())
+                         ? ::shouldIncludeArea(existing->second, areasFilter)
+                         : ::shouldIncludeArea(parsedArea, areasFilter);
+
+    if (!shouldAddArea) {
+      continue;
+    }
+
+    Area area = parsedArea.withoutMeasures();
+
+    for (const auto& codeMeasurePair : parsedArea.getMeasures()) {
+      const Measure& parsedMeasure = codeMeasurePair.second;
+
+      if (!::filterContains(measuresFilterLowercase, parsedMeasure.getCodename())) {
+        continue;
+      }
+
+      Measure measure{parsedMeasure.getCodename(), parsedMeasure.getLabel()};
+      for (const auto& reading : parsedMeasure.getAllReadingsSorted()) {
+        if (::shouldIncludeYear(static_cast<unsigned int>(reading.first), yearsFilter)) {
+          measure.setValue(reading.first, reading.second);
+        }
+      }
+
+      // JSON files only add a measure for a row that passes the filters,
+      // whereas CSV files add one for every area they include.
+      if ((type == BethYw::SourceDataType::WelshStatsJSON || type == BethYw::SourceDataType::WelshStatsNDJSON) &&
+          measure.size() == 0) {
+        continue;
+      }
+
+      area.setMeasure(codeMeasurePair.first, measure);
+    }
+
+    if (type != BethYw::SourceDataType::AuthorityCodeCSV && area.size() == 0) {
+      continue;
+    }
+
+    setArea(parsedArea.getLocalAuthorityCode(), area);
+  }
+}
+
+
+/*
+  Import the areas of a snapshot, applying the filters as populateFromParsed()
+  does for the areas of an areas.csv file: an area is imported if its code or
+  one of its names in the snapshot matches the areas filter (with only its
+  names if no measures do), and a measure if its codename matches the
+  measures filter. A measure with none of its readings in the years filter
+  is left out, as it would be when its dataset is parsed with the filter.
+
+  Only the areas, measures and readings that are imported are read from the
+  snapshot, and the readings of a measure are only checked one by one against
+  the years filter if its years aren't all inside or all outside of it.
+
+  @param snapshot
+    The snapshot, opened with Snapshot's constructor
+
+  @param areasFilter
+    An umodifiable pointer to set of umodifiable strings for areas to import,
+    or an empty set if all areas should be imported
+
+  @param measuresFilter
+    An umodifiable pointer to set of umodifiable strings for measures to import,
+    or an empty set if all measures should be imported
+
+  @param yearsFilter
+    An umodifiable pointer to an umodifiable tuple of two unsigned integers,
+    where if both values are 0, then all years should be imported, otherwise
+    they should be treated as the range of years to be imported
+
+  @example
+    Snapshot snapshot("all.snapshot");
+
+    Areas data = Areas();
+    data.populateFromSnapshot(snapshot, &areasFilter, &measuresFilter, &yearsFilter);
+*/
+void Areas::populateFromSnapshot(
+        const Snapshot& snapshot,
+        const StringFilterSet* const areasFilter,
+        const StringFilterSet* const measuresFilter,
+        const YearFilterTuple* const yearsFilter) noexcept(false) {
+  StringFilterSet measuresFilterLowercase = ::lowerCaseFilter(measuresFilter);
+  AreaFilter areaFilter(areas, areasFilter);
+  std::vector<InputSpan> names;
+
+  for (size_t areaIdx = 0; areaIdx < snapshot.size(); areaIdx++) {
+    const Snapshot::AreaEntry entry = snapshot.getArea(areaIdx);
+
+    names.clear();
+    for (uint32_t nameIdx = entry.firstName; nameIdx < entry.firstName + entry.nameCount; nameIdx++) {
+      names.push_back(snapshot.getName(nameIdx).second);
+    }
+
+    if (!areaFilter.matches(entry.code, names)) {
+      continue;
+    }
+
+    Area area(std::string(entry.code.data, entry.code.size));
+    for (uint32_t nameIdx = entry.firstName; nameIdx < entry.firstName + entry.nameCount; nameIdx++) {
+      const auto langName = snapshot.getName(nameIdx);
+      area.setName(std::string(langName.first.data, langName.first.size),
+                   std::string(langName.second.data, langName.second.size));
+    }
+
+    for (uint32_t seriesIdx = entry.firstSeries; seriesIdx < entry.firstSeries + entry.seriesCount; seriesIdx++) {
+      const Snapshot::SeriesEntry series = snapshot.getSeries(seriesIdx);
+      if (!::filterContains(measuresFilterLowercase, series.codename)) {
+        continue;
+      }
+
+      Measure measure(std::string(series.codename.data, series.codename.size),
+                      std::string(series.label.data, series.label.size));
+
+      const bool allYears = series.readingCount == 0 ||
+                            (::shouldIncludeYear(series.minYear, yearsFilter) &&
+                             ::shouldIncludeYear(series.maxYear, yearsFilter));
+      // Otherwise there is a years filter, and only if the years of the
+      // readings overlap it can any of them be in it
+      const bool someYears = allYears ||
+                             (series.minYear <= std::max(std::get<0>(*yearsFilter), std::get<1>(*yearsFilter)) &&
+                              series.maxYear >= std::min(std::get<0>(*yearsFilter), std::get<1>(*yearsFilter)));
+
+      for (uint32_t reading = series.firstReading;
+           someYears && reading < series.firstReading + series.readingCount;
+           reading++) {
+        const unsigned int year = snapshot.getYear(reading);
+        if (allYears || ::shouldIncludeYear(year, yearsFilter)) {
+          measure.setValue(year, snapshot.getValue(reading));
+        }
+      }
+
+      if (!allYears && measure.size() == 0) {
+        continue;
+      }
+
+      area.setMeasure(std::string(series.key.data, series.key.size), measure);
+    }
+
+    setArea(area.getLocalAuthorityCode(), area);
+  }
+}
+
 /*
   TODO: Areas::populateFromAuthorityCodeCSV(is, cols, areasFilter)
 
@@ -296,41 +1229,80 @@ size_t Areas::size() const noexcept {
 void Areas::populateFromAuthorityCodeCSV(
         std::istream& is,
         const BethYw::SourceColumnMapping& cols,
-        const StringFilterSet* const areasFilter) {
+        const StringFilterSet* const areasFilter,
+        ParseErrors* const errors) {
+
+  CSVReader reader(is);
+  parseAuthorityCodeCSV(reader, cols, areasFilter, errors);
+}
+
+
+/*
+  The same as populateFromAuthorityCodeCSV(is, cols, areasFilter), but reads
+  the file directly from a span of characters, e.g. from an InputMappedFile.
+*/
+void Areas::populateFromAuthorityCodeCSV(
+        const InputSpan& span,
+        const BethYw::SourceColumnMapping& cols,
+        const StringFilterSet* const areasFilter,
+        ParseErrors* const errors) {
+
+  CSVReader reader(span);
+  parseAuthorityCodeCSV(reader, cols, areasFilter, errors);
+}
+
+
+/*
+  Parse the records of an areas.csv file, regardless of where they come
+  from. The fields of each record point into the file (or the reader's
+  buffer), so only the fields that are kept are copied.
+*/
+void Areas::parseAuthorityCodeCSV(
+        CSVReader& reader,
+        const BethYw::SourceColumnMapping& cols,
+        const StringFilterSet* const areasFilter,
+        ParseErrors* const errors) {
 
   const std::string LANG_CODE_ENG = "eng";
   const std::string LANG_CODE_CYM = "cym";
 
   try {
-    std::string line;
-    std::getline(is, line);
+    reader.next();
 
-    auto elements = string_operations::splitString(line, ',');
+    const std::vector<InputSpan>& elements = reader.fields();
+    const AreaFilter areaFilter(areas, areasFilter);
 
     if (elements.size() > cols.size()) {
       throw std::out_of_range("The parsed files contains more columns than the mapping");
     }
 
-    while (std::getline(is, line)) {
-      if (line.empty()) {
+    while (reader.next()) {
+      if (elements.empty()) {
         continue;
       }
 
-      elements = string_operations::splitString(line, ',');
       if (elements.size() != 3) {
-        throw std::runtime_error("Error parsing areas.csv. Three args per line expected.");
+        if (errors == nullptr) {
+          throw std::runtime_error("Error parsing areas.csv. Three args per line expected.");
+        }
+
+        errors->skip("line", reader.getLine(), "Three args per line expected, but got " +
+                                               std::to_string(elements.size()), reader.getOffset());
+        continue;
+      }
+
+      // Only the areas that are included are copied
+      if (!areaFilter.matches(elements[0], {elements[1], elements[2]})) {
+        continue;
       }
 
-      const std::string& code = elements[0];
-      const std::string& nameEng = elements[1];
-      const std::string& nameCym = elements[2];
+      const std::string code(elements[0].data, elements[0].size);
+      const std::string nameEng(elements[1].data, elements[1].size);
+      const std::string nameCym(elements[2].data, elements[2].size);
 
-      Area area = Area(code);
+      Area& area = upsertArea(code);
       area.setName(LANG_CODE_ENG, nameEng);
       area.setName(LANG_CODE_CYM, nameCym);
-      if (::shouldIncludeArea(area, areasFilter)) {
-        setArea(code, area);
-      }
     }
   }
   catch (const std::out_of_range& ex) {
@@ -364,200 +1336,636 @@ void Areas::populateFromAuthorityCodeCSV(
   library that you must use for your coursework. Read up on how to use it here:
   https://github.com/nlohmann/json
 
-  Example of using this library:
-    - Reading/parsing in from a stream is very simply using the >> operator:
-        json j;
-        stream >> j;
+  Example of using this library:
+    - Reading/parsing in from a stream is very simply using the >> operator:
+        json j;
+        stream >> j;
+
+    - Looping through parsed JSON is done with a simple for each loop. Inside
+      the loop, you can access each using the array syntax, with the key/
+      column name, e.g. data["Localauthority_ItemName_ENG"] gives you the
+      local authority name:
+        for (auto& el : j["value"].items()) {
+           auto &data = el.value();
+           std::string localAuthorityCode = data["Localauthority_ItemName_ENG"];
+           // do stuff here...
+        }
+
+  In this function, you will have to parse the JSON datasets, extracting
+  the local authority code, English name (the files only contain the English
+  names), and each measure by year.
+
+  If you encounter an Area that does not exist in the Areas container, you
+  should create the Area object
+
+  If areasFilter is a non-empty set only include areas matching the filter. If
+  measuresFilter is a non-empty set only include measures matching the filter.
+  If yearsFilter is not equal to <0,0>, only import years within the range
+  specified by the tuple (inclusive).
+
+  I've provided the column names for each JSON file that you need to parse
+  as std::strings in datasets.h. This mapping should be passed through to the
+  cols parameter of this function.
+
+  Note that in the JSON format, years are stored as strings, but we need
+  them as ints. When retrieving values from the JSON library, you will
+  have to cast them to the right type.
+
+  @param is
+    The input stream from InputSource
+
+  @param cols
+    A map of the enum BethyYw::SourceColumnMapping (see datasets.h) to strings
+    that give the column header in the CSV file
+
+  @param areasFilter
+    An umodifiable pointer to set of umodifiable strings of areas to import,
+    or an empty set if all areas should be imported
+
+  @param measuresFilter
+    An umodifiable pointer to set of umodifiable strings of measures to import,
+    or an empty set if all measures should be imported
+
+  @param yearsFilter
+    An umodifiable pointer to an umodifiable tuple of two unsigned integers,
+    where if both values are 0, then all years should be imported, otherwise
+    they should be treated as the range of years to be imported (inclusively)
+
+  @return
+    void
+
+  @throws 
+    std::runtime_error if a parsing error occurs (e.g. due to a malformed file)
+    std::out_of_range if there are not enough columns in cols
+
+  @see
+    See datasets.h for details of how the variable cols is organised
+
+  @see
+    See bethyw.cpp for details of how the variable areasFilter is created
+
+  @example
+    InputFile input("data/popu1009.json");
+    auto is = input.open();
+
+    auto cols = InputFiles::DATASETS["popden"].COLS;
+
+    auto areasFilter = BethYw::parseAreasArg();
+    auto measuresFilter = BethYw::parseMeasuresArg();
+    auto yearsFilter = BethYw::parseMeasuresArg();
+
+    Areas data = Areas();
+    areas.populateFromWelshStatsJSON(
+      is,
+      cols,
+      &areasFilter,
+      &measuresFilter,
+      &yearsFilter);
+*/
+
+void Areas::populateFromWelshStatsJSON(
+        std::istream& is,
+        const BethYw::SourceColumnMapping& cols,
+        const StringFilterSet* const areasFilter,
+        const StringFilterSet* const measuresFilter,
+        const YearFilterTuple* const yearsFilter,
+        ParseErrors* const errors
+) noexcept(false) {
+  // Anything but whitespace after the end of the document is rejected, as
+  // it is when scanning a span
+  auto parseRecords = [&is](JSONColumnPlan& plan,
+                            const std::function<void(const JSONColumnPlan::Values&)>& importRecord) {
+    WelshStatsJSONRecords records(plan, importRecord);
+    json::sax_parse(is, &records, json::input_format_t::json, true);
+  };
+
+  importWelshStatsJSON(parseRecords, cols, areasFilter, measuresFilter, yearsFilter, errors);
+}
+
+
+/*
+  The same as populateFromWelshStatsJSON(is, cols, areasFilter, measuresFilter,
+  yearsFilter), but reads directly from a span of characters, e.g. from an
+  InputMappedFile. As the whole document is available, it is tokenized with a
+  StatsWalesJSONScanner, which skips over the keys we don't import.
+*/
+void Areas::populateFromWelshStatsJSON(
+        const InputSpan& span,
+        const BethYw::SourceColumnMapping& cols,
+        const StringFilterSet* const areasFilter,
+        const StringFilterSet* const measuresFilter,
+        const YearFilterTuple* const yearsFilter,
+        ParseErrors* const errors
+) noexcept(false) {
+  auto parseRecords = [&span](JSONColumnPlan& plan,
+                              const std::function<void(const JSONColumnPlan::Values&)>& importRecord) {
+    StatsWalesJSONScanner scanner(span);
+    scanner.forEachRecord(plan, importRecord);
+  };
+
+  importWelshStatsJSON(parseRecords, cols, areasFilter, measuresFilter, yearsFilter, errors);
+}
+
+
+/*
+  The same as populateFromWelshStatsJSON(span, cols, areasFilter,
+  measuresFilter, yearsFilter), but with the records split into a range for
+  each thread (see StatsWalesJSONScanner::splitRecords()). Each range is
+  imported by its own thread into a copy of this instance without measures,
+  and the copies are combined into this one afterwards, in the order of the
+  ranges, so the result is the same as importing them one after the other.
+
+  As with loading several datasets at once in bethyw.cpp, an area filter that
+  matches an area's name only sees the names this instance had beforehand,
+  and those in the same range.
+
+  @param span
+    The StatsWales JSON document
+
+  @param cols
+    The columns of the dataset
+
+  @param threads
+    The most threads to use (and ranges to split the records into)
+
+  @param areasFilter
+    An umodifiable pointer to set of umodifiable strings for areas to import,
+    or an empty set if all areas should be imported
+
+  @param measuresFilter
+    An umodifiable pointer to set of umodifiable strings for measures to import,
+    or an empty set if all measures should be imported
+
+  @param yearsFilter
+    An umodifiable pointer to an umodifiable tuple of two unsigned integers,
+    where if both values are 0, then all years should be imported
+
+  @throws
+    std::runtime_error if a parsing error occurs (e.g. due to a malformed file)
+
+  @example
+    InputMappedFile input("datasets/popu1009.json");
+    auto cols = InputFiles::DATASETS["popden"].COLS;
+
+    Areas data = Areas();
+    data.populateFromWelshStatsJSONInParallel(input.span(), cols, 4,
+                                              nullptr, nullptr, nullptr);
+*/
+void Areas::populateFromWelshStatsJSONInParallel(
+        const InputSpan& span,
+        const BethYw::SourceColumnMapping& cols,
+        unsigned int threads,
+        const StringFilterSet* const areasFilter,
+        const StringFilterSet* const measuresFilter,
+        const YearFilterTuple* const yearsFilter,
+        ParseErrors* const errors
+) noexcept(false) {
+  const StatsWalesJSONScanner scanner(span);
+  std::vector<StatsWalesJSONScanner::RecordRange> ranges;
+
+  try {
+    ranges = scanner.splitRecords(threads);
+  } catch (const std::exception& ex) {
+    throw std::runtime_error("Failure parsing JSON file: " + std::string(ex.what()) + "\n");
+  }
+
+  std::vector<Areas> parts(ranges.size(), withoutMeasures());
+
+  // Each range numbers its records from 1, so the records it skipped are
+  // renumbered from the records of the ranges before it
+  std::vector<size_t> recordCounts(ranges.size(), 0);
+  const size_t remainingBudget = (errors == nullptr) ? 0 : errors->getBudget() - errors->size();
+  std::vector<ParseErrors> partErrors(ranges.size(), ParseErrors(remainingBudget));
+
+  thread_operations::parallelFor(ranges.size(), threads, [&](size_t i) {
+    auto parseRecords = [&scanner, &ranges, i](JSONColumnPlan& plan,
+                                               const std::function<void(const JSONColumnPlan::Values&)>& importRecord) {
+      scanner.forEachRecord(ranges[i], plan, importRecord);
+    };
+
+    recordCounts[i] = parts[i].importWelshStatsJSON(parseRecords, cols, areasFilter, measuresFilter, yearsFilter,
+                                                    (errors == nullptr) ? nullptr : &partErrors[i]);
+  });
+
+  size_t records = 0;
+  for (size_t i = 0; i < parts.size(); i++) {
+    combineAreas(parts[i]);
+
+    if (errors != nullptr) {
+      errors->append(partErrors[i], records);
+    }
+    records += recordCounts[i];
+  }
+}
+
+
+/*
+  Import the records in the value array of a StatsWales JSON document as they
+  are parsed, one at a time. See populateFromWelshStatsJSON() for the details.
+  ParseRecords is called with the JSONColumnPlan of the columns in cols and
+  the function that imports a record, and must call it with the values of
+  those columns for each record in the document, in order. If errors is
+  given, records that can't be imported are skipped and added to it.
+  Returns the number of records parsed.
+*/
+template <typename ParseRecords>
+size_t Areas::importWelshStatsJSON(
+        ParseRecords& parseRecords,
+        const BethYw::SourceColumnMapping& cols,
+        const StringFilterSet* const areasFilter,
+        const StringFilterSet* const measuresFilter,
+        const YearFilterTuple* const yearsFilter,
+        ParseErrors* const errors
+) noexcept(false) {
+  using SC = BethYw::SourceColumn;
+
+  // The keys of the columns we import, each once (two columns can have the
+  // same key), and the index of each column's key among them
+  std::vector<std::string> keys;
+  auto keyIdx = [&keys, &cols](SC column) {
+    // If any of the .at() function calls fail they will throw out_of_range
+    // exception as is expected by the function, so we don't need to wrap in
+    // try-catch.
+    const std::string& key = cols.at(column);
+    const auto found = std::find(keys.begin(), keys.end(), key);
+    if (found != keys.end()) {
+      return static_cast<size_t>(found - keys.begin());
+    }
+
+    keys.push_back(key);
+    return keys.size() - 1;
+  };
+
+  const size_t areaCodeIdx = keyIdx(SC::AUTH_CODE);
+  const size_t nameEngIdx = keyIdx(SC::AUTH_NAME_ENG);
+
+
+  bool singleMeasureCode = (cols.count(SC::SINGLE_MEASURE_CODE) > 0);
+
+  size_t measureCodeIdx = 0;
+  size_t measureNameIdx = 0;
+  std::string singleMeasureCodeValue;
+  std::string singleMeasureLabelValue;
+
+  if (singleMeasureCode) {
+    singleMeasureCodeValue = cols.at(SC::SINGLE_MEASURE_CODE);
+    singleMeasureLabelValue = cols.at(SC::SINGLE_MEASURE_NAME);
+  } else {
+    measureCodeIdx = keyIdx(SC::MEASURE_CODE);
+    measureNameIdx = keyIdx(SC::MEASURE_NAME);
+  }
+
+  const size_t yearIdx = keyIdx(SC::YEAR);
+  const size_t valueIdx = keyIdx(SC::VALUE);
+
+  // Resolved against the order of the keys in the records as they are parsed
+  JSONColumnPlan plan(keys);
+
+
+  // Copy the filters in lowercase so that we can do case-insensitive
+  // checks for measures.
+  StringFilterSet measuresFilterLowercase = ::lowerCaseFilter(measuresFilter);
+
+  // Records that would be ignored below are rejected from the characters of
+  // their columns by the plan, so their values are never built. Anything we
+  // can't be sure of (e.g. a column that isn't a string) is left for below.
+  AreaFilter areaFilter(areas, areasFilter);
+  std::vector<InputSpan> recordNames(1, InputSpan{nullptr, 0});
+
+  const bool filteringYears = yearsFilter != nullptr &&
+                              std::get<0>(*yearsFilter) != 0 && std::get<1>(*yearsFilter) != 0;
+  const bool includesMeasure = !singleMeasureCode ||
+                               ::filterContains(measuresFilterLowercase, singleMeasureCodeValue);
+
+  if (!areaFilter.empty() || !measuresFilterLowercase.empty() || filteringYears) {
+    plan.setRecordFilter([&](const JSONColumnPlan::Strings& strings) {
+      if (!includesMeasure) {
+        return false;
+      }
+
+      const InputSpan& measureCode = strings[measureCodeIdx];
+      if (!singleMeasureCode && measureCode.data != nullptr &&
+          !::filterContains(measuresFilterLowercase, measureCode)) {
+        return false;
+      }
+
+      int year;
+      if (filteringYears && strings[yearIdx].data != nullptr &&
+          string_operations::parseInteger(strings[yearIdx], year) == string_operations::ParseError::None &&
+          !::shouldIncludeYear(year, yearsFilter)) {
+        return false;
+      }
+
+      const InputSpan& areaCode = strings[areaCodeIdx];
+      recordNames[0] = strings[nameEngIdx];
+      if (areaCode.data == nullptr || recordNames[0].data == nullptr) {
+        return true;
+      }
+
+      return areaFilter.includes(areaCode, recordNames);
+    });
+  }
+
+
+  const std::string LANG_CODE_ENG = "eng";
+
+  std::function<void(const JSONColumnPlan::Values&)> importRecord = [&](const JSONColumnPlan::Values& values) {
+    const std::string& areaCode = ::stringField(values[areaCodeIdx], keys[areaCodeIdx]);
+    const std::string& nameEng = ::stringField(values[nameEngIdx], keys[nameEngIdx]);
+
+    bool shouldAddArea;
+
+    try {
+      shouldAddArea = ::shouldIncludeArea(getArea(areaCode), areasFilter);
+    }
+    catch (const std::out_of_range& ex) {
+      shouldAddArea = ::shouldIncludeArea(areaCode, {nameEng}, areasFilter);
+    }
+
+    if (!shouldAddArea) {
+      return;
+    }
+
+    const std::string& measureCode =
+            singleMeasureCode ? singleMeasureCodeValue : ::stringField(values[measureCodeIdx], keys[measureCodeIdx]);
+    const std::string& measureLabel =
+            singleMeasureCode ? singleMeasureLabelValue : ::stringField(values[measureNameIdx], keys[measureNameIdx]);
+
+    if (!::filterContains(measuresFilterLowercase, measureCode)) {
+      return;
+    }
+
+
+    const std::string& yearText = ::stringField(values[yearIdx], keys[yearIdx]);
+    int year = ::parseYearField(InputSpan{yearText.data(), yearText.size()}, keys[yearIdx]);
+    if (!::shouldIncludeYear(year, yearsFilter)) {
+      return;
+    }
+
+    const auto& valueData = values[valueIdx];
+    double value;
+
+    if (valueData.is_string()) {
+      const std::string& valueText = ::stringValue(valueData);
+      value = ::parseValueField(InputSpan{valueText.data(), valueText.size()}, keys[valueIdx]);
+    } else if (valueData.is_number()) {
+      value = valueData.get<double>();
+    } else {
+      throw FieldError(keys[valueIdx], "expected value data of string or numerical type, but got " +
+                                       std::string(valueData.type_name()));
+    }
+
+    Area& area = upsertArea(areaCode);
+    area.setName(LANG_CODE_ENG, nameEng);
+    area.upsertMeasure(measureCode, measureLabel).setValue(year, value);
+  };
+
+  // Nothing above changes this instance until the record has been checked,
+  // so a record that can't be imported can be skipped
+  std::function<void(const JSONColumnPlan::Values&)> importOrSkipRecord =
+          [&](const JSONColumnPlan::Values& values) {
+    const size_t offset = (plan.getRecordOffset() == JSONColumnPlan::UNKNOWN_OFFSET)
+                          ? ParseErrors::UNKNOWN_OFFSET : plan.getRecordOffset();
+
+    try {
+      importRecord(values);
+    }
+    catch (const FieldError& ex) {
+      errors->skip("record", plan.getRecordCount(), ex.reason, offset, ex.field);
+    }
+    catch (const std::exception& ex) {
+      errors->skip("record", plan.getRecordCount(), ex.what(), offset);
+    }
+  };
+
+  try {
+    parseRecords(plan, (errors == nullptr) ? importRecord : importOrSkipRecord);
+  }
+  catch (const std::exception& ex) {
+    throw std::runtime_error("Failure parsing JSON file: " + std::string(ex.what()) + "\n");
+  }
+
+  return plan.getRecordCount();
+}
 
-    - Looping through parsed JSON is done with a simple for each loop. Inside
-      the loop, you can access each using the array syntax, with the key/
-      column name, e.g. data["Localauthority_ItemName_ENG"] gives you the
-      local authority name:
-        for (auto& el : j["value"].items()) {
-           auto &data = el.value();
-           std::string localAuthorityCode = data["Localauthority_ItemName_ENG"];
-           // do stuff here...
-        }
 
-  In this function, you will have to parse the JSON datasets, extracting
-  the local authority code, English name (the files only contain the English
-  names), and each measure by year.
+/*
+  Import the records of a span of newline-delimited StatsWales JSON, one
+  record to a line, as with importWelshStatsJSON(). The lines are numbered
+  from firstLine, e.g. the number of the first line of the span in the file,
+  both in the errors they are skipped to, if given, and in the exception
+  thrown otherwise. Likewise, firstOffset is the offset of the span in the
+  file, which the offsets of skipped lines are given from.
+*/
+void Areas::importWelshStatsNDJSON(
+        const InputSpan& lines,
+        size_t firstLine,
+        size_t firstOffset,
+        const BethYw::SourceColumnMapping& cols,
+        const StringFilterSet* const areasFilter,
+        const StringFilterSet* const measuresFilter,
+        const YearFilterTuple* const yearsFilter,
+        ParseErrors* const errors
+) noexcept(false) {
+  auto parseRecords = [&lines, firstLine, firstOffset, errors](
+          JSONColumnPlan& plan,
+          const std::function<void(const JSONColumnPlan::Values&)>& importRecord) {
+    ::forEachLine(lines, firstLine, [&](const InputSpan& line, size_t lineNumber) {
+      const size_t lineOffset = firstOffset + static_cast<size_t>(line.data - lines.data);
+      ::scanNDJSONLine(line, lineNumber, lineOffset, plan, importRecord, errors);
+    });
+  };
+
+  // Each line is checked, and skipped, on its own, so records are imported
+  // without errors to let what can't be imported reach scanNDJSONLine()
+  importWelshStatsJSON(parseRecords, cols, areasFilter, measuresFilter, yearsFilter, nullptr);
+}
 
-  If you encounter an Area that does not exist in the Areas container, you
-  should create the Area object
 
-  If areasFilter is a non-empty set only include areas matching the filter. If
-  measuresFilter is a non-empty set only include measures matching the filter.
-  If yearsFilter is not equal to <0,0>, only import years within the range
-  specified by the tuple (inclusive).
+/*
+  Populate this Areas instance from a newline-delimited StatsWales JSON file
+  (NDJSON), where each line is one of the records that would be in the
+  value array of a StatsWales JSON file, e.g.:
 
-  I've provided the column names for each JSON file that you need to parse
-  as std::strings in datasets.h. This mapping should be passed through to the
-  cols parameter of this function.
+    {"Localauthority_Code": "W06000011", "Year_Code": "2015", "Data": 246993, ...}
+    {"Localauthority_Code": "W06000011", "Year_Code": "2016", "Data": 245480, ...}
 
-  Note that in the JSON format, years are stored as strings, but we need
-  them as ints. When retrieving values from the JSON library, you will
-  have to cast them to the right type.
+  The records are imported in the same way as populateFromWelshStatsJSON(),
+  with the same columns, but as each line is a record on its own, the file is
+  read a line at a time, and a malformed line can be skipped (if errors is
+  given) without losing the rest of the file. Blank lines are ignored.
 
   @param is
     The input stream from InputSource
 
   @param cols
-    A map of the enum BethyYw::SourceColumnMapping (see datasets.h) to strings
-    that give the column header in the CSV file
+    A BethYw::SourceColumnMapping of column index values
 
   @param areasFilter
-    An umodifiable pointer to set of umodifiable strings of areas to import,
+    An umodifiable pointer to set of umodifiable strings for areas to import,
     or an empty set if all areas should be imported
 
   @param measuresFilter
-    An umodifiable pointer to set of umodifiable strings of measures to import,
+    An umodifiable pointer to set of umodifiable strings for measures to import,
     or an empty set if all measures should be imported
 
   @param yearsFilter
     An umodifiable pointer to an umodifiable tuple of two unsigned integers,
-    where if both values are 0, then all years should be imported, otherwise
-    they should be treated as the range of years to be imported (inclusively)
+    where if both values are 0, then all years should be imported
+
+  @param errors
+    Where to skip the lines that can't be imported, or nullptr to fail on
+    the first of them
 
   @return
     void
 
-  @throws 
-    std::runtime_error if a parsing error occurs (e.g. due to a malformed file)
+  @throws
+    std::runtime_error if a parsing error occurs (e.g. due to a malformed
+    line), with the number of the line
     std::out_of_range if there are not enough columns in cols
 
-  @see
-    See datasets.h for details of how the variable cols is organised
-
-  @see
-    See bethyw.cpp for details of how the variable areasFilter is created
-
   @example
-    InputFile input("data/popu1009.json");
+    InputFile input("data/popu1009.ndjson");
     auto is = input.open();
 
     auto cols = InputFiles::DATASETS["popden"].COLS;
 
-    auto areasFilter = BethYw::parseAreasArg();
-    auto measuresFilter = BethYw::parseMeasuresArg();
-    auto yearsFilter = BethYw::parseMeasuresArg();
-
     Areas data = Areas();
-    areas.populateFromWelshStatsJSON(
-      is,
-      cols,
-      &areasFilter,
-      &measuresFilter,
-      &yearsFilter);
+    areas.populateFromWelshStatsNDJSON(is, cols, nullptr, nullptr, nullptr);
 */
-
-void Areas::populateFromWelshStatsJSON(
+void Areas::populateFromWelshStatsNDJSON(
         std::istream& is,
         const BethYw::SourceColumnMapping& cols,
         const StringFilterSet* const areasFilter,
         const StringFilterSet* const measuresFilter,
-        const YearFilterTuple* const yearsFilter
+        const YearFilterTuple* const yearsFilter,
+        ParseErrors* const errors
 ) noexcept(false) {
-  using SC = BethYw::SourceColumn;
-
-  // If any of the .at() function calls fail they will throw out_of_range exception
-  // as is expected by the function, so we don't need to wrap in try-catch. 
-  const std::string& areaCodeIdx = cols.at(SC::AUTH_CODE);
-  const std::string& nameEngIdx = cols.at(SC::AUTH_NAME_ENG);
-
-
-  bool singleMeasureCode = (cols.count(SC::SINGLE_MEASURE_CODE) > 0);
+  auto parseRecords = [&is, errors](JSONColumnPlan& plan,
+                                    const std::function<void(const JSONColumnPlan::Values&)>& importRecord) {
+    std::string line;
+    size_t lineNumber = 0;
+    size_t lineOffset = 0;
 
-  std::string measureCodeIdx;
-  std::string measureNameIdx;
+    while (std::getline(is, line)) {
+      // Counting the line ending, which getline() doesn't keep
+      const size_t nextOffset = lineOffset + line.size() + 1;
 
-  if (!singleMeasureCode) {
-    measureCodeIdx = cols.at(SC::MEASURE_CODE);
-    measureNameIdx = cols.at(SC::MEASURE_NAME);
-  }
+      if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+      }
 
-  const std::string& yearIdx = cols.at(SC::YEAR);
-  const std::string& valueIdx = cols.at(SC::VALUE);
+      ::scanNDJSONLine(InputSpan{line.data(), line.size()}, ++lineNumber, lineOffset, plan, importRecord, errors);
+      lineOffset = nextOffset;
+    }
+  };
 
+  importWelshStatsJSON(parseRecords, cols, areasFilter, measuresFilter, yearsFilter, nullptr);
+}
 
-  // Copy the filters in lowercase so that we can do case-insensitive
-  // checks for measures.
-  StringFilterSet measuresFilterLowercase = ::lowerCaseFilter(measuresFilter);
 
+/*
+  The same as populateFromWelshStatsNDJSON(is, cols, areasFilter,
+  measuresFilter, yearsFilter), but reads directly from a span of
+  characters, e.g. from an InputMappedFile, without copying each line.
+*/
+void Areas::populateFromWelshStatsNDJSON(
+        const InputSpan& span,
+        const BethYw::SourceColumnMapping& cols,
+        const StringFilterSet* const areasFilter,
+        const StringFilterSet* const measuresFilter,
+        const YearFilterTuple* const yearsFilter,
+        ParseErrors* const errors
+) noexcept(false) {
+  importWelshStatsNDJSON(span, 1, 0, cols, areasFilter, measuresFilter, yearsFilter, errors);
+}
 
-  try {
-    json json;
-    is >> json;
 
-    for (const auto& arrElement : json["value"].items()) {
-      const auto& obj = arrElement.value();
+/*
+  The same as populateFromWelshStatsNDJSON(span, cols, areasFilter,
+  measuresFilter, yearsFilter), but with the lines split into a chunk for
+  each thread. Unlike a StatsWales JSON file, nothing has to be scanned to
+  find where records end, as every line ending is one. As with
+  populateFromWelshStatsJSONInParallel(), each chunk is imported into its
+  own copy of this instance without measures, and the copies are combined
+  into this one in order.
 
-      std::string areaCode = obj[areaCodeIdx];
-      std::string nameEng = obj[nameEngIdx];
+  @param span
+    The newline-delimited StatsWales JSON file
 
-      bool shouldAddArea;
+  @param cols
+    The columns of the dataset
 
-      try {
-        shouldAddArea = ::shouldIncludeArea(getArea(areaCode), areasFilter);
-      }
-      catch (const std::out_of_range& ex) {
-        shouldAddArea = ::shouldIncludeArea(areaCode, {nameEng}, areasFilter);
-      }
+  @param threads
+    The most threads to use (and chunks to split the lines into)
 
-      if (!shouldAddArea) {
-        continue;
-      }
+  @param areasFilter
+    An umodifiable pointer to set of umodifiable strings for areas to import,
+    or an empty set if all areas should be imported
 
-      std::string measureCode;
-      std::string measureLabel;
+  @param measuresFilter
+    An umodifiable pointer to set of umodifiable strings for measures to import,
+    or an empty set if all measures should be imported
 
-      if (singleMeasureCode) {
-        measureCode = cols.at(SC::SINGLE_MEASURE_CODE);
-        measureLabel = cols.at(SC::SINGLE_MEASURE_NAME);
-      } else {
-        measureCode = obj[measureCodeIdx];
-        measureLabel = obj[measureNameIdx];
-      }
+  @param yearsFilter
+    An umodifiable pointer to an umodifiable tuple of two unsigned integers,
+    where if both values are 0, then all years should be imported
 
-      if (!::filterContains(measuresFilterLowercase, measureCode)) {
-        continue;
-      }
+  @throws
+    std::runtime_error if a parsing error occurs (e.g. due to a malformed line)
 
+  @example
+    InputMappedFile input("data/popu1009.ndjson");
+    auto cols = InputFiles::DATASETS["popden"].COLS;
 
-      std::string yearData = obj[yearIdx];
-      int year = string_operations::stringToNumber(yearData);
-      if (!::shouldIncludeYear(year, yearsFilter)) {
-        continue;
-      }
+    Areas data = Areas();
+    data.populateFromWelshStatsNDJSONInParallel(input.span(), cols, 4,
+                                                nullptr, nullptr, nullptr);
+*/
+void Areas::populateFromWelshStatsNDJSONInParallel(
+        const InputSpan& span,
+        const BethYw::SourceColumnMapping& cols,
+        unsigned int threads,
+        const StringFilterSet* const areasFilter,
+        const StringFilterSet* const measuresFilter,
+        const YearFilterTuple* const yearsFilter,
+        ParseErrors* const errors
+) noexcept(false) {
+  const std::vector<InputSpan> chunks = ::splitLines(span, threads);
+  std::vector<Areas> parts(chunks.size(), withoutMeasures());
+
+  // Every chunk but the last ends with a line ending, so the lines before
+  // each chunk are counted first, for its lines to be numbered from the
+  // start of the file, whether they are skipped or thrown
+  std::vector<size_t> firstLines(chunks.size(), 0);
+  thread_operations::parallelFor(chunks.size(), threads, [&](size_t i) {
+    firstLines[i] = static_cast<size_t>(std::count(chunks[i].data, chunks[i].data + chunks[i].size, '\n'));
+  });
+
+  size_t lines = 1;
+  for (size_t& firstLine : firstLines) {
+    const size_t chunkLines = firstLine;
+    firstLine = lines;
+    lines += chunkLines;
+  }
 
-      const auto& valueData = obj[valueIdx];
-      double value;
+  const size_t remainingBudget = (errors == nullptr) ? 0 : errors->getBudget() - errors->size();
+  std::vector<ParseErrors> partErrors(chunks.size(), ParseErrors(remainingBudget));
 
-      if (valueData.is_string()) {
-        value = string_operations::stringToFloatingPointNumber(valueData);
-      } else if (valueData.is_number()) {
-        value = valueData.get<double>();
-      } else {
-        throw std::runtime_error(
-                "populateFromWelshStatsJson: expected value data of string or numberical type but got " +
-                std::string(valueData.type_name()));
-      }
+  thread_operations::parallelFor(chunks.size(), threads, [&](size_t i) {
+    parts[i].importWelshStatsNDJSON(chunks[i], firstLines[i], static_cast<size_t>(chunks[i].data - span.data),
+                                    cols, areasFilter, measuresFilter, yearsFilter,
+                                    (errors == nullptr) ? nullptr : &partErrors[i]);
+  });
 
-      // Not as slow as it seems.
-      // The "combining" logic only loops through the "other" (second)
-      // objects variables so it will only check 1 measure and its 1 value.
-      Area area{areaCode};
-      area.setName("eng", nameEng);
-      Measure measure{measureCode, measureLabel};
-      measure.setValue(year, value);
+  for (size_t i = 0; i < parts.size(); i++) {
+    combineAreas(parts[i]);
 
-      area.setMeasure(measureCode, measure);
-      setArea(areaCode, area);
+    if (errors != nullptr) {
+      errors->append(partErrors[i], 0);
     }
   }
-  catch (const std::exception& ex) {
-    throw std::runtime_error("Failure parsing JSON file: " + std::string(ex.what()) + "\n");
-  }
 }
 
 /*
@@ -631,7 +2039,43 @@ void Areas::populateFromAuthorityByYearCSV(
         const BethYw::SourceColumnMapping& cols,
         const StringFilterSet* const areasFilter,
         const StringFilterSet* const measuresFilter,
-        const YearFilterTuple* const yearsFilter
+        const YearFilterTuple* const yearsFilter,
+        ParseErrors* const errors
+) {
+  CSVReader reader(is);
+  parseAuthorityByYearCSV(reader, cols, areasFilter, measuresFilter, yearsFilter, errors);
+}
+
+
+/*
+  The same as populateFromAuthorityByYearCSV(is, cols, areasFilter,
+  measuresFilter, yearsFilter), but reads the file directly from a span
+  of characters, e.g. from an InputMappedFile.
+*/
+void Areas::populateFromAuthorityByYearCSV(
+        const InputSpan& span,
+        const BethYw::SourceColumnMapping& cols,
+        const StringFilterSet* const areasFilter,
+        const StringFilterSet* const measuresFilter,
+        const YearFilterTuple* const yearsFilter,
+        ParseErrors* const errors
+) {
+  CSVReader reader(span);
+  parseAuthorityByYearCSV(reader, cols, areasFilter, measuresFilter, yearsFilter, errors);
+}
+
+
+/*
+  Parse the records of an authority-by-year CSV file, regardless of where
+  they come from.
+*/
+void Areas::parseAuthorityByYearCSV(
+        CSVReader& reader,
+        const BethYw::SourceColumnMapping& cols,
+        const StringFilterSet* const areasFilter,
+        const StringFilterSet* const measuresFilter,
+        const YearFilterTuple* const yearsFilter,
+        ParseErrors* const errors
 ) {
 
   // Copy the case-sensitive filter and convert it to lowercase
@@ -646,16 +2090,13 @@ void Areas::populateFromAuthorityByYearCSV(
     return;
   }
 
-  // a single line in the file.
-  std::string line;
-
-  // the elements of each line, when separated by ','
-  std::vector<std::string> lineElements;
+  // the elements of each line. These point into the file (or the reader's
+  // buffer), and the array is reused for each line.
+  const std::vector<InputSpan>& lineElements = reader.fields();
 
 
   // parse first line
-  std::getline(is, line);
-  lineElements = string_operations::splitString(line, ',');
+  reader.next();
 
   if (lineElements.size() <= 2) {
     throw std::runtime_error("Expected AuthorityCode and at least one year");
@@ -663,49 +2104,43 @@ void Areas::populateFromAuthorityByYearCSV(
 
   for (size_t i = 1; i < lineElements.size(); i++) {
     try {
-      int year = string_operations::stringToNumber(lineElements[i]);
-      years.push_back(year);
+      years.push_back(::parseYearField(lineElements[i], "column " + std::to_string(i + 1)));
     }
-    catch (const std::exception& ex) {
-      // may throw std::invalid_argument or std::out_of_range, but
-      // in both cases we will just rethrow, so catch a general type exception 
-      throw std::runtime_error("Failed to parse year " + std::string(ex.what()));
+    catch (const FieldError& ex) {
+      throw std::runtime_error("Failed to parse year in " + std::string(ex.what()));
     }
   }
 
 
-  // parse lines 2nd to last
-  while (std::getline(is, line)) {
-    lineElements = string_operations::splitString(line, ',');
+  const std::string& measureCode = cols.at(BethYw::SourceColumn::SINGLE_MEASURE_CODE);
+  const std::string& measureLabel = cols.at(BethYw::SourceColumn::SINGLE_MEASURE_NAME);
+
+  // The values of each line, reused for every line
+  std::vector<std::pair<int, double>> lineValues;
 
+  // The authority code is checked before any of the values are parsed, so
+  // the lines of areas that are filtered out are only split into fields
+  AreaFilter areaFilter(areas, areasFilter);
+  const std::vector<InputSpan> noNames;
+
+  // parse lines 2nd to last
+  while (reader.next()) {
     if (lineElements.size() <= 2) {
       // disregard lines with only authority code or empty lines
       continue;
     }
 
-    std::string areaCode = lineElements[0];
-
-    bool shouldAddArea;
-
-    try {
-      shouldAddArea = ::shouldIncludeArea(getArea(areaCode), areasFilter);
-    }
-    catch (const std::out_of_range& ex) {
-      shouldAddArea = ::shouldIncludeArea(areaCode, {}, areasFilter);
-    }
-
-    if (!shouldAddArea) {
+    if (!areaFilter.includes(lineElements[0], noNames)) {
       continue;
     }
 
+    std::string areaCode(lineElements[0].data, lineElements[0].size);
 
-    Area area{areaCode};
+    // Parse the values on the line before importing any of them, so that a
+    // line with a value that can't be parsed leaves nothing behind
+    lineValues.clear();
+    bool malformed = false;
 
-    std::string measureCode = cols.at(BethYw::SourceColumn::SINGLE_MEASURE_CODE);
-    std::string measureLabel = cols.at(BethYw::SourceColumn::SINGLE_MEASURE_NAME);
-    Measure measure{measureCode, measureLabel};
-
-    // Parse the values on the line
     // years in years vector start from 0
     // values in the lineElements vector start from 1 as the authority code is the 0th element
     for (size_t yearsIndex = 0, valuesIndex = 1;
@@ -713,23 +2148,37 @@ void Areas::populateFromAuthorityByYearCSV(
          yearsIndex++, valuesIndex++) {
 
       int year = years[yearsIndex];
-      std::string value = lineElements[valuesIndex];
 
-      if (::shouldIncludeYear(year, yearsFilter) && !value.empty()) {
-        try {
-          double valueParsed = string_operations::stringToFloatingPointNumber(value);
-          measure.setValue(year, valueParsed);
-        }
-        catch (const std::exception& ex) {
-          // may throw std::invalid_argument or std::out_of_range, but
-          // in both cases we will just rethrow, so catch a general type exception
-          throw std::runtime_error("Failed to parse measurement " + std::string(ex.what()));
+      if (::shouldIncludeYear(year, yearsFilter) && !lineElements[valuesIndex].empty()) {
+        double valueParsed;
+        const auto error = string_operations::parseFloatingPointNumber(lineElements[valuesIndex], valueParsed);
+
+        if (error != string_operations::ParseError::None) {
+          // The column is named after its year
+          const FieldError ex = ::valueError(lineElements[valuesIndex], error, std::to_string(year));
+
+          if (errors == nullptr) {
+            throw std::runtime_error("Failed to parse measurement on line " + std::to_string(reader.getLine()) +
+                                     ": " + ex.what());
+          }
+
+          errors->skip("line", reader.getLine(), ex.reason, reader.getOffset(), ex.field);
+          malformed = true;
+          break;
         }
+
+        lineValues.emplace_back(year, valueParsed);
       }
     }
 
-    area.setMeasure(measureCode, measure);
-    setArea(areaCode, area);
+    if (malformed) {
+      continue;
+    }
+
+    Measure& measure = upsertArea(areaCode).upsertMeasure(measureCode, measureLabel);
+    for (const auto& yearValue : lineValues) {
+      measure.setValue(yearValue.first, yearValue.second);
+    }
   }
 }
 
@@ -822,26 +2271,215 @@ void Areas::populate(
         const BethYw::SourceColumnMapping& cols,
         const StringFilterSet* const areasFilter,
         const StringFilterSet* const measuresFilter,
-        const YearFilterTuple* const yearsFilter) {
+        const YearFilterTuple* const yearsFilter,
+        ParseErrors* const errors) {
 
   if (!is) {
     throw std::runtime_error("populate: Invalid data (file) stream");
   }
 
   if (type == BethYw::SourceDataType::AuthorityCodeCSV) {
-    populateFromAuthorityCodeCSV(is, cols, areasFilter);
+    populateFromAuthorityCodeCSV(is, cols, areasFilter, errors);
+  }
+  else if (type == BethYw::SourceDataType::AuthorityByYearCSV) {
+    populateFromAuthorityByYearCSV(is, cols, areasFilter, measuresFilter, yearsFilter, errors);
+  }
+  else if (type == BethYw::SourceDataType::WelshStatsJSON) {
+    populateFromWelshStatsJSON(is, cols, areasFilter, measuresFilter, yearsFilter, errors);
+  }
+  else if (type == BethYw::SourceDataType::WelshStatsNDJSON) {
+    populateFromWelshStatsNDJSON(is, cols, areasFilter, measuresFilter, yearsFilter, errors);
+  }
+  else {
+    throw std::runtime_error("Areas::populate: Unexpected data type");
+  }
+}
+
+/*
+  The same as populate(is, type, cols, areasFilter, measuresFilter,
+  yearsFilter), but the data is read directly from a span of characters,
+  e.g. from an InputMappedFile, saving the copies made by a stream.
+
+  @throws 
+    std::runtime_error if a parsing error occurs (e.g. due to a malformed file),
+    the span is not valid, or an unexpected type is passed in.
+    std::out_of_range if there are not enough columns in cols
+
+  @example
+    InputMappedFile input("data/popu1009.json");
+
+    auto cols = InputFiles::DATASETS["popden"].COLS;
+
+    Areas data = Areas();
+    areas.populate(input.span(), DataType::WelshStatsJSON, cols);
+*/
+void Areas::populate(
+        const InputSpan& span,
+        const BethYw::SourceDataType& type,
+        const BethYw::SourceColumnMapping& cols,
+        const StringFilterSet* const areasFilter,
+        const StringFilterSet* const measuresFilter,
+        const YearFilterTuple* const yearsFilter,
+        ParseErrors* const errors) {
+
+  if (span.data == nullptr) {
+    throw std::runtime_error("populate: Invalid data (file) span");
+  }
+
+  if (type == BethYw::SourceDataType::AuthorityCodeCSV) {
+    populateFromAuthorityCodeCSV(span, cols, areasFilter, errors);
   }
   else if (type == BethYw::SourceDataType::AuthorityByYearCSV) {
-    populateFromAuthorityByYearCSV(is, cols, areasFilter, measuresFilter, yearsFilter);
+    populateFromAuthorityByYearCSV(span, cols, areasFilter, measuresFilter, yearsFilter, errors);
   }
   else if (type == BethYw::SourceDataType::WelshStatsJSON) {
-    populateFromWelshStatsJSON(is, cols, areasFilter, measuresFilter, yearsFilter);
+    populateFromWelshStatsJSON(span, cols, areasFilter, measuresFilter, yearsFilter, errors);
+  }
+  else if (type == BethYw::SourceDataType::WelshStatsNDJSON) {
+    populateFromWelshStatsNDJSON(span, cols, areasFilter, measuresFilter, yearsFilter, errors);
   }
   else {
     throw std::runtime_error("Areas::populate: Unexpected data type");
   }
 }
 
+/*
+  Populate this Areas instance from a file that is only ever appended to,
+  parsing only what has been appended since it was last parsed, from a
+  watermark returned last time. Nothing is filtered, so that the areas can be
+  kept to be populated again (see ParseCache::storeIncremental()).
+
+  The watermark is the offset of where the appended data starts:
+    - for StatsWales JSON files, the ',' or ']' after the last record of the
+      value array, as new records are appended to it;
+    - for newline-delimited StatsWales JSON files, the end of the last line
+      with a line ending, as a last line without one is parsed again (as it
+      may not have been finished yet);
+    - for CSV files, the start of the last record, which is parsed again (as
+      it may not have ended with a newline yet), as new areas are appended
+      as records. The header is parsed again too, so that the appended
+      records are parsed against it.
+
+  The caller must check that the file up to the watermark hasn't changed
+  (e.g. with a hash of it), and parse the whole file into an empty instance,
+  with a watermark of 0, if it has (or if this throws). New years added to a
+  CSV file as columns change every record, so the whole file has to be
+  parsed again then.
+
+  @param span
+    The whole file
+
+  @param type
+    The type of file
+
+  @param cols
+    The columns of the dataset
+
+  @param watermark
+    The watermark returned last time the file was parsed into this instance,
+    or 0 to parse the whole file
+
+  @return
+    The watermark to pass next time, once more has been appended to the file
+
+  @throws
+    std::runtime_error if a parsing error occurs (e.g. due to a malformed file,
+    or one that has changed before the watermark), the span is not valid, or
+    an unexpected type is passed in.
+    std::out_of_range if there are not enough columns in cols
+
+  @example
+    InputMappedFile input("data/popu1009.json");
+    auto cols = InputFiles::DATASETS["popden"].COLS;
+
+    Areas data = Areas();
+    size_t watermark = data.populateIncrementally(input.span(), DataType::WelshStatsJSON, cols);
+    // Later, once records have been appended to the file
+    InputMappedFile appended("data/popu1009.json");
+    watermark = data.populateIncrementally(appended.span(), DataType::WelshStatsJSON, cols, watermark);
+*/
+size_t Areas::populateIncrementally(
+        const InputSpan& span,
+        const BethYw::SourceDataType& type,
+        const BethYw::SourceColumnMapping& cols,
+        size_t watermark,
+        ParseErrors* const errors) noexcept(false) {
+
+  if (span.data == nullptr) {
+    throw std::runtime_error("populate: Invalid data (file) span");
+  }
+
+  if (type == BethYw::SourceDataType::WelshStatsJSON) {
+    const StatsWalesJSONScanner scanner(span);
+    std::vector<StatsWalesJSONScanner::RecordRange> ranges;
+
+    try {
+      ranges = (watermark == 0) ? scanner.splitRecords(1) : scanner.splitRecordsAfter(watermark, 1);
+    } catch (const std::exception& ex) {
+      throw std::runtime_error("Failure parsing JSON file: " + std::string(ex.what()) + "\n");
+    }
+
+    auto parseRecords = [&scanner, &ranges](JSONColumnPlan& plan,
+                                            const std::function<void(const JSONColumnPlan::Values&)>& importRecord) {
+      for (const auto& range : ranges) {
+        scanner.forEachRecord(range, plan, importRecord);
+      }
+    };
+
+    importWelshStatsJSON(parseRecords, cols, nullptr, nullptr, nullptr, errors);
+    return ranges.empty() ? watermark : ranges.back().end;
+  }
+
+  if (type == BethYw::SourceDataType::WelshStatsNDJSON) {
+    if (watermark > span.size || (watermark > 0 && span.data[watermark - 1] != '\n')) {
+      throw std::runtime_error("Failure parsing JSON file: the file has changed before the watermark");
+    }
+
+    const InputSpan appended{span.data + watermark, span.size - watermark};
+    importWelshStatsNDJSON(appended, ::lineAt(span, watermark), watermark, cols, nullptr, nullptr, nullptr, errors);
+
+    // A last line without a line ending may not have been finished yet
+    size_t end = span.size;
+    while (end > watermark && span.data[end - 1] != '\n') {
+      end--;
+    }
+
+    return end;
+  }
+
+  if (type != BethYw::SourceDataType::AuthorityCodeCSV && type != BethYw::SourceDataType::AuthorityByYearCSV) {
+    throw std::runtime_error("Areas::populate: Unexpected data type");
+  }
+
+  auto parseCSV = [this, &type, &cols, errors](CSVReader& reader) {
+    if (type == BethYw::SourceDataType::AuthorityCodeCSV) {
+      parseAuthorityCodeCSV(reader, cols, nullptr, errors);
+    } else {
+      parseAuthorityByYearCSV(reader, cols, nullptr, nullptr, nullptr, errors);
+    }
+  };
+
+  // Where the records after the header start. A file without any is parsed
+  // whole every time.
+  CSVReader header(span);
+  const size_t headerEnd = (header.next() && header.next()) ? header.getOffset() : 0;
+
+  if (watermark == 0) {
+    CSVReader reader(span);
+    parseCSV(reader);
+    return (headerEnd == 0) ? 0 : std::max(reader.getOffset(), headerEnd);
+  }
+
+  if (headerEnd == 0 || watermark < headerEnd || watermark >= span.size) {
+    throw std::runtime_error("Failure parsing CSV file: the file has changed before the watermark");
+  }
+
+  CSVReader reader(span);
+  reader.resumeAfterHeader(watermark, ::lineAt(span, watermark));
+  parseCSV(reader);
+  return std::max(reader.getOffset(), watermark);
+}
+
 /*
   TODO: Areas::toJSON()
 
@@ -30,10 +30,15 @@
 #include <string>
 #include <tuple>
 #include <unordered_set>
+#include <vector>
 #include <map>
 
 #include "datasets.h"
 #include "area.h"
+#include "input.h"
+
+class CSVReader;
+class Snapshot;
 
 /*
   An alias for filters based on strings such as categorisations e.g. area,
@@ -58,6 +63,61 @@ using YearFilterTuple = std::tuple<unsigned int, unsigned int>;
 // Use normal map and keep the Areas sorted by code for easier printing
 using AreasContainer = std::map<std::string, Area>;
 
+/*
+  The malformed records of a file that were skipped as it was parsed, when
+  parsing leniently. A record is malformed if it has the wrong number of
+  fields, or a value that can't be parsed; malformed files (e.g. invalid
+  JSON, or an unterminated quoted field) still can't be parsed at all.
+
+  Each skipped record counts against a budget, and once there are more than
+  that, the file is given up on with a std::runtime_error.
+*/
+class ParseErrors {
+public:
+  // The offset of a record that was parsed from a stream that can't tell
+  // where it is (i.e. by nlohmann::json's SAX parser)
+  static const size_t UNKNOWN_OFFSET;
+
+  struct Error {
+    // Where the record is, as a "line" of a CSV or newline-delimited JSON
+    // file or a "record" of the value array of a StatsWales JSON file,
+    // numbered from 1, and the offset in bytes of its start in the file
+    std::string unit;
+    size_t position;
+    size_t offset;
+
+    // The column whose value couldn't be parsed, if it was one column
+    std::string field;
+
+    std::string what;
+  };
+
+private:
+  size_t budget;
+  std::vector<Error> errors;
+
+public:
+  explicit ParseErrors(size_t budget_);
+
+  void skip(const std::string& unit,
+            size_t position,
+            const std::string& what,
+            size_t offset = UNKNOWN_OFFSET,
+            const std::string& field = "") noexcept(false);
+
+  void append(const ParseErrors& other, size_t positionOffset) noexcept(false);
+
+  size_t size() const noexcept;
+
+  bool empty() const noexcept;
+
+  size_t getBudget() const noexcept;
+
+  const std::vector<Error>& getErrors() const noexcept;
+
+  static std::string describe(const Error& error);
+};
+
 /*
   Areas is a class that stores all the data categorised by area. The 
   underlying Standard Library container is customisable using the alias above.
@@ -75,6 +135,43 @@ using AreasContainer = std::map<std::string, Area>;
 class Areas {
 private:
   AreasContainer areas;
+
+  void parseAuthorityCodeCSV(
+          CSVReader& reader,
+          const BethYw::SourceColumnMapping& cols,
+          const StringFilterSet* const areasFilter,
+          ParseErrors* const errors
+  ) noexcept(false);
+
+  template <typename ParseRecords>
+  size_t importWelshStatsJSON(
+          ParseRecords& parseRecords,
+          const BethYw::SourceColumnMapping& cols,
+          const StringFilterSet* const areasFilter,
+          const StringFilterSet* const measuresFilter,
+          const YearFilterTuple* const yearsFilter,
+          ParseErrors* const errors
+  ) noexcept(false);
+
+  void importWelshStatsNDJSON(
+          const InputSpan& lines,
+          size_t firstLine,
+          size_t firstOffset,
+          const BethYw::SourceColumnMapping& cols,
+          const StringFilterSet* const areasFilter,
+          const StringFilterSet* const measuresFilter,
+          const YearFilterTuple* const yearsFilter,
+          ParseErrors* const errors
+  ) noexcept(false);
+
+  void parseAuthorityByYearCSV(
+          CSVReader& reader,
+          const BethYw::SourceColumnMapping& cols,
+          const StringFilterSet* const areasFilter,
+          const StringFilterSet* const measuresFilter,
+          const YearFilterTuple* const yearsFilter,
+          ParseErrors* const errors
+  ) noexcept(false);
 public:
   Areas();
 
@@ -82,12 +179,33 @@ public:
 
   void setArea(const std::string& localAuthorityCode, const Area& area);
 
+  /* Get the Area with a local authority code, creating it if it doesn't
+  exist, so that it can be updated in place. The same as setArea() with an
+  Area that only has that code. */
+  Area& upsertArea(const std::string& localAuthorityCode);
+
   size_t size() const noexcept;
 
+  /* Combine all the Area objects of another Areas instance into this one,
+  with the other instance's data taking precedence (as with setArea). */
+  void combineAreas(const Areas& other);
+
+  /* Get a copy of this instance with the same areas and names, but no
+  measures. */
+  Areas withoutMeasures() const;
+
   void populateFromAuthorityCodeCSV(
           std::istream& is,
           const BethYw::SourceColumnMapping& cols,
-          const StringFilterSet* const areas = nullptr
+          const StringFilterSet* const areas = nullptr,
+          ParseErrors* const errors = nullptr
+  ) noexcept(false);
+
+  void populateFromAuthorityCodeCSV(
+          const InputSpan& span,
+          const BethYw::SourceColumnMapping& cols,
+          const StringFilterSet* const areas = nullptr,
+          ParseErrors* const errors = nullptr
   ) noexcept(false);
 
   void populateFromWelshStatsJSON(
@@ -95,7 +213,55 @@ public:
           const BethYw::SourceColumnMapping& cols,
           const StringFilterSet* const areasFilter,
           const StringFilterSet* const measuresFilter,
-          const YearFilterTuple* const yearsFilter
+          const YearFilterTuple* const yearsFilter,
+          ParseErrors* const errors = nullptr
+  ) noexcept(false);
+
+  void populateFromWelshStatsJSON(
+          const InputSpan& span,
+          const BethYw::SourceColumnMapping& cols,
+          const StringFilterSet* const areasFilter,
+          const StringFilterSet* const measuresFilter,
+          const YearFilterTuple* const yearsFilter,
+          ParseErrors* const errors = nullptr
+  ) noexcept(false);
+
+  void populateFromWelshStatsJSONInParallel(
+          const InputSpan& span,
+          const BethYw::SourceColumnMapping& cols,
+          unsigned int threads,
+          const StringFilterSet* const areasFilter,
+          const StringFilterSet* const measuresFilter,
+          const YearFilterTuple* const yearsFilter,
+          ParseErrors* const errors = nullptr
+  ) noexcept(false);
+
+  void populateFromWelshStatsNDJSON(
+          std::istream& is,
+          const BethYw::SourceColumnMapping& cols,
+          const StringFilterSet* const areasFilter,
+          const StringFilterSet* const measuresFilter,
+          const YearFilterTuple* const yearsFilter,
+          ParseErrors* const errors = nullptr
+  ) noexcept(false);
+
+  void populateFromWelshStatsNDJSON(
+          const InputSpan& span,
+          const BethYw::SourceColumnMapping& cols,
+          const StringFilterSet* const areasFilter,
+          const StringFilterSet* const measuresFilter,
+          const YearFilterTuple* const yearsFilter,
+          ParseErrors* const errors = nullptr
+  ) noexcept(false);
+
+  void populateFromWelshStatsNDJSONInParallel(
+          const InputSpan& span,
+          const BethYw::SourceColumnMapping& cols,
+          unsigned int threads,
+          const StringFilterSet* const areasFilter,
+          const StringFilterSet* const measuresFilter,
+          const YearFilterTuple* const yearsFilter,
+          ParseErrors* const errors = nullptr
   ) noexcept(false);
 
   void populateFromAuthorityByYearCSV(
@@ -103,9 +269,37 @@ public:
           const BethYw::SourceColumnMapping& cols,
           const StringFilterSet* const areasFilter,
           const StringFilterSet* const measuresFilter,
-          const YearFilterTuple* const yearsFilter
+          const YearFilterTuple* const yearsFilter,
+          ParseErrors* const errors = nullptr
+  ) noexcept(false);
+
+  void populateFromAuthorityByYearCSV(
+          const InputSpan& span,
+          const BethYw::SourceColumnMapping& cols,
+          const StringFilterSet* const areasFilter,
+          const StringFilterSet* const measuresFilter,
+          const YearFilterTuple* const yearsFilter,
+          ParseErrors* const errors = nullptr
+  ) noexcept(false);
+
+  void populateFromParsed(
+          const Areas& parsed,
+          const BethYw::SourceDataType& type,
+          const StringFilterSet* const areasFilter = nullptr,
+          const StringFilterSet* const measuresFilter = nullptr,
+          const YearFilterTuple* const yearsFilter = nullptr
+  ) noexcept(false);
+
+  void populateFromSnapshot(
+          const Snapshot& snapshot,
+          const StringFilterSet* const areasFilter = nullptr,
+          const StringFilterSet* const measuresFilter = nullptr,
+          const YearFilterTuple* const yearsFilter = nullptr
   ) noexcept(false);
 
+  /* Get all the Area objects, keyed by their lower case authority code. */
+  const AreasContainer& getAllAreas() const noexcept;
+
   /* !!! populate(is, type, cols) removes as per canvas discussion */
 
   void populate(
@@ -114,7 +308,26 @@ public:
           const BethYw::SourceColumnMapping& cols,
           const StringFilterSet* const areasFilter = nullptr,
           const StringFilterSet* const measuresFilter = nullptr,
-          const YearFilterTuple* const yearsFilter = nullptr
+          const YearFilterTuple* const yearsFilter = nullptr,
+          ParseErrors* const errors = nullptr
+  ) noexcept(false);
+
+  void populate(
+          const InputSpan& span,
+          const BethYw::SourceDataType& type,
+          const BethYw::SourceColumnMapping& cols,
+          const StringFilterSet* const areasFilter = nullptr,
+          const StringFilterSet* const measuresFilter = nullptr,
+          const YearFilterTuple* const yearsFilter = nullptr,
+          ParseErrors* const errors = nullptr
+  ) noexcept(false);
+
+  size_t populateIncrementally(
+          const InputSpan& span,
+          const BethYw::SourceDataType& type,
+          const BethYw::SourceColumnMapping& cols,
+          size_t watermark = 0,
+          ParseErrors* const errors = nullptr
   ) noexcept(false);
 
   std::string toJSON() const;
@@ -22,6 +22,13 @@
   additional functions not specified.
 */
 
+#include <cerrno>
+#include <clocale>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
 #include <iostream>
 #include <string>
 #include <tuple>
@@ -29,6 +36,17 @@
 #include <unordered_map>
 #include <vector>
 #include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#ifndef _WIN32
+#include <glob.h>
+#endif
 
 
 #include "lib_cxxopts.hpp"
@@ -36,6 +54,8 @@
 #include "datasets.h"
 #include "bethyw.h"
 #include "input.h"
+#include "schema.h"
+#include "snapshot.h"
 
 // Anonymous namespace for helper functions private to bethyw.cpp.
 namespace {
@@ -83,6 +103,655 @@ namespace {
     return parsedArgs;
   }
 
+
+  /*
+    Check whether a file exists (and can be opened for reading).
+  */
+  bool fileExists(const std::string& filePath) {
+    return std::ifstream(filePath).is_open();
+  }
+
+
+  /*
+    Resolve the path of a dataset file in the data directory. Datasets may be
+    stored compressed, so if the file does not exist as named, we look for a
+    gzip (.gz) or Zstandard (.zst) version of it instead.
+
+    @param filePath
+      The path of the dataset file, as given by InputFileSource::FILE
+
+    @return
+      The path of the file that should be imported
+  */
+  std::string resolveDatasetPath(const std::string& filePath) {
+    if (InputCompressedFile::isCompressedFile(filePath) || ::fileExists(filePath)) {
+      return filePath;
+    }
+
+    for (const char* extension : {".gz", ".zst"}) {
+      if (::fileExists(filePath + extension)) {
+        return filePath + extension;
+      }
+    }
+
+    // Let the InputSource report that the file is missing.
+    return filePath;
+  }
+
+
+  /*
+    The first DatasetSchema::SAMPLE_BYTES bytes of a dataset file (or all of
+    it, if it is smaller), decompressed if the file is compressed.
+
+    @param filePath
+      The path of the file, from resolveDatasetPath()
+
+    @return
+      The start of the file
+  */
+  std::string readSample(const std::string& filePath) {
+    if (InputCompressedFile::isCompressedFile(filePath)) {
+      InputCompressedFile file{filePath};
+      std::istream& is = file.open();
+
+      std::string sample(DatasetSchema::SAMPLE_BYTES, '\0');
+      is.read(&sample[0], static_cast<std::streamsize>(sample.size()));
+      sample.resize(static_cast<size_t>(is.gcount()));
+      return sample;
+    }
+
+    InputMappedFile file{filePath};
+    const InputSpan contents = file.span();
+    return std::string(contents.data, std::min(contents.size, DatasetSchema::SAMPLE_BYTES));
+  }
+
+
+  // Held while writing a report about a file, as files in different shards
+  // (or datasets) are parsed at the same time
+  std::mutex outputMutex;
+
+
+  /*
+    Output how a file was read by InputFile, and how fast, to the standard
+    error (so it does not mix with the tables/JSON output), e.g.:
+      datasets/popu1009.json: whole-file, 562098 bytes at 1843.21 MB/s
+  */
+  void reportRead(const InputFile& file) {
+    std::ostringstream report;
+    report << file.getSource() << ": " << InputFile::strategyName(file.getStrategy()) << ", "
+           << file.getBytesRead() << " bytes at " << std::fixed << std::setprecision(2)
+           << file.getBytesPerSecond() / (1024 * 1024) << " MB/s";
+
+    // Files in different shards are read at the same time
+    std::lock_guard<std::mutex> lock(outputMutex);
+    std::cerr << report.str() << std::endl;
+  }
+
+
+  // The most skipped records of a file that are listed, after which they are
+  // only counted
+  const size_t MAX_SKIPPED_LISTED = 10;
+
+
+  /*
+    Output the malformed records of a file that were skipped, if there were
+    any, to the standard error, e.g.:
+      datasets/popu1009.json: skipped 2 malformed records
+        record 17: Failure parsing JSON file: ...
+        record 90: ...
+  */
+  void reportSkipped(const std::string& filePath, const ParseErrors& errors) {
+    if (errors.empty()) {
+      return;
+    }
+
+    std::ostringstream report;
+    report << filePath << ": skipped " << errors.size() << " malformed record"
+           << (errors.size() == 1 ? "" : "s");
+
+    const auto& skipped = errors.getErrors();
+    for (size_t i = 0; i < skipped.size() && i < MAX_SKIPPED_LISTED; i++) {
+      report << "\n  " << ParseErrors::describe(skipped[i]);
+    }
+
+    if (skipped.size() > MAX_SKIPPED_LISTED) {
+      report << "\n  ... and " << (skipped.size() - MAX_SKIPPED_LISTED) << " more";
+    }
+
+    std::lock_guard<std::mutex> lock(outputMutex);
+    std::cerr << report.str() << std::endl;
+  }
+
+
+  // The fewest bytes of a StatsWales JSON file worth giving each thread that
+  // parses it, below which it is parsed by fewer threads
+  const size_t MIN_PARSE_THREAD_BYTES = 1024 * 1024;
+
+
+  /*
+    Populate an Areas instance from a dataset that is entirely in memory,
+    splitting the records of a large StatsWales JSON (or newline-delimited
+    JSON) file between several threads if requested.
+
+    ! Helper function for parseFile.
+  */
+  void populateFromSpan(Areas& areas,
+                        const InputSpan& span,
+                        const BethYw::InputFileSource& dataset,
+                        const BethYw::LoadOptions& options,
+                        const StringFilterSet* const areasFilter,
+                        const StringFilterSet* const measuresFilter,
+                        const YearFilterTuple* const yearsFilter,
+                        ParseErrors* const errors) {
+    const size_t requested = (options.parseThreads == 0) ? thread_operations::defaultThreadCount()
+                                                         : options.parseThreads;
+    const size_t threads = std::min(requested, span.size / MIN_PARSE_THREAD_BYTES);
+
+    if (dataset.PARSER == BethYw::SourceDataType::WelshStatsJSON && threads > 1) {
+      areas.populateFromWelshStatsJSONInParallel(span, dataset.COLS, static_cast<unsigned int>(threads),
+                                                 areasFilter, measuresFilter, yearsFilter, errors);
+    } else if (dataset.PARSER == BethYw::SourceDataType::WelshStatsNDJSON && threads > 1) {
+      areas.populateFromWelshStatsNDJSONInParallel(span, dataset.COLS, static_cast<unsigned int>(threads),
+                                                   areasFilter, measuresFilter, yearsFilter, errors);
+    } else {
+      areas.populate(span, dataset.PARSER, dataset.COLS, areasFilter, measuresFilter, yearsFilter, errors);
+    }
+  }
+
+
+  /*
+    Populate an Areas instance from a dataset file kept in the parse cache
+    with a watermark, only parsing what has been appended to the file since
+    it was stored. If the file has changed before the watermark (or there is
+    no entry for it), the whole file is parsed.
+
+    Files with malformed records that were skipped are not stored, so that
+    they are parsed (and reported) again next time.
+
+    ! Helper function for parseFile.
+  */
+  void populateIncrementally(Areas& areas,
+                             const ParseCache& cache,
+                             const std::string& filePath,
+                             const BethYw::InputFileSource& dataset,
+                             const StringFilterSet* const areasFilter,
+                             const StringFilterSet* const measuresFilter,
+                             const YearFilterTuple* const yearsFilter,
+                             ParseErrors* const errors) {
+    InputMappedFile file{filePath};
+    const InputSpan contents = file.span();
+    const std::string key = cache.incrementalKey(filePath, dataset.PARSER, dataset.COLS);
+
+    // The entry holds the whole file, so filter it as it is imported
+    Areas parsed = Areas();
+    ParseCache::Watermark watermark{0, 0};
+    bool resumed = false;
+
+    bool unchanged = false;
+
+    if (cache.loadIncremental(key, parsed, watermark) && watermark.matches(contents)) {
+      try {
+        const uint64_t previous = watermark.offset;
+        watermark.offset = parsed.populateIncrementally(contents, dataset.PARSER, dataset.COLS, watermark.offset,
+                                                        errors);
+        resumed = true;
+        unchanged = (watermark.offset == previous);
+      }
+      catch (const std::exception& ex) {
+        // Something other than appending has changed the file
+      }
+    }
+
+    if (!resumed) {
+      if (errors != nullptr) {
+        *errors = ParseErrors(errors->getBudget());
+      }
+
+      parsed = Areas();
+      watermark.offset = parsed.populateIncrementally(contents, dataset.PARSER, dataset.COLS, 0, errors);
+    }
+
+    // An entry that nothing was added to is left as it is
+    if (!unchanged && (errors == nullptr || errors->empty())) {
+      cache.storeIncremental(key, parsed, ParseCache::Watermark::of(contents, watermark.offset));
+    }
+    areas.populateFromParsed(parsed, dataset.PARSER, areasFilter, measuresFilter, yearsFilter);
+  }
+
+
+  /*
+    Populate an Areas instance from a dataset file, picking the InputSource
+    from the file's extension: compressed files are decompressed as they are
+    streamed to the parser, while all other files are memory mapped (or read
+    ahead on a background thread, if requested). If requested, StatsWales
+    JSON files are followed across their pages, or have their records split
+    between several threads.
+
+    ! Helper function for populateFromFile.
+
+    @param areas
+      The Areas instance to populate
+
+    @param filePath
+      The path of the dataset file, as given by InputFileSource::FILE
+
+    @param dataset
+      The dataset the file belongs to
+
+    @param options
+      How the file should be loaded
+
+    @param errors
+      Where to skip the file's malformed records, or nullptr to fail on them
+  */
+  void parseFile(Areas& areas,
+                 const std::string& filePath,
+                 const BethYw::InputFileSource& dataset,
+                 const BethYw::LoadOptions& options,
+                 const StringFilterSet* const areasFilter,
+                 const StringFilterSet* const measuresFilter,
+                 const YearFilterTuple* const yearsFilter,
+                 ParseErrors* const errors) {
+    bool paged = options.followNextLinks && dataset.PARSER == BethYw::SourceDataType::WelshStatsJSON;
+
+    if (!options.parseCacheDir.empty() && !paged && !InputHttpFile::isHttpUrl(filePath)) {
+      ParseCache cache{options.parseCacheDir, options.parseCacheKeyMode};
+
+      const std::string resolvedPath = ::resolveDatasetPath(filePath);
+      if (options.incremental && !InputCompressedFile::isCompressedFile(resolvedPath)) {
+        ::populateIncrementally(areas, cache, resolvedPath, dataset, areasFilter, measuresFilter, yearsFilter,
+                                errors);
+        return;
+      }
+
+      std::string key;
+
+      try {
+        key = cache.key(resolvedPath, dataset.PARSER, dataset.COLS);
+      }
+      catch (const std::exception& ex) {
+        // Let the file be opened as normal, to report why it can't be
+      }
+
+      if (!key.empty()) {
+        // The cache holds the whole file, so filter it as it is imported
+        Areas parsed = Areas();
+
+        if (!cache.load(key, parsed)) {
+          BethYw::LoadOptions parseOptions = options;
+          parseOptions.parseCacheDir = "";
+
+          // Files with malformed records that were skipped are parsed (and
+          // reported) again next time
+          ::parseFile(parsed, filePath, dataset, parseOptions, nullptr, nullptr, nullptr, errors);
+          if (errors == nullptr || errors->empty()) {
+            cache.store(key, parsed);
+          }
+        }
+
+        areas.populateFromParsed(parsed, dataset.PARSER, areasFilter, measuresFilter, yearsFilter);
+        return;
+      }
+    }
+
+    if (paged) {
+      // Each page is parsed on its own, while the next one is read (or
+      // fetched, from an http:// --dir).
+      InputPagedFile pages{::resolveDatasetPath(filePath), options.httpCacheDir, options.httpConnections};
+      while (pages.nextPage()) {
+        areas.populate(pages.page(), dataset.PARSER, dataset.COLS, areasFilter, measuresFilter, yearsFilter, errors);
+      }
+      return;
+    }
+
+    if (InputHttpFile::isHttpUrl(filePath)) {
+      InputHttpFile file{filePath, options.httpCacheDir, options.httpConnections};
+      ::populateFromSpan(areas, file.span(), dataset, options, areasFilter, measuresFilter, yearsFilter, errors);
+      return;
+    }
+
+    const std::string resolvedPath = ::resolveDatasetPath(filePath);
+
+    if (InputCompressedFile::isCompressedFile(resolvedPath)) {
+      InputCompressedFile file{resolvedPath};
+      areas.populate(file.open(), dataset.PARSER, dataset.COLS, areasFilter, measuresFilter, yearsFilter, errors);
+    } else if (options.readAheadBufferSize > 0) {
+      InputReadAheadFile file{resolvedPath, options.readAheadBufferSize, options.readAheadDepth};
+      areas.populate(file.open(), dataset.PARSER, dataset.COLS, areasFilter, measuresFilter, yearsFilter, errors);
+    } else if (options.useReadStrategy) {
+      InputFile file{resolvedPath, options.readStrategy};
+      areas.populate(file.open(), dataset.PARSER, dataset.COLS, areasFilter, measuresFilter, yearsFilter, errors);
+
+      if (options.reportReads) {
+        ::reportRead(file);
+      }
+    } else {
+      InputMappedFile file{resolvedPath};
+      ::populateFromSpan(areas, file.span(), dataset, options, areasFilter, measuresFilter, yearsFilter, errors);
+    }
+  }
+
+
+  /*
+    Populate an Areas instance from a dataset file (see parseFile()). If
+    options.maxErrors allows, malformed records are skipped, and reported once
+    the file has been parsed.
+
+    ! Helper function for loadAreas and loadDatasets.
+  */
+  void populateFromFile(Areas& areas,
+                        const std::string& filePath,
+                        const BethYw::InputFileSource& dataset,
+                        const BethYw::LoadOptions& options,
+                        const StringFilterSet* const areasFilter,
+                        const StringFilterSet* const measuresFilter = nullptr,
+                        const YearFilterTuple* const yearsFilter = nullptr) {
+    if (options.maxErrors == 0) {
+      ::parseFile(areas, filePath, dataset, options, areasFilter, measuresFilter, yearsFilter, nullptr);
+      return;
+    }
+
+    ParseErrors errors(options.maxErrors);
+    ::parseFile(areas, filePath, dataset, options, areasFilter, measuresFilter, yearsFilter, &errors);
+    ::reportSkipped(filePath, errors);
+  }
+
+
+  /*
+    Find all the files matching a glob pattern (e.g. popu1009.part-*.json),
+    sorted by name. On platforms without glob(), the pattern is returned as is.
+  */
+  std::vector<std::string> globFiles(const std::string& pattern) {
+    std::vector<std::string> files;
+
+#ifdef _WIN32
+    files.push_back(pattern);
+#else
+    glob_t matches{};
+    if (glob(pattern.c_str(), 0, nullptr, &matches) == 0) {
+      for (size_t i = 0; i < matches.gl_pathc; i++) {
+        files.emplace_back(matches.gl_pathv[i]);
+      }
+    }
+    globfree(&matches);
+#endif
+
+    return files;
+  }
+
+
+  /*
+    Find the shards of a dataset file that has been split into parts, named
+    <name>.part-<anything>.<extension> (e.g. popu1009.part-001.json for
+    popu1009.json). Compressed shards are also found.
+  */
+  std::vector<std::string> findShards(const std::string& filePath) {
+    size_t extensionStart = filePath.find_last_of('.');
+    size_t nameStart = filePath.find_last_of(DIR_SEP);
+
+    if (extensionStart == std::string::npos || (nameStart != std::string::npos && extensionStart < nameStart)) {
+      return {};
+    }
+
+    std::string pattern = filePath.substr(0, extensionStart) + ".part-*" + filePath.substr(extensionStart);
+
+    std::vector<std::string> shards;
+    for (const char* extension : {"", ".gz", ".zst"}) {
+      for (const std::string& shard : ::globFiles(pattern + extension)) {
+        shards.push_back(shard);
+      }
+    }
+
+    std::sort(shards.begin(), shards.end());
+    return shards;
+  }
+
+
+  /*
+    Expand the FILE of a dataset into the files the dataset is made of. FILE
+    may be a comma-separated list of files, and each file may be a glob
+    pattern (e.g. popu1009.part-*.json). If a plain file does not exist, but
+    shards of it do (see findShards()), the shards are used instead.
+
+    @param dir
+      The data directory
+
+    @param file
+      The FILE of a dataset
+
+    @return
+      The paths of all files in the dataset, in the order they should be
+      merged
+
+    @throws
+      std::runtime_error if a glob pattern does not match any files
+  */
+  std::vector<std::string> expandDatasetFiles(const std::string& dir, const std::string& file) {
+    std::vector<std::string> files;
+
+    for (const std::string& entry : string_operations::splitString(file, ',')) {
+      if (entry.empty()) {
+        continue;
+      }
+
+      std::string filePath = dir + entry;
+
+      // We can't look for other versions of files on a web server
+      if (InputHttpFile::isHttpUrl(filePath)) {
+        files.push_back(filePath);
+        continue;
+      }
+
+      if (entry.find_first_of("*?[") != std::string::npos) {
+        std::vector<std::string> matches = ::globFiles(filePath);
+        if (matches.empty()) {
+          throw std::runtime_error("No dataset files match " + filePath);
+        }
+
+        files.insert(files.end(), matches.begin(), matches.end());
+        continue;
+      }
+
+      std::string resolvedPath = ::resolveDatasetPath(filePath);
+      std::vector<std::string> shards;
+
+      if (!::fileExists(resolvedPath)) {
+        shards = ::findShards(filePath);
+      }
+
+      if (shards.empty()) {
+        files.push_back(resolvedPath);
+      } else {
+        files.insert(files.end(), shards.begin(), shards.end());
+      }
+    }
+
+    return files;
+  }
+
+
+  /*
+    Populate an Areas instance with all the files of a dataset. A dataset
+    split into several files has each file parsed on its own thread into
+    a separate Areas instance, and these are then combined in file order, so
+    the result is the same as parsing the files one after another.
+
+    ! Helper function for loadAreas and loadDatasets.
+
+    @param areas
+      The Areas instance to populate
+
+    @param dir
+      The data directory
+
+    @param dataset
+      The dataset to import
+
+    @param options
+      How the files should be loaded
+  */
+  void populateFromDataset(Areas& areas,
+                           const std::string& dir,
+                           const BethYw::InputFileSource& dataset,
+                           const BethYw::LoadOptions& options,
+                           const StringFilterSet* const areasFilter,
+                           const StringFilterSet* const measuresFilter = nullptr,
+                           const YearFilterTuple* const yearsFilter = nullptr) {
+    std::vector<std::string> files = ::expandDatasetFiles(dir, dataset.FILE);
+
+    if (files.size() == 1) {
+      ::populateFromFile(areas, files[0], dataset, options, areasFilter, measuresFilter, yearsFilter);
+      return;
+    }
+
+    // Each part starts with the areas we already know about,
+    // so areas are filtered by their names as they would be otherwise.
+    std::vector<Areas> parts(files.size(), areas.withoutMeasures());
+
+    thread_operations::parallelFor(files.size(), thread_operations::defaultThreadCount(), [&](size_t i) {
+      ::populateFromFile(parts[i], files[i], dataset, options, areasFilter, measuresFilter, yearsFilter);
+    });
+
+    for (const Areas& part : parts) {
+      areas.combineAreas(part);
+    }
+  }
+
+
+  /*
+    Import a list of datasets, reading all their (uncompressed, single page)
+    files with one InputFileBatch. Files are still parsed one after another
+    in the order of the datasets (with options.parseThreads, as when they
+    are mapped), so the result is the same as importing them with
+    populateFromDataset(), but no parse waits on more than its own file being
+    read. The batch replaces options.readAheadBufferSize and
+    options.readStrategy, and with a parse cache, which has to read each file
+    to check it, every file is imported as usual instead.
+
+    @param areas
+      The Areas instance to populate
+
+    @param dir
+      The directory where the datasets are
+
+    @param datasets
+      The datasets to import
+
+    @param options
+      How the files should be loaded
+  */
+  void populateFromDatasetsBatched(Areas& areas,
+                                   const std::string& dir,
+                                   const std::vector<BethYw::InputFileSource>& datasets,
+                                   const BethYw::LoadOptions& options,
+                                   const StringFilterSet* const areasFilter,
+                                   const StringFilterSet* const measuresFilter,
+                                   const YearFilterTuple* const yearsFilter) {
+    // Every file to import, with the dataset it belongs to and, if it is
+    // read by the batch, its index in the batch
+    struct FileToImport {
+      const BethYw::InputFileSource* dataset;
+      std::string path;
+      bool batched;
+      size_t batchIndex;
+    };
+
+    std::vector<FileToImport> files;
+    std::vector<std::string> batchPaths;
+
+    for (const BethYw::InputFileSource& dataset : datasets) {
+      for (const std::string& file : ::expandDatasetFiles(dir, dataset.FILE)) {
+        const std::string path = ::resolveDatasetPath(file);
+        bool paged = options.followNextLinks && dataset.PARSER == BethYw::SourceDataType::WelshStatsJSON;
+        bool batched = !paged && !InputCompressedFile::isCompressedFile(path) && !InputHttpFile::isHttpUrl(path) &&
+                       options.parseCacheDir.empty();
+
+        files.push_back({&dataset, path, batched, batchPaths.size()});
+        if (batched) {
+          batchPaths.push_back(path);
+        }
+      }
+    }
+
+    InputFileBatch batch{batchPaths, thread_operations::defaultThreadCount()};
+    batch.start();
+
+    for (const FileToImport& file : files) {
+      if (file.batched) {
+        ParseErrors errors(options.maxErrors);
+        ::populateFromSpan(areas, batch.wait(file.batchIndex), *file.dataset, options, areasFilter, measuresFilter,
+                           yearsFilter, (options.maxErrors == 0) ? nullptr : &errors);
+        batch.release(file.batchIndex);
+        ::reportSkipped(file.path, errors);
+      } else {
+        ::populateFromFile(areas, file.path, *file.dataset, options, areasFilter, measuresFilter, yearsFilter);
+      }
+    }
+  }
+
+
+  // Powers of ten that are exactly representable as doubles
+  const double EXACT_POWERS_OF_TEN[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+
+  // The characters std::isspace accepts in the "C" locale
+  bool isSpace(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+  }
+
+
+  bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+  }
+
+
+  /*
+    Parse a number the slow way, with std::strtod on a null-terminated copy,
+    for the forms that parseFloatingPointNumber() does not handle itself. The
+    copy's '.' is swapped for the locale's decimal point, so that the number
+    is read the same way in any locale.
+  */
+  string_operations::ParseError parseWithStrtod(const InputSpan& str, double& value) {
+    char buffer[64];
+    std::string longer;
+    char* text = buffer;
+
+    if (str.size < sizeof(buffer)) {
+      std::memcpy(buffer, str.data, str.size);
+      buffer[str.size] = '\0';
+    } else {
+      longer.assign(str.data, str.size);
+      text = &longer[0];
+    }
+
+    const char decimalPoint = *std::localeconv()->decimal_point;
+    if (decimalPoint != '.') {
+      char* point = std::strchr(text, '.');
+      if (point != nullptr) {
+        *point = decimalPoint;
+      }
+    }
+
+    char* end = nullptr;
+    errno = 0;
+    const double parsed = std::strtod(text, &end);
+
+    if (end == text) {
+      return string_operations::ParseError::Invalid;
+    }
+
+    value = parsed;
+
+    if (errno == ERANGE) {
+      return string_operations::ParseError::OutOfRange;
+    }
+
+    return string_operations::ParseError::None;
+  }
+
 } // end of anonymous namespace
 
 
@@ -115,25 +784,66 @@ int BethYw::run(int argc, char* argv[]) {
     }
 
     // Parse data directory argument
-    std::string dir = args["dir"].as<std::string>() + DIR_SEP;
+    // (a web server's URL always uses '/', even on Windows)
+    std::string dir = args["dir"].as<std::string>();
+    dir += InputHttpFile::isHttpUrl(dir) ? '/' : DIR_SEP;
 
     // Parse other arguments and import data
     std::vector<BethYw::InputFileSource> datasetsToImport = BethYw::parseDatasetsArg(args);
     StringFilterSet areasFilter = BethYw::parseAreasArg(args);
     StringFilterSet measuresFilter = BethYw::parseMeasuresArg(args);
     YearFilterTuple yearsFilter = BethYw::parseYearsArg(args);
+    LoadOptions loadOptions = BethYw::parseLoadOptionsArgs(args);
 
-    Areas data = Areas();
+    // Data streamed in from another program, a snapshot, or dataset files
+    // that aren't built in replace the datasets, unless they are asked for
+    // as well.
+    if (!args.count("datasets") && (args.count("input") || args.count("load-snapshot") || args.count("detect"))) {
+      datasetsToImport.clear();
+    }
+
+    std::vector<BethYw::InputFileSource> streamedInputs;
+    if (args.count("input")) {
+      streamedInputs.push_back(BethYw::parseInputArgs(args));
+    }
 
-    BethYw::loadAreas(data, dir, areasFilter);
+    for (const BethYw::InputFileSource& detected : BethYw::parseDetectArg(args, dir)) {
+      datasetsToImport.push_back(detected);
+    }
+
+    Areas data = Areas();
+    std::vector<BethYw::InputFileSource> filesToImport;
+
+    // A snapshot replaces areas.csv as well
+    if (args.count("load-snapshot")) {
+      Snapshot snapshot(args["load-snapshot"].as<std::string>());
+      data.populateFromSnapshot(snapshot, &areasFilter, &measuresFilter, &yearsFilter);
+    } else if (loadOptions.batchRead) {
+      // areas.csv is read in the same batch as the datasets, and parsed first
+      filesToImport.push_back(InputFiles::AREAS);
+    } else {
+      BethYw::loadAreas(data, dir, areasFilter, loadOptions);
+    }
 
+    for (const BethYw::InputFileSource& dataset : datasetsToImport) {
+      filesToImport.push_back(dataset);
+    }
 
     BethYw::loadDatasets(data,
                          dir,
-                         datasetsToImport,
+                         filesToImport,
                          areasFilter,
                          measuresFilter,
-                         yearsFilter);
+                         yearsFilter,
+                         loadOptions);
+
+    for (const BethYw::InputFileSource& input : streamedInputs) {
+      BethYw::loadInput(data, input, areasFilter, measuresFilter, yearsFilter, loadOptions);
+    }
+
+    if (args.count("save-snapshot")) {
+      Snapshot::save(args["save-snapshot"].as<std::string>(), data);
+    }
 
     if (args.count("json")) {
       // The output as JSON
@@ -171,7 +881,8 @@ cxxopts::Options BethYw::cxxoptsSetup() noexcept(false) {
 
   cxxopts.add_options()(
           "dir",
-          "Directory for input data passed in as files",
+          "Directory for input data passed in as files, or the http:// URL "
+          "of a web server to fetch them from",
           cxxopts::value<std::string>()->default_value("datasets"))(
 
           "d,datasets",
@@ -197,6 +908,124 @@ cxxopts::Options BethYw::cxxoptsSetup() noexcept(false) {
           "j,json",
           "Print the output as JSON instead of tables.")(
 
+          "paginate",
+          "Follow the odata.nextLink of StatsWales JSON datasets to import all "
+          "of their pages (saved as <name>.page-<N>.json next to the dataset, "
+          "or fetched from the server of an http:// --dir)")(
+
+          "read-ahead",
+          "Read dataset files on a background thread while they are parsed, "
+          "using buffers of this many KiB (e.g. for slow network storage). Not "
+          "used with --batch-read.",
+          cxxopts::value<unsigned int>())(
+
+          "read-ahead-depth",
+          "The number of buffers to read ahead into (at least 2)",
+          cxxopts::value<unsigned int>()->default_value("2"))(
+
+          "threads",
+          "The number of datasets to parse at the same time (0 for one per "
+          "processor), which are merged in order afterwards. Not used with "
+          "--batch-read.",
+          cxxopts::value<unsigned int>()->default_value("1"))(
+
+          "batch-read",
+          "Read all the dataset files (and areas.csv) at once before parsing "
+          "them in order, with io_uring on Linux or a pool of threads "
+          "otherwise. Compressed files, --paginate datasets and all files "
+          "with --parse-cache are read one at a time as usual.")(
+
+          "read-strategy",
+          "How to read the dataset files instead of mapping them into memory: "
+          "auto (by their size), stream, whole-file, buffered, or direct "
+          "(O_DIRECT, bypassing the page cache). Not used with --batch-read.",
+          cxxopts::value<std::string>())(
+
+          "io-stats",
+          "Report how each dataset file was read, and how fast, to the "
+          "standard error (reading files with --read-strategy auto by default)")(
+
+          "http-cache",
+          "The directory to cache datasets fetched over HTTP in, so that "
+          "unchanged ones are not downloaded again ('none' to not cache them)",
+          cxxopts::value<std::string>()->default_value(".bethyw-cache"))(
+
+          "http-connections",
+          "The number of connections to fetch each large dataset over at once",
+          cxxopts::value<unsigned int>()->default_value(std::to_string(InputHttpFile::DEFAULT_CONNECTIONS)))(
+
+          "parse-threads",
+          "The number of threads to split the records of each large StatsWales "
+          "JSON or NDJSON file between as it is parsed (0 for one per processor)",
+          cxxopts::value<unsigned int>()->default_value("1"))(
+
+          "parse-cache",
+          "Reuse the result of parsing dataset files that have not changed since "
+          "an earlier run, stored in this directory (e.g. .bethyw-cache/parse)",
+          cxxopts::value<std::string>())(
+
+          "parse-cache-key",
+          "How --parse-cache tells whether a file has changed: content (a hash "
+          "of the file) or mtime (its modification time and size, which is faster)",
+          cxxopts::value<std::string>()->default_value("content"))(
+
+          "max-errors",
+          "Skip up to this many malformed records (e.g. a row with a value that "
+          "can't be parsed) in each dataset file (and the --input data) instead "
+          "of stopping at the first, listing them once the file is loaded (0 to "
+          "stop at the first)",
+          cxxopts::value<size_t>()->default_value("0"))(
+
+          "incremental",
+          "With --parse-cache, only parse what has been appended to each "
+          "dataset file since an earlier run (new records of StatsWales JSON "
+          "files, or new rows of CSV files), parsing the whole file again if "
+          "anything before it has changed")(
+
+          "detect",
+          "Import dataset files in --dir that aren't built in (e.g. new "
+          "StatsWales tables) as a comma-separated list of file names, detecting "
+          "their data type and columns from their first records. What is "
+          "detected is saved next to each file as <file>.schema, which is used "
+          "from then on (and can be edited, or deleted to detect it again). Only "
+          "the datasets given with --datasets are imported alongside them.",
+          cxxopts::value<std::vector<std::string>>())(
+
+          "save-snapshot",
+          "Save the areas, measures and readings that were imported (after the "
+          "filters) to a snapshot file, which --load-snapshot can start from",
+          cxxopts::value<std::string>())(
+
+          "load-snapshot",
+          "Start from a snapshot file saved with --save-snapshot, applying the "
+          "filters to it, instead of importing areas.csv and the datasets (only "
+          "the datasets given with --datasets are imported on top of it)",
+          cxxopts::value<std::string>())(
+
+          "input",
+          "Import data streamed by another program, from a named pipe or '-' "
+          "for the standard input (only the datasets given with --datasets "
+          "are imported alongside it)",
+          cxxopts::value<std::string>())(
+
+          "input-like",
+          "The code of a dataset (e.g. popden, or areas) that the --input data "
+          "is formatted like, to use its data type and column names",
+          cxxopts::value<std::string>())(
+
+          "input-type",
+          "The data type of the --input data: authority-code-csv, "
+          "welsh-stats-json, welsh-stats-ndjson or authority-by-year-csv",
+          cxxopts::value<std::string>())(
+
+          "input-cols",
+          "The column names of the --input data as a comma-separated list of "
+          "COLUMN=name pairs, e.g. auth_code=Localauthority_Code,year=Year_Code "
+          "(COLUMN is one of auth_code, auth_name_eng, auth_name_cym, "
+          "measure_code, measure_name, single_measure_code, "
+          "single_measure_name, year, value)",
+          cxxopts::value<std::vector<std::string>>())(
+
           "h,help",
           "Print usage.");
 
@@ -435,6 +1264,344 @@ YearFilterTuple BethYw::parseYearsArg(cxxopts::ParseResult& args) noexcept(false
 }
 
 
+/*
+  Parse the program arguments that change how the datasets are loaded (but
+  not which data is imported from them).
+
+  @param args
+    Parsed program arguments
+
+  @return
+    The LoadOptions to pass to loadAreas() and loadDatasets()
+
+  @throws
+    std::invalid_argument if an argument has an invalid value, with the
+    message: Invalid input for <argument> argument
+*/
+BethYw::LoadOptions BethYw::parseLoadOptionsArgs(cxxopts::ParseResult& args) noexcept(false) {
+  LoadOptions options;
+
+  options.followNextLinks = args.count("paginate") > 0;
+
+  if (args.count("read-ahead")) {
+    unsigned int sizeKiB = args["read-ahead"].as<unsigned int>();
+    if (sizeKiB == 0) {
+      throw std::invalid_argument("Invalid input for read-ahead argument");
+    }
+
+    options.readAheadBufferSize = static_cast<size_t>(sizeKiB) * 1024;
+  }
+
+  options.readAheadDepth = args["read-ahead-depth"].as<unsigned int>();
+  if (options.readAheadDepth < 2) {
+    throw std::invalid_argument("Invalid input for read-ahead-depth argument");
+  }
+
+  options.batchRead = args.count("batch-read") > 0;
+  options.threads = args["threads"].as<unsigned int>();
+
+  if (args.count("read-strategy")) {
+    static const std::unordered_map<std::string, InputFile::ReadStrategy> strategies = {
+      {"auto", InputFile::ReadStrategy::Auto},
+      {"stream", InputFile::ReadStrategy::Stream},
+      {"whole-file", InputFile::ReadStrategy::WholeFile},
+      {"buffered", InputFile::ReadStrategy::Buffered},
+      {"direct", InputFile::ReadStrategy::Direct}
+    };
+
+    auto strategy = strategies.find(string_operations::stringToLower(args["read-strategy"].as<std::string>()));
+    if (strategy == strategies.end()) {
+      throw std::invalid_argument("Invalid input for read-strategy argument");
+    }
+
+    options.useReadStrategy = true;
+    options.readStrategy = strategy->second;
+  }
+
+  options.httpCacheDir = args["http-cache"].as<std::string>();
+  if (string_operations::stringToLower(options.httpCacheDir) == "none") {
+    options.httpCacheDir = "";
+  }
+
+  options.httpConnections = args["http-connections"].as<unsigned int>();
+  if (options.httpConnections == 0) {
+    throw std::invalid_argument("Invalid input for http-connections argument");
+  }
+
+  options.parseThreads = args["parse-threads"].as<unsigned int>();
+
+  if (args.count("parse-cache")) {
+    options.parseCacheDir = args["parse-cache"].as<std::string>();
+    if (options.parseCacheDir.empty()) {
+      throw std::invalid_argument("Invalid input for parse-cache argument");
+    }
+  }
+
+  const std::string keyMode = string_operations::stringToLower(args["parse-cache-key"].as<std::string>());
+  if (keyMode == "content") {
+    options.parseCacheKeyMode = ParseCache::KeyMode::ContentHash;
+  } else if (keyMode == "mtime") {
+    options.parseCacheKeyMode = ParseCache::KeyMode::ModificationTime;
+  } else {
+    throw std::invalid_argument("Invalid input for parse-cache-key argument");
+  }
+
+  options.maxErrors = args["max-errors"].as<size_t>();
+
+  options.incremental = args["incremental"].as<bool>();
+  if (options.incremental && options.parseCacheDir.empty()) {
+    throw std::invalid_argument("Invalid input for incremental argument");
+  }
+
+  // We can only report on files read by InputFile
+  options.reportReads = args.count("io-stats") > 0;
+  options.useReadStrategy = options.useReadStrategy || options.reportReads;
+
+  return options;
+}
+
+
+/*
+  Parse the program arguments describing data streamed in with --input: where
+  it comes from, how to parse it, and what its columns are called.
+
+  The data type and columns can be taken from one of the known datasets with
+  --input-like, or given with --input-type and --input-cols. When both are
+  used, --input-type and --input-cols override the dataset's.
+
+  @param args
+    Parsed program arguments
+
+  @return
+    An InputFileSource whose FILE is the named pipe (or "-" for the standard
+    input), to pass to loadInput()
+
+  @throws
+    std::invalid_argument if an argument has an invalid value, or the data
+    type is not given, with the message: Invalid input for <argument> argument
+
+  @example
+    auto cxxopts = BethYw::cxxoptsSetup();
+    auto args = cxxopts.parse(argc, argv);
+
+    InputFileSource input = BethYw::parseInputArgs(args);
+*/
+BethYw::InputFileSource BethYw::parseInputArgs(cxxopts::ParseResult& args) noexcept(false) {
+  std::string source = args.count("input") ? args["input"].as<std::string>() : InputPipe::STANDARD_INPUT;
+  SourceDataType parser = SourceDataType::None;
+  SourceColumnMapping cols;
+
+  if (args.count("input-like")) {
+    const std::string code = args["input-like"].as<std::string>();
+    bool found = false;
+
+    if (code == InputFiles::AREAS.CODE) {
+      parser = InputFiles::AREAS.PARSER;
+      cols = InputFiles::AREAS.COLS;
+      found = true;
+    }
+
+    for (size_t i = 0; i < InputFiles::NUM_DATASETS && !found; i++) {
+      if (InputFiles::DATASETS[i].CODE == code) {
+        parser = InputFiles::DATASETS[i].PARSER;
+        cols = InputFiles::DATASETS[i].COLS;
+        found = true;
+      }
+    }
+
+    if (!found) {
+      throw std::invalid_argument("Invalid input for input-like argument");
+    }
+  }
+
+  if (args.count("input-type")) {
+    parser = DatasetSchema::parserFromName(args["input-type"].as<std::string>());
+
+    if (parser == SourceDataType::None) {
+      throw std::invalid_argument("Invalid input for input-type argument");
+    }
+  }
+
+  if (parser == SourceDataType::None) {
+    // We can not guess how to parse the data
+    throw std::invalid_argument("Invalid input for input-type argument");
+  }
+
+  if (args.count("input-cols")) {
+    for (const std::string& pair : args["input-cols"].as<std::vector<std::string>>()) {
+      size_t separator = pair.find('=');
+      SourceColumn column;
+
+      if (separator == std::string::npos || separator + 1 == pair.size() ||
+          !DatasetSchema::columnFromName(pair.substr(0, separator), column)) {
+        throw std::invalid_argument("Invalid input for input-cols argument");
+      }
+
+      cols[column] = pair.substr(separator + 1);
+    }
+  }
+
+  return InputFileSource{"input", "input", source, parser, cols};
+}
+
+
+/*
+  Parse the detect argument, which lists dataset files in the data directory
+  that aren't in datasets.h, and describe each of them (see detectDataset()).
+
+  @param args
+    Parsed program arguments
+
+  @param dir
+    The data directory, ending in a separator
+
+  @return
+    An InputFileSource for each of the files, to import with loadDatasets()
+
+  @throws
+    std::invalid_argument if the data directory is a web server, with the
+    message: Invalid input for detect argument
+    std::runtime_error if a file can't be read, or what it holds can't be
+    detected
+
+  @example
+    auto cxxopts = BethYw::cxxoptsSetup();
+    auto args = cxxopts.parse(argc, argv);
+
+    auto detected = BethYw::parseDetectArg(args, "datasets/");
+*/
+std::vector<BethYw::InputFileSource> BethYw::parseDetectArg(cxxopts::ParseResult& args,
+                                                            const std::string& dir) noexcept(false) {
+  std::vector<InputFileSource> detected;
+  if (!args.count("detect")) {
+    return detected;
+  }
+
+  // Only local files can have a sidecar saved next to them
+  if (InputHttpFile::isHttpUrl(dir)) {
+    throw std::invalid_argument("Invalid input for detect argument");
+  }
+
+  for (const std::string& file : args["detect"].as<std::vector<std::string>>()) {
+    detected.push_back(BethYw::detectDataset(dir, file));
+  }
+
+  return detected;
+}
+
+
+/*
+  Describe a dataset file that isn't in datasets.h with the schema in its
+  sidecar (<file>.schema), or, if it doesn't have one yet, with the schema
+  detected from its first records, which is then saved to its sidecar so
+  that later runs don't detect it again (see DatasetSchema).
+
+  The code and name of the dataset are the name of the file up to its first
+  '.' (e.g. hlth0123 for hlth0123.json), which is also the measure of a file
+  with only one.
+
+  @param dir
+    The data directory, ending in a separator
+
+  @param file
+    The name of the file in the data directory
+
+  @return
+    An InputFileSource for the file, to import with loadDatasets()
+
+  @throws
+    std::runtime_error if the file can't be read, or the sidecar is invalid,
+    or the file's schema can't be detected, with the message:
+    Failed to detect the columns of the dataset: <reason>
+
+  @example
+    std::vector<BethYw::InputFileSource> datasets = {
+        BethYw::detectDataset("datasets/", "hlth0123.json")};
+    BethYw::loadDatasets(data, "datasets/", datasets, ...);
+*/
+BethYw::InputFileSource BethYw::detectDataset(const std::string& dir, const std::string& file) noexcept(false) {
+  const std::string fileName = file.substr(file.find_last_of("/\\") + 1);
+  const std::string code = fileName.substr(0, fileName.find('.'));
+
+  const std::string filePath = dir + file;
+  const std::string sidecarPath = filePath + ".schema";
+
+  DatasetSchema schema;
+  if (!DatasetSchema::load(sidecarPath, schema)) {
+    const std::string sample = ::readSample(::resolveDatasetPath(filePath));
+    schema = DatasetSchema::detect({sample.data(), sample.size()}, code);
+
+    try {
+      schema.save(sidecarPath);
+    }
+    catch (const std::exception& ex) {
+      // Not saving the schema only costs us detecting it again
+    }
+  }
+
+  return InputFileSource{code, code, file, schema.parser, schema.cols};
+}
+
+
+/*
+  Import data streamed by another program (see parseInputArgs()). The data is
+  parsed as it arrives, front to back, so it is never written to disk. If
+  options.maxErrors allows, malformed records are skipped, and reported once
+  the stream ends.
+
+  Like loadDatasets(), this promises not to throw: errors are output after
+  'Error importing dataset:' and the program exits.
+
+  @param areas
+    An Areas instance that should be modified
+
+  @param input
+    Where the data comes from, and how to parse it
+
+  @param areasFilter
+    An unordered set of areas to filter, or empty to import all areas
+
+  @param measuresFilter
+    An unordered set of measures to filter, or empty to import all measures
+
+  @param yearsFilter
+    The range of years to import, which should both be 0 to import all years
+
+  @param options
+    How the data should be loaded (only maxErrors applies to a stream)
+
+  @example
+    Areas areas();
+
+    BethYw::loadInput(
+      areas,
+      BethYw::parseInputArgs(args),
+      BethYw::parseAreasArg(args),
+      BethYw::parseMeasuresArg(args),
+      BethYw::parseYearsArg(args),
+      BethYw::parseLoadOptionsArgs(args));
+*/
+void BethYw::loadInput(Areas& areas,
+                       const InputFileSource& input,
+                       const StringFilterSet& areasFilter,
+                       const StringFilterSet& measuresFilter,
+                       const YearFilterTuple& yearsFilter,
+                       const LoadOptions& options) noexcept {
+  try {
+    InputPipe pipe{input.FILE};
+    ParseErrors errors(options.maxErrors);
+    areas.populate(pipe.open(), input.PARSER, input.COLS, &areasFilter, &measuresFilter, &yearsFilter,
+                   (options.maxErrors == 0) ? nullptr : &errors);
+    ::reportSkipped((input.FILE == InputPipe::STANDARD_INPUT) ? "standard input" : input.FILE, errors);
+  }
+  catch (const std::exception& ex) {
+    std::cerr << "Error importing dataset:" << std::endl;
+    std::cerr << ex.what() << std::endl;
+    std::exit(1);
+  }
+}
+
+
 /*
   TODO: BethYw::loadAreas(areas, dir, areasFilter)
 
@@ -462,6 +1629,9 @@ YearFilterTuple BethYw::parseYearsArg(cxxopts::ParseResult& args) noexcept(false
   @param areasFilter
     An unordered set of areas to filter, or empty to import all areas
 
+  @param options
+    How the areas file should be loaded (see LoadOptions)
+
   @return
     void
 
@@ -470,13 +1640,12 @@ YearFilterTuple BethYw::parseYearsArg(cxxopts::ParseResult& args) noexcept(false
 
     BethYw::loadAreas(areas, "data", BethYw::parseAreasArg(args));
 */
-void BethYw::loadAreas(Areas& areas, const std::string& dir, const StringFilterSet& areasFilter) noexcept {
+void BethYw::loadAreas(Areas& areas,
+                       const std::string& dir,
+                       const StringFilterSet& areasFilter,
+                       const LoadOptions& options) noexcept {
   try {
-    const BethYw::InputFileSource& AREAS = InputFiles::AREAS;
-    std::string areasFilePath = dir + AREAS.FILE;
-    InputFile file{areasFilePath};
-
-    areas.populate(file.open(), BethYw::SourceDataType::AuthorityCodeCSV, AREAS.COLS, &areasFilter);
+    ::populateFromDataset(areas, dir, InputFiles::AREAS, options, &areasFilter);
   }
   catch (const std::exception& ex) {
     std::cerr << "Error importing dataset:" << std::endl;
@@ -505,6 +1674,11 @@ void BethYw::loadAreas(Areas& areas, const std::string& dir, const StringFilterS
   output 'Error importing dataset:', followed by a new line and then the output
   of the what() function on the exception.
 
+  If options.threads allows, the datasets are parsed at the same time, each
+  into its own copy of areas without measures. The copies are combined into
+  areas in the order of datasetsToImport, so data from later datasets takes
+  precedence just as when they are imported one after another.
+
   @param areas
     An Areas instance that should be modified (i.e. datasets loaded into it)
 
@@ -526,6 +1700,9 @@ void BethYw::loadAreas(Areas& areas, const std::string& dir, const StringFilterS
     An two-pair tuple of unsigned ints corresponding to the range of years 
     to import, which should both be 0 to import all years.
 
+  @param options
+    How the dataset files should be loaded (see LoadOptions)
+
   @return
     void
 
@@ -545,15 +1722,36 @@ void BethYw::loadDatasets(Areas& areas,
                           std::vector<BethYw::InputFileSource>& datasetsToImport,
                           const StringFilterSet& areasFilter,
                           const StringFilterSet& measuresFilter,
-                          const YearFilterTuple& yearsFilter
+                          const YearFilterTuple& yearsFilter,
+                          const LoadOptions& options
 ) noexcept {
 
   try {
-    for (const InputFileSource& dataset : datasetsToImport) {
-      std::string filePath = dir + dataset.FILE;
-      InputFile file{filePath};
+    if (options.batchRead) {
+      ::populateFromDatasetsBatched(areas, dir, datasetsToImport, options,
+                                    &areasFilter, &measuresFilter, &yearsFilter);
+      return;
+    }
+
+    const unsigned int threads = (options.threads == 0) ? thread_operations::defaultThreadCount()
+                                                        : options.threads;
 
-      areas.populate(file.open(), dataset.PARSER, dataset.COLS, &areasFilter, &measuresFilter, &yearsFilter);
+    if (threads > 1 && datasetsToImport.size() > 1) {
+      std::vector<Areas> parts(datasetsToImport.size(), areas.withoutMeasures());
+
+      thread_operations::parallelFor(datasetsToImport.size(), threads, [&](size_t i) {
+        ::populateFromDataset(parts[i], dir, datasetsToImport[i], options,
+                              &areasFilter, &measuresFilter, &yearsFilter);
+      });
+
+      for (const Areas& part : parts) {
+        areas.combineAreas(part);
+      }
+      return;
+    }
+
+    for (const InputFileSource& dataset : datasetsToImport) {
+      ::populateFromDataset(areas, dir, dataset, options, &areasFilter, &measuresFilter, &yearsFilter);
     }
   }
   catch (const std::exception& ex) {
@@ -619,7 +1817,87 @@ bool string_operations::isWord(const std::string& wordStr) {
 
 
 int string_operations::stringToNumber(const std::string& numStr) {
-  return std::stoi(numStr);
+  return stringToNumber(InputSpan{numStr.data(), numStr.size()});
+}
+
+
+int string_operations::stringToNumber(const InputSpan& numStr) {
+  int value = 0;
+
+  switch (parseInteger(numStr, value)) {
+    case ParseError::None:
+      return value;
+    case ParseError::Invalid:
+      throw std::invalid_argument("stoi");
+    case ParseError::OutOfRange:
+    default:
+      throw std::out_of_range("stoi");
+  }
+}
+
+
+/*
+  Parse an integer from the start of a span of characters, in the same way as
+  std::stoi (i.e. leading whitespace and a sign are allowed, and anything
+  after the digits is ignored), but without copying the characters, looking
+  at the locale, or throwing.
+
+  @param str
+    The characters
+
+  @param value
+    Set to the integer, if there is no error
+
+  @return
+    ParseError::None, or ParseError::Invalid if there are no digits, or
+    ParseError::OutOfRange if the integer doesn't fit in an int
+
+  @example
+    int year;
+    if (string_operations::parseInteger(InputSpan{"2015", 4}, year) ==
+        string_operations::ParseError::None) { ... }
+*/
+string_operations::ParseError string_operations::parseInteger(const InputSpan& str, int& value) noexcept {
+  const char* position = str.begin();
+  const char* const end = str.end();
+
+  while (position < end && ::isSpace(*position)) {
+    position++;
+  }
+
+  bool negative = false;
+  if (position < end && (*position == '+' || *position == '-')) {
+    negative = (*position == '-');
+    position++;
+  }
+
+  if (position == end || !::isDigit(*position)) {
+    return ParseError::Invalid;
+  }
+
+  // The digits are accumulated as a positive magnitude in a long long, and
+  // checked against the largest magnitude an int of this sign can hold (one
+  // more for a negative number). It is clamped there once exceeded, so that
+  // any number of further digits can't overflow the long long either.
+  const long long limit = negative ? -static_cast<long long>(std::numeric_limits<int>::min())
+                                   : std::numeric_limits<int>::max();
+  long long magnitude = 0;
+  bool overflow = false;
+
+  for (; position < end && ::isDigit(*position); position++) {
+    magnitude = magnitude * 10 + (*position - '0');
+    if (magnitude > limit) {
+      overflow = true;
+      magnitude = limit;
+    }
+  }
+
+  if (overflow) {
+    return ParseError::OutOfRange;
+  }
+
+  value = static_cast<int>(negative ? -magnitude : magnitude);
+  return ParseError::None;
 }
 
 
@@ -632,5 +1910,212 @@ int string_operations::charsInDouble(double num, size_t decimalPrecision) {
 
 
 double string_operations::stringToFloatingPointNumber(const std::string& numStr) {
-  return std::stod(numStr);
+  return stringToFloatingPointNumber(InputSpan{numStr.data(), numStr.size()});
+}
+
+
+double string_operations::stringToFloatingPointNumber(const InputSpan& numStr) {
+  double value = 0;
+
+  switch (parseFloatingPointNumber(numStr, value)) {
+    case ParseError::None:
+      return value;
+    case ParseError::Invalid:
+      throw std::invalid_argument("stod");
+    case ParseError::OutOfRange:
+    default:
+      throw std::out_of_range("stod");
+  }
+}
+
+
+/*
+  Parse a double from the start of a span of characters, in the same way as
+  std::stod (i.e. leading whitespace and a sign are allowed, and anything
+  after the number is ignored), but without copying the characters or
+  throwing, and always with '.' as the decimal point, whatever the locale.
+
+  Decimal numbers with at most 19 significant digits whose value and power
+  of ten are both exactly representable as doubles (which includes every
+  value in the StatsWales datasets) are converted with a single correctly
+  rounded multiplication or division (Clinger's fast path), and so give
+  exactly the same double as std::stod. Anything else (e.g. more digits,
+  large exponents, hexadecimal, infinity or NaN) falls back to std::strtod,
+  with the decimal point swapped for the locale's.
+
+  @param str
+    The characters
+
+  @param value
+    Set to the double, if there is no error, or (like std::strtod) to the
+    infinity or tiny value it rounds to if the number is out of range
+
+  @return
+    ParseError::None, or ParseError::Invalid if there is no number, or
+    ParseError::OutOfRange if the number overflows or underflows a double
+
+  @example
+    double value;
+    if (string_operations::parseFloatingPointNumber(InputSpan{"1.25", 4}, value) ==
+        string_operations::ParseError::None) { ... }
+*/
+string_operations::ParseError string_operations::parseFloatingPointNumber(const InputSpan& str,
+                                                                          double& value) noexcept {
+  const char* position = str.begin();
+  const char* const end = str.end();
+
+  while (position < end && ::isSpace(*position)) {
+    position++;
+  }
+
+  const char* const start = position;
+
+  bool negative = false;
+  if (position < end && (*position == '+' || *position == '-')) {
+    negative = (*position == '-');
+    position++;
+  }
+
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int exponent = 0;
+
+  const char* const integerStart = position;
+  for (; position < end && ::isDigit(*position); position++) {
+    if (digits > 0 || *position != '0') {
+      mantissa = mantissa * 10 + (*position - '0');
+      digits++;
+    }
+
+    if (digits > 19) {
+      break;
+    }
+  }
+  bool anyDigits = (position != integerStart);
+
+  if (position < end && *position == '.' && digits <= 19) {
+    position++;
+    const char* const fractionStart = position;
+
+    for (; position < end && ::isDigit(*position); position++) {
+      if (digits > 0 || *position != '0') {
+        mantissa = mantissa * 10 + (*position - '0');
+        digits++;
+      }
+      exponent--;
+
+      if (digits > 19) {
+        break;
+      }
+    }
+    anyDigits = anyDigits || (position != fractionStart);
+  }
+
+  // Hexadecimal, infinity and NaN, and numbers with too many digits
+  const bool hexadecimal = (position < end && (*position == 'x' || *position == 'X'));
+  if (!anyDigits || digits > 19 || hexadecimal) {
+    try {
+      return ::parseWithStrtod(InputSpan{start, static_cast<size_t>(end - start)}, value);
+    }
+    catch (const std::bad_alloc& ex) {
+      return ParseError::OutOfRange;
+    }
+  }
+
+  // An exponent only counts if it has digits (like strtod)
+  if (position < end && (*position == 'e' || *position == 'E')) {
+    const char* exponentPosition = position + 1;
+    bool negativeExponent = false;
+
+    if (exponentPosition < end && (*exponentPosition == '+' || *exponentPosition == '-')) {
+      negativeExponent = (*exponentPosition == '-');
+      exponentPosition++;
+    }
+
+    if (exponentPosition < end && ::isDigit(*exponentPosition)) {
+      int explicitExponent = 0;
+      for (; exponentPosition < end && ::isDigit(*exponentPosition); exponentPosition++) {
+        if (explicitExponent < 100000) {
+          explicitExponent = explicitExponent * 10 + (*exponentPosition - '0');
+        }
+      }
+      exponent += negativeExponent ? -explicitExponent : explicitExponent;
+      position = exponentPosition;
+    }
+  }
+
+  if (mantissa == 0) {
+    value = negative ? -0.0 : 0.0;
+    return ParseError::None;
+  }
+
+  const uint64_t MAX_EXACT_MANTISSA = uint64_t(1) << 53;
+  if (mantissa > MAX_EXACT_MANTISSA || exponent < -22 || exponent > 22) {
+    try {
+      return ::parseWithStrtod(InputSpan{start, static_cast<size_t>(position - start)}, value);
+    }
+    catch (const std::bad_alloc& ex) {
+      return ParseError::OutOfRange;
+    }
+  }
+
+  double result = static_cast<double>(mantissa);
+  if (exponent < 0) {
+    result /= ::EXACT_POWERS_OF_TEN[-exponent];
+  } else {
+    result *= ::EXACT_POWERS_OF_TEN[exponent];
+  }
+
+  value = negative ? -result : result;
+  return ParseError::None;
+}
+
+
+
+/* ---- THREAD HELPER FUNCTIONS ---- */
+
+unsigned int thread_operations::defaultThreadCount() noexcept {
+  // hardware_concurrency() may return 0 if it cannot tell
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+
+void thread_operations::parallelFor(size_t count,
+                                    unsigned int maxThreads,
+                                    const std::function<void(size_t)>& task) noexcept(false) {
+  // An exception for each task, so that the one that is rethrown does not
+  // depend on the order in which the threads happened to run.
+  std::vector<std::exception_ptr> errors(count);
+  std::atomic<size_t> nextTask(0);
+
+  auto worker = [&]() {
+    for (size_t i = nextTask++; i < count; i = nextTask++) {
+      try {
+        task(i);
+      }
+      catch (...) {
+        errors[i] = std::current_exception();
+      }
+    }
+  };
+
+  size_t numThreads = std::min(count, static_cast<size_t>(std::max(1u, maxThreads)));
+
+  // The calling thread is one of the workers, so only start the others.
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < numThreads; i++) {
+    threads.emplace_back(worker);
+  }
+
+  worker();
+
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  for (const std::exception_ptr& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
 }
@@ -15,6 +15,7 @@
   functions you need to declare in this file.
  */
 
+#include <functional>
 #include <string>
 #include <unordered_set>
 #include <vector>
@@ -24,6 +25,7 @@
 
 #include "datasets.h"
 #include "areas.h"
+#include "cache.h"
 
 
 const char DIR_SEP =
@@ -42,6 +44,57 @@ namespace BethYw {
 
   const std::string IMPORT_ALL_ARG = "all";
 
+  /*
+   Options that change how the datasets are loaded, but not what is imported.
+  */
+  struct LoadOptions {
+    // Follow the odata.nextLink of StatsWales JSON files to their other pages
+    bool followNextLinks = false;
+
+    // Read files on a background thread, with this many buffers of this
+    // size (in bytes). A size of 0 turns reading ahead off.
+    size_t readAheadBufferSize = 0;
+    unsigned int readAheadDepth = 2;
+
+    // Submit the reads of all dataset files at once (with io_uring where
+    // available, otherwise a pool of threads) before parsing them in order
+    bool batchRead = false;
+
+    // Read files with InputFile and this strategy, instead of mapping them
+    bool useReadStrategy = false;
+    InputFile::ReadStrategy readStrategy = InputFile::ReadStrategy::Auto;
+
+    // Report how each file read with InputFile was read, and how fast
+    bool reportReads = false;
+
+    // For datasets fetched over HTTP (when --dir is an http:// URL): where to
+    // cache them with their ETags (empty to not cache), and how many
+    // connections to fetch each one's byte ranges over.
+    std::string httpCacheDir = ".bethyw-cache";
+    unsigned int httpConnections = InputHttpFile::DEFAULT_CONNECTIONS;
+
+    // Parse this many datasets at once (0 for one per processor), merging
+    // them in order afterwards
+    unsigned int threads = 1;
+
+    // Split the records of large StatsWales JSON files between this many
+    // threads (0 for one per processor)
+    unsigned int parseThreads = 1;
+
+    // Reuse the result of parsing unchanged files, from this directory
+    // (empty to always parse them)
+    std::string parseCacheDir = "";
+    ParseCache::KeyMode parseCacheKeyMode = ParseCache::KeyMode::ContentHash;
+
+    // Skip up to this many malformed records in each file, reporting them
+    // once it has been parsed, rather than failing on the first (0)
+    size_t maxErrors = 0;
+
+    // Keep files in the parse cache with a watermark of how far they were
+    // parsed, and only parse what has been appended to them since
+    bool incremental = false;
+  };
+
   /*
    Run Beth Yw?, parsing the command line arguments and acting upon them.
   */
@@ -80,10 +133,39 @@ namespace BethYw {
   YearFilterTuple parseYearsArg(cxxopts::ParseResult& args) noexcept(false);
 
 
+  /*
+   Parse the arguments that control how datasets are loaded.
+  */
+  LoadOptions parseLoadOptionsArgs(cxxopts::ParseResult& args) noexcept(false);
+
+
+  /*
+   Parse the arguments describing data streamed in from another program.
+  */
+  InputFileSource parseInputArgs(cxxopts::ParseResult& args) noexcept(false);
+
+
+  /*
+   Parse the detect argument, and describe each of the dataset files in it.
+  */
+  std::vector<InputFileSource> parseDetectArg(cxxopts::ParseResult& args,
+                                              const std::string& dir) noexcept(false);
+
+
+  /*
+   Describe a dataset file that isn't built in, by its sidecar or by
+   detecting its data type and columns.
+  */
+  InputFileSource detectDataset(const std::string& dir, const std::string& file) noexcept(false);
+
+
   /*
    Load the areas.csv file.
   */
-  void loadAreas(Areas& areas, const std::string& dir, const StringFilterSet& areasFilter) noexcept;
+  void loadAreas(Areas& areas,
+                 const std::string& dir,
+                 const StringFilterSet& areasFilter,
+                 const LoadOptions& options = LoadOptions()) noexcept;
 
   /*
     Load the remaining datasets.
@@ -93,9 +175,20 @@ namespace BethYw {
                     std::vector<BethYw::InputFileSource>& datasetsToImport,
                     const StringFilterSet& areasFilter,
                     const StringFilterSet& measuresFilter,
-                    const YearFilterTuple& yearsFilter
+                    const YearFilterTuple& yearsFilter,
+                    const LoadOptions& options = LoadOptions()
   ) noexcept;
 
+  /*
+    Load data streamed in on the standard input or a named pipe.
+  */
+  void loadInput(Areas& areas,
+                 const InputFileSource& input,
+                 const StringFilterSet& areasFilter,
+                 const StringFilterSet& measuresFilter,
+                 const YearFilterTuple& yearsFilter,
+                 const LoadOptions& options = LoadOptions()) noexcept;
+
 } // namespace BethYw
 
 
@@ -112,14 +205,38 @@ namespace string_operations {
   // Check if a string contains only leters.
   bool isWord(const std::string& wordStr);
 
+  // The errors from parsing a number without exceptions.
+  enum class ParseError { None, Invalid, OutOfRange };
+
+  // Parse an integer from the start of a span, like std::stoi.
+  ParseError parseInteger(const InputSpan& str, int& value) noexcept;
+
+  // Parse a double from the start of a span, like std::stod.
+  ParseError parseFloatingPointNumber(const InputSpan& str, double& value) noexcept;
+
   // Convert a string to a number.
   int stringToNumber(const std::string& numStr);
 
+  int stringToNumber(const InputSpan& numStr);
+
   // The number of characters a double will take when printed to the screen.
   int charsInDouble(double num, size_t decimalPrecision);
 
   // Convert a string to a floating point number
   double stringToFloatingPointNumber(const std::string& numStr);
+
+  double stringToFloatingPointNumber(const InputSpan& numStr);
 } // namespace string_operations
 
+
+namespace thread_operations {
+  // The number of worker threads to use when none is requested.
+  unsigned int defaultThreadCount() noexcept;
+
+  // Call task(i) for each i in [0, count), spreading the calls across
+  // at most maxThreads threads. Rethrows the exception of the lowest i
+  // that failed, once all tasks have finished.
+  void parallelFor(size_t count, unsigned int maxThreads, const std::function<void(size_t)>& task) noexcept(false);
+} // namespace thread_operations
+
 #endif // BETHYW_H_
\ No newline at end of file
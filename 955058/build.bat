@@ -2,9 +2,10 @@
 
 SET bin_dir=bin
 SET tests_dir=tests
-SET source_files=bethyw.cpp input.cpp areas.cpp area.cpp measure.cpp
+SET source_files=bethyw.cpp input.cpp areas.cpp area.cpp measure.cpp cache.cpp snapshot.cpp schema.cpp jsonscanner.cpp csvscanner.cpp
 SET main_file=main.cpp
 SET executable=%bin_dir%\bethyw.exe
+SET libs=-pthread -lz
 
 COPY bin\bethyw2.exe bin\bethyw.exe
 
@@ -25,6 +26,6 @@ IF %testStr%==test (
 :compile
 IF NOT EXIST %bin_dir% MKDIR %bin_dir%
 IF EXIST %executable% DEL %executable%
-g++ --std=c++14 -Wall %source_files% %main_file% -o %executable%
+g++ --std=c++14 -Wall %source_files% %main_file% -o %executable% %libs%
 
 :end
@@ -2,9 +2,11 @@
 
 BIN_DIR="bin"
 TESTS_DIR="tests"
-SOURCE_FILES="bethyw.cpp input.cpp areas.cpp area.cpp measure.cpp"
+SOURCE_FILES="bethyw.cpp input.cpp areas.cpp area.cpp measure.cpp cache.cpp snapshot.cpp schema.cpp jsonscanner.cpp csvscanner.cpp"
 MAIN_FILE="main.cpp"
 EXECUTABLE="./${BIN_DIR}/bethyw"
+LIBS="-pthread -lz"
+DEFINES=""
 
 set -x
 cd "${0%/*}"
@@ -25,6 +27,12 @@ elif [ $# -eq 1 ]; then
   fi
 fi
 
+# Zstandard support is optional, so only enable it if libzstd is installed
+if echo '#include <zstd.h>' | g++ -E -x c++ - > /dev/null 2>&1; then
+  DEFINES="${DEFINES} -DBETHYW_WITH_ZSTD"
+  LIBS="${LIBS} -lzstd"
+fi
+
 mkdir -p ${BIN_DIR}
 rm ${EXECUTABLE} 2> /dev/null
-g++ --std=c++14 -pedantic -Wall ${SOURCE_FILES} ${MAIN_FILE} -o ${EXECUTABLE}
\ No newline at end of file
+g++ --std=c++14 -pedantic -Wall ${DEFINES} ${SOURCE_FILES} ${MAIN_FILE} -o ${EXECUTABLE} ${LIBS}
\ No newline at end of file
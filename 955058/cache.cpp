@@ -0,0 +1,661 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  This file contains the implementation of ParseCache.
+
+  An entry is a file named after the hash of its key, containing:
+    - the magic string BYWPARSE and the format version,
+    - the key itself (to tell apart keys with the same hash),
+    - the encoded Areas (see ParseCache::encode()), and
+    - a hash of everything before it, to detect truncated or corrupt entries.
+  An incremental entry has the same form, but its key is for the path of the
+  file, and the watermark (its offset and hash, as 64-bit integers) is
+  stored before the encoded Areas.
+
+  Other integers are stored as 32-bit, and doubles as their 64 bits, in the byte
+  order of the machine (which is checked when an entry is read).
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+#include "cache.h"
+#include "input.h"
+
+// Anonymous namespace for helper functions private to cache.cpp.
+namespace {
+  const char MAGIC[] = "BYWPARSE";
+  const size_t MAGIC_SIZE = sizeof(MAGIC) - 1;
+  const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+
+  /*
+    The FNV-1a hash of a block of characters, continuing from an earlier hash.
+  */
+  uint64_t hashBytes(const char* data, size_t size, uint64_t hash = 14695981039346656037ULL) {
+    for (size_t i = 0; i < size; i++) {
+      hash ^= static_cast<unsigned char>(data[i]);
+      hash *= 1099511628211ULL;
+    }
+
+    return hash;
+  }
+
+
+  /*
+    A 128-bit hash of a whole file's contents, as two 64-bit halves, computed
+    in a single pass a word at a time. Each half has its own multiplier, and
+    the two chains don't depend on each other, so they run side by side.
+  */
+  void hashContents(const char* data, size_t size, uint64_t& first, uint64_t& second) {
+    const uint64_t FIRST_MULTIPLIER = 0x9e3779b97f4a7c15ULL;
+    const uint64_t SECOND_MULTIPLIER = 0xc2b2ae3d27d4eb4fULL;
+
+    first = 14695981039346656037ULL ^ size;
+    second = 0x84222325cbf29ce4ULL ^ size;
+
+    auto mix = [&](uint64_t word) {
+      first = (first ^ word) * FIRST_MULTIPLIER;
+      first ^= first >> 29;
+      second = (second ^ word) * SECOND_MULTIPLIER;
+      second ^= second >> 32;
+    };
+
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+      uint64_t word;
+      std::memcpy(&word, data + i, sizeof(word));
+      mix(word);
+    }
+
+    if (i < size) {
+      uint64_t word = 0;
+      std::memcpy(&word, data + i, size - i);
+      mix(word);
+    }
+
+    // Spread the last words across all of the bits (MurmurHash3's finaliser)
+    for (uint64_t* half : {&first, &second}) {
+      *half ^= *half >> 33;
+      *half *= 0xff51afd7ed558ccdULL;
+      *half ^= *half >> 33;
+      *half *= 0xc4ceb9fe1a85ec53ULL;
+      *half ^= *half >> 33;
+    }
+  }
+
+
+  std::string toHex(uint64_t value) {
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(value));
+    return hex;
+  }
+
+
+  /*
+    The part of a key for the parser and column mapping a file is parsed
+    with.
+  */
+  std::string parserKey(const BethYw::SourceDataType& type, const BethYw::SourceColumnMapping& cols) {
+    std::string key = "v" + std::to_string(ParseCache::FORMAT_VERSION) + "\n" +
+                      std::to_string(static_cast<int>(type)) + "\n";
+
+    // The mapping is unordered, so sort it to get the same key every time
+    std::vector<std::pair<int, std::string>> sortedCols;
+    for (const auto& col : cols) {
+      sortedCols.emplace_back(static_cast<int>(col.first), col.second);
+    }
+    std::sort(sortedCols.begin(), sortedCols.end());
+
+    for (const auto& col : sortedCols) {
+      key += std::to_string(col.first) + "=" + std::to_string(col.second.size()) + ":" + col.second + "\n";
+    }
+
+    return key;
+  }
+
+
+  /*
+    Appends fixed size values and length-prefixed strings to a buffer.
+  */
+  class BinaryWriter {
+  private:
+    std::string& buffer;
+
+  public:
+    explicit BinaryWriter(std::string& buffer_) : buffer(buffer_) {}
+
+    template <typename T>
+    void write(T value) {
+      buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void writeString(const std::string& str) {
+      write(static_cast<uint32_t>(str.size()));
+      buffer.append(str);
+    }
+  };
+
+
+  /*
+    Reads what a BinaryWriter wrote from a span, throwing std::out_of_range
+    if it runs past the end of it.
+  */
+  class BinaryReader {
+  private:
+    const char* position;
+    const char* end;
+
+  public:
+    explicit BinaryReader(const InputSpan& span) : position(span.begin()), end(span.end()) {}
+
+    template <typename T>
+    T read() {
+      T value;
+      if (static_cast<size_t>(end - position) < sizeof(value)) {
+        throw std::out_of_range("ParseCache: Entry is truncated");
+      }
+
+      std::memcpy(&value, position, sizeof(value));
+      position += sizeof(value);
+      return value;
+    }
+
+    std::string readString() {
+      uint32_t size = read<uint32_t>();
+      if (static_cast<size_t>(end - position) < size) {
+        throw std::out_of_range("ParseCache: Entry is truncated");
+      }
+
+      std::string str(position, size);
+      position += size;
+      return str;
+    }
+
+    bool atEnd() const {
+      return position == end;
+    }
+  };
+} // end of anonymous namespace
+
+
+constexpr unsigned int ParseCache::FORMAT_VERSION;
+
+
+/*
+  Constructor for a cache stored in a directory. The directory is created
+  when the first entry is stored.
+
+  @param cacheDir_
+    The directory to store entries in
+
+  @param keyMode_
+    How to tell whether a file has changed
+
+  @example
+    ParseCache cache(".bethyw-cache/parse");
+*/
+ParseCache::ParseCache(std::string cacheDir_, KeyMode keyMode_) :
+        cacheDir(std::move(cacheDir_)),
+        keyMode(keyMode_) {}
+
+
+std::string ParseCache::entryPath(const std::string& key) const {
+  return cacheDir + "/" + ::toHex(::hashBytes(key.data(), key.size())) + ".bin";
+}
+
+
+/*
+  Build the key for a file parsed with a parser and column mapping.
+
+  @param filePath
+    The path of the file
+
+  @param type
+    The parser the file is parsed with
+
+  @param cols
+    The column mapping the file is parsed with
+
+  @return
+    The key, to pass to load() and store()
+
+  @throws
+    std::runtime_error if the file can't be read, with the message:
+    ParseCache: Failed to open file <file name>
+
+  @example
+    ParseCache cache(".bethyw-cache/parse");
+    std::string key = cache.key("datasets/popu1009.json",
+                                BethYw::InputFiles::POPDEN.PARSER,
+                                BethYw::InputFiles::POPDEN.COLS);
+*/
+std::string ParseCache::key(const std::string& filePath,
+                            const BethYw::SourceDataType& type,
+                            const BethYw::SourceColumnMapping& cols) const noexcept(false) {
+  std::string key = ::parserKey(type, cols);
+
+  if (keyMode == KeyMode::ContentHash) {
+    InputMappedFile file(filePath);
+    InputSpan contents = file.span();
+
+    uint64_t first = 0, second = 0;
+    ::hashContents(contents.data, contents.size, first, second);
+
+    key += "content=" + ::toHex(first) + ::toHex(second) + "/" + std::to_string(contents.size);
+    return key;
+  }
+
+#ifndef _WIN32
+  struct stat fileStat{};
+  if (stat(filePath.c_str(), &fileStat) != 0) {
+    throw std::runtime_error("ParseCache: Failed to open file " + filePath);
+  }
+
+#ifdef __APPLE__
+  long long modifiedNanoseconds = fileStat.st_mtimespec.tv_sec * 1000000000LL + fileStat.st_mtimespec.tv_nsec;
+#else
+  long long modifiedNanoseconds = fileStat.st_mtim.tv_sec * 1000000000LL + fileStat.st_mtim.tv_nsec;
+#endif
+
+  key += "file=" + filePath + "/" + std::to_string(modifiedNanoseconds) + "/" + std::to_string(fileStat.st_size);
+#else
+  std::ifstream file(filePath, std::ifstream::in | std::ifstream::binary | std::ifstream::ate);
+  if (!file) {
+    throw std::runtime_error("ParseCache: Failed to open file " + filePath);
+  }
+
+  // No nanosecond modification times here, so fall back to the contents
+  key += "file=" + filePath + "/" + std::to_string(static_cast<long long>(file.tellg()));
+#endif
+
+  return key;
+}
+
+
+/*
+  Load the Areas stored under a key.
+
+  @param key
+    The key from key()
+
+  @param parsed
+    The Areas instance to load the stored areas into, which should be empty
+
+  @return
+    Whether an entry was found (and loaded)
+
+  @example
+    Areas parsed = Areas();
+    if (cache.load(key, parsed)) {
+      data.populateFromParsed(parsed, BethYw::InputFiles::POPDEN.PARSER);
+    }
+*/
+bool ParseCache::load(const std::string& key, Areas& parsed) const noexcept {
+  std::string encoded;
+  return readEntry(key, encoded) && decode({encoded.data(), encoded.size()}, parsed);
+}
+
+
+/*
+  Store the Areas parsed from a file under a key. The entry is written under a
+  temporary name and then renamed, so other runs never see half an entry.
+
+  @param key
+    The key from key()
+
+  @param parsed
+    The areas parsed from the file, without any filters
+
+  @example
+    Areas parsed = Areas();
+    parsed.populate(input.open(), BethYw::InputFiles::POPDEN.PARSER, BethYw::InputFiles::POPDEN.COLS);
+    cache.store(key, parsed);
+*/
+void ParseCache::store(const std::string& key, const Areas& parsed) const noexcept {
+  try {
+    writeEntry(key, encode(parsed));
+  }
+  catch (const std::exception& ex) {
+    // Not caching a file only costs us time
+  }
+}
+
+
+/*
+  Remove the entry stored under a key (by store() or storeIncremental()), if
+  there is one, e.g. so that the file is parsed again next time.
+
+  @param key
+    The key from key() or incrementalKey()
+
+  @example
+    cache.erase(cache.key("datasets/popu1009.json", BethYw::InputFiles::POPDEN.PARSER,
+                          BethYw::InputFiles::POPDEN.COLS));
+*/
+void ParseCache::erase(const std::string& key) const noexcept {
+  std::remove(entryPath(key).c_str());
+}
+
+
+/*
+  Build the key for the incremental entry of a file (see storeIncremental()),
+  which is the same however the file changes.
+
+  @param filePath
+    The path of the file
+
+  @param type
+    The parser the file is parsed with
+
+  @param cols
+    The column mapping the file is parsed with
+
+  @return
+    The key, to pass to loadIncremental() and storeIncremental()
+*/
+std::string ParseCache::incrementalKey(const std::string& filePath,
+                                       const BethYw::SourceDataType& type,
+                                       const BethYw::SourceColumnMapping& cols) const {
+  return ::parserKey(type, cols) + "incremental=" + filePath;
+}
+
+
+/*
+  Load the Areas stored under an incremental key, and the watermark of the
+  file they were parsed up to.
+
+  @param key
+    The key from incrementalKey()
+
+  @param parsed
+    The Areas instance to load the stored areas into, which should be empty
+
+  @param watermark
+    Set to the watermark stored with the areas
+
+  @return
+    Whether an entry was found (and loaded)
+
+  @example
+    Areas parsed = Areas();
+    ParseCache::Watermark watermark;
+    if (cache.loadIncremental(key, parsed, watermark) && watermark.matches(input.span())) {
+      watermark.offset = parsed.populateIncrementally(input.span(), type, cols, watermark.offset);
+    }
+*/
+bool ParseCache::loadIncremental(const std::string& key, Areas& parsed, Watermark& watermark) const noexcept {
+  try {
+    std::string entry;
+    if (!readEntry(key, entry)) {
+      return false;
+    }
+
+    BinaryReader reader({entry.data(), entry.size()});
+    watermark.offset = reader.read<uint64_t>();
+    watermark.prefixHash = reader.read<uint64_t>();
+
+    std::string encoded = reader.readString();
+    return reader.atEnd() && decode({encoded.data(), encoded.size()}, parsed);
+  }
+  catch (const std::exception& ex) {
+    return false;
+  }
+}
+
+
+/*
+  Store the Areas parsed from a file that is only ever appended to, with the
+  watermark returned by Areas::populateIncrementally(), so that a later run
+  only needs to parse what has been appended to the file since.
+
+  @param key
+    The key from incrementalKey()
+
+  @param parsed
+    The areas parsed from the file, without any filters
+
+  @param watermark
+    The watermark, with the hash of the file up to it (see Watermark::of())
+
+  @example
+    Areas parsed = Areas();
+    size_t offset = parsed.populateIncrementally(input.span(), type, cols);
+    cache.storeIncremental(key, parsed, ParseCache::Watermark::of(input.span(), offset));
+*/
+void ParseCache::storeIncremental(const std::string& key,
+                                  const Areas& parsed,
+                                  const Watermark& watermark) const noexcept {
+  try {
+    std::string entry;
+    BinaryWriter writer(entry);
+    writer.write(watermark.offset);
+    writer.write(watermark.prefixHash);
+    writer.writeString(encode(parsed));
+
+    writeEntry(key, entry);
+  }
+  catch (const std::exception& ex) {
+    // Not caching a file only costs us time
+  }
+}
+
+
+/*
+  Read the contents of the entry stored under a key, checking that it is
+  whole and is for that key.
+
+  @return
+    Whether an entry was found (and read)
+*/
+bool ParseCache::readEntry(const std::string& key, std::string& contents) const noexcept {
+  try {
+    InputMappedFile entry(entryPath(key));
+    InputSpan span = entry.span();
+
+    const size_t checksumSize = sizeof(uint64_t);
+    if (span.size < MAGIC_SIZE + checksumSize ||
+        std::memcmp(span.data, MAGIC, MAGIC_SIZE) != 0) {
+      return false;
+    }
+
+    uint64_t checksum;
+    std::memcpy(&checksum, span.end() - checksumSize, checksumSize);
+    if (checksum != ::hashBytes(span.data, span.size - checksumSize)) {
+      return false;
+    }
+
+    BinaryReader reader({span.data + MAGIC_SIZE, span.size - MAGIC_SIZE - checksumSize});
+    if (reader.read<uint32_t>() != BYTE_ORDER_MARK ||
+        reader.read<uint32_t>() != FORMAT_VERSION ||
+        reader.readString() != key) {
+      return false;
+    }
+
+    contents = reader.readString();
+    return reader.atEnd();
+  }
+  catch (const std::exception& ex) {
+    return false;
+  }
+}
+
+
+/*
+  Write an entry under a key. The entry is written under a temporary name and
+  then renamed, so other runs never see half an entry.
+
+  @throws
+    std::exception if the entry can't be built
+*/
+void ParseCache::writeEntry(const std::string& key, const std::string& contents) const noexcept(false) {
+  std::string entry(MAGIC, MAGIC_SIZE);
+  BinaryWriter writer(entry);
+  writer.write(BYTE_ORDER_MARK);
+  writer.write(static_cast<uint32_t>(FORMAT_VERSION));
+  writer.writeString(key);
+  writer.writeString(contents);
+  writer.write(::hashBytes(entry.data(), entry.size()));
+
+#ifndef _WIN32
+  mkdir(cacheDir.c_str(), 0755);
+#endif
+
+  const std::string path = entryPath(key);
+  const std::string temporaryPath = path + ".tmp";
+
+  {
+    std::ofstream file(temporaryPath, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+    file.write(entry.data(), static_cast<std::streamsize>(entry.size()));
+    if (!file) {
+      std::remove(temporaryPath.c_str());
+      return;
+    }
+  }
+
+  std::rename(temporaryPath.c_str(), path.c_str());
+}
+
+
+/*
+  The watermark of a file parsed up to an offset, with the hash of the file
+  up to there.
+
+  @param contents
+    The whole file
+
+  @param offset
+    The watermark returned by Areas::populateIncrementally()
+
+  @return
+    The watermark
+*/
+ParseCache::Watermark ParseCache::Watermark::of(const InputSpan& contents, size_t offset) noexcept {
+  offset = std::min(offset, contents.size);
+  return Watermark{offset, ::hashBytes(contents.data, offset)};
+}
+
+
+/*
+  Whether a file is the one this watermark was taken from with, at most,
+  something appended to it, i.e. it is the same up to the watermark. A
+  watermark at the end of the file (e.g. after the last line of a
+  newline-delimited JSON file) matches it while nothing has been appended.
+
+  @param contents
+    The whole file
+
+  @return
+    true if only what comes after the watermark needs parsing
+*/
+bool ParseCache::Watermark::matches(const InputSpan& contents) const noexcept {
+  return offset > 0 && offset <= contents.size &&
+         ::hashBytes(contents.data, static_cast<size_t>(offset)) == prefixHash;
+}
+
+
+/*
+  Encode Areas in the binary form stored in the cache.
+
+  @param parsed
+    The Areas to encode
+
+  @return
+    The encoded areas
+*/
+std::string ParseCache::encode(const Areas& parsed) {
+  std::string encoded;
+  BinaryWriter writer(encoded);
+
+  writer.write(static_cast<uint32_t>(parsed.size()));
+  for (const auto& codeAreaPair : parsed.getAllAreas()) {
+    const Area& area = codeAreaPair.second;
+    writer.writeString(area.getLocalAuthorityCode());
+
+    writer.write(static_cast<uint32_t>(area.getNames().size()));
+    for (const auto& langNamePair : area.getNames()) {
+      writer.writeString(langNamePair.first);
+      writer.writeString(langNamePair.second);
+    }
+
+    writer.write(static_cast<uint32_t>(area.getMeasures().size()));
+    for (const auto& codeMeasurePair : area.getMeasures()) {
+      const Measure& measure = codeMeasurePair.second;
+      writer.writeString(codeMeasurePair.first);
+      writer.writeString(measure.getCodename());
+      writer.writeString(measure.getLabel());
+
+      const auto readings = measure.getAllReadingsSorted();
+      writer.write(static_cast<uint32_t>(readings.size()));
+      for (const auto& reading : readings) {
+        writer.write(static_cast<uint32_t>(reading.first));
+        writer.write(reading.second);
+      }
+    }
+  }
+
+  return encoded;
+}
+
+
+/*
+  Decode Areas encoded with encode().
+
+  @param encoded
+    The encoded areas
+
+  @param parsed
+    The Areas instance to decode the areas into
+
+  @return
+    Whether the areas could be decoded (i.e. they are not truncated)
+*/
+bool ParseCache::decode(const InputSpan& encoded, Areas& parsed) noexcept {
+  try {
+    BinaryReader reader(encoded);
+
+    for (uint32_t areaCount = reader.read<uint32_t>(); areaCount > 0; areaCount--) {
+      Area area(reader.readString());
+
+      for (uint32_t nameCount = reader.read<uint32_t>(); nameCount > 0; nameCount--) {
+        std::string lang = reader.readString();
+        area.setName(lang, reader.readString());
+      }
+
+      for (uint32_t measureCount = reader.read<uint32_t>(); measureCount > 0; measureCount--) {
+        std::string key = reader.readString();
+        std::string codename = reader.readString();
+        Measure measure(codename, reader.readString());
+
+        for (uint32_t readingCount = reader.read<uint32_t>(); readingCount > 0; readingCount--) {
+          uint32_t year = reader.read<uint32_t>();
+          measure.setValue(year, reader.read<double>());
+        }
+
+        area.setMeasure(key, measure);
+      }
+
+      parsed.setArea(area.getLocalAuthorityCode(), area);
+    }
+
+    return reader.atEnd();
+  }
+  catch (const std::exception& ex) {
+    return false;
+  }
+}
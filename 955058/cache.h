@@ -0,0 +1,103 @@
+#ifndef CACHE_H_
+#define CACHE_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  This file contains the declaration of ParseCache, which keeps the result of
+  parsing dataset files on disk, in a compact binary form, so that later runs
+  of Beth Yw? on unchanged files can load that result instead of parsing the
+  files again.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "datasets.h"
+#include "areas.h"
+#include "input.h"
+
+/*
+  A directory of parsed dataset files. Each entry holds the Areas parsed from
+  one file without any filters (see Areas::populateFromParsed() for applying
+  them afterwards), and is keyed by:
+    - the file, by either a hash of its contents, or its path, modification
+      time and size (see KeyMode),
+    - the parser (SourceDataType) and column mapping it was parsed with, and
+    - the version of the cache format.
+
+  Files that are only ever appended to can also be kept in incremental
+  entries, keyed by their path rather than their contents, with a watermark
+  of how far into the file they were parsed. Then only what has been
+  appended since needs to be parsed (see Areas::populateIncrementally()).
+
+  The cache never causes a failure: entries that are missing, unreadable or
+  corrupt are treated as misses, and entries that can't be written are
+  skipped.
+*/
+class ParseCache {
+public:
+  enum class KeyMode {
+    // A hash of the whole file, which reads it, but is safe against files
+    // that are replaced without their modification time changing
+    ContentHash,
+    // The path, modification time and size, which does not read the file
+    ModificationTime
+  };
+
+  // Change this whenever the format of the entries changes.
+  static constexpr unsigned int FORMAT_VERSION = 1;
+
+  // How far into a file its incremental entry was parsed, and a hash of the
+  // file up to there, to tell whether anything but appending has changed it
+  struct Watermark {
+    uint64_t offset;
+    uint64_t prefixHash;
+
+    static Watermark of(const InputSpan& contents, size_t offset) noexcept;
+
+    bool matches(const InputSpan& contents) const noexcept;
+  };
+
+private:
+  std::string cacheDir;
+  KeyMode keyMode;
+
+  std::string entryPath(const std::string& key) const;
+
+  bool readEntry(const std::string& key, std::string& contents) const noexcept;
+
+  void writeEntry(const std::string& key, const std::string& contents) const noexcept(false);
+
+public:
+  explicit ParseCache(std::string cacheDir_, KeyMode keyMode_ = KeyMode::ContentHash);
+
+  std::string key(const std::string& filePath,
+                  const BethYw::SourceDataType& type,
+                  const BethYw::SourceColumnMapping& cols) const noexcept(false);
+
+  bool load(const std::string& key, Areas& parsed) const noexcept;
+
+  void store(const std::string& key, const Areas& parsed) const noexcept;
+
+  void erase(const std::string& key) const noexcept;
+
+  std::string incrementalKey(const std::string& filePath,
+                             const BethYw::SourceDataType& type,
+                             const BethYw::SourceColumnMapping& cols) const;
+
+  bool loadIncremental(const std::string& key, Areas& parsed, Watermark& watermark) const noexcept;
+
+  void storeIncremental(const std::string& key, const Areas& parsed, const Watermark& watermark) const noexcept;
+
+  static std::string encode(const Areas& parsed);
+
+  static bool decode(const InputSpan& encoded, Areas& parsed) noexcept;
+};
+
+#endif // CACHE_H_
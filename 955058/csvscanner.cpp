@@ -0,0 +1,424 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  This file contains the implementation of CSVReader.
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define BETHYW_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "csvscanner.h"
+
+// Anonymous namespace for helper functions private to csvscanner.cpp.
+namespace {
+  const char BYTE_ORDER_MARK[] = "\xEF\xBB\xBF";
+
+#ifdef BETHYW_SSE2
+  unsigned int trailingZeros(unsigned int bits) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return static_cast<unsigned int>(index);
+#else
+    return static_cast<unsigned int>(__builtin_ctz(bits));
+#endif
+  }
+#endif
+} // end of anonymous namespace
+
+
+constexpr size_t CSVReader::BUFFER_SIZE;
+
+/*
+  Construct a reader over a CSV file that is entirely in memory (e.g. mapped
+  with InputMappedFile). Fields point into the span where they can.
+
+  @param span
+    The characters of the file, which must outlive the reader
+
+  @param delimiter_
+    The character between fields
+
+  @example
+    InputMappedFile input("datasets/areas.csv");
+    CSVReader reader(input.span());
+*/
+CSVReader::CSVReader(const InputSpan& span, char delimiter_) :
+        is(nullptr),
+        buffer(),
+        data(span.data),
+        size(span.size),
+        position(0),
+        delimiter(delimiter_),
+        started(false),
+        line(0),
+        nextLine(1),
+        discarded(0),
+        offset(0),
+        recordStart(0),
+        refs(),
+        unescaped(),
+        fieldSpans(),
+        resumeOffset(0),
+        resumeLine(0) {}
+
+/*
+  Construct a reader over a CSV file read from a stream, a buffer at a time.
+
+  @param is_
+    The stream, which must outlive the reader
+
+  @param delimiter_
+    The character between fields
+
+  @param bufferSize
+    How many characters to read from the stream at a time
+
+  @example
+    InputFile input("datasets/areas.csv");
+    CSVReader reader(input.open());
+*/
+CSVReader::CSVReader(std::istream& is_, char delimiter_, size_t bufferSize) :
+        is(&is_),
+        buffer(std::max<size_t>(bufferSize, 1)),
+        data(buffer.data()),
+        size(0),
+        position(0),
+        delimiter(delimiter_),
+        started(false),
+        line(0),
+        nextLine(1),
+        discarded(0),
+        offset(0),
+        recordStart(0),
+        refs(),
+        unescaped(),
+        fieldSpans(),
+        resumeOffset(0),
+        resumeLine(0) {}
+
+/*
+  Read more of a stream into the buffer, keeping the current record at the
+  start of it (and growing it if the record fills it). Offsets from the start
+  of the record stay the same, but positions in data move.
+
+  @return
+    false if there was nothing more to read (or the file is a span)
+*/
+bool CSVReader::fill() {
+  if (is == nullptr) {
+    return false;
+  }
+
+  if (recordStart > 0) {
+    std::memmove(buffer.data(), buffer.data() + recordStart, size - recordStart);
+    discarded += recordStart;
+    size -= recordStart;
+    position -= recordStart;
+    recordStart = 0;
+  }
+
+  if (size == buffer.size()) {
+    buffer.resize(buffer.size() * 2);
+  }
+
+  is->read(buffer.data() + size, static_cast<std::streamsize>(buffer.size() - size));
+  const size_t count = static_cast<size_t>(is->gcount());
+
+  data = buffer.data();
+  size += count;
+  return count > 0;
+}
+
+/*
+  Make sure that at least some characters after the position are available,
+  reading more of a stream if needed.
+
+  @return
+    false if the file ends before then
+*/
+bool CSVReader::ensure(size_t count) {
+  while (size - position < count) {
+    if (!fill()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/*
+  The position of the first delimiter or newline from a position onwards, or
+  the end of what is available.
+*/
+size_t CSVReader::findFieldEnd(size_t from) const noexcept {
+  const char* p = data + from;
+  const char* const end = data + size;
+
+#ifdef BETHYW_SSE2
+  const __m128i delimiters = _mm_set1_epi8(delimiter);
+  const __m128i newlines = _mm_set1_epi8('\n');
+
+  for (; end - p >= 16; p += 16) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i found = _mm_or_si128(_mm_cmpeq_epi8(bytes, delimiters), _mm_cmpeq_epi8(bytes, newlines));
+    const unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(found));
+
+    if (mask != 0) {
+      return static_cast<size_t>(p - data) + ::trailingZeros(mask);
+    }
+  }
+#endif
+
+  while (p < end && *p != delimiter && *p != '\n') {
+    p++;
+  }
+
+  return static_cast<size_t>(p - data);
+}
+
+/*
+  Read a field that doesn't start with a quote, up to the next delimiter or
+  newline (leaving out the CR of a CRLF).
+*/
+void CSVReader::readUnquotedField(bool& endOfRecord) {
+  const size_t begin = position - recordStart;
+
+  position = findFieldEnd(position);
+  while (position == size && fill()) {
+    position = findFieldEnd(position);
+  }
+
+  size_t end = position - recordStart;
+  const bool endOfFile = (position == size);
+  endOfRecord = endOfFile || data[position] == '\n';
+
+  if (endOfRecord && end > begin && data[recordStart + end - 1] == '\r') {
+    end--;
+  }
+
+  refs.push_back(FieldRef{false, false, begin, end - begin});
+
+  if (!endOfFile) {
+    position++;
+  }
+}
+
+/*
+  Read a field that starts with a quote, up to its closing quote, which must
+  be followed by a delimiter, a newline, or the end of the file.
+*/
+void CSVReader::readQuotedField(bool& endOfRecord) {
+  position++;
+  const size_t begin = position - recordStart;
+
+  // Where the characters not yet copied into unescaped start, if the field
+  // has escaped quotes
+  size_t segment = begin;
+  bool escaped = false;
+  const size_t unescapedBegin = unescaped.size();
+
+  while (true) {
+    const void* quote = std::memchr(data + position, '"', size - position);
+    if (quote == nullptr) {
+      position = size;
+      if (!fill()) {
+        malformed("unterminated quoted field");
+      }
+      continue;
+    }
+
+    position = static_cast<const char*>(quote) - data;
+
+    if (!ensure(2) || data[position + 1] != '"') {
+      break;
+    }
+
+    unescaped.append(data + recordStart + segment, position - recordStart - segment);
+    unescaped.push_back('"');
+    escaped = true;
+
+    position += 2;
+    segment = position - recordStart;
+  }
+
+  const size_t end = position - recordStart;
+  nextLine += std::count(data + recordStart + begin, data + recordStart + end, '\n');
+
+  if (escaped) {
+    unescaped.append(data + recordStart + segment, end - segment);
+    refs.push_back(FieldRef{true, true, unescapedBegin, unescaped.size() - unescapedBegin});
+  } else {
+    refs.push_back(FieldRef{true, false, begin, end - begin});
+  }
+
+  // Past the closing quote
+  position++;
+
+  if (!ensure(1)) {
+    endOfRecord = true;
+    return;
+  }
+
+  const char c = data[position];
+  if (c == delimiter) {
+    endOfRecord = false;
+    position++;
+  } else if (c == '\n') {
+    endOfRecord = true;
+    position++;
+  } else if (c == '\r' && (!ensure(2) || data[position + 1] == '\n')) {
+    endOfRecord = true;
+    position = std::min(position + 2, size);
+  } else {
+    malformed("unexpected character after a quoted field");
+  }
+}
+
+/*
+  Throw an exception for a malformed file, saying where.
+*/
+void CSVReader::malformed(const std::string& what) const {
+  throw std::runtime_error("CSV line " + std::to_string(line) + ": " + what);
+}
+
+/*
+  Read the next record of the file.
+
+  @return
+    false once there are no records left
+
+  @throws
+    std::runtime_error if the record is malformed
+
+  @example
+    InputMappedFile input("datasets/areas.csv");
+    CSVReader reader(input.span());
+    while (reader.next()) {
+      std::cout << reader.fields().size() << std::endl;
+    }
+*/
+bool CSVReader::next() noexcept(false) {
+  refs.clear();
+  unescaped.clear();
+  fieldSpans.clear();
+
+  if (started && resumeLine > 0) {
+    position = resumeOffset;
+    nextLine = resumeLine;
+    resumeLine = 0;
+  }
+
+  recordStart = position;
+
+  if (!started) {
+    started = true;
+    ensure(3);
+    if (size - position >= 3 && std::memcmp(data + position, BYTE_ORDER_MARK, 3) == 0) {
+      position += 3;
+      recordStart = position;
+    }
+  }
+
+  if (!ensure(1)) {
+    return false;
+  }
+
+  line = nextLine;
+  nextLine++;
+  offset = discarded + recordStart;
+
+  bool endOfRecord = false;
+  while (!endOfRecord) {
+    if (ensure(1) && data[position] == '"') {
+      readQuotedField(endOfRecord);
+    } else {
+      readUnquotedField(endOfRecord);
+    }
+  }
+
+  // A blank line has no fields, rather than one empty one
+  if (refs.size() == 1 && !refs[0].quoted && refs[0].size == 0) {
+    return true;
+  }
+
+  for (const FieldRef& ref : refs) {
+    const char* fieldData = ref.unescaped ? unescaped.data() + ref.begin : data + recordStart + ref.begin;
+    fieldSpans.push_back(InputSpan{fieldData, ref.size});
+  }
+
+  return true;
+}
+
+/*
+  Skip the records of a span between its header and a record further on, so
+  that the header is read first, and then the records from that one on
+  (e.g. only those appended to a file since it was last read). Lines and
+  offsets are still those in the whole file.
+
+  @param offset_
+    The offset of the record to carry on from, as given by getOffset(),
+    which must be in the span
+
+  @param line_
+    The line that record starts on
+
+  @example
+    CSVReader reader(input.span());
+    reader.resumeAfterHeader(watermark, lineOfWatermark);
+    reader.next();  // The header
+    reader.next();  // The record at watermark
+*/
+void CSVReader::resumeAfterHeader(size_t offset_, size_t line_) noexcept {
+  resumeOffset = offset_;
+  resumeLine = line_;
+}
+
+/*
+  The fields of the record that was read last.
+
+  @return
+    The fields, which are valid until the next record is read
+*/
+const std::vector<InputSpan>& CSVReader::fields() const noexcept {
+  return fieldSpans;
+}
+
+/*
+  The line of the file that the record that was read last started on.
+
+  @return
+    The line number, from 1
+*/
+size_t CSVReader::getLine() const noexcept {
+  return line;
+}
+
+/*
+  The offset from the start of the file of the record that was read last.
+  Reading the file again from there (after its header) reads the same
+  records from then on, so this is where to resume reading a file that is
+  appended to.
+
+  @return
+    The offset, in characters (including any byte order mark)
+*/
+size_t CSVReader::getOffset() const noexcept {
+  return offset;
+}
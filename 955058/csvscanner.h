@@ -0,0 +1,120 @@
+#ifndef CSVSCANNER_H_
+#define CSVSCANNER_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  This file contains the declaration of CSVReader, which reads the records of
+  the CSV files (areas.csv and the complete-popu1009-*.csv files) as they are
+  exported, quoted fields and all, from either a span or a stream.
+ */
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "input.h"
+
+/*
+  Reads the records of a CSV file as described in RFC 4180, in a single pass
+  over its characters:
+
+    - Fields may be quoted, in which case they can contain the delimiter,
+      newlines, and quotes (written as two quotes).
+    - Records end with either LF or CRLF, and a byte order mark at the start
+      of the file is skipped.
+    - A blank line is a record without any fields.
+
+  Unquoted fields are found by looking for the delimiter and newlines 16
+  bytes at a time with SSE2 (where it is available), without looking at
+  quotes at all; a quote is only special at the start of a field.
+
+  Each field is a span of characters. For a span, they point into it, unless
+  the field has escaped quotes. For a stream, the file is read a buffer at a
+  time, and the fields point into the buffer. Either way, the fields are only
+  valid until the next record is read.
+
+  Malformed files (an unterminated quoted field, or characters after one's
+  closing quote) are rejected with std::runtime_error.
+*/
+class CSVReader {
+public:
+  // The size of the buffer that streams are read into, which grows if a
+  // record doesn't fit in it
+  static constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+private:
+  // Where the file is read from, if it isn't a span, and what has been read
+  std::istream* is;
+  std::vector<char> buffer;
+
+  // The characters available to parse, and how far they have been parsed
+  const char* data;
+  size_t size;
+  size_t position;
+
+  char delimiter;
+  bool started;
+
+  // The line the current record started on, and the line the next starts on
+  size_t line;
+  size_t nextLine;
+
+  // How many characters of a stream have been dropped from the start of the
+  // buffer, and the offset in the file of the current record
+  size_t discarded;
+  size_t offset;
+
+  // The fields of the current record, either as offsets from its start, or
+  // into unescaped if they had escaped quotes
+  struct FieldRef {
+    bool quoted;
+    bool unescaped;
+    size_t begin;
+    size_t size;
+  };
+
+  size_t recordStart;
+  std::vector<FieldRef> refs;
+  std::string unescaped;
+  std::vector<InputSpan> fieldSpans;
+
+  // Where to carry on reading a span from once its header has been read, if
+  // resumeLine isn't 0
+  size_t resumeOffset;
+  size_t resumeLine;
+
+  bool fill();
+
+  bool ensure(size_t count);
+
+  size_t findFieldEnd(size_t from) const noexcept;
+
+  void readUnquotedField(bool& endOfRecord);
+
+  void readQuotedField(bool& endOfRecord);
+
+  [[noreturn]] void malformed(const std::string& what) const;
+
+public:
+  explicit CSVReader(const InputSpan& span, char delimiter_ = ',');
+
+  explicit CSVReader(std::istream& is_, char delimiter_ = ',', size_t bufferSize = BUFFER_SIZE);
+
+  bool next() noexcept(false);
+
+  void resumeAfterHeader(size_t offset_, size_t line_) noexcept;
+
+  const std::vector<InputSpan>& fields() const noexcept;
+
+  size_t getLine() const noexcept;
+
+  size_t getOffset() const noexcept;
+};
+
+#endif // CSVSCANNER_H_
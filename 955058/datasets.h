@@ -50,7 +50,10 @@ enum SourceDataType {
   None,
   AuthorityCodeCSV,
   WelshStatsJSON,
-  AuthorityByYearCSV
+  AuthorityByYearCSV,
+  // The records of a StatsWales JSON value array, one object per line
+  // (newline-delimited JSON), without the document around them
+  WelshStatsNDJSON
 };
 
 /*
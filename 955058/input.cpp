@@ -19,8 +19,56 @@
 
 #include "input.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
 #include <utility>
 
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <zlib.h>
+
+#ifdef BETHYW_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#endif
+
+// io_uring is used without liburing, through its system calls directly
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define BETHYW_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
 /*
   TODO: InputSource::InputSource(source)
 
@@ -45,6 +93,164 @@ std::string InputSource::getSource() const noexcept {
 }
 
 
+#ifndef _WIN32
+/*
+  A stream buffer reading a file descriptor with read()s of a fixed size into
+  its own buffer, timing how long is spent in read(). The buffer is aligned
+  to DIRECT_ALIGNMENT, so that it can be used with O_DIRECT, where reads must
+  start at aligned offsets into aligned memory.
+*/
+class DescriptorStreamBuffer : public std::streambuf {
+private:
+  static constexpr size_t DIRECT_ALIGNMENT = 4096;
+
+  int descriptor;
+  bool direct;
+  char* buffer;
+  size_t bufferSize;
+
+  // The offset in the file of the end of the buffer's contents
+  off_t fileOffset;
+
+  // Characters to skip after the next read, after seeking with O_DIRECT
+  size_t skip;
+
+  size_t bytesRead;
+  double secondsReading;
+
+protected:
+  virtual int_type underflow() {
+    if (gptr() < egptr()) {
+      return traits_type::to_int_type(*gptr());
+    }
+
+    auto started = std::chrono::steady_clock::now();
+
+    ssize_t count;
+    do {
+      count = ::read(descriptor, buffer, bufferSize);
+    } while (count < 0 && errno == EINTR);
+
+    secondsReading += std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    if (count < 0) {
+      throw std::runtime_error("InputFile: Failed to read from the file");
+    }
+
+    bytesRead += static_cast<size_t>(count);
+    fileOffset += count;
+
+    size_t first = std::min(skip, static_cast<size_t>(count));
+    skip = 0;
+
+    if (first == static_cast<size_t>(count)) {
+      setg(buffer, buffer, buffer);
+      return traits_type::eof();
+    }
+
+    setg(buffer, buffer + first, buffer + count);
+    return traits_type::to_int_type(*gptr());
+  }
+
+  virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) {
+    if (!(which & std::ios_base::in)) {
+      return pos_type(off_type(-1));
+    }
+
+    off_type current = fileOffset - (egptr() - gptr());
+    off_type target;
+
+    if (dir == std::ios_base::beg) {
+      target = off;
+    } else if (dir == std::ios_base::cur) {
+      if (off == 0) {
+        return pos_type(current);
+      }
+      target = current + off;
+    } else {
+      struct stat fileStat{};
+      if (fstat(descriptor, &fileStat) != 0) {
+        return pos_type(off_type(-1));
+      }
+      target = fileStat.st_size + off;
+    }
+
+    if (target < 0) {
+      return pos_type(off_type(-1));
+    }
+
+    // O_DIRECT reads have to start at an aligned offset
+    off_type start = direct ? target - target % static_cast<off_type>(DIRECT_ALIGNMENT) : target;
+    if (lseek(descriptor, start, SEEK_SET) != start) {
+      return pos_type(off_type(-1));
+    }
+
+    fileOffset = start;
+    skip = static_cast<size_t>(target - start);
+    setg(buffer, buffer, buffer);
+
+    return pos_type(target);
+  }
+
+  virtual pos_type seekpos(pos_type pos, std::ios_base::openmode which) {
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+  }
+
+public:
+  DescriptorStreamBuffer(int descriptor_, bool direct_, size_t bufferSize_) :
+          std::streambuf(),
+          descriptor(descriptor_),
+          direct(direct_),
+          buffer(nullptr),
+          bufferSize(std::max(DIRECT_ALIGNMENT, bufferSize_ - bufferSize_ % DIRECT_ALIGNMENT)),
+          fileOffset(0),
+          skip(0),
+          bytesRead(0),
+          secondsReading(0) {
+    void* memory = nullptr;
+    if (posix_memalign(&memory, DIRECT_ALIGNMENT, bufferSize) != 0) {
+      close(descriptor);
+      throw std::bad_alloc();
+    }
+
+    buffer = static_cast<char*>(memory);
+    setg(buffer, buffer, buffer);
+  }
+
+  DescriptorStreamBuffer(const DescriptorStreamBuffer& other) = delete;
+
+  DescriptorStreamBuffer& operator=(const DescriptorStreamBuffer& other) = delete;
+
+  virtual ~DescriptorStreamBuffer() {
+    std::free(buffer);
+    close(descriptor);
+  }
+
+  size_t getBytesRead() const noexcept {
+    return bytesRead;
+  }
+
+  double getSecondsReading() const noexcept {
+    return secondsReading;
+  }
+};
+
+constexpr size_t DescriptorStreamBuffer::DIRECT_ALIGNMENT;
+#else
+// Only std::ifstream is used to read files on Windows.
+class DescriptorStreamBuffer : public std::streambuf {
+public:
+  size_t getBytesRead() const noexcept { return 0; }
+
+  double getSecondsReading() const noexcept { return 0; }
+};
+#endif
+
+
+constexpr size_t InputFile::WHOLE_FILE_LIMIT;
+constexpr size_t InputFile::LARGE_BUFFER_SIZE;
+
+
 /*
   TODO: InputFile:InputFile(path)
 
@@ -53,13 +259,26 @@ std::string InputSource::getSource() const noexcept {
   @param path
     The complete path for a file to import.
 
+  @param strategy_
+    How to read the file, chosen from its size by default
+
   @example
     InputFile input("data/areas.csv");
 */
-InputFile::InputFile(std::string filePath) : InputSource(std::move(filePath)), inputStream() {
+InputFile::InputFile(std::string filePath, ReadStrategy strategy_) :
+        InputSource(std::move(filePath)),
+        strategy(strategy_),
+        inputStream(),
+        contents(),
+        contentsBuffer(),
+        descriptorBuffer(),
+        bufferStream(nullptr),
+        bytesRead(0),
+        secondsReading(0) {
 }
 
 
+// Defined here, as DescriptorStreamBuffer is incomplete in the header.
 InputFile::~InputFile() {
   if (inputStream.is_open()) {
     inputStream.close();
@@ -73,6 +292,10 @@ InputFile::~InputFile() {
   Open a file stream to the file path retrievable from getSource()
   and return a reference to the stream.
 
+  With ReadStrategy::Auto, regular files up to WHOLE_FILE_LIMIT bytes are
+  read with ReadStrategy::WholeFile, and anything else (larger files, or
+  e.g. pipes) with ReadStrategy::Buffered.
+
   @return
     A standard input stream reference
 
@@ -87,13 +310,2562 @@ InputFile::~InputFile() {
 std::istream& InputFile::open() noexcept(false) {
   if (inputStream.is_open()) {
     return inputStream;
+  } else if (bufferStream.rdbuf()) {
+    return bufferStream;
+  }
+
+#ifdef _WIN32
+  strategy = ReadStrategy::Stream;
+#endif
+
+  if (strategy == ReadStrategy::Stream) {
+    inputStream.open(getSource(), std::ifstream::in);
+
+    if (!inputStream) {
+      throw std::runtime_error("InputFile::open: Failed to open file " + getSource());
+    }
+
+    return inputStream;
+  }
+
+#ifndef _WIN32
+  int descriptor = -1;
+
+  if (strategy == ReadStrategy::Direct) {
+#ifdef O_DIRECT
+    descriptor = ::open(getSource().c_str(), O_RDONLY | O_DIRECT);
+
+    // Not every file system supports O_DIRECT (e.g. tmpfs)
+    if (descriptor < 0 && errno == EINVAL) {
+      strategy = ReadStrategy::Buffered;
+    }
+#else
+    strategy = ReadStrategy::Buffered;
+#endif
   }
 
-  inputStream.open(getSource(), std::ifstream::in);
+  if (descriptor < 0) {
+    descriptor = ::open(getSource().c_str(), O_RDONLY);
+  }
 
-  if (!inputStream) {
+  struct stat fileStat{};
+  if (descriptor < 0 || fstat(descriptor, &fileStat) != 0 || S_ISDIR(fileStat.st_mode)) {
+    if (descriptor >= 0) {
+      close(descriptor);
+    }
     throw std::runtime_error("InputFile::open: Failed to open file " + getSource());
   }
 
-  return inputStream;
-}
\ No newline at end of file
+  bool regularFile = S_ISREG(fileStat.st_mode);
+  size_t fileSize = static_cast<size_t>(fileStat.st_size);
+
+  if (strategy == ReadStrategy::Auto) {
+    strategy = regularFile && fileSize <= WHOLE_FILE_LIMIT ? ReadStrategy::WholeFile : ReadStrategy::Buffered;
+  }
+
+  if (strategy == ReadStrategy::WholeFile && regularFile) {
+    openWholeFile(descriptor, fileSize);
+    return bufferStream;
+  }
+
+  if (strategy == ReadStrategy::WholeFile) {
+    // We can't size the buffer up front for pipes and the like
+    strategy = ReadStrategy::Buffered;
+  }
+
+#ifdef POSIX_FADV_SEQUENTIAL
+  if (regularFile) {
+    posix_fadvise(descriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+    posix_fadvise(descriptor, 0, 0, POSIX_FADV_WILLNEED);
+  }
+#endif
+
+  descriptorBuffer.reset(new DescriptorStreamBuffer(descriptor, strategy == ReadStrategy::Direct, LARGE_BUFFER_SIZE));
+  bufferStream.rdbuf(descriptorBuffer.get());
+
+  // Rethrow read errors instead of quietly ending the stream
+  bufferStream.exceptions(std::ios::badbit);
+#endif
+
+  return bufferStream;
+}
+
+
+/*
+  Read a whole regular file into contents, with as few read()s as possible
+  (one, unless the file is over ~2GB), and close it.
+
+  @param descriptor
+    The open file, which is closed by this function
+
+  @param fileSize
+    The size of the file
+*/
+void InputFile::openWholeFile(int descriptor, size_t fileSize) noexcept(false) {
+#ifndef _WIN32
+  contents.resize(fileSize);
+
+  auto started = std::chrono::steady_clock::now();
+
+  while (bytesRead < fileSize) {
+    ssize_t count = ::read(descriptor, &contents[bytesRead], fileSize - bytesRead);
+
+    if (count < 0 && errno == EINTR) {
+      continue;
+    } else if (count < 0) {
+      close(descriptor);
+      throw std::runtime_error("InputFile: Failed to read from the file " + getSource());
+    } else if (count == 0) {
+      // The file shrank since we checked its size
+      contents.resize(bytesRead);
+      break;
+    }
+
+    bytesRead += static_cast<size_t>(count);
+  }
+
+  secondsReading = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+  close(descriptor);
+
+  contentsBuffer.reset({contents.data(), contents.size()});
+  bufferStream.rdbuf(&contentsBuffer);
+#endif
+}
+
+
+/*
+  The strategy the file is read with. Until the file is opened, this is the
+  strategy asked for, which may be ReadStrategy::Auto.
+*/
+InputFile::ReadStrategy InputFile::getStrategy() const noexcept {
+  return strategy;
+}
+
+
+/*
+  The number of bytes read from the file so far (not counting ones read with
+  ReadStrategy::Stream, which we can't see).
+*/
+size_t InputFile::getBytesRead() const noexcept {
+  return descriptorBuffer ? descriptorBuffer->getBytesRead() : bytesRead;
+}
+
+
+/*
+  How fast the file has been read so far, in bytes per second, counting only
+  the time spent waiting for the file to be read, and not the time spent
+  parsing it. This is 0 if nothing has been read (or measured).
+*/
+double InputFile::getBytesPerSecond() const noexcept {
+  double seconds = descriptorBuffer ? descriptorBuffer->getSecondsReading() : secondsReading;
+  size_t bytes = getBytesRead();
+
+  return seconds > 0 ? static_cast<double>(bytes) / seconds : 0;
+}
+
+
+/*
+  A short name for a strategy, for reporting (e.g. "whole-file").
+*/
+std::string InputFile::strategyName(ReadStrategy strategy) noexcept {
+  switch (strategy) {
+    case ReadStrategy::Auto:
+      return "auto";
+    case ReadStrategy::Stream:
+      return "stream";
+    case ReadStrategy::WholeFile:
+      return "whole-file";
+    case ReadStrategy::Buffered:
+      return "buffered";
+    case ReadStrategy::Direct:
+      return "direct";
+  }
+
+  return "unknown";
+}
+
+SpanStreamBuffer::SpanStreamBuffer() : std::streambuf() {}
+
+
+/*
+  Point the get area of the buffer at the characters of a span. The span must
+  outlive any stream reading from this buffer.
+
+  @param span
+    The characters to read from
+*/
+void SpanStreamBuffer::reset(const InputSpan& span) noexcept {
+  // streambuf only works with non-const pointers, but we never write to them
+  char* first = const_cast<char*>(span.begin());
+  char* last = const_cast<char*>(span.end());
+  setg(first, first, last);
+}
+
+
+std::streambuf::pos_type SpanStreamBuffer::seekoff(off_type off,
+                                                   std::ios_base::seekdir dir,
+                                                   std::ios_base::openmode which) {
+  if (!(which & std::ios_base::in)) {
+    return pos_type(off_type(-1));
+  }
+
+  off_type base;
+  if (dir == std::ios_base::beg) {
+    base = 0;
+  } else if (dir == std::ios_base::cur) {
+    base = gptr() - eback();
+  } else {
+    base = egptr() - eback();
+  }
+
+  off_type target = base + off;
+  if (target < 0 || target > egptr() - eback()) {
+    return pos_type(off_type(-1));
+  }
+
+  setg(eback(), eback() + target, egptr());
+  return pos_type(target);
+}
+
+
+std::streambuf::pos_type SpanStreamBuffer::seekpos(pos_type pos, std::ios_base::openmode which) {
+  return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+
+/*
+  Constructor for a memory mapped file-based source. The file is not opened
+  until span() or open() is called.
+
+  @param filePath
+    The complete path for a file to import.
+
+  @example
+    InputMappedFile input("data/popu1009.json");
+*/
+InputMappedFile::InputMappedFile(std::string filePath) :
+        InputSource(std::move(filePath)),
+        mapping(nullptr),
+        mappingSize(0),
+        fallbackContents(),
+        mapped(false),
+        spanBuffer(),
+        spanStream(&spanBuffer) {}
+
+
+InputMappedFile::~InputMappedFile() {
+#ifndef _WIN32
+  if (mapping != nullptr) {
+    munmap(mapping, mappingSize);
+  }
+#endif
+}
+
+
+/*
+  Map the file at getSource() into memory, read-only. Empty files cannot be
+  mapped, so they are left as an empty span.
+
+  A file that can't be opened is reported in the same way as by InputFile,
+  which the mapped file stands in for.
+
+  @throws
+    std::runtime_error if the file can't be opened, with the message:
+    InputFile::open: Failed to open file <file name>
+    or if it can't be mapped, with the message:
+    InputMappedFile::open: Failed to map file <file name> (<reason>)
+*/
+void InputMappedFile::map() noexcept(false) {
+  if (mapped) {
+    return;
+  }
+
+  const std::string failMessage = "InputFile::open: Failed to open file " + getSource();
+
+#ifdef _WIN32
+  // No mmap() here, so read the file in a single go instead.
+  std::ifstream file(getSource(), std::ifstream::in | std::ifstream::binary);
+  if (!file) {
+    throw std::runtime_error(failMessage);
+  }
+
+  fallbackContents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+#else
+  int fileDescriptor = ::open(getSource().c_str(), O_RDONLY);
+  if (fileDescriptor < 0) {
+    throw std::runtime_error(failMessage);
+  }
+
+  auto mapError = [this](const std::string& reason) {
+    return std::runtime_error("InputMappedFile::open: Failed to map file " + getSource() + " (" + reason + ")");
+  };
+
+  struct stat fileStat{};
+  if (fstat(fileDescriptor, &fileStat) != 0) {
+    const int error = errno;
+    close(fileDescriptor);
+    throw mapError(std::strerror(error));
+  }
+
+  if (S_ISDIR(fileStat.st_mode)) {
+    close(fileDescriptor);
+    throw std::runtime_error(failMessage);
+  }
+
+  if (!S_ISREG(fileStat.st_mode)) {
+    close(fileDescriptor);
+    throw mapError("not a regular file");
+  }
+
+  size_t fileSize = static_cast<size_t>(fileStat.st_size);
+
+  if (fileSize > 0) {
+    void* address = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    if (address == MAP_FAILED) {
+      const int error = errno;
+      close(fileDescriptor);
+      throw mapError(std::strerror(error));
+    }
+
+    mapping = address;
+    mappingSize = fileSize;
+
+    // Only a hint, so ignore any failure.
+    madvise(mapping, mappingSize, MADV_SEQUENTIAL);
+  }
+
+  // The mapping stays valid after the descriptor is closed.
+  close(fileDescriptor);
+#endif
+
+  mapped = true;
+  spanBuffer.reset(span());
+}
+
+
+/*
+  Retrieve the whole contents of the file as a contiguous span of characters.
+  The span stays valid for as long as this InputMappedFile exists.
+
+  @return
+    An InputSpan over the contents of the file
+
+  @throws
+    std::runtime_error if the file can't be opened, with the message:
+    InputFile::open: Failed to open file <file name>
+    or if it can't be mapped, with the message:
+    InputMappedFile::open: Failed to map file <file name> (<reason>)
+
+  @example
+    InputMappedFile input("data/popu1009.json");
+    InputSpan contents = input.span();
+*/
+InputSpan InputMappedFile::span() noexcept(false) {
+  map();
+
+  if (mapping != nullptr) {
+    return {static_cast<const char*>(mapping), mappingSize};
+  }
+
+  // Never hand out a null pointer, even for empty files.
+  return {fallbackContents.c_str(), fallbackContents.size()};
+}
+
+
+/*
+  Open a stream that reads from the mapped file. Unlike InputFile, no further
+  copies are made into a stream buffer.
+
+  @return
+    A standard input stream reference
+
+  @throws
+    std::runtime_error if the file can't be opened, with the message:
+    InputFile::open: Failed to open file <file name>
+    or if it can't be mapped, with the message:
+    InputMappedFile::open: Failed to map file <file name> (<reason>)
+
+  @example
+    InputMappedFile input("data/areas.csv");
+    input.open();
+*/
+std::istream& InputMappedFile::open() noexcept(false) {
+  map();
+  return spanStream;
+}
+
+
+
+/*
+  A stream buffer that decompresses data from another (compressed) stream
+  as it is read. The compressed data is read in chunks of a fixed size, and
+  decompressed into a fixed size buffer that is reused once the reader has
+  consumed it, so the memory used does not depend on the size of the file.
+
+  Derived classes only need to implement decompress() for their format.
+*/
+class DecompressingStreamBuffer : public std::streambuf {
+protected:
+  std::istream& source;
+  std::vector<char> compressed;
+  std::vector<char> decompressed;
+
+  // Read the next chunk of compressed data from the source into compressed.
+  size_t readChunk() {
+    source.read(compressed.data(), compressed.size());
+    return static_cast<size_t>(source.gcount());
+  }
+
+  // Fill the decompressed buffer. Returns the number of characters produced,
+  // where 0 means that the end of the data has been reached.
+  virtual size_t decompress() noexcept(false) = 0;
+
+  virtual int_type underflow() {
+    if (gptr() < egptr()) {
+      return traits_type::to_int_type(*gptr());
+    }
+
+    size_t produced = decompress();
+    if (produced == 0) {
+      return traits_type::eof();
+    }
+
+    setg(decompressed.data(), decompressed.data(), decompressed.data() + produced);
+    return traits_type::to_int_type(*gptr());
+  }
+
+public:
+  explicit DecompressingStreamBuffer(std::istream& source_) :
+          source(source_),
+          compressed(InputCompressedFile::COMPRESSED_CHUNK_SIZE),
+          decompressed(InputCompressedFile::DECOMPRESSED_BUFFER_SIZE) {}
+
+  virtual ~DecompressingStreamBuffer() = default;
+};
+
+
+namespace {
+  /*
+    Decompresses gzip files (or zlib streams) with zlib. Files made from
+    several concatenated gzip members (e.g. by pigz or cat) are supported.
+  */
+  class GzipStreamBuffer : public DecompressingStreamBuffer {
+  private:
+    z_stream stream;
+    bool finished;
+
+    // Whether we are part way through a gzip member, i.e. its end is still expected.
+    bool memberOpen;
+
+  protected:
+    virtual size_t decompress() noexcept(false) {
+      stream.next_out = reinterpret_cast<Bytef*>(decompressed.data());
+      stream.avail_out = static_cast<uInt>(decompressed.size());
+
+      while (!finished && stream.avail_out > 0) {
+        if (stream.avail_in == 0) {
+          size_t read = readChunk();
+          if (read == 0) {
+            if (memberOpen) {
+              throw std::runtime_error("InputCompressedFile: Unexpected end of gzip data");
+            }
+
+            finished = true;
+            break;
+          }
+
+          stream.next_in = reinterpret_cast<Bytef*>(compressed.data());
+          stream.avail_in = static_cast<uInt>(read);
+        }
+
+        memberOpen = true;
+        int result = inflate(&stream, Z_NO_FLUSH);
+
+        if (result == Z_STREAM_END) {
+          memberOpen = false;
+
+          // Another gzip member may follow this one.
+          if (stream.avail_in == 0 && source.peek() == std::char_traits<char>::eof()) {
+            finished = true;
+          } else {
+            inflateReset(&stream);
+          }
+        } else if (result != Z_OK && result != Z_BUF_ERROR) {
+          throw std::runtime_error("InputCompressedFile: Invalid gzip data: " +
+                                   std::string(stream.msg != nullptr ? stream.msg : "unknown error"));
+        }
+      }
+
+      return decompressed.size() - stream.avail_out;
+    }
+
+  public:
+    explicit GzipStreamBuffer(std::istream& source_) : DecompressingStreamBuffer(source_),
+                                                         stream(),
+                                                         finished(false),
+                                                         memberOpen(false) {
+      // 15 is the largest window size, and adding 32 detects gzip or zlib headers
+      if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+        throw std::runtime_error("InputCompressedFile: Failed to initialise zlib");
+      }
+    }
+
+    virtual ~GzipStreamBuffer() {
+      inflateEnd(&stream);
+    }
+  };
+
+#ifdef BETHYW_WITH_ZSTD
+  /*
+    Decompresses Zstandard files with libzstd's streaming API.
+  */
+  class ZstdStreamBuffer : public DecompressingStreamBuffer {
+  private:
+    ZSTD_DStream* stream;
+    ZSTD_inBuffer input;
+    bool finished;
+    bool frameOpen;
+
+  protected:
+    virtual size_t decompress() noexcept(false) {
+      ZSTD_outBuffer output = {decompressed.data(), decompressed.size(), 0};
+
+      while (!finished && output.pos < output.size) {
+        if (input.pos == input.size) {
+          size_t read = readChunk();
+          if (read == 0) {
+            if (frameOpen) {
+              throw std::runtime_error("InputCompressedFile: Unexpected end of zstd data");
+            }
+
+            finished = true;
+            break;
+          }
+
+          input = {compressed.data(), read, 0};
+        }
+
+        size_t result = ZSTD_decompressStream(stream, &output, &input);
+        if (ZSTD_isError(result)) {
+          throw std::runtime_error("InputCompressedFile: Invalid zstd data: " +
+                                   std::string(ZSTD_getErrorName(result)));
+        }
+
+        // 0 is only returned once a frame has been completely decoded
+        frameOpen = result != 0;
+      }
+
+      return output.pos;
+    }
+
+  public:
+    explicit ZstdStreamBuffer(std::istream& source_) :
+            DecompressingStreamBuffer(source_),
+            stream(ZSTD_createDStream()),
+            input({nullptr, 0, 0}),
+            finished(false),
+            frameOpen(false) {
+      if (stream == nullptr) {
+        throw std::runtime_error("InputCompressedFile: Failed to initialise zstd");
+      }
+
+      ZSTD_initDStream(stream);
+    }
+
+    virtual ~ZstdStreamBuffer() {
+      ZSTD_freeDStream(stream);
+    }
+  };
+#endif
+
+  bool endsWith(const std::string& str, const std::string& suffix) {
+    return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+  }
+
+  bool startsWith(const std::string& str, const std::string& prefix) {
+    return str.compare(0, prefix.size(), prefix) == 0;
+  }
+} // end of anonymous namespace
+
+
+constexpr size_t InputCompressedFile::COMPRESSED_CHUNK_SIZE;
+constexpr size_t InputCompressedFile::DECOMPRESSED_BUFFER_SIZE;
+
+
+/*
+  Constructor for a compressed file-based source. The compression format is
+  picked from the extension of the path (.gz or .zst).
+
+  @param filePath
+    The complete path for a compressed file to import.
+
+  @example
+    InputCompressedFile input("data/popu1009.json.gz");
+*/
+InputCompressedFile::InputCompressedFile(std::string filePath) :
+        InputSource(std::move(filePath)),
+        compressedStream(),
+        decompressor(),
+        decompressedStream(nullptr) {}
+
+
+// Defined here, as DecompressingStreamBuffer is incomplete in the header.
+InputCompressedFile::~InputCompressedFile() = default;
+
+
+/*
+  Check if a file path refers to a compressed file we can read, based on its
+  extension.
+
+  @param filePath
+    The path to check
+
+  @return
+    true if the path ends with .gz or .zst, false otherwise
+*/
+bool InputCompressedFile::isCompressedFile(const std::string& filePath) noexcept {
+  return ::endsWith(filePath, ".gz") || ::endsWith(filePath, ".zst");
+}
+
+
+/*
+  Open the compressed file and return a stream of its decompressed contents.
+  Errors in the compressed data are thrown as exceptions from the stream
+  while it is read.
+
+  @return
+    A standard input stream reference
+
+  @throws
+    std::runtime_error if there is an issue opening the file, with the message:
+    InputCompressedFile::open: Failed to open file <file name>
+    or if the compression format is not supported by this build.
+
+  @example
+    InputCompressedFile input("data/popu1009.json.gz");
+    input.open();
+*/
+std::istream& InputCompressedFile::open() noexcept(false) {
+  if (decompressor) {
+    return decompressedStream;
+  }
+
+  compressedStream.open(getSource(), std::ifstream::in | std::ifstream::binary);
+
+  if (!compressedStream) {
+    throw std::runtime_error("InputCompressedFile::open: Failed to open file " + getSource());
+  }
+
+  if (::endsWith(getSource(), ".zst")) {
+#ifdef BETHYW_WITH_ZSTD
+    decompressor.reset(new ZstdStreamBuffer(compressedStream));
+#else
+    throw std::runtime_error("InputCompressedFile::open: Zstandard support is not enabled, cannot open file " +
+                             getSource());
+#endif
+  } else {
+    decompressor.reset(new GzipStreamBuffer(compressedStream));
+  }
+
+  decompressedStream.rdbuf(decompressor.get());
+
+  // Rethrow errors in the compressed data instead of quietly ending the stream
+  decompressedStream.exceptions(std::ios::badbit);
+
+  return decompressedStream;
+}
+
+
+
+namespace {
+  /*
+    Read a whole page of a paged source into memory, decompressing it if
+    needed, or fetch it if it is an http:// URL.
+  */
+  std::string readPage(const std::string& pagePath, const std::string& httpCacheDir, unsigned int httpConnections) {
+    std::string contents;
+
+    if (InputHttpFile::isHttpUrl(pagePath)) {
+      InputHttpFile file(pagePath, httpCacheDir,
+                         httpConnections == 0 ? InputHttpFile::DEFAULT_CONNECTIONS : httpConnections);
+      const InputSpan body = file.span();
+      contents.assign(body.data, body.size);
+      return contents;
+    }
+
+    if (InputCompressedFile::isCompressedFile(pagePath)) {
+      InputCompressedFile file(pagePath);
+      std::istream& stream = file.open();
+      contents.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+      return contents;
+    }
+
+    std::ifstream file(pagePath, std::ifstream::in | std::ifstream::binary);
+    if (!file) {
+      throw std::runtime_error("InputPagedFile::open: Failed to open file " + pagePath);
+    }
+
+    file.seekg(0, std::ios::end);
+    contents.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0, std::ios::beg);
+    file.read(&contents[0], contents.size());
+
+    return contents;
+  }
+
+  bool fileExists(const std::string& filePath) {
+    return std::ifstream(filePath).is_open();
+  }
+} // end of anonymous namespace
+
+
+/*
+  Constructor for a paged source. No page is read until nextPage() or
+  open() is called.
+
+  @param firstPagePath
+    The complete path of the first page, or its http:// URL
+
+  @param httpCacheDir_
+    The directory to cache pages fetched over HTTP in, or an empty string to
+    not cache them (see InputHttpFile)
+
+  @param httpConnections_
+    The largest number of connections to fetch each page over at once, or 0
+    for InputHttpFile's default
+
+  @example
+    InputPagedFile input("data/popu1009.json");
+*/
+InputPagedFile::InputPagedFile(std::string firstPagePath, std::string httpCacheDir_, unsigned int httpConnections_) :
+        InputSource(std::move(firstPagePath)),
+        httpCacheDir(std::move(httpCacheDir_)),
+        httpConnections(httpConnections_),
+        currentPage(),
+        nextPageContents(),
+        pageNumber(0),
+        hasNextPage(true),
+        pageBuffer(),
+        pageStream(&pageBuffer) {}
+
+
+// A page that is still being read is waited for by the std::future.
+InputPagedFile::~InputPagedFile() = default;
+
+
+/*
+  Find the odata.nextLink value in a page of StatsWales JSON without parsing
+  the page. The link comes after the value array, so we search backwards
+  from the end of the page.
+
+  @param page
+    The contents of a page
+
+  @return
+    The link to the next page, or an empty string if this is the last page
+*/
+std::string InputPagedFile::findNextLink(const InputSpan& page) {
+  const std::string KEY = "\"odata.nextLink\"";
+
+  if (page.size < KEY.size()) {
+    return std::string();
+  }
+
+  const char* keyStart = nullptr;
+  for (size_t offset = page.size - KEY.size() + 1; offset > 0; offset--) {
+    if (std::memcmp(page.data + offset - 1, KEY.data(), KEY.size()) == 0) {
+      keyStart = page.data + offset - 1;
+      break;
+    }
+  }
+
+  if (keyStart == nullptr) {
+    return std::string();
+  }
+
+  const char* it = keyStart + KEY.size();
+  while (it < page.end() && (std::isspace(*it) || *it == ':')) {
+    it++;
+  }
+
+  if (it == page.end() || *it != '"') {
+    return std::string();
+  }
+
+  // Copy the string value, undoing the escapes that can appear in a URL
+  std::string link;
+  for (it++; it < page.end() && *it != '"'; it++) {
+    if (*it == '\\' && it + 1 < page.end()) {
+      it++;
+    }
+
+    link += *it;
+  }
+
+  return link;
+}
+
+
+/*
+  Work out the path of the page a nextLink refers to. See the class comment
+  for how links are mapped to files.
+
+  @throws
+    std::runtime_error if the page cannot be found
+*/
+std::string InputPagedFile::resolveNextLink(const std::string& nextLink, unsigned int nextPageNumber) const
+noexcept(false) {
+  const std::string& firstPage = getSource();
+
+  size_t nameStart = firstPage.find_last_of("/\\");
+  std::string directory = nameStart == std::string::npos ? "" : firstPage.substr(0, nameStart + 1);
+
+  if (::startsWith(nextLink, "file://")) {
+    return nextLink.substr(std::strlen("file://"));
+  }
+
+  const bool fetched = InputHttpFile::isHttpUrl(firstPage);
+
+  if (nextLink.find("://") == std::string::npos) {
+    if (fetched && nextLink[0] == '/') {
+      // Relative to the root of the server the first page came from
+      return firstPage.substr(0, firstPage.find('/', std::strlen("http://"))) + nextLink;
+    }
+
+    return nextLink[0] == '/' ? nextLink : directory + nextLink;
+  }
+
+  if (fetched && InputHttpFile::isHttpUrl(nextLink)) {
+    return nextLink;
+  }
+
+  // Number the page, keeping the file's extensions
+  // e.g. popu1009.json.gz -> popu1009.page-2.json.gz
+  size_t extensionStart = firstPage.find('.', nameStart == std::string::npos ? 0 : nameStart + 1);
+  if (extensionStart == std::string::npos) {
+    extensionStart = firstPage.size();
+  }
+
+  std::string numberedPage = firstPage.substr(0, extensionStart) + ".page-" + std::to_string(nextPageNumber) +
+                             firstPage.substr(extensionStart);
+
+  if (fetched) {
+    // e.g. an https:// link to the StatsWales API, from a mirror of it
+    return numberedPage;
+  }
+
+  for (const char* extension : {"", ".gz", ".zst"}) {
+    if (::fileExists(numberedPage + extension)) {
+      return numberedPage + extension;
+    }
+  }
+
+  throw std::runtime_error("InputPagedFile: Page " + std::to_string(nextPageNumber) + " of " + firstPage +
+                           " was not found locally (expected " + numberedPage + ") for " + nextLink);
+}
+
+
+/*
+  Move on to the next page. The first call reads the first page. As soon
+  as a page is available, the page after it starts being read in the
+  background.
+
+  @return
+    true if there was another page, false once all pages have been read
+
+  @throws
+    std::runtime_error if a page could not be read
+
+  @example
+    InputPagedFile input("data/popu1009.json");
+    while (input.nextPage()) {
+      areas.populate(input.page(), ...);
+    }
+*/
+bool InputPagedFile::nextPage() noexcept(false) {
+  if (!hasNextPage) {
+    return false;
+  }
+
+  if (pageNumber == 0) {
+    currentPage = ::readPage(getSource(), httpCacheDir, httpConnections);
+  } else {
+    currentPage = nextPageContents.get();
+  }
+
+  pageNumber++;
+
+  std::string nextLink = findNextLink(page());
+  hasNextPage = !nextLink.empty();
+
+  if (hasNextPage) {
+    unsigned int nextPageNumber = pageNumber + 1;
+    nextPageContents = std::async(std::launch::async, [this, nextLink, nextPageNumber]() {
+      return ::readPage(resolveNextLink(nextLink, nextPageNumber), httpCacheDir, httpConnections);
+    });
+  }
+
+  pageBuffer.reset(page());
+  pageStream.clear();
+
+  return true;
+}
+
+
+/*
+  The number of the current page, starting from 1 (or 0 before the first
+  page has been read).
+*/
+unsigned int InputPagedFile::getPageNumber() const noexcept {
+  return pageNumber;
+}
+
+
+/*
+  The contents of the current page, valid until nextPage() is called again.
+*/
+InputSpan InputPagedFile::page() const noexcept {
+  return {currentPage.c_str(), currentPage.size()};
+}
+
+
+/*
+  Open a stream over the current page, reading the first page if no page has
+  been read yet.
+
+  @return
+    A standard input stream reference
+
+  @throws
+    std::runtime_error if there is an issue opening the first page, with the
+    message: InputPagedFile::open: Failed to open file <file name>
+*/
+std::istream& InputPagedFile::open() noexcept(false) {
+  if (pageNumber == 0) {
+    nextPage();
+  }
+
+  return pageStream;
+}
+
+
+
+/*
+  A stream buffer that is filled by a background thread. The thread reads the
+  file into whichever buffers the reader is not using, and hands them over in
+  order. The reader returns each buffer once it has been consumed, so the
+  thread is never more than `depth` buffers ahead.
+*/
+class ReadAheadStreamBuffer : public std::streambuf {
+private:
+  std::ifstream file;
+  std::vector<std::vector<char>> buffers;
+
+  // Indexes of the buffers that are filledBuffers (with their sizes) and freeBuffers
+  std::deque<std::pair<size_t, size_t>> filledBuffers;
+  std::deque<size_t> freeBuffers;
+
+  // The buffer the reader is currently consuming
+  bool hasCurrent;
+  size_t current;
+
+  bool finished;
+  bool stopping;
+  std::exception_ptr error;
+
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::thread readerThread;
+
+  void readFile() noexcept {
+    try {
+      while (true) {
+        size_t index;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          changed.wait(lock, [this]() { return stopping || !freeBuffers.empty(); });
+
+          if (stopping) {
+            return;
+          }
+
+          index = freeBuffers.front();
+          freeBuffers.pop_front();
+        }
+
+        // Read without holding the lock, so the parser can carry on
+        std::vector<char>& buffer = buffers[index];
+        file.read(buffer.data(), buffer.size());
+        size_t read = static_cast<size_t>(file.gcount());
+
+        if (file.bad()) {
+          throw std::runtime_error("InputReadAheadFile: Failed to read from file");
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (read > 0) {
+          filledBuffers.emplace_back(index, read);
+        }
+
+        if (read < buffer.size()) {
+          finished = true;
+        }
+
+        changed.notify_all();
+
+        if (finished) {
+          return;
+        }
+      }
+    }
+    catch (...) {
+      std::lock_guard<std::mutex> lock(mutex);
+      error = std::current_exception();
+      finished = true;
+      changed.notify_all();
+    }
+  }
+
+protected:
+  virtual int_type underflow() {
+    if (gptr() < egptr()) {
+      return traits_type::to_int_type(*gptr());
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    // Give the buffer we have finished with back to the reading thread
+    if (hasCurrent) {
+      freeBuffers.push_back(current);
+      hasCurrent = false;
+      changed.notify_all();
+    }
+
+    changed.wait(lock, [this]() { return finished || !filledBuffers.empty(); });
+
+    if (filledBuffers.empty()) {
+      if (error) {
+        std::rethrow_exception(error);
+      }
+
+      return traits_type::eof();
+    }
+
+    current = filledBuffers.front().first;
+    size_t size = filledBuffers.front().second;
+    filledBuffers.pop_front();
+    hasCurrent = true;
+
+    char* data = buffers[current].data();
+    setg(data, data, data + size);
+
+    return traits_type::to_int_type(*gptr());
+  }
+
+public:
+  ReadAheadStreamBuffer(const std::string& filePath, size_t bufferSize, unsigned int depth) :
+          file(filePath, std::ifstream::in | std::ifstream::binary),
+          buffers(),
+          filledBuffers(),
+          freeBuffers(),
+          hasCurrent(false),
+          current(0),
+          finished(false),
+          stopping(false),
+          error(),
+          mutex(),
+          changed(),
+          readerThread() {
+    if (!file) {
+      // Reported in the same way as by InputFile, which this stands in for
+      throw std::runtime_error("InputFile::open: Failed to open file " + filePath);
+    }
+
+    // The reader holds one buffer while the thread fills the others,
+    // so we need at least two for any reading ahead to happen.
+    depth = std::max(2u, depth);
+    bufferSize = std::max(static_cast<size_t>(1), bufferSize);
+
+    for (unsigned int i = 0; i < depth; i++) {
+      buffers.emplace_back(bufferSize);
+      freeBuffers.push_back(i);
+    }
+
+    readerThread = std::thread(&ReadAheadStreamBuffer::readFile, this);
+  }
+
+  virtual ~ReadAheadStreamBuffer() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+      changed.notify_all();
+    }
+
+    readerThread.join();
+  }
+};
+
+
+constexpr size_t InputReadAheadFile::DEFAULT_BUFFER_SIZE;
+constexpr unsigned int InputReadAheadFile::DEFAULT_DEPTH;
+
+
+/*
+  Constructor for a read ahead file-based source. The file is not opened
+  until open() is called.
+
+  @param filePath
+    The complete path for a file to import.
+
+  @param bufferSize_
+    The size of each buffer, in bytes
+
+  @param depth_
+    The number of buffers (at least 2)
+
+  @example
+    InputReadAheadFile input("data/popu1009.json", 4 * 1024 * 1024, 3);
+*/
+InputReadAheadFile::InputReadAheadFile(std::string filePath, size_t bufferSize_, unsigned int depth_) :
+        InputSource(std::move(filePath)),
+        bufferSize(bufferSize_),
+        depth(depth_),
+        readAhead(),
+        readAheadStream(nullptr) {}
+
+
+// Defined here, as ReadAheadStreamBuffer is incomplete in the header.
+InputReadAheadFile::~InputReadAheadFile() = default;
+
+
+/*
+  Open the file and start reading it on the background thread.
+
+  @return
+    A standard input stream reference
+
+  @throws
+    std::runtime_error if there is an issue opening the file, with the message:
+    InputFile::open: Failed to open file <file name>
+
+  @example
+    InputReadAheadFile input("data/areas.csv");
+    input.open();
+*/
+std::istream& InputReadAheadFile::open() noexcept(false) {
+  if (readAhead) {
+    return readAheadStream;
+  }
+
+  readAhead.reset(new ReadAheadStreamBuffer(getSource(), bufferSize, depth));
+  readAheadStream.rdbuf(readAhead.get());
+
+  // Rethrow read errors instead of quietly ending the stream
+  readAheadStream.exceptions(std::ios::badbit);
+
+  return readAheadStream;
+}
+
+
+
+/*
+  The shared state of the two ways of reading an InputFileBatch: the
+  contents of each file, and whether it has been read yet (or failed).
+*/
+class BatchReader {
+protected:
+  const std::vector<std::string>& filePaths;
+  std::vector<std::string> contents;
+  std::vector<bool> ready;
+  std::vector<std::exception_ptr> errors;
+
+public:
+  explicit BatchReader(const std::vector<std::string>& filePaths_) :
+          filePaths(filePaths_),
+          contents(filePaths_.size()),
+          ready(filePaths_.size(), false),
+          errors(filePaths_.size()) {}
+
+  virtual ~BatchReader() = default;
+
+  virtual bool isUsingIoUring() const noexcept = 0;
+
+  // Block until the file at index has been read (or failed)
+  virtual void waitFor(size_t index) noexcept(false) = 0;
+
+  InputSpan wait(size_t index) noexcept(false) {
+    waitFor(index);
+
+    if (errors[index]) {
+      std::rethrow_exception(errors[index]);
+    }
+
+    return {contents[index].c_str(), contents[index].size()};
+  }
+
+  void release(size_t index) noexcept {
+    std::string().swap(contents[index]);
+  }
+};
+
+
+namespace {
+  std::runtime_error batchOpenError(const std::string& filePath) {
+    return std::runtime_error("InputFileBatch::open: Failed to open file " + filePath);
+  }
+
+
+  /*
+    Reads the files of a batch with a pool of threads, each reading whole
+    files one after another.
+  */
+  class ThreadPoolBatchReader : public BatchReader {
+  private:
+    std::atomic<size_t> nextFile;
+    std::mutex mutex;
+    std::condition_variable fileRead;
+    std::vector<std::thread> threads;
+
+    void readFiles() noexcept {
+      for (size_t i = nextFile++; i < filePaths.size(); i = nextFile++) {
+        std::exception_ptr error;
+        std::string fileContents;
+
+        try {
+          std::ifstream file(filePaths[i], std::ifstream::in | std::ifstream::binary);
+          if (!file) {
+            throw ::batchOpenError(filePaths[i]);
+          }
+
+          fileContents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        catch (...) {
+          error = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        contents[i] = std::move(fileContents);
+        errors[i] = error;
+        ready[i] = true;
+        fileRead.notify_all();
+      }
+    }
+
+  public:
+    ThreadPoolBatchReader(const std::vector<std::string>& filePaths_, unsigned int numThreads) :
+            BatchReader(filePaths_),
+            nextFile(0),
+            mutex(),
+            fileRead(),
+            threads() {
+      size_t count = std::min(static_cast<size_t>(std::max(1u, numThreads)), filePaths.size());
+
+      for (size_t i = 0; i < count; i++) {
+        threads.emplace_back(&ThreadPoolBatchReader::readFiles, this);
+      }
+    }
+
+    virtual ~ThreadPoolBatchReader() {
+      for (std::thread& thread : threads) {
+        thread.join();
+      }
+    }
+
+    virtual bool isUsingIoUring() const noexcept {
+      return false;
+    }
+
+    virtual void waitFor(size_t index) noexcept(false) {
+      std::unique_lock<std::mutex> lock(mutex);
+      fileRead.wait(lock, [this, index]() { return static_cast<bool>(ready[index]); });
+    }
+  };
+
+#ifdef BETHYW_IO_URING
+  /*
+    Reads the files of a batch with io_uring. Every file is opened and its
+    read submitted up front; completions are then collected by the thread
+    calling waitFor(), so no extra threads are needed. A read that
+    completes short (e.g. files over ~2GB) is resubmitted for the rest.
+  */
+  class IoUringBatchReader : public BatchReader {
+  private:
+    // The largest read we ask for at once, as Linux caps single reads
+    static constexpr size_t MAX_READ_SIZE = 1 << 30;
+    static constexpr unsigned int MAX_ENTRIES = 64;
+
+    int ringDescriptor;
+    io_uring_params params;
+
+    void* submissionRing;
+    size_t submissionRingSize;
+    void* completionRing;
+    size_t completionRingSize;
+    io_uring_sqe* submissionEntries;
+
+    unsigned* submissionTail;
+    unsigned* submissionMask;
+    unsigned* submissionArray;
+    unsigned* completionHead;
+    unsigned* completionTail;
+    unsigned* completionMask;
+    io_uring_cqe* completionEntries;
+
+    std::vector<int> descriptors;
+    std::vector<size_t> bytesRead;
+
+    // Files (or the rest of them) waiting for a free submission entry
+    std::deque<size_t> waiting;
+    unsigned int inFlight;
+    unsigned int unsubmitted;
+    unsigned int queued;
+
+    void fail(size_t index, std::exception_ptr error) {
+      errors[index] = error;
+      finish(index);
+    }
+
+    void finish(size_t index) {
+      if (descriptors[index] >= 0) {
+        close(descriptors[index]);
+        descriptors[index] = -1;
+      }
+
+      ready[index] = true;
+    }
+
+    // Queue reads for as many waiting files as there are free entries
+    void queueReads() {
+      while (!waiting.empty() && inFlight + unsubmitted + queued < params.sq_entries) {
+        size_t index = waiting.front();
+        waiting.pop_front();
+
+        unsigned tail = *submissionTail + queued;
+        unsigned slot = tail & *submissionMask;
+
+        size_t remaining = contents[index].size() - bytesRead[index];
+
+        io_uring_sqe& entry = submissionEntries[slot];
+        std::memset(&entry, 0, sizeof(entry));
+        entry.opcode = IORING_OP_READ;
+        entry.fd = descriptors[index];
+        entry.addr = reinterpret_cast<unsigned long long>(&contents[index][0] + bytesRead[index]);
+        entry.len = static_cast<unsigned>(std::min(remaining, MAX_READ_SIZE));
+        entry.off = bytesRead[index];
+        entry.user_data = index;
+
+        submissionArray[slot] = slot;
+        queued++;
+      }
+    }
+
+    /*
+      Submit the queued reads, and wait for at least minComplete completions.
+      io_uring_enter may submit fewer entries than it is given (and then
+      doesn't wait), so it is called until all of them have been submitted.
+    */
+    void submitAndWait(unsigned int minComplete) {
+      // Publish the new entries before telling the kernel about them
+      __atomic_store_n(submissionTail, *submissionTail + queued, __ATOMIC_RELEASE);
+
+      unsubmitted += queued;
+      queued = 0;
+
+      while (true) {
+        long result = syscall(__NR_io_uring_enter, ringDescriptor, unsubmitted, minComplete,
+                              IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (result < 0) {
+          if (errno != EINTR) {
+            throw std::runtime_error("InputFileBatch: io_uring_enter failed");
+          }
+          continue;
+        }
+
+        const unsigned int submitted = static_cast<unsigned int>(result);
+        inFlight += submitted;
+        unsubmitted -= submitted;
+
+        if (unsubmitted == 0) {
+          return;
+        }
+
+        if (submitted == 0) {
+          throw std::runtime_error("InputFileBatch: io_uring_enter did not submit any reads");
+        }
+      }
+    }
+
+    void reapCompletions() {
+      unsigned head = *completionHead;
+      unsigned tail = __atomic_load_n(completionTail, __ATOMIC_ACQUIRE);
+
+      for (; head != tail; head++) {
+        const io_uring_cqe& completion = completionEntries[head & *completionMask];
+        size_t index = static_cast<size_t>(completion.user_data);
+        inFlight--;
+
+        if (completion.res < 0) {
+          fail(index, std::make_exception_ptr(
+                  std::runtime_error("InputFileBatch: Failed to read file " + filePaths[index])));
+        } else if (completion.res == 0) {
+          // The file shrank since we checked its size
+          contents[index].resize(bytesRead[index]);
+          finish(index);
+        } else {
+          bytesRead[index] += static_cast<size_t>(completion.res);
+
+          if (bytesRead[index] < contents[index].size()) {
+            waiting.push_back(index);
+          } else {
+            finish(index);
+          }
+        }
+      }
+
+      __atomic_store_n(completionHead, head, __ATOMIC_RELEASE);
+    }
+
+  public:
+    IoUringBatchReader(const std::vector<std::string>& filePaths_, int ringDescriptor_,
+                       const io_uring_params& params_) :
+            BatchReader(filePaths_),
+            ringDescriptor(ringDescriptor_),
+            params(params_),
+            submissionRing(MAP_FAILED),
+            submissionRingSize(params.sq_off.array + params.sq_entries * sizeof(unsigned)),
+            completionRing(MAP_FAILED),
+            completionRingSize(params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe)),
+            submissionEntries(static_cast<io_uring_sqe*>(MAP_FAILED)),
+            submissionTail(nullptr),
+            submissionMask(nullptr),
+            submissionArray(nullptr),
+            completionHead(nullptr),
+            completionTail(nullptr),
+            completionMask(nullptr),
+            completionEntries(nullptr),
+            descriptors(filePaths_.size(), -1),
+            bytesRead(filePaths_.size(), 0),
+            waiting(),
+            inFlight(0),
+            unsubmitted(0),
+            queued(0) {
+      // The destructor isn't run if the constructor throws, so the ring (and
+      // anything else set up by then) is torn down here instead
+      try {
+        setUp();
+      }
+      catch (const std::exception& ex) {
+        tearDown();
+        throw;
+      }
+    }
+
+    virtual ~IoUringBatchReader() {
+      tearDown();
+    }
+
+    virtual bool isUsingIoUring() const noexcept {
+      return true;
+    }
+
+    virtual void waitFor(size_t index) noexcept(false) {
+      while (!ready[index]) {
+        queueReads();
+        submitAndWait(1);
+        reapCompletions();
+      }
+    }
+
+    /*
+      Set up an io_uring instance, or return a null pointer if io_uring
+      (with IORING_OP_READ, added in Linux 5.6) is not available, or the
+      instance can't be set up.
+    */
+    static std::unique_ptr<BatchReader> create(const std::vector<std::string>& filePaths) {
+      io_uring_params params{};
+      unsigned int entries = static_cast<unsigned int>(std::min(filePaths.size(), static_cast<size_t>(MAX_ENTRIES)));
+
+      int descriptor = static_cast<int>(syscall(__NR_io_uring_setup, std::max(1u, entries), &params));
+      if (descriptor < 0) {
+        return nullptr;
+      }
+
+      // IORING_FEAT_FAST_POLL arrived after IORING_OP_READ (Linux 5.7)
+#ifdef IORING_FEAT_FAST_POLL
+      if ((params.features & IORING_FEAT_FAST_POLL) == 0) {
+        close(descriptor);
+        return nullptr;
+      }
+#else
+      close(descriptor);
+      return nullptr;
+#endif
+
+      try {
+        return std::unique_ptr<BatchReader>(new IoUringBatchReader(filePaths, descriptor, params));
+      }
+      catch (const std::exception& ex) {
+        // The reader has closed the descriptor, so fall back to the thread pool
+        return nullptr;
+      }
+    }
+
+  private:
+    // Map the rings, open every file and submit the first reads
+    void setUp() {
+      bool singleMapping = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+      if (singleMapping) {
+        submissionRingSize = completionRingSize = std::max(submissionRingSize, completionRingSize);
+      }
+
+      submissionRing = mmap(nullptr, submissionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            ringDescriptor, IORING_OFF_SQ_RING);
+      completionRing = singleMapping ? submissionRing :
+                       mmap(nullptr, completionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            ringDescriptor, IORING_OFF_CQ_RING);
+      void* entries = mmap(nullptr, params.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, ringDescriptor, IORING_OFF_SQES);
+      submissionEntries = static_cast<io_uring_sqe*>(entries);
+
+      if (submissionRing == MAP_FAILED || completionRing == MAP_FAILED || entries == MAP_FAILED) {
+        throw std::runtime_error("InputFileBatch: Failed to map the io_uring rings");
+      }
+
+      char* sq = static_cast<char*>(submissionRing);
+      char* cq = static_cast<char*>(completionRing);
+      submissionTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+      submissionMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+      submissionArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+      completionHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+      completionTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+      completionMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+      completionEntries = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+      // Open every file and size its buffer, then submit all the reads
+      for (size_t i = 0; i < filePaths.size(); i++) {
+        descriptors[i] = ::open(filePaths[i].c_str(), O_RDONLY);
+
+        struct stat fileStat{};
+        if (descriptors[i] < 0 || fstat(descriptors[i], &fileStat) != 0 || !S_ISREG(fileStat.st_mode)) {
+          fail(i, std::make_exception_ptr(::batchOpenError(filePaths[i])));
+          continue;
+        }
+
+        contents[i].resize(static_cast<size_t>(fileStat.st_size));
+
+        if (contents[i].empty()) {
+          finish(i);
+        } else {
+          waiting.push_back(i);
+        }
+      }
+
+      queueReads();
+      if (queued > 0) {
+        submitAndWait(0);
+      }
+    }
+
+    // Release everything set up so far, whether or not setUp() finished
+    void tearDown() noexcept {
+      // Reads still in flight write into our buffers, so wait for them.
+      try {
+        while (inFlight > 0) {
+          submitAndWait(1);
+          reapCompletions();
+        }
+      }
+      catch (const std::exception& ex) {
+        // Nothing more we can do, the ring is torn down below
+      }
+
+      for (int descriptor : descriptors) {
+        if (descriptor >= 0) {
+          close(descriptor);
+        }
+      }
+
+      if (submissionEntries != MAP_FAILED) {
+        munmap(submissionEntries, params.sq_entries * sizeof(io_uring_sqe));
+      }
+      if (completionRing != MAP_FAILED && completionRing != submissionRing) {
+        munmap(completionRing, completionRingSize);
+      }
+      if (submissionRing != MAP_FAILED) {
+        munmap(submissionRing, submissionRingSize);
+      }
+
+      close(ringDescriptor);
+    }
+  };
+
+  constexpr size_t IoUringBatchReader::MAX_READ_SIZE;
+  constexpr unsigned int IoUringBatchReader::MAX_ENTRIES;
+#endif
+} // end of anonymous namespace
+
+
+/*
+  Constructor for a batch of files. Nothing is read until start() is called.
+
+  @param filePaths_
+    The complete paths of the files to read
+
+  @param fallbackThreads_
+    The number of threads to read the files with if io_uring is unavailable
+
+  @example
+    InputFileBatch batch({"data/areas.csv", "data/popu1009.json"}, 4);
+*/
+InputFileBatch::InputFileBatch(std::vector<std::string> filePaths_, unsigned int fallbackThreads_) :
+        filePaths(std::move(filePaths_)),
+        fallbackThreads(fallbackThreads_),
+        reader() {}
+
+
+// Defined here, as BatchReader is incomplete in the header.
+InputFileBatch::~InputFileBatch() = default;
+
+
+/*
+  Start reading all the files in the batch. Problems with individual files
+  are only reported when they are waited for.
+
+  @example
+    InputFileBatch batch({"data/areas.csv", "data/popu1009.json"}, 4);
+    batch.start();
+*/
+void InputFileBatch::start() noexcept(false) {
+  if (reader) {
+    return;
+  }
+
+#ifdef BETHYW_IO_URING
+  if (!filePaths.empty()) {
+    reader = IoUringBatchReader::create(filePaths);
+  }
+#endif
+
+  if (!reader) {
+    reader.reset(new ThreadPoolBatchReader(filePaths, fallbackThreads));
+  }
+}
+
+
+/*
+  Wait until a file in the batch has been read, and get its contents. The
+  span stays valid until release() is called for the file.
+
+  @param index
+    The index of the file in the paths given to the constructor
+
+  @return
+    An InputSpan over the contents of the file
+
+  @throws
+    std::runtime_error if the file could not be opened or read, e.g. with the
+    message: InputFileBatch::open: Failed to open file <file name>
+
+  @example
+    InputFileBatch batch({"data/areas.csv", "data/popu1009.json"}, 4);
+    batch.start();
+    InputSpan areasFile = batch.wait(0);
+*/
+InputSpan InputFileBatch::wait(size_t index) noexcept(false) {
+  start();
+  return reader->wait(index);
+}
+
+
+/*
+  Free the memory holding a file's contents once it is no longer needed.
+
+  @param index
+    The index of the file in the paths given to the constructor
+*/
+void InputFileBatch::release(size_t index) noexcept {
+  if (reader) {
+    reader->release(index);
+  }
+}
+
+
+/*
+  Whether the files are being read with io_uring (rather than a thread pool).
+*/
+bool InputFileBatch::isUsingIoUring() const noexcept {
+  return reader && reader->isUsingIoUring();
+}
+
+
+
+/*
+  A stream buffer reading a pipe (or anything else given as a file
+  descriptor) in order, one block at a time. It can not seek, so the parsers
+  reading from it have to consume their input front to back.
+*/
+class PipeStreamBuffer : public std::streambuf {
+private:
+#ifdef _WIN32
+  std::ifstream file;
+  std::streambuf* source;
+#else
+  int descriptor;
+  bool ownsDescriptor;
+#endif
+  std::vector<char> buffer;
+
+protected:
+  virtual int_type underflow() {
+    if (gptr() < egptr()) {
+      return traits_type::to_int_type(*gptr());
+    }
+
+#ifdef _WIN32
+    std::streamsize bytesRead = source->sgetn(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+#else
+    ssize_t bytesRead;
+    do {
+      bytesRead = ::read(descriptor, buffer.data(), buffer.size());
+    } while (bytesRead < 0 && errno == EINTR);
+
+    if (bytesRead < 0) {
+      throw std::runtime_error("InputPipe: Failed to read from the pipe");
+    }
+#endif
+
+    if (bytesRead <= 0) {
+      return traits_type::eof();
+    }
+
+    setg(buffer.data(), buffer.data(), buffer.data() + bytesRead);
+    return traits_type::to_int_type(*gptr());
+  }
+
+public:
+  PipeStreamBuffer(const std::string& source_, size_t bufferSize) :
+          std::streambuf(),
+#ifdef _WIN32
+          file(),
+          source(nullptr),
+#else
+          descriptor(-1),
+          ownsDescriptor(false),
+#endif
+          buffer(std::max(static_cast<size_t>(1), bufferSize)) {
+#ifdef _WIN32
+    if (source_ == InputPipe::STANDARD_INPUT) {
+      source = std::cin.rdbuf();
+    } else {
+      file.open(source_, std::ifstream::in | std::ifstream::binary);
+      source = file.rdbuf();
+    }
+
+    if (!source || (file.rdbuf() == source && !file.is_open())) {
+      throw std::runtime_error("InputPipe::open: Failed to open " + source_);
+    }
+#else
+    if (source_ == InputPipe::STANDARD_INPUT) {
+      descriptor = STDIN_FILENO;
+    } else {
+      // Opening a named pipe blocks until its writer opens it too
+      descriptor = ::open(source_.c_str(), O_RDONLY);
+      ownsDescriptor = true;
+    }
+
+    if (descriptor < 0) {
+      throw std::runtime_error("InputPipe::open: Failed to open " + source_);
+    }
+#endif
+
+    setg(buffer.data(), buffer.data(), buffer.data());
+  }
+
+  PipeStreamBuffer(const PipeStreamBuffer& other) = delete;
+
+  PipeStreamBuffer& operator=(const PipeStreamBuffer& other) = delete;
+
+  virtual ~PipeStreamBuffer() {
+#ifndef _WIN32
+    if (ownsDescriptor) {
+      close(descriptor);
+    }
+#endif
+  }
+};
+
+
+const std::string InputPipe::STANDARD_INPUT = "-";
+constexpr size_t InputPipe::BUFFER_SIZE;
+
+
+/*
+  Constructor for a pipe-based source. The pipe is not opened until open()
+  is called.
+
+  @param source
+    The path of a named pipe, or "-" (InputPipe::STANDARD_INPUT) for the
+    standard input
+
+  @example
+    InputPipe input("-");
+*/
+InputPipe::InputPipe(std::string source) :
+        InputSource(std::move(source)),
+        pipe(),
+        pipeStream(nullptr) {}
+
+
+// Defined here, as PipeStreamBuffer is incomplete in the header.
+InputPipe::~InputPipe() = default;
+
+
+/*
+  Open the pipe for reading. A named pipe is opened once its writer has
+  opened it as well.
+
+  @return
+    A standard input stream reference, which can only be read forwards
+
+  @throws
+    std::runtime_error if there is an issue opening the pipe, with the message:
+    InputPipe::open: Failed to open <source>
+
+  @example
+    InputPipe input("/tmp/popu1009.fifo");
+    input.open();
+*/
+std::istream& InputPipe::open() noexcept(false) {
+  if (pipe) {
+    return pipeStream;
+  }
+
+  pipe.reset(new PipeStreamBuffer(getSource(), BUFFER_SIZE));
+  pipeStream.rdbuf(pipe.get());
+
+  // Rethrow read errors instead of quietly ending the stream
+  pipeStream.exceptions(std::ios::badbit);
+
+  return pipeStream;
+}
+
+
+
+namespace {
+  /*
+    The parts of an http:// URL that we need to make a request.
+  */
+  struct HttpUrl {
+    std::string url;
+    std::string host;
+    std::string port;
+    std::string target;
+  };
+
+
+  HttpUrl parseHttpUrl(const std::string& url) noexcept(false) {
+    const std::string scheme = "http://";
+    if (!::startsWith(url, scheme)) {
+      throw std::runtime_error("InputHttpFile: Invalid URL " + url);
+    }
+
+    size_t authorityEnd = url.find_first_of("/?#", scheme.size());
+    std::string authority = url.substr(scheme.size(), authorityEnd - scheme.size());
+
+    HttpUrl parsed;
+    parsed.url = url;
+    parsed.target = authorityEnd == std::string::npos ? "/" : url.substr(authorityEnd);
+    parsed.target = parsed.target.substr(0, parsed.target.find('#'));
+    if (parsed.target.empty() || parsed.target[0] != '/') {
+      parsed.target = "/" + parsed.target;
+    }
+
+    size_t portStart = authority.rfind(':');
+    if (portStart != std::string::npos && authority.find(']', portStart) == std::string::npos) {
+      parsed.host = authority.substr(0, portStart);
+      parsed.port = authority.substr(portStart + 1);
+    } else {
+      parsed.host = authority;
+      parsed.port = "80";
+    }
+
+    // IPv6 addresses are written in brackets, e.g. [::1]:8080
+    if (parsed.host.size() > 2 && parsed.host.front() == '[' && parsed.host.back() == ']') {
+      parsed.host = parsed.host.substr(1, parsed.host.size() - 2);
+    }
+
+    if (parsed.host.empty() || parsed.port.empty() ||
+        parsed.port.find_first_not_of("0123456789") != std::string::npos) {
+      throw std::runtime_error("InputHttpFile: Invalid URL " + url);
+    }
+
+    return parsed;
+  }
+
+
+  /*
+    A response to an HTTP request. Header names are stored in lower case.
+  */
+  struct HttpResponse {
+    int status = 0;
+    std::unordered_map<std::string, std::string> headers;
+    std::string body;
+    bool keepAlive = false;
+
+    std::string header(const std::string& name) const {
+      auto found = headers.find(name);
+      return found == headers.end() ? "" : found->second;
+    }
+  };
+
+
+#ifndef _WIN32
+  /*
+    A persistent (keep-alive) connection to a web server, with a buffer for
+    reading its responses.
+  */
+  class HttpConnection {
+  private:
+    static constexpr size_t READ_SIZE = 64 * 1024;
+    static constexpr int TIMEOUT_SECONDS = 30;
+
+    int socketDescriptor;
+    std::vector<char> buffer;
+    size_t bufferStart;
+    size_t bufferEnd;
+
+    // Make sure there are unread characters in the buffer, or return false
+    // if the server has closed the connection.
+    bool fill() {
+      if (bufferStart < bufferEnd) {
+        return true;
+      }
+
+      ssize_t count;
+      do {
+        count = recv(socketDescriptor, buffer.data(), buffer.size(), 0);
+      } while (count < 0 && errno == EINTR);
+
+      if (count < 0) {
+        throw std::runtime_error("InputHttpFile: Failed to receive from the server");
+      }
+
+      bufferStart = 0;
+      bufferEnd = static_cast<size_t>(count);
+      return count > 0;
+    }
+
+    std::string readLine() {
+      std::string line;
+
+      while (true) {
+        if (!fill()) {
+          throw std::runtime_error("InputHttpFile: The server closed the connection");
+        }
+
+        const char* start = buffer.data() + bufferStart;
+        const char* newline = static_cast<const char*>(std::memchr(start, '\n', bufferEnd - bufferStart));
+
+        if (newline == nullptr) {
+          line.append(start, bufferEnd - bufferStart);
+          bufferStart = bufferEnd;
+          continue;
+        }
+
+        line.append(start, static_cast<size_t>(newline - start));
+        bufferStart += static_cast<size_t>(newline - start) + 1;
+
+        if (!line.empty() && line.back() == '\r') {
+          line.pop_back();
+        }
+
+        return line;
+      }
+    }
+
+    void readExactly(std::string& body, size_t length) {
+      size_t start = body.size();
+      body.resize(start + length);
+
+      for (size_t done = 0; done < length;) {
+        if (!fill()) {
+          throw std::runtime_error("InputHttpFile: The server closed the connection");
+        }
+
+        size_t count = std::min(length - done, bufferEnd - bufferStart);
+        std::memcpy(&body[start + done], buffer.data() + bufferStart, count);
+        bufferStart += count;
+        done += count;
+      }
+    }
+
+    void readUntilClosed(std::string& body) {
+      while (fill()) {
+        body.append(buffer.data() + bufferStart, bufferEnd - bufferStart);
+        bufferStart = bufferEnd;
+      }
+    }
+
+    // Parse the length of a body or chunk, in the given base (a
+    // Content-Length is decimal, while chunk sizes are hexadecimal).
+    static size_t parseLength(const std::string& text, int base) {
+      const char* start = text.c_str();
+      while (*start == ' ' || *start == '\t') {
+        start++;
+      }
+
+      char* end = nullptr;
+      errno = 0;
+      unsigned long long length = std::strtoull(start, &end, base);
+
+      while (end != nullptr && (*end == ' ' || *end == '\t')) {
+        end++;
+      }
+
+      if (end == start || end == nullptr || *end != '\0' || *start == '-' || errno == ERANGE ||
+          length > std::numeric_limits<size_t>::max()) {
+        throw std::runtime_error("InputHttpFile: Invalid response from the server");
+      }
+
+      return static_cast<size_t>(length);
+    }
+
+    void readChunked(std::string& body) {
+      while (true) {
+        std::string sizeLine = readLine();
+        size_t size = parseLength(sizeLine.substr(0, sizeLine.find(';')), 16);
+
+        if (size == 0) {
+          // Skip any trailer headers
+          while (!readLine().empty()) {}
+          return;
+        }
+
+        readExactly(body, size);
+        readLine();
+      }
+    }
+
+  public:
+    const std::string key;
+
+    HttpConnection(const HttpUrl& url, std::string key_) :
+            socketDescriptor(-1),
+            buffer(READ_SIZE),
+            bufferStart(0),
+            bufferEnd(0),
+            key(std::move(key_)) {
+      addrinfo hints{};
+      hints.ai_family = AF_UNSPEC;
+      hints.ai_socktype = SOCK_STREAM;
+
+      addrinfo* addresses = nullptr;
+      if (getaddrinfo(url.host.c_str(), url.port.c_str(), &hints, &addresses) != 0) {
+        throw std::runtime_error("InputHttpFile: Failed to resolve " + url.host);
+      }
+
+      for (addrinfo* address = addresses; address != nullptr; address = address->ai_next) {
+        socketDescriptor = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (socketDescriptor < 0) {
+          continue;
+        }
+
+        if (connect(socketDescriptor, address->ai_addr, address->ai_addrlen) == 0) {
+          break;
+        }
+
+        close(socketDescriptor);
+        socketDescriptor = -1;
+      }
+
+      freeaddrinfo(addresses);
+
+      if (socketDescriptor < 0) {
+        throw std::runtime_error("InputHttpFile: Failed to connect to " + url.host + ":" + url.port);
+      }
+
+      timeval timeout{};
+      timeout.tv_sec = TIMEOUT_SECONDS;
+      setsockopt(socketDescriptor, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+      setsockopt(socketDescriptor, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+      int enabled = 1;
+      setsockopt(socketDescriptor, IPPROTO_TCP, TCP_NODELAY, &enabled, sizeof(enabled));
+#ifdef SO_NOSIGPIPE
+      setsockopt(socketDescriptor, SOL_SOCKET, SO_NOSIGPIPE, &enabled, sizeof(enabled));
+#endif
+    }
+
+    HttpConnection(const HttpConnection& other) = delete;
+
+    HttpConnection& operator=(const HttpConnection& other) = delete;
+
+    ~HttpConnection() {
+      close(socketDescriptor);
+    }
+
+    void send(const std::string& request) {
+#ifdef MSG_NOSIGNAL
+      const int flags = MSG_NOSIGNAL;
+#else
+      const int flags = 0;
+#endif
+
+      for (size_t sent = 0; sent < request.size();) {
+        ssize_t count = ::send(socketDescriptor, request.data() + sent, request.size() - sent, flags);
+
+        if (count < 0 && errno == EINTR) {
+          continue;
+        } else if (count <= 0) {
+          throw std::runtime_error("InputHttpFile: Failed to send to the server");
+        }
+
+        sent += static_cast<size_t>(count);
+      }
+    }
+
+    HttpResponse receive() {
+      HttpResponse response;
+
+      // e.g. HTTP/1.1 200 OK
+      std::string statusLine = readLine();
+      if (!::startsWith(statusLine, "HTTP/") || statusLine.size() < 12) {
+        throw std::runtime_error("InputHttpFile: Invalid response from the server");
+      }
+
+      bool http10 = ::startsWith(statusLine, "HTTP/1.0");
+      response.status = std::atoi(statusLine.c_str() + statusLine.find(' ') + 1);
+
+      for (std::string line = readLine(); !line.empty(); line = readLine()) {
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+          continue;
+        }
+
+        std::string name = line.substr(0, colon);
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+        size_t valueStart = line.find_first_not_of(" \t", colon + 1);
+        response.headers[name] = valueStart == std::string::npos ? "" : line.substr(valueStart);
+      }
+
+      std::string connection = response.header("connection");
+      std::transform(connection.begin(), connection.end(), connection.begin(), ::tolower);
+      response.keepAlive = http10 ? connection == "keep-alive" : connection != "close";
+
+      std::string transferEncoding = response.header("transfer-encoding");
+      std::transform(transferEncoding.begin(), transferEncoding.end(), transferEncoding.begin(), ::tolower);
+
+      if (response.status == 204 || response.status == 304 || response.status / 100 == 1) {
+        // No body
+      } else if (transferEncoding.find("chunked") != std::string::npos) {
+        readChunked(response.body);
+      } else if (response.headers.count("content-length")) {
+        readExactly(response.body, parseLength(response.header("content-length"), 10));
+      } else {
+        readUntilClosed(response.body);
+        response.keepAlive = false;
+      }
+
+      return response;
+    }
+  };
+
+  constexpr size_t HttpConnection::READ_SIZE;
+  constexpr int HttpConnection::TIMEOUT_SECONDS;
+
+
+  /*
+    The idle keep-alive connections, shared by all InputHttpFile instances,
+    keyed by host and port.
+  */
+  class HttpConnectionPool {
+  private:
+    std::mutex mutex;
+    std::unordered_map<std::string, std::vector<std::unique_ptr<HttpConnection>>> idle;
+
+  public:
+    static HttpConnectionPool& instance() {
+      static HttpConnectionPool pool;
+      return pool;
+    }
+
+    std::unique_ptr<HttpConnection> acquire(const HttpUrl& url, bool& reused) {
+      const std::string key = url.host + ":" + url.port;
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto& connections = idle[key];
+
+        if (!connections.empty()) {
+          std::unique_ptr<HttpConnection> connection = std::move(connections.back());
+          connections.pop_back();
+          reused = true;
+          return connection;
+        }
+      }
+
+      reused = false;
+      return std::unique_ptr<HttpConnection>(new HttpConnection(url, key));
+    }
+
+    void release(std::unique_ptr<HttpConnection> connection) {
+      std::lock_guard<std::mutex> lock(mutex);
+      idle[connection->key].push_back(std::move(connection));
+    }
+  };
+
+
+  /*
+    Make a GET request, on an idle connection if there is one. A server may
+    close an idle connection at any time, so if the request fails on one, it
+    is retried once on a new connection. Errors name the URL requested.
+  */
+  HttpResponse httpGet(const HttpUrl& url, const std::vector<std::string>& headers) {
+    std::string request = "GET " + url.target + " HTTP/1.1\r\n"
+                          "Host: " + url.host + (url.port == "80" ? "" : ":" + url.port) + "\r\n"
+                          "Connection: keep-alive\r\n"
+                          "Accept-Encoding: identity\r\n";
+    for (const std::string& header : headers) {
+      request += header + "\r\n";
+    }
+    request += "\r\n";
+
+    HttpConnectionPool& pool = HttpConnectionPool::instance();
+
+    while (true) {
+      bool reused = false;
+      std::unique_ptr<HttpConnection> connection = pool.acquire(url, reused);
+
+      try {
+        connection->send(request);
+        HttpResponse response = connection->receive();
+
+        if (response.keepAlive) {
+          pool.release(std::move(connection));
+        }
+
+        return response;
+      }
+      catch (const std::exception& ex) {
+        if (!reused) {
+          throw std::runtime_error(std::string(ex.what()) + " for " + url.url);
+        }
+      }
+    }
+  }
+#else
+  HttpResponse httpGet(const HttpUrl& url, const std::vector<std::string>& headers) {
+    throw std::runtime_error("InputHttpFile: HTTP is not supported on this platform");
+  }
+#endif
+
+
+  /*
+    Parse a Content-Range header (e.g. bytes 0-1023/562098) into the first and
+    last byte of the range, and the size of the whole body.
+  */
+  bool parseContentRange(const std::string& header, size_t& first, size_t& last, size_t& total) {
+    unsigned long long parsedFirst, parsedLast, parsedTotal;
+    if (std::sscanf(header.c_str(), "bytes %llu-%llu/%llu", &parsedFirst, &parsedLast, &parsedTotal) != 3 ||
+        parsedFirst > parsedLast || parsedLast >= parsedTotal) {
+      return false;
+    }
+
+    first = static_cast<size_t>(parsedFirst);
+    last = static_cast<size_t>(parsedLast);
+    total = static_cast<size_t>(parsedTotal);
+    return true;
+  }
+
+
+  /*
+    Check whether an ETag is strong, i.e. it can be used with If-Range
+    (RFC 7233), rather than missing or weak (e.g. W/"v1").
+  */
+  bool isStrongETag(const std::string& etag) {
+    return !etag.empty() && !::startsWith(etag, "W/");
+  }
+
+
+  std::string readWholeFile(const std::string& filePath, bool& found) {
+    std::ifstream file(filePath, std::ifstream::in | std::ifstream::binary);
+    found = file.is_open();
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+
+
+  // Write a file under a temporary name, then rename it, so that other runs
+  // never see a half written file.
+  void writeWholeFile(const std::string& filePath, const std::string& contents) {
+    const std::string temporaryPath = filePath + ".tmp";
+
+    {
+      std::ofstream file(temporaryPath, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+      file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+      if (!file) {
+        std::remove(temporaryPath.c_str());
+        return;
+      }
+    }
+
+    std::rename(temporaryPath.c_str(), filePath.c_str());
+  }
+} // end of anonymous namespace
+
+
+constexpr unsigned int InputHttpFile::DEFAULT_CONNECTIONS;
+constexpr size_t InputHttpFile::DEFAULT_RANGE_SIZE;
+
+
+/*
+  Constructor for a web source. Nothing is fetched until the source is opened.
+
+  @param url
+    The http:// URL of the data
+
+  @param cacheDir_
+    The directory to cache bodies and their ETags in, or an empty string to
+    not cache them
+
+  @param connections_
+    The largest number of connections to fetch ranges over at once
+
+  @param rangeSize_
+    The size of each range fetched, in bytes. Bodies that fit in one range
+    are fetched with a single request.
+
+  @example
+    InputHttpFile input("http://localhost:8080/popu1009.json", ".bethyw-cache");
+*/
+InputHttpFile::InputHttpFile(std::string url, std::string cacheDir_, unsigned int connections_, size_t rangeSize_) :
+        InputSource(std::move(url)),
+        cacheDir(std::move(cacheDir_)),
+        connections(std::max(1u, connections_)),
+        rangeSize(std::max(static_cast<size_t>(1), rangeSize_)),
+        contents(),
+        fetched(false),
+        fromCache(false),
+        contentsBuffer(),
+        contentsStream(&contentsBuffer) {}
+
+
+/*
+  Download the body of the URL into contents, unless the cached copy is
+  still current.
+
+  The first request asks for the first range of the body. If the server
+  replies with that range (206), the rest of the ranges are fetched over
+  several connections, each making sure with If-Range that they get the same
+  version of the body. If-Range only works with a strong ETag, so a body
+  without one is fetched again with a single request instead. A server that
+  does not support ranges simply replies with the whole body (200).
+
+  @throws
+    std::runtime_error if the body could not be fetched, with the message:
+    InputHttpFile::open: Failed to fetch <url> (HTTP <status>)
+*/
+void InputHttpFile::fetch() noexcept(false) {
+  if (fetched) {
+    return;
+  }
+
+  const HttpUrl url = ::parseHttpUrl(getSource());
+
+  const std::string cachePath = cacheDir.empty() ? "" : cacheDir + "/" + cacheKey(getSource());
+  bool cached = false;
+  std::string cachedETag;
+
+  if (!cachePath.empty()) {
+    cachedETag = ::readWholeFile(cachePath + ".etag", cached);
+    cached = cached && !cachedETag.empty();
+  }
+
+  std::vector<std::string> headers = {"Range: bytes=0-" + std::to_string(rangeSize - 1)};
+  if (cached) {
+    headers.push_back("If-None-Match: " + cachedETag);
+  }
+
+  HttpResponse response = ::httpGet(url, headers);
+
+  if (response.status == 416) {
+    // The range could not be satisfied, so the body must be empty
+    response = ::httpGet(url, {});
+  }
+
+  if (response.status == 304 && cached) {
+    bool found = false;
+    contents = ::readWholeFile(cachePath + ".data", found);
+
+    if (found) {
+      fromCache = true;
+      fetched = true;
+      return;
+    }
+
+    // The cached body has gone, so fetch it again
+    response = ::httpGet(url, {headers[0]});
+  }
+
+  const std::string failMessage = "InputHttpFile::open: Failed to fetch " + getSource() +
+                                  " (HTTP " + std::to_string(response.status) + ")";
+
+  size_t first = 0, last = 0, total = 0;
+
+  if (response.status == 206 && ::parseContentRange(response.header("content-range"), first, last, total) &&
+      last + 1 < total && !::isStrongETag(response.header("etag"))) {
+    // We couldn't tell whether the other ranges are of the same version
+    response = ::httpGet(url, {});
+  }
+
+  if (response.status == 200) {
+    contents = std::move(response.body);
+  } else if (response.status == 206 && ::parseContentRange(response.header("content-range"), first, last, total) &&
+             first == 0 && response.body.size() == last + 1) {
+    const std::string etag = response.header("etag");
+    contents.resize(total);
+    std::memcpy(&contents[0], response.body.data(), response.body.size());
+
+    size_t rangeCount = (total - response.body.size() + rangeSize - 1) / rangeSize;
+    std::atomic<size_t> nextRange(0);
+    std::vector<std::exception_ptr> errors(connections);
+    std::vector<std::thread> fetchers;
+
+    auto fetchRanges = [&](size_t fetcher) {
+      try {
+        for (size_t range = nextRange++; range < rangeCount; range = nextRange++) {
+          size_t rangeFirst = response.body.size() + range * rangeSize;
+          size_t rangeLast = std::min(total, rangeFirst + rangeSize) - 1;
+
+          std::vector<std::string> rangeHeaders = {
+            "Range: bytes=" + std::to_string(rangeFirst) + "-" + std::to_string(rangeLast),
+            "If-Range: " + etag
+          };
+
+          HttpResponse part = ::httpGet(url, rangeHeaders);
+          size_t partFirst = 0, partLast = 0, partTotal = 0;
+
+          if (part.status != 206 || !::parseContentRange(part.header("content-range"), partFirst, partLast, partTotal) ||
+              partFirst != rangeFirst || partLast != rangeLast || partTotal != total ||
+              part.body.size() != rangeLast - rangeFirst + 1) {
+            // e.g. the body changed while we were fetching it
+            throw std::runtime_error("InputHttpFile::open: Failed to fetch " + getSource() +
+                                     " (HTTP " + std::to_string(part.status) + ")");
+          }
+
+          std::memcpy(&contents[rangeFirst], part.body.data(), part.body.size());
+        }
+      }
+      catch (...) {
+        errors[fetcher] = std::current_exception();
+      }
+    };
+
+    for (size_t i = 1; i < std::min(static_cast<size_t>(connections), rangeCount); i++) {
+      fetchers.emplace_back(fetchRanges, i);
+    }
+
+    fetchRanges(0);
+
+    for (std::thread& fetcher : fetchers) {
+      fetcher.join();
+    }
+
+    for (const std::exception_ptr& error : errors) {
+      if (error) {
+        std::rethrow_exception(error);
+      }
+    }
+  } else {
+    throw std::runtime_error(failMessage);
+  }
+
+  const std::string etag = response.header("etag");
+  if (!cachePath.empty() && !etag.empty()) {
+#ifndef _WIN32
+    mkdir(cacheDir.c_str(), 0755);
+#endif
+    ::writeWholeFile(cachePath + ".data", contents);
+    ::writeWholeFile(cachePath + ".etag", etag);
+  }
+
+  fetched = true;
+}
+
+
+/*
+  Fetch the data (if it has not been already) and get it as one contiguous
+  span of characters, which remains valid while this object exists.
+
+  @return
+    An InputSpan over the body of the response
+
+  @throws
+    std::runtime_error if the body could not be fetched, with the message:
+    InputHttpFile::open: Failed to fetch <url> (HTTP <status>)
+
+  @example
+    InputHttpFile input("http://localhost:8080/popu1009.json");
+    InputSpan contents = input.span();
+*/
+InputSpan InputHttpFile::span() noexcept(false) {
+  fetch();
+  return {contents.c_str(), contents.size()};
+}
+
+
+/*
+  Fetch the data (if it has not been already) and open a stream over it.
+
+  @return
+    A standard input stream reference
+
+  @throws
+    std::runtime_error if the body could not be fetched, with the message:
+    InputHttpFile::open: Failed to fetch <url> (HTTP <status>)
+
+  @example
+    InputHttpFile input("http://localhost:8080/areas.csv");
+    input.open();
+*/
+std::istream& InputHttpFile::open() noexcept(false) {
+  contentsBuffer.reset(span());
+  contentsStream.clear();
+  return contentsStream;
+}
+
+
+/*
+  Whether the body was unchanged on the server, and read from the cache.
+*/
+bool InputHttpFile::isFromCache() const noexcept {
+  return fromCache;
+}
+
+
+/*
+  Check whether a source is an http:// URL, rather than a file path.
+
+  @example
+    InputHttpFile::isHttpUrl("http://localhost:8080/areas.csv"); // true
+*/
+bool InputHttpFile::isHttpUrl(const std::string& source) noexcept {
+  return ::startsWith(source, "http://");
+}
+
+
+/*
+  The name the cached files of a URL are stored under in the cache
+  directory (the FNV-1a hash of the URL, in hex), without an extension.
+*/
+std::string InputHttpFile::cacheKey(const std::string& url) noexcept {
+  unsigned long long hash = 14695981039346656037ULL;
+  for (char c : url) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ULL;
+  }
+
+  char key[17];
+  std::snprintf(key, sizeof(key), "%016llx", hash);
+  return key;
+}
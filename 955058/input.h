@@ -8,21 +8,65 @@
 
   AUTHOR: 955058
 
-  This file contains declarations for the input source handlers. There are
-  two classes: InputSource and InputFile. InputSource is abstract (i.e. it
-  contains a pure virtual function). InputFile is a concrete derivation of
-  InputSource, for input from files.
+  This file contains declarations for the input source handlers. InputSource
+  is abstract (i.e. it contains a pure virtual function). InputFile is a
+  concrete derivation of InputSource, for input from files, and
+  InputMappedFile is a derivation that maps the whole file into memory so
+  that the parsers can read it as one contiguous span of characters, and
+  InputCompressedFile decompresses gzip/Zstandard files as they are read.
+  InputPagedFile follows a StatsWales JSON file across its pages, and
+  InputReadAheadFile reads a file on a background thread ahead of the parser.
+  InputFileBatch reads many whole files concurrently (with io_uring on
+  Linux). Finally, InputPipe reads data streamed on the standard input or a
+  named pipe by another program, and InputHttpFile fetches data from a web
+  server.
 
-  Although only one class derives from InputSource, we have implemented our
-  code this way to support future expansion of input from different sources
-  (e.g. the web).
+  Deriving all of these from InputSource lets us mix and match the sources
+  of the data as needed.
 
   TODO: Read the block comments with TODO in input.cpp to know which 
   functions and member variables you need to declare in these classes.
  */
 
+#include <cstddef>
 #include <string>
 #include <fstream>
+#include <future>
+#include <memory>
+#include <streambuf>
+#include <vector>
+
+/*
+  A read-only view of a contiguous block of characters that is owned by
+  someone else (e.g. a memory mapped file). We are limited to C++14, so this
+  is a minimal stand-in for std::string_view.
+*/
+struct InputSpan {
+  const char* data;
+  size_t size;
+
+  const char* begin() const noexcept { return data; }
+
+  const char* end() const noexcept { return data + size; }
+
+  bool empty() const noexcept { return size == 0; }
+};
+
+/*
+  A stream buffer that reads directly from an InputSpan, so that a span can be
+  handed to code expecting a std::istream without copying the characters.
+*/
+class SpanStreamBuffer : public std::streambuf {
+public:
+  SpanStreamBuffer();
+
+  void reset(const InputSpan& span) noexcept;
+
+protected:
+  virtual pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which);
+
+  virtual pos_type seekpos(pos_type pos, std::ios_base::openmode which);
+};
 
 /*
   InputSource is an abstract/purely virtual base class for all input source 
@@ -48,25 +92,373 @@ public:
   virtual std::istream& open() noexcept(false) = 0;
 };
 
+/*
+  The stream buffer InputFile reads large files with, declared in input.cpp.
+*/
+class DescriptorStreamBuffer;
+
 /*
   Source data that is contained within a file. For now, our application will
   only work with files (and in particular, the files in the datasets directory).
 
+  How the file is read depends on its size (see ReadStrategy): small files are
+  read with a single read() into memory, while large files are streamed
+  through a large buffer, after telling the kernel we will read them
+  sequentially. The strategy used, and how fast the file was read, can be
+  retrieved for reporting.
+
   TODO: Based on your implementation, there may be additional constructors
   or functions you implement here, and perhaps additional operators you may wish
   to overload.
 */
 class InputFile : public InputSource {
 
+public:
+  enum class ReadStrategy {
+    // Choose WholeFile or Buffered from the size of the file
+    Auto,
+    // A std::ifstream with its default buffer
+    Stream,
+    // One read() of the whole file into a buffer of its size
+    WholeFile,
+    // read()s of LARGE_BUFFER_SIZE, with posix_fadvise() read ahead
+    Buffered,
+    // Like Buffered, but with O_DIRECT to bypass the page cache. This is
+    // never chosen by Auto, and falls back to Buffered if not supported.
+    Direct
+  };
+
+  // The largest file read with ReadStrategy::WholeFile by ReadStrategy::Auto
+  static constexpr size_t WHOLE_FILE_LIMIT = 4 * 1024 * 1024;
+
+  static constexpr size_t LARGE_BUFFER_SIZE = 1024 * 1024;
+
 private:
+  ReadStrategy strategy;
   std::ifstream inputStream;
 
+  std::string contents;
+  SpanStreamBuffer contentsBuffer;
+  std::unique_ptr<DescriptorStreamBuffer> descriptorBuffer;
+  std::istream bufferStream;
+
+  // For ReadStrategy::WholeFile (the other strategies measure as they go)
+  size_t bytesRead;
+  double secondsReading;
+
+  void openWholeFile(int descriptor, size_t fileSize) noexcept(false);
+
 public:
-  explicit InputFile(std::string filePath);
+  explicit InputFile(std::string filePath, ReadStrategy strategy_ = ReadStrategy::Auto);
 
   virtual ~InputFile();
 
   virtual std::istream& open() noexcept(false);
+
+  ReadStrategy getStrategy() const noexcept;
+
+  size_t getBytesRead() const noexcept;
+
+  double getBytesPerSecond() const noexcept;
+
+  static std::string strategyName(ReadStrategy strategy) noexcept;
+};
+
+/*
+  Source data that is contained within a file, which is mapped read-only into
+  memory instead of being read through a std::ifstream. The parsers can take
+  the mapped file as one contiguous InputSpan (see span()), which saves the
+  copies made by the stream buffer and std::getline. The kernel is also told
+  that we will read the mapping sequentially, so it can read ahead.
+
+  open() is still supported and returns a stream that reads from the mapping.
+*/
+class InputMappedFile : public InputSource {
+
+private:
+  // The mapping is released with munmap() in the destructor.
+  void* mapping;
+  size_t mappingSize;
+
+  // Holds the file contents on platforms without mmap().
+  std::string fallbackContents;
+
+  bool mapped;
+
+  SpanStreamBuffer spanBuffer;
+  std::istream spanStream;
+
+  void map() noexcept(false);
+
+public:
+  explicit InputMappedFile(std::string filePath);
+
+  InputMappedFile(const InputMappedFile& other) = delete;
+
+  InputMappedFile& operator=(const InputMappedFile& other) = delete;
+
+  virtual ~InputMappedFile();
+
+  InputSpan span() noexcept(false);
+
+  virtual std::istream& open() noexcept(false);
+};
+
+/*
+  The stream buffer that does the actual decompression for an
+  InputCompressedFile. Declared in input.cpp, as each compression format has
+  its own implementation.
+*/
+class DecompressingStreamBuffer;
+
+/*
+  Source data that is contained within a compressed file. gzip (.gz) files are
+  always supported, and Zstandard (.zst) files are supported when compiled
+  with BETHYW_WITH_ZSTD (and linked with libzstd).
+
+  The file is decompressed as the parsers read from the stream returned by
+  open(), through a fixed size buffer that is refilled once the parser has
+  consumed it. Therefore, neither the compressed nor the decompressed file is
+  ever held in memory (or on disk) as a whole.
+*/
+class InputCompressedFile : public InputSource {
+
+private:
+  std::ifstream compressedStream;
+  std::unique_ptr<DecompressingStreamBuffer> decompressor;
+  std::istream decompressedStream;
+
+public:
+  // The amount of compressed data read from the file at a time, and the
+  // size of the buffer the parser reads the decompressed data from.
+  static constexpr size_t COMPRESSED_CHUNK_SIZE = 64 * 1024;
+  static constexpr size_t DECOMPRESSED_BUFFER_SIZE = 256 * 1024;
+
+  explicit InputCompressedFile(std::string filePath);
+
+  virtual ~InputCompressedFile();
+
+  virtual std::istream& open() noexcept(false);
+
+  static bool isCompressedFile(const std::string& filePath) noexcept;
+};
+
+/*
+  Source data that is split across several pages, as returned by the
+  StatsWales API. Each page is a complete JSON document, whose
+  odata.nextLink value links to the following page (the last page has no
+  link).
+
+  Pages are read one at a time with nextPage(). While a page is parsed, the
+  next one is already being read on a background thread, so at most two
+  pages are held in memory at once, regardless of how many pages there are.
+
+  A nextLink may be a path (relative to the first page) or a file:// URL.
+  Otherwise, e.g. for the https:// links to the StatsWales API, the pages are
+  expected to have been saved next to the first page, numbered from 2:
+  popu1009.json, popu1009.page-2.json, popu1009.page-3.json, ...
+
+  If the first page is an http:// URL, every page is fetched with an
+  InputHttpFile: http:// links are followed as they are, and other links are
+  mapped to URLs on the same server in the same way as they are to files.
+*/
+class InputPagedFile : public InputSource {
+
+private:
+  std::string httpCacheDir;
+  unsigned int httpConnections;
+
+  std::string currentPage;
+  std::future<std::string> nextPageContents;
+  unsigned int pageNumber;
+  bool hasNextPage;
+
+  SpanStreamBuffer pageBuffer;
+  std::istream pageStream;
+
+  std::string resolveNextLink(const std::string& nextLink, unsigned int nextPageNumber) const noexcept(false);
+
+public:
+  explicit InputPagedFile(std::string firstPagePath,
+                          std::string httpCacheDir_ = "",
+                          unsigned int httpConnections_ = 0);
+
+  InputPagedFile(const InputPagedFile& other) = delete;
+
+  InputPagedFile& operator=(const InputPagedFile& other) = delete;
+
+  virtual ~InputPagedFile();
+
+  bool nextPage() noexcept(false);
+
+  unsigned int getPageNumber() const noexcept;
+
+  InputSpan page() const noexcept;
+
+  virtual std::istream& open() noexcept(false);
+
+  static std::string findNextLink(const InputSpan& page);
+};
+
+/*
+  The stream buffer used by InputReadAheadFile, declared in input.cpp.
+*/
+class ReadAheadStreamBuffer;
+
+/*
+  Source data that is contained within a file, which is read by a background
+  thread ahead of the parser. The file is read into a ring of `depth`
+  buffers of `bufferSize` bytes each: while the parser consumes one buffer,
+  the thread fills the next ones. This lets the time spent waiting for slow
+  storage (e.g. a network mounted data directory) overlap with the time
+  spent parsing, instead of adding to it.
+*/
+class InputReadAheadFile : public InputSource {
+
+private:
+  size_t bufferSize;
+  unsigned int depth;
+
+  std::unique_ptr<ReadAheadStreamBuffer> readAhead;
+  std::istream readAheadStream;
+
+public:
+  static constexpr size_t DEFAULT_BUFFER_SIZE = 1024 * 1024;
+  static constexpr unsigned int DEFAULT_DEPTH = 2;
+
+  explicit InputReadAheadFile(std::string filePath,
+                              size_t bufferSize_ = DEFAULT_BUFFER_SIZE,
+                              unsigned int depth_ = DEFAULT_DEPTH);
+
+  virtual ~InputReadAheadFile();
+
+  virtual std::istream& open() noexcept(false);
+};
+
+/*
+  Does the reading for an InputFileBatch, declared in input.cpp. There is one
+  implementation using io_uring and one using a pool of threads.
+*/
+class BatchReader;
+
+/*
+  Reads a batch of whole files into memory concurrently, so that loading many
+  medium sized files is not bound by the latency of each file in turn.
+
+  On Linux, the reads for all the files are submitted to the kernel at once
+  through io_uring. Where io_uring is unavailable (other platforms, old
+  kernels, or when it is blocked), the files are read by a pool of threads.
+
+  Each file can be used as soon as its own read completes (see wait()),
+  while the reads of the other files carry on.
+*/
+class InputFileBatch {
+
+private:
+  std::vector<std::string> filePaths;
+  unsigned int fallbackThreads;
+  std::unique_ptr<BatchReader> reader;
+
+public:
+  InputFileBatch(std::vector<std::string> filePaths_, unsigned int fallbackThreads_);
+
+  InputFileBatch(const InputFileBatch& other) = delete;
+
+  InputFileBatch& operator=(const InputFileBatch& other) = delete;
+
+  ~InputFileBatch();
+
+  void start() noexcept(false);
+
+  InputSpan wait(size_t index) noexcept(false);
+
+  void release(size_t index) noexcept;
+
+  bool isUsingIoUring() const noexcept;
+};
+
+/*
+  Source data that is fetched from a web server over plain HTTP (e.g. a
+  StatsWales compatible endpoint, or a local mirror of one). The whole body is
+  downloaded into memory when the source is first opened.
+
+  Connections are kept alive and shared by all InputHttpFile instances, so
+  fetching several datasets from the same server only connects once. Bodies
+  larger than the range size are fetched as byte ranges over several
+  connections at once. If a cache directory is given, bodies are stored there
+  with their ETag, and later fetches of the same URL send the ETag in a
+  conditional GET, so an unchanged dataset is not downloaded again.
+*/
+class InputHttpFile : public InputSource {
+
+private:
+  std::string cacheDir;
+  unsigned int connections;
+  size_t rangeSize;
+
+  std::string contents;
+  bool fetched;
+  bool fromCache;
+
+  SpanStreamBuffer contentsBuffer;
+  std::istream contentsStream;
+
+  void fetch() noexcept(false);
+
+public:
+  static constexpr unsigned int DEFAULT_CONNECTIONS = 4;
+  static constexpr size_t DEFAULT_RANGE_SIZE = 4 * 1024 * 1024;
+
+  explicit InputHttpFile(std::string url,
+                         std::string cacheDir_ = "",
+                         unsigned int connections_ = DEFAULT_CONNECTIONS,
+                         size_t rangeSize_ = DEFAULT_RANGE_SIZE);
+
+  InputHttpFile(const InputHttpFile& other) = delete;
+
+  InputHttpFile& operator=(const InputHttpFile& other) = delete;
+
+  InputSpan span() noexcept(false);
+
+  virtual std::istream& open() noexcept(false);
+
+  bool isFromCache() const noexcept;
+
+  static bool isHttpUrl(const std::string& source) noexcept;
+
+  static std::string cacheKey(const std::string& url) noexcept;
+};
+
+/*
+  The stream buffer used by InputPipe, declared in input.cpp.
+*/
+class PipeStreamBuffer;
+
+/*
+  Source data that arrives on the standard input or through a named pipe
+  (FIFO) written to by another program, e.g. a job that produces StatsWales
+  shaped data. Such data can only be read once, from start to end: the
+  stream does not support seeking, and nothing is kept once it has been
+  passed on to the parser, so rows flow straight from the producer into
+  Areas::populate() without going through a file on disk.
+*/
+class InputPipe : public InputSource {
+
+private:
+  std::unique_ptr<PipeStreamBuffer> pipe;
+  std::istream pipeStream;
+
+public:
+  // The source name that stands for the standard input
+  static const std::string STANDARD_INPUT;
+
+  static constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+  explicit InputPipe(std::string source = STANDARD_INPUT);
+
+  virtual ~InputPipe();
+
+  virtual std::istream& open() noexcept(false);
 };
 
 #endif // INPUT_H_
\ No newline at end of file
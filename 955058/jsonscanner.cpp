@@ -0,0 +1,1555 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  This file contains the implementation of StatsWalesJSONScanner.
+
+  The bit tricks for finding the strings in a block are those described in
+  "Parsing Gigabytes of JSON per Second" (Langdale and Lemire), except that
+  escapes are found with a loop over the backslashes, as they are rare in
+  StatsWales documents.
+*/
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define BETHYW_SSE2
+#include <emmintrin.h>
+#endif
+
+// AVX2 is chosen at runtime, which needs GCC or Clang's target attribute
+#if defined(BETHYW_SSE2) && defined(__GNUC__)
+#define BETHYW_AVX2
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "jsonscanner.h"
+#include "bethyw.h"
+
+using json = nlohmann::json;
+
+// Anonymous namespace for helper functions private to jsonscanner.cpp.
+namespace {
+  const char BYTE_ORDER_MARK[] = "\xEF\xBB\xBF";
+  const uint64_t HIGHEST_BIT = uint64_t(1) << 63;
+
+
+  [[noreturn]] void syntaxError(size_t position, const std::string& what) {
+    throw std::runtime_error("syntax error at byte " + std::to_string(position) + ": " + what);
+  }
+
+
+  bool isWhitespace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+  }
+
+
+  bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+  }
+
+
+  unsigned int trailingZeros(uint64_t bits) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return static_cast<unsigned int>(index);
+#else
+    return static_cast<unsigned int>(__builtin_ctzll(bits));
+#endif
+  }
+
+
+  unsigned int populationCount(uint64_t bits) {
+#ifdef _MSC_VER
+    return static_cast<unsigned int>(__popcnt64(bits));
+#else
+    return static_cast<unsigned int>(__builtin_popcountll(bits));
+#endif
+  }
+
+
+  /*
+    Each bit of the result is the XOR of that bit and all of the bits below it
+    in bits, i.e. given the quotes in a block, the bytes inside strings.
+  */
+  uint64_t prefixXor(uint64_t bits) {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+  }
+
+
+#ifndef BETHYW_SSE2
+  void classifyBlockScalar(const char* block, StatsWalesJSONScanner::BlockMasks& masks) {
+    masks = StatsWalesJSONScanner::BlockMasks{0, 0, 0, 0};
+
+    for (unsigned int i = 0; i < 64; i++) {
+      const unsigned char c = static_cast<unsigned char>(block[i]);
+      const uint64_t bit = uint64_t(1) << i;
+
+      if (c == '"') {
+        masks.quotes |= bit;
+      } else if (c == '\\') {
+        masks.backslashes |= bit;
+      } else if (c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',') {
+        masks.structurals |= bit;
+      } else if (c < 0x20) {
+        masks.controls |= bit;
+      }
+    }
+  }
+#endif
+
+
+#ifdef BETHYW_SSE2
+  void classifyBlockSSE2(const char* block, StatsWalesJSONScanner::BlockMasks& masks) {
+    // '[' and ']' are '{' and '}' without the 0x20 bit, so both pairs can be
+    // found with one comparison each after setting that bit
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    const __m128i openBrace = _mm_set1_epi8('{');
+    const __m128i closeBrace = _mm_set1_epi8('}');
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i lastControl = _mm_set1_epi8(0x1F);
+
+    masks = StatsWalesJSONScanner::BlockMasks{0, 0, 0, 0};
+
+    for (unsigned int i = 0; i < 4; i++) {
+      const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16 * i));
+      const __m128i folded = _mm_or_si128(bytes, caseBit);
+
+      const __m128i structurals = _mm_or_si128(
+              _mm_or_si128(_mm_cmpeq_epi8(folded, openBrace), _mm_cmpeq_epi8(folded, closeBrace)),
+              _mm_or_si128(_mm_cmpeq_epi8(bytes, colon), _mm_cmpeq_epi8(bytes, comma)));
+      const __m128i controls = _mm_cmpeq_epi8(_mm_max_epu8(bytes, lastControl), lastControl);
+
+      const unsigned int shift = 16 * i;
+      masks.quotes |= uint64_t(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, quote)) & 0xFFFF) << shift;
+      masks.backslashes |= uint64_t(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, backslash)) & 0xFFFF) << shift;
+      masks.structurals |= uint64_t(_mm_movemask_epi8(structurals) & 0xFFFF) << shift;
+      masks.controls |= uint64_t(_mm_movemask_epi8(controls) & 0xFFFF) << shift;
+    }
+  }
+#endif
+
+
+#ifdef BETHYW_AVX2
+  __attribute__((target("avx2")))
+  void classifyBlockAVX2(const char* block, StatsWalesJSONScanner::BlockMasks& masks) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i caseBit = _mm256_set1_epi8(0x20);
+    const __m256i openBrace = _mm256_set1_epi8('{');
+    const __m256i closeBrace = _mm256_set1_epi8('}');
+    const __m256i colon = _mm256_set1_epi8(':');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i lastControl = _mm256_set1_epi8(0x1F);
+
+    masks = StatsWalesJSONScanner::BlockMasks{0, 0, 0, 0};
+
+    for (unsigned int i = 0; i < 2; i++) {
+      const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32 * i));
+      const __m256i folded = _mm256_or_si256(bytes, caseBit);
+
+      const __m256i structurals = _mm256_or_si256(
+              _mm256_or_si256(_mm256_cmpeq_epi8(folded, openBrace), _mm256_cmpeq_epi8(folded, closeBrace)),
+              _mm256_or_si256(_mm256_cmpeq_epi8(bytes, colon), _mm256_cmpeq_epi8(bytes, comma)));
+      const __m256i controls = _mm256_cmpeq_epi8(_mm256_max_epu8(bytes, lastControl), lastControl);
+
+      const unsigned int shift = 32 * i;
+      masks.quotes |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, quote)))) << shift;
+      masks.backslashes |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, backslash)))) << shift;
+      masks.structurals |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(structurals))) << shift;
+      masks.controls |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(controls))) << shift;
+    }
+  }
+#endif
+
+
+  typedef void (*ClassifyBlock)(const char*, StatsWalesJSONScanner::BlockMasks&);
+
+  ClassifyBlock chooseClassifier() {
+#ifdef BETHYW_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+      return classifyBlockAVX2;
+    }
+#endif
+#ifdef BETHYW_SSE2
+    return classifyBlockSSE2;
+#else
+    return classifyBlockScalar;
+#endif
+  }
+
+
+  /*
+    The fastest way of classifying a block on this processor, chosen once.
+  */
+  ClassifyBlock blockClassifier() {
+    static const ClassifyBlock classifier = chooseClassifier();
+    return classifier;
+  }
+
+
+  /*
+    Check that the document is valid UTF-8 (as nlohmann::json requires of
+    strings, and JSON of everything else), skipping over ASCII 8 bytes at a
+    time. Only the bytes in [begin, end) are checked, which must not split a
+    character.
+  */
+  void validateUtf8(const char* data, size_t begin, size_t end) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    size_t i = begin;
+
+    while (i < end) {
+      if (i + 8 <= end) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        if ((word & 0x8080808080808080ULL) == 0) {
+          i += 8;
+          continue;
+        }
+      }
+
+      const unsigned char lead = bytes[i];
+      if (lead < 0x80) {
+        i++;
+        continue;
+      }
+
+      // The range of the second byte depends on the first, to rule out
+      // overlong encodings, surrogates and code points above U+10FFFF
+      size_t length;
+      unsigned char low = 0x80;
+      unsigned char high = 0xBF;
+
+      if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+      } else if (lead >= 0xE0 && lead <= 0xEF) {
+        length = 3;
+        if (lead == 0xE0) {
+          low = 0xA0;
+        } else if (lead == 0xED) {
+          high = 0x9F;
+        }
+      } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        if (lead == 0xF0) {
+          low = 0x90;
+        } else if (lead == 0xF4) {
+          high = 0x8F;
+        }
+      } else {
+        syntaxError(i, "invalid UTF-8 byte");
+      }
+
+      if (i + length > end || bytes[i + 1] < low || bytes[i + 1] > high) {
+        syntaxError(i, "invalid UTF-8 sequence");
+      }
+
+      for (size_t j = 2; j < length; j++) {
+        if (bytes[i + j] < 0x80 || bytes[i + j] > 0xBF) {
+          syntaxError(i, "invalid UTF-8 sequence");
+        }
+      }
+
+      i += length;
+    }
+  }
+
+
+  void appendUtf8(std::string& out, unsigned long codePoint) {
+    if (codePoint < 0x80) {
+      out.push_back(static_cast<char>(codePoint));
+    } else if (codePoint < 0x800) {
+      out.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+      out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else if (codePoint < 0x10000) {
+      out.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+      out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else {
+      out.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+      out.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+  }
+
+
+  /*
+    A validating parser over the structural index of a document. Values are
+    started with beginValue(), and then either skipped (and checked) with
+    skip(), or decoded into a json value with materialize().
+  */
+  class Walker {
+  public:
+    enum class Kind { Object, Array, String, Scalar };
+
+    // For objects and arrays, begin is the position of the opening bracket.
+    // For strings, [begin, end) are the characters between the quotes, and
+    // for scalars, the characters of the literal or number.
+    struct Value {
+      Kind kind;
+      size_t begin;
+      size_t end;
+    };
+
+  private:
+    const char* data;
+    size_t size;
+    StatsWalesJSONScanner::StructuralIndex index;
+
+    // Everything before the cursor has been parsed
+    size_t cursor;
+
+    std::string scratch;
+
+    size_t skipWhitespace(size_t from, size_t to) const {
+      while (from < to && isWhitespace(data[from])) {
+        from++;
+      }
+      return from;
+    }
+
+    void expectWhitespace(size_t to) const {
+      const size_t nonWhitespace = skipWhitespace(cursor, to);
+      if (nonWhitespace != to) {
+        syntaxError(nonWhitespace, "unexpected character");
+      }
+    }
+
+    void validateScalar(size_t begin, size_t end) const {
+      const char* text = data + begin;
+      const size_t length = end - begin;
+
+      if ((length == 4 && std::memcmp(text, "true", 4) == 0) ||
+          (length == 4 && std::memcmp(text, "null", 4) == 0) ||
+          (length == 5 && std::memcmp(text, "false", 5) == 0)) {
+        return;
+      }
+
+      size_t i = 0;
+      if (text[i] == '-') {
+        i++;
+      }
+
+      if (i < length && text[i] == '0') {
+        i++;
+      } else if (i < length && isDigit(text[i])) {
+        while (i < length && isDigit(text[i])) {
+          i++;
+        }
+      } else {
+        syntaxError(begin, "invalid literal");
+      }
+
+      if (i < length && text[i] == '.') {
+        i++;
+        if (i == length || !isDigit(text[i])) {
+          syntaxError(begin + i, "invalid number");
+        }
+        while (i < length && isDigit(text[i])) {
+          i++;
+        }
+      }
+
+      if (i < length && (text[i] == 'e' || text[i] == 'E')) {
+        i++;
+        if (i < length && (text[i] == '+' || text[i] == '-')) {
+          i++;
+        }
+        if (i == length || !isDigit(text[i])) {
+          syntaxError(begin + i, "invalid number");
+        }
+        while (i < length && isDigit(text[i])) {
+          i++;
+        }
+      }
+
+      if (i != length) {
+        syntaxError(begin + i, "invalid number");
+      }
+
+      // Like nlohmann::json, reject numbers too large for a double. Those
+      // short enough and without a large exponent can't be.
+      const char* exponent = static_cast<const char*>(std::memchr(text, 'e', length));
+      if (exponent == nullptr) {
+        exponent = static_cast<const char*>(std::memchr(text, 'E', length));
+      }
+
+      const size_t exponentDigits = (exponent == nullptr) ? 0 : (text + length) - exponent - 1;
+      if (length >= 24 || exponentDigits >= 3) {
+        double value = 0;
+        string_operations::parseFloatingPointNumber(InputSpan{text, length}, value);
+        if (!std::isfinite(value)) {
+          syntaxError(begin, "number overflow");
+        }
+      }
+    }
+
+    unsigned long hexQuad(size_t position, size_t end) const {
+      if (position + 4 > end) {
+        syntaxError(position, "incomplete \\u escape");
+      }
+
+      unsigned long value = 0;
+      for (size_t i = position; i < position + 4; i++) {
+        const char c = data[i];
+        value <<= 4;
+        if (isDigit(c)) {
+          value |= c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+          value |= c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+          value |= c - 'A' + 10;
+        } else {
+          syntaxError(i, "invalid \\u escape");
+        }
+      }
+
+      return value;
+    }
+
+  public:
+    // Walk the document, or only [begin, size) of it
+    Walker(const char* data_, size_t size_, size_t begin = 0) :
+            data(data_),
+            size(size_),
+            index(data_, size_, begin),
+            cursor(begin),
+            scratch() {
+      // Like nlohmann::json, skip a byte order mark
+      if (begin == 0 && size >= 3 && std::memcmp(data, BYTE_ORDER_MARK, 3) == 0) {
+        cursor = 3;
+      }
+    }
+
+    Value beginValue() {
+      const size_t token = index.peek();
+      const size_t gapEnd = (token == StatsWalesJSONScanner::StructuralIndex::END) ? size : token;
+      const size_t begin = skipWhitespace(cursor, gapEnd);
+
+      // Literals and numbers aren't in the index, so are whatever is between
+      // the last structural character and the next one
+      if (begin < gapEnd) {
+        size_t end = begin;
+        while (end < gapEnd && !isWhitespace(data[end])) {
+          end++;
+        }
+
+        cursor = end;
+        expectWhitespace(gapEnd);
+        validateScalar(begin, end);
+        cursor = gapEnd;
+        return Value{Kind::Scalar, begin, end};
+      }
+
+      if (token == StatsWalesJSONScanner::StructuralIndex::END) {
+        syntaxError(size, "unexpected end of input");
+      }
+
+      index.take();
+      cursor = token + 1;
+
+      switch (data[token]) {
+        case '{':
+          return Value{Kind::Object, token, token};
+        case '[':
+          return Value{Kind::Array, token, token};
+        case '"': {
+          // Nothing is indexed inside strings, so the next position is
+          // always the closing quote
+          const size_t close = index.take();
+          if (close == StatsWalesJSONScanner::StructuralIndex::END || data[close] != '"') {
+            syntaxError(token, "unterminated string");
+          }
+          cursor = close + 1;
+          return Value{Kind::String, token + 1, close};
+        }
+        default:
+          syntaxError(token, std::string("unexpected '") + data[token] + "'");
+      }
+    }
+
+    void expect(char c) {
+      const size_t token = index.peek();
+      if (token == StatsWalesJSONScanner::StructuralIndex::END) {
+        syntaxError(size, std::string("expected '") + c + "'");
+      }
+
+      expectWhitespace(token);
+      if (data[token] != c) {
+        syntaxError(token, std::string("expected '") + c + "'");
+      }
+
+      index.take();
+      cursor = token + 1;
+    }
+
+    // Expect a ',' or the closer of a container. Returns whether it was the
+    // closer.
+    bool expectSeparator(char closer) {
+      const size_t token = index.peek();
+      if (token == StatsWalesJSONScanner::StructuralIndex::END) {
+        syntaxError(size, std::string("expected ',' or '") + closer + "'");
+      }
+
+      expectWhitespace(token);
+      if (data[token] != ',' && data[token] != closer) {
+        syntaxError(token, std::string("expected ',' or '") + closer + "'");
+      }
+
+      index.take();
+      cursor = token + 1;
+      return data[token] == closer;
+    }
+
+    // Whether the container that was just opened is empty, consuming the
+    // closer if so
+    bool closesImmediately(char closer) {
+      const size_t token = index.peek();
+      if (token == StatsWalesJSONScanner::StructuralIndex::END || data[token] != closer ||
+          skipWhitespace(cursor, token) != token) {
+        return false;
+      }
+
+      index.take();
+      cursor = token + 1;
+      return true;
+    }
+
+    void expectEnd() {
+      const size_t token = index.peek();
+      if (token != StatsWalesJSONScanner::StructuralIndex::END) {
+        syntaxError(token, "unexpected content after the document");
+      }
+      expectWhitespace(size);
+    }
+
+    // Whether there is nothing left to walk but whitespace
+    bool atEnd() {
+      return index.peek() == StatsWalesJSONScanner::StructuralIndex::END &&
+             skipWhitespace(cursor, size) == size;
+    }
+
+    size_t position() const noexcept {
+      return cursor;
+    }
+
+    // Split the elements of the array that was just opened into ranges of
+    // at least chunkLength bytes, ending at a ',' between elements or the
+    // closing ']', which is consumed. Only brackets are counted, so the
+    // elements themselves are left to be checked when each range is walked.
+    void splitArray(size_t chunkLength, std::vector<StatsWalesJSONScanner::RecordRange>& ranges) {
+      size_t rangeBegin = cursor;
+      size_t depth = 0;
+
+      while (true) {
+        const size_t token = index.take();
+        if (token == StatsWalesJSONScanner::StructuralIndex::END) {
+          syntaxError(size, "expected ',' or ']'");
+        }
+
+        switch (data[token]) {
+          case '{':
+          case '[':
+            depth++;
+            break;
+
+          case '}':
+          case ']':
+            if (depth > 0) {
+              depth--;
+              break;
+            }
+            if (data[token] != ']') {
+              syntaxError(token, "expected ',' or ']'");
+            }
+            ranges.push_back(StatsWalesJSONScanner::RecordRange{rangeBegin, token});
+            cursor = token + 1;
+            return;
+
+          case ',':
+            if (depth == 0 && token - rangeBegin >= chunkLength) {
+              ranges.push_back(StatsWalesJSONScanner::RecordRange{rangeBegin, token});
+              rangeBegin = token + 1;
+            }
+            break;
+
+          default:
+            // Quotes, colons, and commas inside records
+            break;
+        }
+      }
+    }
+
+    Value beginKey() {
+      const Value key = beginValue();
+      if (key.kind != Kind::String) {
+        syntaxError(key.begin, "expected a key");
+      }
+      return key;
+    }
+
+    // The characters of a string, with escapes decoded. If the string has no
+    // escapes, the span points into the document, otherwise into scratch.
+    InputSpan decodeString(const Value& str) {
+      return decodeString(str, scratch);
+    }
+
+    // The same, but with escapes decoded into the given buffer
+    InputSpan decodeString(const Value& str, std::string& buffer) {
+      const char* escape = static_cast<const char*>(
+              std::memchr(data + str.begin, '\\', str.end - str.begin));
+      if (escape == nullptr) {
+        return InputSpan{data + str.begin, str.end - str.begin};
+      }
+
+      buffer.assign(data + str.begin, escape);
+
+      size_t i = escape - data;
+      while (i < str.end) {
+        if (data[i] != '\\') {
+          buffer.push_back(data[i++]);
+          continue;
+        }
+
+        // The closing quote is never escaped, so there is always a character
+        // after the backslash
+        const char c = data[i + 1];
+        i += 2;
+
+        switch (c) {
+          case '"': buffer.push_back('"'); break;
+          case '\\': buffer.push_back('\\'); break;
+          case '/': buffer.push_back('/'); break;
+          case 'b': buffer.push_back('\b'); break;
+          case 'f': buffer.push_back('\f'); break;
+          case 'n': buffer.push_back('\n'); break;
+          case 'r': buffer.push_back('\r'); break;
+          case 't': buffer.push_back('\t'); break;
+          case 'u': {
+            unsigned long codePoint = hexQuad(i, str.end);
+            i += 4;
+
+            if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+              if (i + 2 > str.end || data[i] != '\\' || data[i + 1] != 'u') {
+                syntaxError(i, "expected a low surrogate");
+              }
+              const unsigned long low = hexQuad(i + 2, str.end);
+              if (low < 0xDC00 || low > 0xDFFF) {
+                syntaxError(i, "expected a low surrogate");
+              }
+              codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+              i += 6;
+            } else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF) {
+              syntaxError(i - 6, "unexpected low surrogate");
+            }
+
+            appendUtf8(buffer, codePoint);
+            break;
+          }
+          default:
+            syntaxError(i - 2, "invalid escape");
+        }
+      }
+
+      return InputSpan{buffer.data(), buffer.size()};
+    }
+
+    void skip(const Value& value) {
+      switch (value.kind) {
+        case Kind::Object:
+          if (closesImmediately('}')) {
+            return;
+          }
+          do {
+            decodeString(beginKey());
+            expect(':');
+            skip(beginValue());
+          } while (!expectSeparator('}'));
+          return;
+
+        case Kind::Array:
+          if (closesImmediately(']')) {
+            return;
+          }
+          do {
+            skip(beginValue());
+          } while (!expectSeparator(']'));
+          return;
+
+        case Kind::String:
+          // Only to check the escapes
+          decodeString(value);
+          return;
+
+        case Kind::Scalar:
+          return;
+      }
+    }
+
+    // Decode a value in the same way as nlohmann::json would
+    json materialize(const Value& value) {
+      switch (value.kind) {
+        case Kind::Object:
+        case Kind::Array:
+          // Rare enough in the keys we import to leave to the library
+          skip(value);
+          return json::parse(data + value.begin, data + cursor);
+
+        case Kind::String: {
+          const InputSpan str = decodeString(value);
+          return json(std::string(str.data, str.size));
+        }
+
+        case Kind::Scalar:
+          break;
+      }
+
+      const std::string text(data + value.begin, value.end - value.begin);
+      if (text == "true") {
+        return json(true);
+      } else if (text == "false") {
+        return json(false);
+      } else if (text == "null") {
+        return json(nullptr);
+      }
+
+      // Integers that fit are kept as integers, and the rest are parsed as
+      // doubles, which (unlike strtod) doesn't depend on the locale
+      if (text.find_first_of(".eE") == std::string::npos) {
+        char* end = nullptr;
+        errno = 0;
+
+        if (text[0] == '-') {
+          const long long integer = std::strtoll(text.c_str(), &end, 10);
+          if (errno == 0 && *end == '\0') {
+            return json(static_cast<json::number_integer_t>(integer));
+          }
+        } else {
+          const unsigned long long integer = std::strtoull(text.c_str(), &end, 10);
+          if (errno == 0 && *end == '\0') {
+            return json(static_cast<json::number_unsigned_t>(integer));
+          }
+        }
+      }
+
+      double value = 0;
+      string_operations::parseFloatingPointNumber(InputSpan{text.data(), text.size()}, value);
+      return json(value);
+    }
+  };
+
+
+  /*
+    The columns of the record being scanned, reused for each record. Strings
+    and scalars are only found as the record is walked, and are decoded once
+    the whole record has passed the plan's filter.
+  */
+  struct RecordColumns {
+    JSONColumnPlan::Values values;
+    std::vector<Walker::Value> fields;
+    std::vector<bool> found;
+
+    // Only used if the plan has a filter
+    JSONColumnPlan::Strings strings;
+    std::vector<std::string> buffers;
+
+    explicit RecordColumns(size_t size) :
+            values(size),
+            fields(size, Walker::Value{Walker::Kind::Scalar, 0, 0}),
+            found(size, false),
+            strings(size, InputSpan{nullptr, 0}),
+            buffers(size) {}
+  };
+
+
+  /*
+    Decode the columns of a record of the value array, and hand them to
+    importRecord, unless the record is rejected by the plan's filter.
+  */
+  void scanRecord(
+          Walker& walker,
+          const Walker::Value& element,
+          JSONColumnPlan& plan,
+          RecordColumns& record,
+          const std::function<void(const JSONColumnPlan::Values&)>& importRecord) {
+    if (element.kind != Walker::Kind::Object) {
+      throw std::runtime_error("expected each record in the value array to be an object, but got " +
+                               std::string(walker.materialize(element).type_name()));
+    }
+
+    for (size_t i = 0; i < record.values.size(); i++) {
+      record.values[i] = nullptr;
+      record.found[i] = false;
+    }
+
+    plan.beginRecord(element.begin);
+    if (!walker.closesImmediately('}')) {
+      do {
+        const InputSpan key = walker.decodeString(walker.beginKey());
+        const int column = plan.column(key.data, key.size);
+        walker.expect(':');
+
+        const Walker::Value field = walker.beginValue();
+        if (column == JSONColumnPlan::SKIP) {
+          walker.skip(field);
+        } else if (field.kind == Walker::Kind::Object || field.kind == Walker::Kind::Array) {
+          // These have to be walked now, so are decoded now
+          record.values[column] = walker.materialize(field);
+          record.found[column] = false;
+        } else {
+          record.fields[column] = field;
+          record.found[column] = true;
+        }
+      } while (!walker.expectSeparator('}'));
+    }
+    plan.endRecord();
+
+    if (plan.hasRecordFilter()) {
+      // Decoding the strings also checks them, even if the record is rejected
+      for (size_t i = 0; i < record.values.size(); i++) {
+        const bool isString = record.found[i] && record.fields[i].kind == Walker::Kind::String;
+        record.strings[i] = isString ? walker.decodeString(record.fields[i], record.buffers[i])
+                                     : InputSpan{nullptr, 0};
+      }
+
+      if (!plan.acceptsRecord(record.strings)) {
+        return;
+      }
+    }
+
+    for (size_t i = 0; i < record.values.size(); i++) {
+      if (record.found[i]) {
+        record.values[i] = walker.materialize(record.fields[i]);
+      }
+    }
+
+    importRecord(record.values);
+  }
+
+  /*
+    Split the elements of a value array that was just opened into ranges of
+    records (see Walker::splitArray()), and check the characters between
+    them, from checked onwards, which is moved to the end of the last range.
+  */
+  void splitValueArray(
+          Walker& walker,
+          const InputSpan& document,
+          size_t count,
+          std::vector<StatsWalesJSONScanner::RecordRange>& ranges,
+          size_t& checked) {
+    const size_t chunkLength = (document.size - walker.position()) / std::max<size_t>(count, 1);
+    const size_t first = ranges.size();
+    walker.splitArray(std::max<size_t>(chunkLength, 1), ranges);
+
+    validateUtf8(document.data, checked, ranges[first].begin);
+    for (size_t i = first + 1; i < ranges.size(); i++) {
+      validateUtf8(document.data, ranges[i - 1].end, ranges[i].begin);
+    }
+    checked = ranges.back().end;
+  }
+
+
+  /*
+    Walk the next member of the top-level object, splitting its records into
+    ranges if it is a value array.
+  */
+  void splitMember(
+          Walker& walker,
+          const InputSpan& document,
+          size_t count,
+          std::vector<StatsWalesJSONScanner::RecordRange>& ranges,
+          size_t& checked) {
+    const InputSpan name = walker.decodeString(walker.beginKey());
+    const bool isValueKey = (name.size == 5 && std::memcmp(name.data, "value", 5) == 0);
+    walker.expect(':');
+
+    const Walker::Value member = walker.beginValue();
+    if (!isValueKey || member.kind != Walker::Kind::Array) {
+      walker.skip(member);
+      return;
+    }
+
+    if (!walker.closesImmediately(']')) {
+      splitValueArray(walker, document, count, ranges, checked);
+    }
+  }
+} // end of anonymous namespace
+
+
+const int JSONColumnPlan::SKIP = -1;
+
+const size_t JSONColumnPlan::UNKNOWN_OFFSET = static_cast<size_t>(-1);
+
+/*
+  Construct a plan for importing some columns, which is resolved against the
+  first record it is used with.
+
+  @param columns_
+    The keys of the columns to import
+
+  @example
+    JSONColumnPlan plan({"Localauthority_Code", "Year_Code", "Data"});
+*/
+JSONColumnPlan::JSONColumnPlan(std::vector<std::string> columns_) :
+        columns(std::move(columns_)),
+        order(),
+        orderColumns(),
+        resolved(false),
+        resolutions(0),
+        records(0),
+        recordOffset(UNKNOWN_OFFSET),
+        position(0),
+        matching(false),
+        recordOrder(),
+        recordColumns(),
+        filter() {}
+
+/*
+  The column of a key, by comparing it with each column.
+*/
+int JSONColumnPlan::lookup(const char* key, size_t length) const noexcept {
+  for (size_t i = 0; i < columns.size(); i++) {
+    if (columns[i].size() == length && std::memcmp(columns[i].data(), key, length) == 0) {
+      return static_cast<int>(i);
+    }
+  }
+
+  return SKIP;
+}
+
+/*
+  The number of columns.
+
+  @return
+    The number of columns
+*/
+size_t JSONColumnPlan::size() const noexcept {
+  return columns.size();
+}
+
+/*
+  Start finding the columns of the keys of a record.
+
+  @param offset
+    The offset of the record's opening brace in the document, if the parser
+    knows it
+*/
+void JSONColumnPlan::beginRecord(size_t offset) noexcept {
+  records++;
+  recordOffset = offset;
+  position = 0;
+  matching = resolved;
+  recordOrder.clear();
+  recordColumns.clear();
+}
+
+/*
+  Find the column of the next key of the current record.
+
+  @param key
+    The characters of the key
+
+  @param length
+    The number of characters in the key
+
+  @return
+    The index of the column, or SKIP if it isn't imported
+*/
+int JSONColumnPlan::column(const char* key, size_t length) {
+  if (matching) {
+    if (position < order.size() && order[position].size() == length &&
+        std::memcmp(order[position].data(), key, length) == 0) {
+      return orderColumns[position++];
+    }
+
+    // The keys are in a different order, so remember those that matched
+    matching = false;
+    recordOrder.assign(order.begin(), order.begin() + position);
+    recordColumns.assign(orderColumns.begin(), orderColumns.begin() + position);
+  }
+
+  const int found = lookup(key, length);
+  recordOrder.emplace_back(key, length);
+  recordColumns.push_back(found);
+  position++;
+  return found;
+}
+
+/*
+  Finish the current record, resolving the plan against it if its keys
+  didn't match. A record that only has fewer keys than the plan matches.
+*/
+void JSONColumnPlan::endRecord() {
+  if (matching) {
+    return;
+  }
+
+  order.swap(recordOrder);
+  orderColumns.swap(recordColumns);
+  resolved = true;
+  resolutions++;
+}
+
+/*
+  How many times the plan has been resolved against a record, i.e. once if
+  all of the records had their keys in the same order.
+
+  @return
+    The number of times the plan was resolved
+*/
+unsigned int JSONColumnPlan::getResolutions() const noexcept {
+  return resolutions;
+}
+
+/*
+  How many records the plan has been used for so far, including the current
+  one, whether or not they were imported.
+
+  @return
+    The number of records, which is also the number of the current record in
+    the value array, from 1
+*/
+size_t JSONColumnPlan::getRecordCount() const noexcept {
+  return records;
+}
+
+/*
+  The offset of the current record in the document, as given to
+  beginRecord().
+
+  @return
+    The offset of the record's opening brace, or UNKNOWN_OFFSET
+*/
+size_t JSONColumnPlan::getRecordOffset() const noexcept {
+  return recordOffset;
+}
+
+/*
+  Set the filter that decides which records are imported, from the
+  characters of their columns that are strings.
+
+  @param filter_
+    The filter, or an empty function to import every record
+
+  @example
+    JSONColumnPlan plan({"Localauthority_Code", "Data"});
+    plan.setRecordFilter([](const JSONColumnPlan::Strings& strings) {
+      return strings[0].data == nullptr || strings[0].size == 9;
+    });
+*/
+void JSONColumnPlan::setRecordFilter(RecordFilter filter_) {
+  filter = std::move(filter_);
+}
+
+/*
+  Whether the plan has a filter.
+
+  @return
+    true if a filter has been set
+*/
+bool JSONColumnPlan::hasRecordFilter() const noexcept {
+  return static_cast<bool>(filter);
+}
+
+/*
+  Whether a record should be imported, according to the filter.
+
+  @param strings
+    The characters of the columns of the record that are strings
+
+  @return
+    true if the record passes the filter, or there is none
+*/
+bool JSONColumnPlan::acceptsRecord(const Strings& strings) const {
+  return !filter || filter(strings);
+}
+
+
+constexpr size_t StatsWalesJSONScanner::CHUNK_SIZE;
+
+
+/*
+  Construct an index over a document, which is built a chunk at a time as
+  positions are taken from it. Only part of the document may be indexed, as
+  long as it doesn't start inside a string; positions are still from the
+  start of the document.
+
+  @param data_
+    The document
+
+  @param size_
+    The size of the document, or the end of the part to index
+
+  @param begin
+    Where to start indexing, by default the start of the document
+*/
+StatsWalesJSONScanner::StructuralIndex::StructuralIndex(const char* data_, size_t size_, size_t begin) :
+        data(data_),
+        size(size_),
+        indexed(begin),
+        chunkStart(begin),
+        // A document smaller than a chunk (e.g. a single record) only needs
+        // room for the blocks it has
+        offsets(std::min(CHUNK_SIZE, (size_ - std::min(begin, size_) + 63) / 64 * 64) + 4),
+        count(0),
+        next(0),
+        escapeCarry(0),
+        inStringCarry(0) {}
+
+/*
+  Index the next chunk of the document.
+
+  @return
+    false if the whole document has already been indexed
+
+  @throws
+    std::runtime_error if a string contains a control character, or is not
+    terminated
+*/
+bool StatsWalesJSONScanner::StructuralIndex::refill() {
+  if (indexed >= size) {
+    return false;
+  }
+
+  chunkStart = indexed;
+  count = 0;
+  next = 0;
+
+  const ClassifyBlock classify = ::blockClassifier();
+  const size_t chunkEnd = std::min(size, indexed + CHUNK_SIZE);
+  for (size_t block = indexed; block < chunkEnd; block += 64) {
+    BlockMasks masks;
+
+    if (block + 64 <= size) {
+      classify(data + block, masks);
+    } else {
+      char padded[64];
+      std::memset(padded, ' ', sizeof(padded));
+      std::memcpy(padded, data + block, size - block);
+      classify(padded, masks);
+    }
+
+    // A backslash escapes the next character, unless it is escaped itself
+    uint64_t escaped = escapeCarry;
+    escapeCarry = 0;
+
+    uint64_t backslashes = masks.backslashes;
+    while (backslashes != 0) {
+      const unsigned int bit = trailingZeros(backslashes);
+      backslashes &= backslashes - 1;
+
+      if ((escaped >> bit) & 1) {
+        continue;
+      }
+
+      if (bit == 63) {
+        escapeCarry = 1;
+      } else {
+        escaped |= uint64_t(1) << (bit + 1);
+      }
+    }
+
+    // Opening quotes are marked as inside their string, and closing quotes
+    // as outside
+    const uint64_t quotes = masks.quotes & ~escaped;
+    const uint64_t inString = prefixXor(quotes) ^ inStringCarry;
+    inStringCarry = (inString >> 63) ? ~uint64_t(0) : 0;
+
+    const uint64_t controls = masks.controls & inString;
+    if (controls != 0) {
+      syntaxError(block + trailingZeros(controls), "control character in string");
+    }
+
+    // Written four at a time, so that the loop is predictable. The extra
+    // offsets written past the end of those in the block are overwritten by
+    // the next block (or ignored), and there is always room for them.
+    uint32_t* out = offsets.data() + count;
+    const uint32_t offset = static_cast<uint32_t>(block - chunkStart);
+
+    uint64_t tokens = (masks.structurals & ~inString) | quotes;
+    const unsigned int found = populationCount(tokens);
+    for (unsigned int i = 0; i < found; i += 4) {
+      out[i] = offset + trailingZeros(tokens | HIGHEST_BIT);
+      tokens &= tokens - 1;
+      out[i + 1] = offset + trailingZeros(tokens | HIGHEST_BIT);
+      tokens &= tokens - 1;
+      out[i + 2] = offset + trailingZeros(tokens | HIGHEST_BIT);
+      tokens &= tokens - 1;
+      out[i + 3] = offset + trailingZeros(tokens | HIGHEST_BIT);
+      tokens &= tokens - 1;
+    }
+    count += found;
+  }
+
+  indexed = chunkEnd;
+
+  if (indexed >= size && inStringCarry != 0) {
+    syntaxError(size, "unterminated string");
+  }
+
+  return true;
+}
+
+/*
+  The position of the next structural character, without taking it.
+
+  @return
+    The position, or END if there are no more
+
+  @throws
+    std::runtime_error if the document is malformed (see refill())
+*/
+size_t StatsWalesJSONScanner::StructuralIndex::peek() noexcept(false) {
+  while (next == count) {
+    if (!refill()) {
+      return END;
+    }
+  }
+
+  return chunkStart + offsets[next];
+}
+
+/*
+  The position of the next structural character, taking it.
+
+  @return
+    The position, or END if there are no more
+
+  @throws
+    std::runtime_error if the document is malformed (see refill())
+*/
+size_t StatsWalesJSONScanner::StructuralIndex::take() noexcept(false) {
+  const size_t position = peek();
+  if (position != END) {
+    next++;
+  }
+
+  return position;
+}
+
+/*
+  Construct a scanner over a StatsWales JSON document.
+
+  @param document_
+    The document, which must outlive the scanner
+
+  @example
+    InputMappedFile input("datasets/popu1009.json");
+    StatsWalesJSONScanner scanner(input.span());
+*/
+StatsWalesJSONScanner::StatsWalesJSONScanner(const InputSpan& document_) :
+        document(document_) {}
+
+/*
+  Call a function with the values of the columns of each record in the value
+  array of the document, in order. Columns the record doesn't have are null.
+
+  @param plan
+    The columns to import, which is resolved against the records as they are
+    scanned
+
+  @param importRecord
+    The function to call with the values of each record
+
+  @throws
+    std::runtime_error if the document is not valid JSON, is an array, or has
+    a record that isn't an object
+
+  @example
+    InputMappedFile input("datasets/popu1009.json");
+    StatsWalesJSONScanner scanner(input.span());
+    JSONColumnPlan plan({"Localauthority_Code", "Data"});
+    scanner.forEachRecord(plan, [](const JSONColumnPlan::Values& values) {
+      std::cout << values[1] << std::endl;
+    });
+*/
+void StatsWalesJSONScanner::forEachRecord(
+        JSONColumnPlan& plan,
+        const std::function<void(const JSONColumnPlan::Values&)>& importRecord) const noexcept(false) {
+  validateUtf8(document.data, 0, document.size);
+
+  Walker walker(document.data, document.size);
+  const Walker::Value top = walker.beginValue();
+
+  if (top.kind == Walker::Kind::Array) {
+    throw std::runtime_error("expected a JSON object with a value array");
+  }
+
+  if (top.kind != Walker::Kind::Object) {
+    walker.skip(top);
+    walker.expectEnd();
+    return;
+  }
+
+  if (walker.closesImmediately('}')) {
+    walker.expectEnd();
+    return;
+  }
+
+  RecordColumns record(plan.size());
+
+  do {
+    const InputSpan name = walker.decodeString(walker.beginKey());
+    const bool isValueKey = (name.size == 5 && std::memcmp(name.data, "value", 5) == 0);
+    walker.expect(':');
+
+    const Walker::Value member = walker.beginValue();
+    if (!isValueKey || member.kind != Walker::Kind::Array) {
+      walker.skip(member);
+      continue;
+    }
+
+    if (walker.closesImmediately(']')) {
+      continue;
+    }
+
+    do {
+      ::scanRecord(walker, walker.beginValue(), plan, record, importRecord);
+    } while (!walker.expectSeparator(']'));
+  } while (!walker.expectSeparator('}'));
+
+  walker.expectEnd();
+}
+
+/*
+  Split the records of the value array of the document into ranges of
+  roughly equal size, so that they can be scanned by separate threads with
+  forEachRecord(). Only the brackets of the records are counted to find where
+  they end, which is much quicker than scanning them; the rest of the
+  document is checked.
+
+  @param count
+    The number of ranges wanted. There may be fewer, if there are fewer
+    records, or a few more, if the document has more than one value array.
+
+  @return
+    The ranges, in the order of the records in the document
+
+  @throws
+    std::runtime_error if the document is not valid JSON outside of the
+    records (or their brackets don't match), or is an array
+
+  @example
+    InputMappedFile input("datasets/popu1009.json");
+    StatsWalesJSONScanner scanner(input.span());
+    auto ranges = scanner.splitRecords(4);
+*/
+std::vector<StatsWalesJSONScanner::RecordRange> StatsWalesJSONScanner::splitRecords(
+        size_t count) const noexcept(false) {
+  std::vector<RecordRange> ranges;
+
+  Walker walker(document.data, document.size);
+  const Walker::Value top = walker.beginValue();
+
+  if (top.kind == Walker::Kind::Array) {
+    throw std::runtime_error("expected a JSON object with a value array");
+  }
+
+  // Everything outside of the ranges is checked here, and the ranges when
+  // they are scanned
+  size_t checked = 0;
+
+  if (top.kind != Walker::Kind::Object) {
+    walker.skip(top);
+  } else if (!walker.closesImmediately('}')) {
+    do {
+      ::splitMember(walker, document, count, ranges, checked);
+    } while (!walker.expectSeparator('}'));
+  }
+
+  walker.expectEnd();
+  validateUtf8(document.data, checked, document.size);
+
+  return ranges;
+}
+
+/*
+  Split the records that have been appended to the value array of the
+  document since it was last split, as splitRecords() does. The document up
+  to the end of the records split last time must not have changed (e.g. the
+  file has only had records appended to it), and is not checked again.
+
+  @param end
+    The end of the last range from the last time the document was split,
+    i.e. the ',' or ']' after the last record
+
+  @param count
+    The number of ranges wanted
+
+  @return
+    The ranges of the records after end, in order, which is empty if none
+    have been appended
+
+  @throws
+    std::runtime_error if the document is not valid JSON after end (outside
+    of the records), or end isn't the end of a range of records
+
+  @example
+    InputMappedFile input("datasets/popu1009.json");
+    StatsWalesJSONScanner scanner(input.span());
+    auto appended = scanner.splitRecordsAfter(watermark, 1);
+*/
+std::vector<StatsWalesJSONScanner::RecordRange> StatsWalesJSONScanner::splitRecordsAfter(
+        size_t end,
+        size_t count) const noexcept(false) {
+  if (end >= document.size || (document.data[end] != ',' && document.data[end] != ']')) {
+    throw std::runtime_error("expected the records to end with ',' or ']' at position " + std::to_string(end));
+  }
+
+  std::vector<RecordRange> ranges;
+  size_t checked = end;
+
+  // The value array is still open, so finish it, then the rest of the
+  // top-level object
+  Walker walker(document.data, document.size, end);
+  if (!walker.expectSeparator(']')) {
+    ::splitValueArray(walker, document, count, ranges, checked);
+  }
+
+  while (!walker.expectSeparator('}')) {
+    ::splitMember(walker, document, count, ranges, checked);
+  }
+
+  walker.expectEnd();
+  validateUtf8(document.data, checked, document.size);
+
+  return ranges;
+}
+
+/*
+  Call a function with the values of the columns of each record in a range
+  of the value array found by splitRecords(), in order. Ranges can be
+  scanned at the same time by different threads, each with its own plan.
+
+  @param range
+    The range of records
+
+  @param plan
+    The columns to import, which is resolved against the records as they are
+    scanned
+
+  @param importRecord
+    The function to call with the values of each record
+
+  @throws
+    std::runtime_error if a record is not valid JSON or isn't an object
+
+  @example
+    InputMappedFile input("datasets/popu1009.json");
+    StatsWalesJSONScanner scanner(input.span());
+    for (const auto& range : scanner.splitRecords(4)) {
+      JSONColumnPlan plan({"Localauthority_Code", "Data"});
+      scanner.forEachRecord(range, plan, [](const JSONColumnPlan::Values& values) {
+        std::cout << values[1] << std::endl;
+      });
+    }
+*/
+void StatsWalesJSONScanner::forEachRecord(
+        const RecordRange& range,
+        JSONColumnPlan& plan,
+        const std::function<void(const JSONColumnPlan::Values&)>& importRecord) const noexcept(false) {
+  validateUtf8(document.data, range.begin, range.end);
+
+  Walker walker(document.data, range.end, range.begin);
+  RecordColumns record(plan.size());
+
+  while (true) {
+    ::scanRecord(walker, walker.beginValue(), plan, record, importRecord);
+    if (walker.atEnd()) {
+      break;
+    }
+    walker.expect(',');
+  }
+}
+
+/*
+  Call a function with the values of the columns of the document, which is
+  a single record rather than a document with a value array, e.g. a line of
+  a newline-delimited StatsWales JSON file.
+
+  @param plan
+    The columns to import, which is resolved against the record as it is
+    scanned
+
+  @param importRecord
+    The function to call with the values of the record
+
+  @throws
+    std::runtime_error if the document is not valid JSON, or isn't an object
+
+  @example
+    const std::string line = "{\"Data\": 12.5, \"Localauthority_Code\": \"W06000011\"}";
+    StatsWalesJSONScanner scanner(InputSpan{line.data(), line.size()});
+    JSONColumnPlan plan({"Localauthority_Code", "Data"});
+    scanner.scanRecord(plan, [](const JSONColumnPlan::Values& values) {
+      std::cout << values[1] << std::endl;
+    });
+*/
+void StatsWalesJSONScanner::scanRecord(
+        JSONColumnPlan& plan,
+        const std::function<void(const JSONColumnPlan::Values&)>& importRecord) const noexcept(false) {
+  validateUtf8(document.data, 0, document.size);
+
+  Walker walker(document.data, document.size);
+  RecordColumns record(plan.size());
+
+  ::scanRecord(walker, walker.beginValue(), plan, record, importRecord);
+  walker.expectEnd();
+}
+
+/*
+  Classify the 64 bytes of a block of a document, with the fastest
+  instructions the processor supports.
+
+  @param block
+    The 64 bytes
+
+  @param masks
+    Set to a bit for each quote, backslash, structural character and control
+    character in the block
+*/
+void StatsWalesJSONScanner::classifyBlock(const char* block, BlockMasks& masks) noexcept {
+  ::blockClassifier()(block, masks);
+}
+
+/*
+  Whether blocks are classified with AVX2 instructions, rather than SSE2 (or
+  one byte at a time on other processors).
+
+  @return
+    true if AVX2 is used
+*/
+bool StatsWalesJSONScanner::isUsingAVX2() noexcept {
+#ifdef BETHYW_AVX2
+  return ::blockClassifier() == classifyBlockAVX2;
+#else
+  return false;
+#endif
+}
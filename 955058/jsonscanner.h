@@ -0,0 +1,218 @@
+#ifndef JSONSCANNER_H_
+#define JSONSCANNER_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  This file contains the declaration of StatsWalesJSONScanner, a tokenizer
+  for StatsWales JSON documents that are entirely in memory (e.g. mapped
+  with InputMappedFile). It only decodes the keys we import from each record
+  of the "value" array, and skips over everything else without building it.
+
+  It also contains JSONColumnPlan, which works out which of those keys each
+  key of a record is, for both the tokenizer and the SAX parser in areas.cpp.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "lib_json.hpp"
+
+#include "input.h"
+
+/*
+  The columns imported from the records of a document, resolved against the
+  order of the keys in the first record. The records of a StatsWales document
+  all have their keys in the same order, so the column of each key in later
+  records is found by its position, which only needs one comparison to check.
+
+  If a record's keys are in a different order (or it has other keys), its
+  keys are looked up among the columns instead, and the plan is resolved
+  again against its order at the end of the record.
+
+  The values of a record's columns are kept in a vector, in the order the
+  columns were given in.
+
+  A plan can also have a filter, which is given the characters of the
+  columns of each record that are strings (without building them into
+  values) to decide whether the record is imported at all. Records it
+  rejects are still checked to be valid JSON, but nothing else.
+*/
+class JSONColumnPlan {
+public:
+  // The column of a key that isn't imported
+  static const int SKIP;
+
+  // The offset of a record whose parser can't tell where it is
+  static const size_t UNKNOWN_OFFSET;
+
+  typedef std::vector<nlohmann::json> Values;
+
+  // The characters of each column of a record, if it is a string. Columns
+  // that the record doesn't have, or that aren't strings, have null data.
+  typedef std::vector<InputSpan> Strings;
+
+  // Whether a record should be imported, from its Strings. Records should
+  // only be rejected if they would be ignored when they are imported.
+  typedef std::function<bool(const Strings&)> RecordFilter;
+
+private:
+  std::vector<std::string> columns;
+
+  // The keys of the record the plan was resolved against, and their columns
+  std::vector<std::string> order;
+  std::vector<int> orderColumns;
+  bool resolved;
+  unsigned int resolutions;
+  size_t records;
+  size_t recordOffset;
+
+  // The position in the current record, and whether its keys have matched
+  // the plan so far. If not, its keys and their columns.
+  size_t position;
+  bool matching;
+  std::vector<std::string> recordOrder;
+  std::vector<int> recordColumns;
+
+  RecordFilter filter;
+
+  int lookup(const char* key, size_t length) const noexcept;
+
+public:
+  explicit JSONColumnPlan(std::vector<std::string> columns_);
+
+  size_t size() const noexcept;
+
+  void beginRecord(size_t offset = UNKNOWN_OFFSET) noexcept;
+
+  int column(const char* key, size_t length);
+
+  void endRecord();
+
+  unsigned int getResolutions() const noexcept;
+
+  size_t getRecordCount() const noexcept;
+
+  size_t getRecordOffset() const noexcept;
+
+  void setRecordFilter(RecordFilter filter_);
+
+  bool hasRecordFilter() const noexcept;
+
+  bool acceptsRecord(const Strings& strings) const;
+};
+
+/*
+  The tokenizer works in two stages, as in simdjson:
+
+    1. A structural index is built for a chunk of the document at a time: the
+       positions of all quotes, and of the characters { } [ ] : , that are not
+       inside strings. 64 bytes are classified at once with SSE2 (or AVX2, if
+       the processor supports it), and whether each byte is inside a string
+       is worked out from the quotes with a few bit operations.
+
+    2. The positions in the index are walked in order, as a validating parser
+       of the JSON grammar. Strings and numbers are only decoded for the keys
+       in a record that we were asked for; the rest are only checked.
+
+  The values of the columns of each record in the value array (see
+  JSONColumnPlan) are handed to a callback, in the same way as the SAX parser
+  does in areas.cpp. Everything outside the value array is skipped.
+
+  The value array can also be split into ranges of records first, with a
+  quick scan that only counts brackets, so that the ranges can be scanned by
+  several threads at once. Records appended to a document that was split
+  before can be split on their own, without walking the document again.
+
+  A document can also be a single record on its own, e.g. a line of a
+  newline-delimited file of records.
+
+  Malformed documents are rejected with std::runtime_error, although the
+  messages differ from nlohmann::json's.
+*/
+class StatsWalesJSONScanner {
+public:
+  // The number of bytes indexed at a time. Must be a multiple of 64.
+  static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+  // The bitmasks of one 64-byte block of the document, one bit per byte
+  struct BlockMasks {
+    uint64_t quotes;
+    uint64_t backslashes;
+    uint64_t structurals;
+    uint64_t controls;
+  };
+
+  // A range of the records in the value array, from the first character of
+  // the first record to the ',' or ']' after the last
+  struct RecordRange {
+    size_t begin;
+    size_t end;
+  };
+
+  // The positions of the structural characters in the document
+  class StructuralIndex {
+  private:
+    const char* data;
+    size_t size;
+
+    // How far the document has been indexed, and the index of the last
+    // chunk, as offsets from its start
+    size_t indexed;
+    size_t chunkStart;
+    std::vector<uint32_t> offsets;
+    size_t count;
+    size_t next;
+
+    // State carried from one 64-byte block to the next
+    uint64_t escapeCarry;
+    uint64_t inStringCarry;
+
+    bool refill();
+
+  public:
+    static const size_t END = static_cast<size_t>(-1);
+
+    StructuralIndex(const char* data_, size_t size_, size_t begin = 0);
+
+    size_t peek() noexcept(false);
+
+    size_t take() noexcept(false);
+  };
+
+private:
+  InputSpan document;
+
+public:
+  explicit StatsWalesJSONScanner(const InputSpan& document_);
+
+  void forEachRecord(
+          JSONColumnPlan& plan,
+          const std::function<void(const JSONColumnPlan::Values&)>& importRecord) const noexcept(false);
+
+  std::vector<RecordRange> splitRecords(size_t count) const noexcept(false);
+
+  std::vector<RecordRange> splitRecordsAfter(size_t end, size_t count) const noexcept(false);
+
+  void forEachRecord(
+          const RecordRange& range,
+          JSONColumnPlan& plan,
+          const std::function<void(const JSONColumnPlan::Values&)>& importRecord) const noexcept(false);
+
+  void scanRecord(
+          JSONColumnPlan& plan,
+          const std::function<void(const JSONColumnPlan::Values&)>& importRecord) const noexcept(false);
+
+  static void classifyBlock(const char* block, BlockMasks& masks) noexcept;
+
+  static bool isUsingAVX2() noexcept;
+};
+
+#endif // JSONSCANNER_H_
@@ -0,0 +1,711 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  This file contains the implementation of DatasetSchema.
+*/
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "lib_json.hpp"
+
+#include "schema.h"
+#include "csvscanner.h"
+
+using json = nlohmann::json;
+
+// Anonymous namespace for helper functions private to schema.cpp.
+namespace {
+  const char UTF8_BOM[] = "\xEF\xBB\xBF";
+  const size_t UTF8_BOM_SIZE = sizeof(UTF8_BOM) - 1;
+
+
+  bool equalsIgnoringCase(const std::string& a, const std::string& b) {
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+             return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+           });
+  }
+
+
+  bool endsWithIgnoringCase(const std::string& str, const std::string& suffix) {
+    return str.size() > suffix.size() && ::equalsIgnoringCase(str.substr(str.size() - suffix.size()), suffix);
+  }
+
+
+  bool containsIgnoringCase(const std::string& str, const std::string& part) {
+    return std::search(str.begin(), str.end(), part.begin(), part.end(), [](char x, char y) {
+      return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+    }) != str.end();
+  }
+
+
+  // A year as StatsWales gives them, e.g. 2019
+  bool isYear(const std::string& str) {
+    return str.size() == 4 && (str[0] == '1' || str[0] == '2') &&
+           std::all_of(str.begin(), str.end(), [](char c) { return c >= '0' && c <= '9'; });
+  }
+
+
+  // A code of the Office for National Statistics, e.g. W06000011
+  bool isAreaCode(const std::string& str) {
+    return str.size() == 9 && str[0] >= 'A' && str[0] <= 'Z' &&
+           std::all_of(str.begin() + 1, str.end(), [](char c) { return c >= '0' && c <= '9'; });
+  }
+
+
+  bool isNumber(const json& value) {
+    if (value.is_number()) {
+      return true;
+    }
+
+    if (!value.is_string()) {
+      return false;
+    }
+
+    const std::string& str = value.get_ref<const std::string&>();
+    char* end = nullptr;
+    std::strtod(str.c_str(), &end);
+    return !str.empty() && end == str.c_str() + str.size();
+  }
+
+
+  // The code of a record's dimension, as a string whatever type it is given as
+  std::string codeOf(const json& record, const std::string& key) {
+    const auto found = record.find(key);
+    if (found == record.end() || found->is_null()) {
+      return "";
+    }
+
+    return found->is_string() ? found->get<std::string>() : found->dump();
+  }
+
+
+  /*
+    The first records of the value array of a StatsWales JSON document, from
+    as much of the start of it as there is. Records cut off at the end of
+    the sample are left out.
+  */
+  std::vector<json> sampleWelshStatsJSON(const std::string& text) {
+    auto skipSpace = [&text](size_t position) {
+      while (position < text.size() && std::isspace(static_cast<unsigned char>(text[position]))) {
+        position++;
+      }
+      return position;
+    };
+
+    // The value array is the first member named value (the quotes of any
+    // string containing "value" are escaped, so it can't be inside one)
+    size_t position = std::string::npos;
+    for (size_t key = text.find("\"value\""); key != std::string::npos; key = text.find("\"value\"", key + 1)) {
+      size_t colon = skipSpace(key + 7);
+      if (colon < text.size() && text[colon] == ':') {
+        size_t array = skipSpace(colon + 1);
+        if (array < text.size() && text[array] == '[') {
+          position = array + 1;
+          break;
+        }
+      }
+    }
+
+    if (position == std::string::npos) {
+      throw std::runtime_error("there is no value array at the start of the file");
+    }
+
+    std::vector<json> records;
+    while (records.size() < DatasetSchema::SAMPLE_RECORDS) {
+      position = skipSpace(position);
+      if (position >= text.size() || text[position] != '{') {
+        break;
+      }
+
+      // Find the end of the record by its brackets, outside of strings
+      size_t end = position;
+      int depth = 0;
+      bool inString = false;
+      for (; end < text.size(); end++) {
+        const char c = text[end];
+        if (inString) {
+          if (c == '\\') {
+            end++;
+          } else if (c == '"') {
+            inString = false;
+          }
+        } else if (c == '"') {
+          inString = true;
+        } else if (c == '{' || c == '[') {
+          depth++;
+        } else if ((c == '}' || c == ']') && --depth == 0) {
+          break;
+        }
+      }
+
+      if (end >= text.size()) {
+        break;
+      }
+
+      records.push_back(json::parse(text.begin() + position, text.begin() + end + 1));
+
+      position = skipSpace(end + 1);
+      if (position >= text.size() || text[position] != ',') {
+        break;
+      }
+      position++;
+    }
+
+    if (records.empty()) {
+      throw std::runtime_error("there are no records at the start of its value array");
+    }
+
+    return records;
+  }
+
+
+  /*
+    Whether the text from start is newline-delimited StatsWales JSON, i.e.
+    its first line is a whole record rather than the start of a document.
+  */
+  bool isWelshStatsNDJSON(const std::string& text, size_t start) {
+    const size_t newline = text.find('\n', start);
+    if (newline == std::string::npos) {
+      return false;
+    }
+
+    const json first = json::parse(text.begin() + start, text.begin() + newline, nullptr, false);
+    return first.is_object() && first.count("value") == 0;
+  }
+
+
+  /*
+    The first records of a newline-delimited StatsWales JSON file, one to a
+    line, from as much of the start of it as there is. The last line is left
+    out if it is cut off at the end of the sample.
+  */
+  std::vector<json> sampleWelshStatsNDJSON(const std::string& text, size_t start) {
+    std::vector<json> records;
+
+    for (size_t newline = text.find('\n', start);
+         newline != std::string::npos && records.size() < DatasetSchema::SAMPLE_RECORDS;
+         start = newline + 1, newline = text.find('\n', start)) {
+      const bool blank = std::all_of(text.begin() + start, text.begin() + newline, [](char c) {
+        return std::isspace(static_cast<unsigned char>(c)) != 0;
+      });
+
+      if (!blank) {
+        records.push_back(json::parse(text.begin() + start, text.begin() + newline));
+      }
+    }
+
+    if (records.empty()) {
+      throw std::runtime_error("there are no whole lines at the start of the file");
+    }
+
+    return records;
+  }
+
+
+  /*
+    A dimension of the records of a StatsWales JSON document, and its codes
+    in each of the records sampled.
+  */
+  struct Dimension {
+    std::string name;
+    std::string codeKey;
+    std::string nameKey;
+    std::vector<std::string> codes;
+
+    size_t distinctCodes() const {
+      return std::set<std::string>(codes.begin(), codes.end()).size();
+    }
+
+    size_t count(bool (*matches)(const std::string&)) const {
+      return static_cast<size_t>(std::count_if(codes.begin(), codes.end(), matches));
+    }
+  };
+
+
+  DatasetSchema detectWelshStatsJSON(const std::vector<json>& records, const std::string& measureCode) {
+    using SC = BethYw::SourceColumn;
+    const json& first = records.front();
+
+    std::vector<Dimension> dimensions;
+    for (const auto& member : first.items()) {
+      if (!::endsWithIgnoringCase(member.key(), "_Code")) {
+        continue;
+      }
+
+      Dimension dimension;
+      dimension.name = member.key().substr(0, member.key().size() - 5);
+      dimension.codeKey = member.key();
+      dimension.nameKey = member.key();
+      for (const auto& other : first.items()) {
+        if (::equalsIgnoringCase(other.key(), dimension.name + "_ItemName_ENG")) {
+          dimension.nameKey = other.key();
+        }
+      }
+
+      for (const json& record : records) {
+        dimension.codes.push_back(::codeOf(record, dimension.codeKey));
+      }
+      dimensions.push_back(dimension);
+    }
+
+    // The year, preferring a dimension named for it if several have years
+    auto year = dimensions.end();
+    for (auto it = dimensions.begin(); it != dimensions.end(); it++) {
+      if (it->count(::isYear) == records.size() &&
+          (year == dimensions.end() || ::containsIgnoringCase(it->name, "year"))) {
+        year = it;
+      }
+    }
+
+    if (year == dimensions.end()) {
+      throw std::runtime_error("no key ending in _Code has years for its values");
+    }
+    const Dimension yearDimension = *year;
+    dimensions.erase(year);
+
+    // The areas, which StatsWales sometimes mixes with codes of its own
+    // (e.g. for all of Wales)
+    auto area = dimensions.end();
+    for (auto it = dimensions.begin(); it != dimensions.end(); it++) {
+      if (it->count(::isAreaCode) * 2 >= records.size() &&
+          (area == dimensions.end() || it->count(::isAreaCode) > area->count(::isAreaCode))) {
+        area = it;
+      }
+    }
+
+    if (area == dimensions.end()) {
+      throw std::runtime_error("no key ending in _Code has area codes (e.g. W06000011) for its values");
+    }
+    const Dimension areaDimension = *area;
+    dimensions.erase(area);
+
+    // The values, in Data in every StatsWales table, otherwise in the first
+    // key that isn't of a dimension and only has numbers
+    std::string valueKey;
+    for (const auto& member : first.items()) {
+      if (::equalsIgnoringCase(member.key(), "Data")) {
+        valueKey = member.key();
+      }
+    }
+
+    for (const auto& member : first.items()) {
+      if (!valueKey.empty()) {
+        break;
+      }
+
+      bool ofDimension = ::endsWithIgnoringCase(member.key(), "_Code") ||
+                         ::endsWithIgnoringCase(member.key(), "_SortOrder") ||
+                         ::endsWithIgnoringCase(member.key(), "_ItemName_ENG");
+      bool numbers = std::all_of(records.begin(), records.end(), [&member](const json& record) {
+        const auto found = record.find(member.key());
+        return found != record.end() && ::isNumber(*found);
+      });
+
+      if (!ofDimension && numbers) {
+        valueKey = member.key();
+      }
+    }
+
+    if (valueKey.empty()) {
+      throw std::runtime_error("no key has numbers for its values");
+    }
+
+    BethYw::SourceColumnMapping cols = {
+      {SC::AUTH_CODE, areaDimension.codeKey},
+      {SC::AUTH_NAME_ENG, areaDimension.nameKey},
+      {SC::YEAR, yearDimension.codeKey},
+      {SC::VALUE, valueKey}
+    };
+
+    // The measures, from the dimension left that varies the most
+    auto measure = dimensions.end();
+    for (auto it = dimensions.begin(); it != dimensions.end(); it++) {
+      if (measure == dimensions.end() || it->distinctCodes() > measure->distinctCodes()) {
+        measure = it;
+      }
+    }
+
+    if (measure != dimensions.end()) {
+      cols[SC::MEASURE_CODE] = measure->codeKey;
+      cols[SC::MEASURE_NAME] = measure->nameKey;
+    } else {
+      cols[SC::SINGLE_MEASURE_CODE] = measureCode;
+      cols[SC::SINGLE_MEASURE_NAME] = measureCode;
+    }
+
+    return DatasetSchema(BethYw::SourceDataType::WelshStatsJSON, cols);
+  }
+
+
+  DatasetSchema detectCSV(const InputSpan& sample, const std::string& measureCode) {
+    using SC = BethYw::SourceColumn;
+
+    // Only the whole lines of the sample (unless it is only one)
+    InputSpan lines = sample;
+    while (lines.size > 0 && lines.data[lines.size - 1] != '\n') {
+      lines.size--;
+    }
+    if (lines.size == 0) {
+      lines = sample;
+    }
+
+    // Blank lines are skipped, as the parsers skip them
+    CSVReader reader(lines);
+    auto nextRecord = [&reader]() {
+      while (reader.next()) {
+        if (!reader.fields().empty()) {
+          return true;
+        }
+      }
+      return false;
+    };
+
+    if (!nextRecord()) {
+      throw std::runtime_error("it is empty");
+    }
+
+    std::vector<std::string> header;
+    for (const InputSpan& field : reader.fields()) {
+      header.emplace_back(field.data, field.size);
+    }
+
+    if (!header.empty() && header[0].compare(0, UTF8_BOM_SIZE, UTF8_BOM) == 0) {
+      header[0].erase(0, UTF8_BOM_SIZE);
+    }
+
+    if (header.size() > 1 && std::all_of(header.begin() + 1, header.end(), ::isYear)) {
+      return DatasetSchema(BethYw::SourceDataType::AuthorityByYearCSV, {
+        {SC::AUTH_CODE, header[0]},
+        {SC::SINGLE_MEASURE_CODE, measureCode},
+        {SC::SINGLE_MEASURE_NAME, measureCode}
+      });
+    }
+
+    size_t rows = 0;
+    size_t areaCodes = 0;
+    while (rows < DatasetSchema::SAMPLE_RECORDS && nextRecord()) {
+      const InputSpan& code = reader.fields()[0];
+      rows++;
+      areaCodes += ::isAreaCode(std::string(code.data, code.size)) ? 1 : 0;
+    }
+
+    if (header.size() == 3 && rows > 0 && areaCodes * 2 >= rows) {
+      return DatasetSchema(BethYw::SourceDataType::AuthorityCodeCSV, {
+        {SC::AUTH_CODE, header[0]},
+        {SC::AUTH_NAME_ENG, header[1]},
+        {SC::AUTH_NAME_CYM, header[2]}
+      });
+    }
+
+    throw std::runtime_error("its header is neither years after an area code column, nor an area code "
+                             "column and two name columns");
+  }
+
+
+  // The columns each data type can't be parsed without, besides a measure
+  // for StatsWales JSON (by MEASURE_CODE or SINGLE_MEASURE_CODE)
+  std::vector<BethYw::SourceColumn> requiredColumns(BethYw::SourceDataType parser) {
+    using SC = BethYw::SourceColumn;
+
+    switch (parser) {
+      case BethYw::SourceDataType::AuthorityCodeCSV:
+        return {SC::AUTH_CODE, SC::AUTH_NAME_ENG, SC::AUTH_NAME_CYM};
+      case BethYw::SourceDataType::WelshStatsJSON:
+      case BethYw::SourceDataType::WelshStatsNDJSON:
+        return {SC::AUTH_CODE, SC::AUTH_NAME_ENG, SC::YEAR, SC::VALUE};
+      case BethYw::SourceDataType::AuthorityByYearCSV:
+        return {SC::AUTH_CODE, SC::SINGLE_MEASURE_CODE, SC::SINGLE_MEASURE_NAME};
+      default:
+        return {};
+    }
+  }
+} // end of anonymous namespace
+
+
+constexpr size_t DatasetSchema::SAMPLE_BYTES;
+constexpr size_t DatasetSchema::SAMPLE_RECORDS;
+
+
+DatasetSchema::DatasetSchema() : parser(BethYw::SourceDataType::None), cols() {}
+
+
+DatasetSchema::DatasetSchema(BethYw::SourceDataType parser_, BethYw::SourceColumnMapping cols_) :
+        parser(parser_),
+        cols(std::move(cols_)) {}
+
+
+/*
+  Detect the data type and columns of a dataset file from its first records.
+
+  @param sample
+    The start of the file, e.g. its first SAMPLE_BYTES bytes
+
+  @param measureCode
+    The code (and name) to give the measure of a file that only has one
+
+  @return
+    The schema of the file
+
+  @throws
+    std::runtime_error if it can't be detected, with the message:
+    Failed to detect the columns of the dataset: <reason>
+
+  @example
+    InputMappedFile file("datasets/hlth0123.json");
+    InputSpan contents = file.span();
+    DatasetSchema schema = DatasetSchema::detect(
+        {contents.data, std::min(contents.size, DatasetSchema::SAMPLE_BYTES)}, "hlth0123");
+*/
+DatasetSchema DatasetSchema::detect(const InputSpan& sample, const std::string& measureCode) noexcept(false) {
+  try {
+    std::string text(sample.data, sample.size);
+    size_t start = (text.compare(0, UTF8_BOM_SIZE, UTF8_BOM) == 0) ? UTF8_BOM_SIZE : 0;
+    while (start < text.size() && std::isspace(static_cast<unsigned char>(text[start]))) {
+      start++;
+    }
+
+    if (start < text.size() && text[start] == '{' && ::isWelshStatsNDJSON(text, start)) {
+      DatasetSchema schema = ::detectWelshStatsJSON(::sampleWelshStatsNDJSON(text, start), measureCode);
+      schema.parser = BethYw::SourceDataType::WelshStatsNDJSON;
+      return schema;
+    }
+
+    if (start < text.size() && text[start] == '{') {
+      return ::detectWelshStatsJSON(::sampleWelshStatsJSON(text), measureCode);
+    }
+
+    return ::detectCSV(sample, measureCode);
+  }
+  catch (const std::exception& ex) {
+    throw std::runtime_error("Failed to detect the columns of the dataset: " + std::string(ex.what()));
+  }
+}
+
+
+/*
+  Load a schema from a sidecar file written by save() (and possibly edited
+  since).
+
+  @param sidecarPath
+    The path of the sidecar
+
+  @param schema
+    Set to the schema in the sidecar
+
+  @return
+    Whether there is a sidecar
+
+  @throws
+    std::runtime_error if the sidecar isn't a valid schema, with the message:
+    Invalid schema in <sidecar path>: <reason>
+*/
+bool DatasetSchema::load(const std::string& sidecarPath, DatasetSchema& schema) noexcept(false) {
+  std::ifstream file(sidecarPath);
+  if (!file.is_open()) {
+    return false;
+  }
+
+  try {
+    const json sidecar = json::parse(file);
+
+    DatasetSchema loaded;
+    loaded.parser = parserFromName(sidecar.at("parser").get<std::string>());
+    if (loaded.parser == BethYw::SourceDataType::None) {
+      throw std::runtime_error("unknown parser " + sidecar.at("parser").get<std::string>());
+    }
+
+    for (const auto& column : sidecar.at("columns").items()) {
+      BethYw::SourceColumn sourceColumn;
+      if (!columnFromName(column.key(), sourceColumn)) {
+        throw std::runtime_error("unknown column " + column.key());
+      }
+
+      loaded.cols[sourceColumn] = column.value().get<std::string>();
+    }
+
+    for (BethYw::SourceColumn column : ::requiredColumns(loaded.parser)) {
+      if (loaded.cols.count(column) == 0) {
+        throw std::runtime_error("missing column " + columnName(column));
+      }
+    }
+
+    if ((loaded.parser == BethYw::SourceDataType::WelshStatsJSON ||
+         loaded.parser == BethYw::SourceDataType::WelshStatsNDJSON) &&
+        !(loaded.cols.count(BethYw::SourceColumn::MEASURE_CODE) > 0 &&
+          loaded.cols.count(BethYw::SourceColumn::MEASURE_NAME) > 0) &&
+        !(loaded.cols.count(BethYw::SourceColumn::SINGLE_MEASURE_CODE) > 0 &&
+          loaded.cols.count(BethYw::SourceColumn::SINGLE_MEASURE_NAME) > 0)) {
+      throw std::runtime_error("missing columns measure_code and measure_name, or single_measure_code and "
+                               "single_measure_name");
+    }
+
+    schema = loaded;
+    return true;
+  }
+  catch (const std::exception& ex) {
+    throw std::runtime_error("Invalid schema in " + sidecarPath + ": " + ex.what());
+  }
+}
+
+
+/*
+  Save the schema to a sidecar file, for load().
+
+  @param sidecarPath
+    The path of the sidecar
+
+  @throws
+    std::runtime_error if the file can't be written, with the message:
+    DatasetSchema: Failed to write file <sidecar path>
+*/
+void DatasetSchema::save(const std::string& sidecarPath) const noexcept(false) {
+  json sidecar;
+  sidecar["parser"] = parserName(parser);
+  sidecar["columns"] = json::object();
+  for (const auto& column : cols) {
+    sidecar["columns"][columnName(column.first)] = column.second;
+  }
+
+  std::ofstream file(sidecarPath, std::ofstream::out | std::ofstream::trunc);
+  file << sidecar.dump(2) << std::endl;
+  if (!file) {
+    throw std::runtime_error("DatasetSchema: Failed to write file " + sidecarPath);
+  }
+}
+
+
+/*
+  @return
+    The name of a data type on the command line, e.g. welsh-stats-json
+*/
+std::string DatasetSchema::parserName(BethYw::SourceDataType parser) noexcept {
+  switch (parser) {
+    case BethYw::SourceDataType::AuthorityCodeCSV:
+      return "authority-code-csv";
+    case BethYw::SourceDataType::WelshStatsJSON:
+      return "welsh-stats-json";
+    case BethYw::SourceDataType::WelshStatsNDJSON:
+      return "welsh-stats-ndjson";
+    case BethYw::SourceDataType::AuthorityByYearCSV:
+      return "authority-by-year-csv";
+    default:
+      return "none";
+  }
+}
+
+
+/*
+  Find the SourceDataType for a name given on the command line, as either
+  the enum name (e.g. WelshStatsJSON) or its lower case, hyphenated form
+  (e.g. welsh-stats-json).
+
+  @param name
+    The name of the data type
+
+  @return
+    The SourceDataType, or SourceDataType::None if the name is unknown
+*/
+BethYw::SourceDataType DatasetSchema::parserFromName(const std::string& name) noexcept {
+  static const std::unordered_map<std::string, BethYw::SourceDataType> types = {
+    {"authoritycodecsv", BethYw::SourceDataType::AuthorityCodeCSV},
+    {"authority-code-csv", BethYw::SourceDataType::AuthorityCodeCSV},
+    {"welshstatsjson", BethYw::SourceDataType::WelshStatsJSON},
+    {"welsh-stats-json", BethYw::SourceDataType::WelshStatsJSON},
+    {"welshstatsndjson", BethYw::SourceDataType::WelshStatsNDJSON},
+    {"welsh-stats-ndjson", BethYw::SourceDataType::WelshStatsNDJSON},
+    {"authoritybyyearcsv", BethYw::SourceDataType::AuthorityByYearCSV},
+    {"authority-by-year-csv", BethYw::SourceDataType::AuthorityByYearCSV}
+  };
+
+  std::string lowerCaseName = name;
+  for (char& c : lowerCaseName) {
+    c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  }
+
+  auto type = types.find(lowerCaseName);
+  return type == types.end() ? BethYw::SourceDataType::None : type->second;
+}
+
+
+/*
+  @return
+    The name of a column on the command line, which is the enum name in
+    lower case (e.g. auth_code)
+*/
+std::string DatasetSchema::columnName(BethYw::SourceColumn column) noexcept {
+  switch (column) {
+    case BethYw::SourceColumn::AUTH_CODE:
+      return "auth_code";
+    case BethYw::SourceColumn::AUTH_NAME_ENG:
+      return "auth_name_eng";
+    case BethYw::SourceColumn::AUTH_NAME_CYM:
+      return "auth_name_cym";
+    case BethYw::SourceColumn::MEASURE_CODE:
+      return "measure_code";
+    case BethYw::SourceColumn::MEASURE_NAME:
+      return "measure_name";
+    case BethYw::SourceColumn::SINGLE_MEASURE_CODE:
+      return "single_measure_code";
+    case BethYw::SourceColumn::SINGLE_MEASURE_NAME:
+      return "single_measure_name";
+    case BethYw::SourceColumn::YEAR:
+      return "year";
+    default:
+      return "value";
+  }
+}
+
+
+/*
+  Find the SourceColumn for a name given on the command line, which is the
+  enum name in any case (e.g. auth_code or YEAR).
+
+  @param name
+    The name of the column
+
+  @param column
+    Set to the SourceColumn if the name is known
+
+  @return
+    Whether the name is a known SourceColumn
+*/
+bool DatasetSchema::columnFromName(const std::string& name, BethYw::SourceColumn& column) noexcept {
+  static const std::unordered_map<std::string, BethYw::SourceColumn> columns = {
+    {"auth_code", BethYw::SourceColumn::AUTH_CODE},
+    {"auth_name_eng", BethYw::SourceColumn::AUTH_NAME_ENG},
+    {"auth_name_cym", BethYw::SourceColumn::AUTH_NAME_CYM},
+    {"measure_code", BethYw::SourceColumn::MEASURE_CODE},
+    {"measure_name", BethYw::SourceColumn::MEASURE_NAME},
+    {"single_measure_code", BethYw::SourceColumn::SINGLE_MEASURE_CODE},
+    {"single_measure_name", BethYw::SourceColumn::SINGLE_MEASURE_NAME},
+    {"year", BethYw::SourceColumn::YEAR},
+    {"value", BethYw::SourceColumn::VALUE}
+  };
+
+  std::string lowerCaseName = name;
+  for (char& c : lowerCaseName) {
+    c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  }
+
+  auto found = columns.find(lowerCaseName);
+  if (found == columns.end()) {
+    return false;
+  }
+
+  column = found->second;
+  return true;
+}
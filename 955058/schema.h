@@ -0,0 +1,77 @@
+#ifndef SCHEMA_H_
+#define SCHEMA_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  This file contains the declaration of DatasetSchema, the data type and
+  column mapping of a dataset file, which can be detected from the first
+  records of a file that isn't in datasets.h (e.g. a new StatsWales table),
+  and kept in a sidecar file next to it so that it is only detected once.
+ */
+
+#include <cstddef>
+#include <string>
+
+#include "datasets.h"
+#include "input.h"
+
+/*
+  How to parse a dataset file: the SourceDataType and SourceColumnMapping
+  that an InputFileSource in datasets.h would give for it.
+
+  Detection looks at the shape of the file and the first records in it:
+    - A StatsWales JSON file has records whose keys are the dimensions of
+      the table (e.g. Localauthority, Area or Year), each with a <dim>_Code
+      key and usually a <dim>_ItemName_ENG key, and its values under Data.
+      The year dimension is the one whose codes are all years, the area
+      dimension the one whose codes mostly look like the nine character
+      codes of the Office for National Statistics (e.g. W06000011), and the
+      measure dimension the one of the others with the most distinct codes.
+      A file with no other dimension is of a single measure.
+    - A newline-delimited StatsWales JSON file, whose first line is a
+      record on its own, is detected from its records in the same way.
+    - A CSV file whose header gives years after the first column is of a
+      single measure by area and year, like complete-popu1009-pop.csv, and a
+      CSV file of areas' codes and two names is like areas.csv.
+  Files with more dimensions than these (e.g. by sex or age too) need their
+  sidecar editing to pick the right ones.
+
+  The sidecar is JSON, with the data type and columns by the names used for
+  them on the command line (see --input-type and --input-cols), e.g.:
+    {"parser": "welsh-stats-json",
+     "columns": {"auth_code": "Area_Code", "year": "Year_Code", ...}}
+*/
+class DatasetSchema {
+public:
+  // How much of a file, and how many of its records, are looked at
+  static constexpr size_t SAMPLE_BYTES = 256 * 1024;
+  static constexpr size_t SAMPLE_RECORDS = 200;
+
+  BethYw::SourceDataType parser;
+  BethYw::SourceColumnMapping cols;
+
+  DatasetSchema();
+
+  DatasetSchema(BethYw::SourceDataType parser_, BethYw::SourceColumnMapping cols_);
+
+  static DatasetSchema detect(const InputSpan& sample, const std::string& measureCode) noexcept(false);
+
+  static bool load(const std::string& sidecarPath, DatasetSchema& schema) noexcept(false);
+
+  void save(const std::string& sidecarPath) const noexcept(false);
+
+  static std::string parserName(BethYw::SourceDataType parser) noexcept;
+
+  static BethYw::SourceDataType parserFromName(const std::string& name) noexcept;
+
+  static std::string columnName(BethYw::SourceColumn column) noexcept;
+
+  static bool columnFromName(const std::string& name, BethYw::SourceColumn& column) noexcept;
+};
+
+#endif // SCHEMA_H_
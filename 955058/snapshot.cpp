@@ -0,0 +1,541 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  This file contains the implementation of Snapshot.
+
+  A snapshot file contains, in order:
+    - a header: the magic string BYWSNAPS, a byte order mark, the format
+      version, the number of strings, areas, names, series and readings, and
+      the offset of each of the sections below from the start of the file,
+    - the string table: the offset of each string in the string data, and
+      then the offset of the end of the last one,
+    - the string data, the characters of every string, one after another,
+    - the areas: the indices of the area's code in the string table, of its
+      first name and of its first series (with one more entry after the last
+      area, so that the names and series of area i end where those of area
+      i + 1 begin),
+    - the names: the indices of the language code and of the name in the
+      string table,
+    - the series: the indices of its key, codename and label in the string
+      table, its first reading (again with one more entry after the last),
+      and the minimum and maximum of its years and of its values,
+    - the year column and the value column: the year and the value of each
+      reading, the readings of each series one after another, and
+    - a checksum of everything before it, to detect truncated or corrupt
+      files.
+
+  Each section starts at a multiple of 8 bytes. Integers are stored as 32-bit
+  (except the offsets in the header, which are 64-bit), and doubles as their
+  64 bits, in the byte order of the machine (which is checked when a snapshot
+  is opened).
+*/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "snapshot.h"
+#include "input.h"
+
+// Anonymous namespace for helper functions private to snapshot.cpp.
+namespace {
+  const char MAGIC[] = "BYWSNAPS";
+  const size_t MAGIC_SIZE = sizeof(MAGIC) - 1;
+  const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+  // The counts of the strings, areas, names, series and readings follow the
+  // byte order mark and version (with one more to align them), and the
+  // offsets of the sections follow them
+  enum Section { STRING_OFFSETS, STRING_DATA, AREAS, NAMES, SERIES, YEARS, VALUES, NUM_SECTIONS };
+  const size_t NUM_COUNTS = 5;
+  const size_t COUNTS_START = MAGIC_SIZE + 2 * sizeof(uint32_t);
+  const size_t OFFSETS_START = COUNTS_START + (NUM_COUNTS + 1) * sizeof(uint32_t);
+  const size_t HEADER_SIZE = OFFSETS_START + NUM_SECTIONS * sizeof(uint64_t);
+
+  const size_t CHECKSUM_SIZE = sizeof(uint64_t);
+
+  // The size of each entry of the areas, names and series sections
+  const size_t AREA_ENTRY_SIZE = 3 * sizeof(uint32_t);
+  const size_t NAME_ENTRY_SIZE = 2 * sizeof(uint32_t);
+  const size_t SERIES_ENTRY_SIZE = 6 * sizeof(uint32_t) + 2 * sizeof(double);
+
+
+  /*
+    A hash of a block of characters for the checksum, taken 8 bytes at a time
+    (unlike ParseCache's), as a whole snapshot is hashed each time it is
+    opened.
+  */
+  uint64_t checksum(const char* data, size_t size) {
+    const uint64_t prime = 1099511628211ULL;
+    uint64_t hash = 14695981039346656037ULL;
+
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+      uint64_t word;
+      std::memcpy(&word, data + i, sizeof(word));
+      hash = (hash ^ word) * prime;
+      hash ^= hash >> 29;
+    }
+
+    for (; i < size; i++) {
+      hash = (hash ^ static_cast<unsigned char>(data[i])) * prime;
+    }
+
+    return hash;
+  }
+
+
+  /*
+    Read a value from anywhere in a snapshot, whatever its alignment.
+  */
+  template <typename T>
+  T readAt(const char* position) {
+    T value;
+    std::memcpy(&value, position, sizeof(value));
+    return value;
+  }
+
+
+  template <typename T>
+  void append(std::string& buffer, T value) {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+
+  // Pad the buffer to the start of the next section
+  void alignSection(std::string& buffer) {
+    buffer.append((sizeof(uint64_t) - buffer.size() % sizeof(uint64_t)) % sizeof(uint64_t), '\0');
+  }
+
+
+  /*
+    The strings of a snapshot, each stored once however many times it is
+    used (e.g. the codename and label of a measure, for every area).
+  */
+  class StringTable {
+  private:
+    std::vector<const std::string*> strings;
+    std::unordered_map<std::string, uint32_t> indices;
+
+  public:
+    uint32_t add(const std::string& str) {
+      const auto inserted = indices.emplace(str, static_cast<uint32_t>(strings.size()));
+      if (inserted.second) {
+        strings.push_back(&inserted.first->first);
+      }
+
+      return inserted.first->second;
+    }
+
+    size_t size() const noexcept {
+      return strings.size();
+    }
+
+    void writeOffsets(std::string& buffer) const {
+      uint32_t offset = 0;
+      for (const std::string* str : strings) {
+        append(buffer, offset);
+        offset += static_cast<uint32_t>(str->size());
+      }
+      append(buffer, offset);
+    }
+
+    void writeData(std::string& buffer) const {
+      for (const std::string* str : strings) {
+        buffer.append(*str);
+      }
+    }
+  };
+} // end of anonymous namespace
+
+
+constexpr unsigned int Snapshot::FORMAT_VERSION;
+
+
+/*
+  Open a snapshot file written by save(), mapping it into memory.
+
+  @param filePath
+    The path of the snapshot
+
+  @throws
+    std::runtime_error if the file can't be opened, with the message:
+    InputFile::open: Failed to open file <file name>
+    or if it isn't a whole snapshot written by this version, with the message:
+    Snapshot: <file name> is not a snapshot file
+    Snapshot: <file name> was written by a different version of Beth Yw?
+    Snapshot: <file name> is corrupt
+
+  @example
+    Snapshot snapshot("popden.snapshot");
+    Areas data = Areas();
+    data.populateFromSnapshot(snapshot);
+*/
+Snapshot::Snapshot(const std::string& filePath) noexcept(false) :
+        file(filePath),
+        contents(file.span()),
+        stringCount(0),
+        areaCount(0),
+        nameCount(0),
+        seriesCount(0),
+        readingCount(0),
+        stringOffsets(nullptr),
+        stringData(nullptr),
+        areaTable(nullptr),
+        nameTable(nullptr),
+        seriesTable(nullptr),
+        yearColumn(nullptr),
+        valueColumn(nullptr) {
+  if (contents.size < HEADER_SIZE + CHECKSUM_SIZE || std::memcmp(contents.data, MAGIC, MAGIC_SIZE) != 0) {
+    throw std::runtime_error("Snapshot: " + filePath + " is not a snapshot file");
+  }
+
+  if (::readAt<uint32_t>(contents.data + MAGIC_SIZE) != BYTE_ORDER_MARK ||
+      ::readAt<uint32_t>(contents.data + MAGIC_SIZE + sizeof(uint32_t)) != FORMAT_VERSION) {
+    throw std::runtime_error("Snapshot: " + filePath + " was written by a different version of Beth Yw?");
+  }
+
+  const size_t checkedSize = contents.size - CHECKSUM_SIZE;
+  if (::readAt<uint64_t>(contents.data + checkedSize) != ::checksum(contents.data, checkedSize)) {
+    throw std::runtime_error("Snapshot: " + filePath + " is corrupt");
+  }
+
+  const char* counts = contents.data + COUNTS_START;
+  stringCount = ::readAt<uint32_t>(counts);
+  areaCount = ::readAt<uint32_t>(counts + sizeof(uint32_t));
+  nameCount = ::readAt<uint32_t>(counts + 2 * sizeof(uint32_t));
+  seriesCount = ::readAt<uint32_t>(counts + 3 * sizeof(uint32_t));
+  readingCount = ::readAt<uint32_t>(counts + 4 * sizeof(uint32_t));
+
+  // The start of a section, if it holds this many entries of this size
+  // before the checksum
+  auto section = [this, &filePath, checkedSize](Section which, uint64_t entries, size_t entrySize) {
+    const uint64_t offset = ::readAt<uint64_t>(contents.data + OFFSETS_START + which * sizeof(uint64_t));
+    if (offset < HEADER_SIZE || offset > checkedSize || entries * entrySize > checkedSize - offset) {
+      throw std::runtime_error("Snapshot: " + filePath + " is corrupt");
+    }
+
+    return contents.data + offset;
+  };
+
+  stringOffsets = section(STRING_OFFSETS, uint64_t(stringCount) + 1, sizeof(uint32_t));
+  stringData = section(STRING_DATA, ::readAt<uint32_t>(stringOffsets + stringCount * sizeof(uint32_t)), 1);
+  areaTable = section(AREAS, uint64_t(areaCount) + 1, AREA_ENTRY_SIZE);
+  nameTable = section(NAMES, nameCount, NAME_ENTRY_SIZE);
+  seriesTable = section(SERIES, uint64_t(seriesCount) + 1, SERIES_ENTRY_SIZE);
+  yearColumn = section(YEARS, readingCount, sizeof(uint32_t));
+  valueColumn = section(VALUES, readingCount, sizeof(double));
+
+  validate(filePath);
+}
+
+
+/*
+  Check that every index in the tables is in range, and that the entries each
+  area and series starts from only go forwards, so that the accessors below
+  never read outside the file.
+
+  @throws
+    std::runtime_error if they aren't, with the message:
+    Snapshot: <file name> is corrupt
+*/
+void Snapshot::validate(const std::string& filePath) const noexcept(false) {
+  const std::runtime_error corrupt("Snapshot: " + filePath + " is corrupt");
+
+  uint32_t previous = 0;
+  for (uint32_t i = 0; i <= stringCount; i++) {
+    const uint32_t offset = ::readAt<uint32_t>(stringOffsets + i * sizeof(uint32_t));
+    if (offset < previous || (i == 0 && offset != 0)) {
+      throw corrupt;
+    }
+    previous = offset;
+  }
+
+  uint32_t previousName = 0;
+  uint32_t previousSeries = 0;
+  for (uint32_t i = 0; i <= areaCount; i++) {
+    const char* entry = areaTable + i * AREA_ENTRY_SIZE;
+    const uint32_t firstName = ::readAt<uint32_t>(entry + sizeof(uint32_t));
+    const uint32_t firstSeries = ::readAt<uint32_t>(entry + 2 * sizeof(uint32_t));
+
+    if (firstName < previousName || firstName > nameCount ||
+        firstSeries < previousSeries || firstSeries > seriesCount ||
+        (i < areaCount && ::readAt<uint32_t>(entry) >= stringCount) ||
+        (i == areaCount && (firstName != nameCount || firstSeries != seriesCount))) {
+      throw corrupt;
+    }
+
+    previousName = firstName;
+    previousSeries = firstSeries;
+  }
+
+  for (uint32_t i = 0; i < nameCount; i++) {
+    const char* entry = nameTable + i * NAME_ENTRY_SIZE;
+    if (::readAt<uint32_t>(entry) >= stringCount || ::readAt<uint32_t>(entry + sizeof(uint32_t)) >= stringCount) {
+      throw corrupt;
+    }
+  }
+
+  uint32_t previousReading = 0;
+  for (uint32_t i = 0; i <= seriesCount; i++) {
+    const char* entry = seriesTable + i * SERIES_ENTRY_SIZE;
+    const uint32_t firstReading = ::readAt<uint32_t>(entry + 3 * sizeof(uint32_t));
+
+    if (firstReading < previousReading || firstReading > readingCount ||
+        (i == seriesCount && firstReading != readingCount)) {
+      throw corrupt;
+    }
+
+    // The key, codename and label (which the entry after the last lacks)
+    if (i < seriesCount &&
+        (::readAt<uint32_t>(entry) >= stringCount ||
+         ::readAt<uint32_t>(entry + sizeof(uint32_t)) >= stringCount ||
+         ::readAt<uint32_t>(entry + 2 * sizeof(uint32_t)) >= stringCount)) {
+      throw corrupt;
+    }
+
+    previousReading = firstReading;
+  }
+}
+
+
+InputSpan Snapshot::getString(uint32_t index) const noexcept {
+  const uint32_t start = ::readAt<uint32_t>(stringOffsets + index * sizeof(uint32_t));
+  const uint32_t end = ::readAt<uint32_t>(stringOffsets + (index + 1) * sizeof(uint32_t));
+  return InputSpan{stringData + start, end - start};
+}
+
+
+/*
+  @return
+    The number of areas in the snapshot
+*/
+size_t Snapshot::size() const noexcept {
+  return areaCount;
+}
+
+
+/*
+  @param index
+    The index of an area, less than size()
+
+  @return
+    The area's code, and where its names and series are
+*/
+Snapshot::AreaEntry Snapshot::getArea(size_t index) const noexcept {
+  const char* entry = areaTable + index * AREA_ENTRY_SIZE;
+  const char* next = entry + AREA_ENTRY_SIZE;
+
+  AreaEntry area;
+  area.code = getString(::readAt<uint32_t>(entry));
+  area.firstName = ::readAt<uint32_t>(entry + sizeof(uint32_t));
+  area.nameCount = ::readAt<uint32_t>(next + sizeof(uint32_t)) - area.firstName;
+  area.firstSeries = ::readAt<uint32_t>(entry + 2 * sizeof(uint32_t));
+  area.seriesCount = ::readAt<uint32_t>(next + 2 * sizeof(uint32_t)) - area.firstSeries;
+  return area;
+}
+
+
+/*
+  @param index
+    The index of a name, from an AreaEntry
+
+  @return
+    The language code of the name, and the name
+*/
+std::pair<InputSpan, InputSpan> Snapshot::getName(size_t index) const noexcept {
+  const char* entry = nameTable + index * NAME_ENTRY_SIZE;
+  return {getString(::readAt<uint32_t>(entry)), getString(::readAt<uint32_t>(entry + sizeof(uint32_t)))};
+}
+
+
+/*
+  @param index
+    The index of a series, from an AreaEntry
+
+  @return
+    The series' measure, where its readings are, and their statistics
+*/
+Snapshot::SeriesEntry Snapshot::getSeries(size_t index) const noexcept {
+  const char* entry = seriesTable + index * SERIES_ENTRY_SIZE;
+  const char* statistics = entry + 4 * sizeof(uint32_t);
+
+  SeriesEntry series;
+  series.key = getString(::readAt<uint32_t>(entry));
+  series.codename = getString(::readAt<uint32_t>(entry + sizeof(uint32_t)));
+  series.label = getString(::readAt<uint32_t>(entry + 2 * sizeof(uint32_t)));
+  series.firstReading = ::readAt<uint32_t>(entry + 3 * sizeof(uint32_t));
+  series.readingCount = ::readAt<uint32_t>(entry + SERIES_ENTRY_SIZE + 3 * sizeof(uint32_t)) - series.firstReading;
+  series.minYear = ::readAt<uint32_t>(statistics);
+  series.maxYear = ::readAt<uint32_t>(statistics + sizeof(uint32_t));
+  series.minValue = ::readAt<double>(statistics + 2 * sizeof(uint32_t));
+  series.maxValue = ::readAt<double>(statistics + 2 * sizeof(uint32_t) + sizeof(double));
+  return series;
+}
+
+
+/*
+  @param reading
+    The index of a reading, from a SeriesEntry
+
+  @return
+    The year of the reading
+*/
+unsigned int Snapshot::getYear(size_t reading) const noexcept {
+  return ::readAt<uint32_t>(yearColumn + reading * sizeof(uint32_t));
+}
+
+
+/*
+  @param reading
+    The index of a reading, from a SeriesEntry
+
+  @return
+    The value of the reading
+*/
+double Snapshot::getValue(size_t reading) const noexcept {
+  return ::readAt<double>(valueColumn + reading * sizeof(double));
+}
+
+
+/*
+  Write every area, measure and reading of an Areas instance to a snapshot
+  file. The file is written under a temporary name and then renamed, so a
+  snapshot being opened is never half written.
+
+  @param filePath
+    The path of the snapshot
+
+  @param areas
+    The areas to write
+
+  @throws
+    std::runtime_error if the file can't be written, with the message:
+    Snapshot: Failed to write file <file name>
+
+  @example
+    Areas data = Areas();
+    BethYw::loadDatasets(data, ...);
+    Snapshot::save("all.snapshot", data);
+*/
+void Snapshot::save(const std::string& filePath, const Areas& areas) noexcept(false) {
+  StringTable strings;
+  std::string areaEntries, nameEntries, seriesEntries, years, values;
+  uint32_t nameIndex = 0, seriesIndex = 0, readingIndex = 0;
+
+  for (const auto& codeAreaPair : areas.getAllAreas()) {
+    const Area& area = codeAreaPair.second;
+    ::append(areaEntries, strings.add(area.getLocalAuthorityCode()));
+    ::append(areaEntries, nameIndex);
+    ::append(areaEntries, seriesIndex);
+
+    for (const auto& langNamePair : area.getNames()) {
+      ::append(nameEntries, strings.add(langNamePair.first));
+      ::append(nameEntries, strings.add(langNamePair.second));
+      nameIndex++;
+    }
+
+    for (const auto& codeMeasurePair : area.getMeasures()) {
+      const Measure& measure = codeMeasurePair.second;
+      const auto readings = measure.getAllReadingsSorted();
+
+      ::append(seriesEntries, strings.add(codeMeasurePair.first));
+      ::append(seriesEntries, strings.add(measure.getCodename()));
+      ::append(seriesEntries, strings.add(measure.getLabel()));
+      ::append(seriesEntries, readingIndex);
+
+      // Sorted by year, so the years' minimum and maximum are at the ends
+      uint32_t minYear = readings.empty() ? 0 : static_cast<uint32_t>(readings.front().first);
+      uint32_t maxYear = readings.empty() ? 0 : static_cast<uint32_t>(readings.back().first);
+      double minValue = readings.empty() ? 0 : readings.front().second;
+      double maxValue = minValue;
+
+      for (const auto& reading : readings) {
+        ::append(years, static_cast<uint32_t>(reading.first));
+        ::append(values, reading.second);
+        minValue = std::min(minValue, reading.second);
+        maxValue = std::max(maxValue, reading.second);
+      }
+
+      ::append(seriesEntries, minYear);
+      ::append(seriesEntries, maxYear);
+      ::append(seriesEntries, minValue);
+      ::append(seriesEntries, maxValue);
+
+      readingIndex += static_cast<uint32_t>(readings.size());
+      seriesIndex++;
+    }
+  }
+
+  // The entries after the last area and series, where their last ones end
+  ::append(areaEntries, uint32_t(0));
+  ::append(areaEntries, nameIndex);
+  ::append(areaEntries, seriesIndex);
+  seriesEntries.append(3 * sizeof(uint32_t), '\0');
+  ::append(seriesEntries, readingIndex);
+  seriesEntries.append(SERIES_ENTRY_SIZE - 4 * sizeof(uint32_t), '\0');
+
+  std::string snapshot(MAGIC, MAGIC_SIZE);
+  ::append(snapshot, BYTE_ORDER_MARK);
+  ::append(snapshot, static_cast<uint32_t>(FORMAT_VERSION));
+  ::append(snapshot, static_cast<uint32_t>(strings.size()));
+  ::append(snapshot, static_cast<uint32_t>(areas.size()));
+  ::append(snapshot, nameIndex);
+  ::append(snapshot, seriesIndex);
+  ::append(snapshot, readingIndex);
+  ::append(snapshot, uint32_t(0));
+
+  // The offsets are filled in as each section is written
+  const size_t offsetsStart = snapshot.size();
+  snapshot.append(NUM_SECTIONS * sizeof(uint64_t), '\0');
+
+  auto startSection = [&snapshot, offsetsStart](Section which) {
+    ::alignSection(snapshot);
+    const uint64_t offset = snapshot.size();
+    std::memcpy(&snapshot[offsetsStart + which * sizeof(uint64_t)], &offset, sizeof(offset));
+  };
+
+  startSection(STRING_OFFSETS);
+  strings.writeOffsets(snapshot);
+  startSection(STRING_DATA);
+  strings.writeData(snapshot);
+  startSection(AREAS);
+  snapshot.append(areaEntries);
+  startSection(NAMES);
+  snapshot.append(nameEntries);
+  startSection(SERIES);
+  snapshot.append(seriesEntries);
+  startSection(YEARS);
+  snapshot.append(years);
+  startSection(VALUES);
+  snapshot.append(values);
+
+  ::append(snapshot, ::checksum(snapshot.data(), snapshot.size()));
+
+  const std::string temporaryPath = filePath + ".tmp";
+  {
+    std::ofstream file(temporaryPath, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+    file.write(snapshot.data(), static_cast<std::streamsize>(snapshot.size()));
+    if (!file) {
+      file.close();
+      std::remove(temporaryPath.c_str());
+      throw std::runtime_error("Snapshot: Failed to write file " + filePath);
+    }
+  }
+
+  if (std::rename(temporaryPath.c_str(), filePath.c_str()) != 0) {
+    std::remove(temporaryPath.c_str());
+    throw std::runtime_error("Snapshot: Failed to write file " + filePath);
+  }
+}
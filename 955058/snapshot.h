@@ -0,0 +1,112 @@
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  This file contains the declaration of Snapshot, a file holding every area,
+  measure and reading of an Areas instance in a columnar binary form, which is
+  mapped into memory and read in place, so that later runs of Beth Yw? can
+  start from it instead of loading the datasets.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "areas.h"
+#include "input.h"
+
+/*
+  A snapshot file, mapped into memory. The areas, names, measures (series) and
+  readings are each stored as an array of fixed size entries, and all of the
+  strings they refer to once each in a table, so an area, measure or reading
+  is found by its index without reading what comes before it.
+
+  Each series has the statistics of its readings, so that the readings of a
+  series with none in a range of years never need to be read.
+
+  Opening a snapshot checks that it is whole (by its checksum) and that its
+  indices are consistent, so reading it afterwards can't fail.
+*/
+class Snapshot {
+public:
+  // Change this whenever the format of the file changes.
+  static constexpr unsigned int FORMAT_VERSION = 1;
+
+  // An area, with its names and series at [firstName, firstName + nameCount)
+  // and [firstSeries, firstSeries + seriesCount)
+  struct AreaEntry {
+    InputSpan code;
+    uint32_t firstName;
+    uint32_t nameCount;
+    uint32_t firstSeries;
+    uint32_t seriesCount;
+  };
+
+  // A measure of an area, keyed in the area by key, with its readings at
+  // [firstReading, firstReading + readingCount), sorted by year. The minimum
+  // and maximum are 0 for a series without readings.
+  struct SeriesEntry {
+    InputSpan key;
+    InputSpan codename;
+    InputSpan label;
+    uint32_t firstReading;
+    uint32_t readingCount;
+    uint32_t minYear;
+    uint32_t maxYear;
+    double minValue;
+    double maxValue;
+  };
+
+private:
+  InputMappedFile file;
+  InputSpan contents;
+
+  uint32_t stringCount;
+  uint32_t areaCount;
+  uint32_t nameCount;
+  uint32_t seriesCount;
+  uint32_t readingCount;
+
+  // The start of each section in contents
+  const char* stringOffsets;
+  const char* stringData;
+  const char* areaTable;
+  const char* nameTable;
+  const char* seriesTable;
+  const char* yearColumn;
+  const char* valueColumn;
+
+  InputSpan getString(uint32_t index) const noexcept;
+
+  void validate(const std::string& filePath) const noexcept(false);
+
+public:
+  explicit Snapshot(const std::string& filePath) noexcept(false);
+
+  Snapshot(const Snapshot& other) = delete;
+
+  Snapshot& operator=(const Snapshot& other) = delete;
+
+  size_t size() const noexcept;
+
+  AreaEntry getArea(size_t index) const noexcept;
+
+  std::pair<InputSpan, InputSpan> getName(size_t index) const noexcept;
+
+  SeriesEntry getSeries(size_t index) const noexcept;
+
+  unsigned int getYear(size_t reading) const noexcept;
+
+  double getValue(size_t reading) const noexcept;
+
+  static void save(const std::string& filePath, const Areas& areas) noexcept(false);
+};
+
+#endif // SNAPSHOT_H_
@@ -0,0 +1,286 @@
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../input.h"
+
+SCENARIO( "a source file can be memory mapped and read as a span", "[InputMappedFile][existent]" ) {
+
+  auto read_file = [](const std::string &path) {
+    std::ifstream file(path);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  };
+
+  const std::string test_file = "datasets/popu1009.json";
+
+  GIVEN( "a constructed InputMappedFile instance" ) {
+
+    InputMappedFile input(test_file);
+
+    THEN( "the source value can be retrieved" ) {
+
+      REQUIRE( input.getSource() == test_file );
+
+    } // THEN
+
+    THEN( "the span contains the whole file" ) {
+
+      InputSpan span = input.span();
+      REQUIRE( std::string(span.begin(), span.end()) == read_file(test_file) );
+
+    } // THEN
+
+    THEN( "a stream over the mapped file can be opened and read" ) {
+
+      std::istream &stream = input.open();
+      std::string contents(std::istreambuf_iterator<char>(stream), {});
+
+      REQUIRE( contents == read_file(test_file) );
+
+      AND_THEN( "the stream can be rewound" ) {
+
+        REQUIRE_NOTHROW( stream.clear() );
+        REQUIRE_NOTHROW( stream.seekg(0, stream.beg) );
+        REQUIRE( stream.get() == '{' );
+
+      } // AND_THEN
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a nonexistent file" ) {
+
+    InputMappedFile input("datasets/jibberish.json");
+
+    THEN( "a std::runtime_error is thrown when the file is mapped" ) {
+
+      REQUIRE_THROWS_AS( input.span(), std::runtime_error );
+      REQUIRE_THROWS_WITH( input.span(), "InputFile::open: Failed to open file datasets/jibberish.json" );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a directory" ) {
+
+    InputMappedFile input("datasets");
+
+    THEN( "a std::runtime_error is thrown as for a file that can't be opened" ) {
+
+      REQUIRE_THROWS_WITH( input.span(), "InputFile::open: Failed to open file datasets" );
+
+    } // THEN
+
+  } // GIVEN
+
+#ifndef _WIN32
+  GIVEN( "a file that can be opened but not mapped" ) {
+
+    InputMappedFile input("/dev/null");
+
+    THEN( "a std::runtime_error is thrown with the reason it can't be mapped" ) {
+
+      REQUIRE_THROWS_WITH( input.span(), "InputMappedFile::open: Failed to map file /dev/null (not a regular file)" );
+
+    } // THEN
+
+  } // GIVEN
+#endif
+
+} // SCENARIO
+
+SCENARIO( "an Areas instance can be populated from a span", "[Areas][InputMappedFile]" ) {
+
+  GIVEN( "every dataset, as a stream and as a span" ) {
+
+    THEN( "populating from the span gives the same result as from the stream" ) {
+
+      for (const auto &dataset : BethYw::InputFiles::DATASETS) {
+        const std::string path = "datasets/" + dataset.FILE;
+
+        Areas fromStream = Areas();
+        std::ifstream stream(path);
+        fromStream.populate(stream, dataset.PARSER, dataset.COLS);
+
+        Areas fromSpan = Areas();
+        InputMappedFile input(path);
+        fromSpan.populate(input.span(), dataset.PARSER, dataset.COLS);
+
+        REQUIRE( fromSpan.size() == fromStream.size() );
+        REQUIRE( fromSpan.toJSON() == fromStream.toJSON() );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "a source file can be read ahead on a background thread", "[InputReadAheadFile]" ) {
+
+  auto read_file = [](const std::string &path) {
+    std::ifstream file(path);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  };
+
+  const std::string test_file = "datasets/areas.csv";
+
+  GIVEN( "InputReadAheadFile instances with small buffers of different depths" ) {
+
+    THEN( "the stream contains the whole file, in order" ) {
+
+      for (unsigned int depth : {2u, 3u, 8u}) {
+        InputReadAheadFile input(test_file, 7, depth);
+        std::istream &stream = input.open();
+        std::string contents(std::istreambuf_iterator<char>(stream), {});
+
+        REQUIRE( contents == read_file(test_file) );
+      }
+
+    } // THEN
+
+    THEN( "the file can be closed before it has been read completely" ) {
+
+      InputReadAheadFile input(test_file, 16, 2);
+      REQUIRE( input.open().get() == 'L' );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a nonexistent file" ) {
+
+    InputReadAheadFile input("datasets/jibberish.json");
+
+    THEN( "a std::runtime_error is thrown when the file is opened" ) {
+
+      REQUIRE_THROWS_WITH( input.open(), "InputFile::open: Failed to open file datasets/jibberish.json" );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "a batch of source files can be read at once", "[InputFileBatch]" ) {
+
+  auto read_file = [](const std::string &path) {
+    std::ifstream file(path);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  };
+
+  const std::vector<std::string> test_files = {
+    "datasets/areas.csv",
+    "datasets/jibberish.json",
+    "datasets/popu1009.json",
+    "datasets/areas.csv"
+  };
+
+  GIVEN( "an InputFileBatch with a nonexistent file among existing ones" ) {
+
+    InputFileBatch batch(test_files, 2);
+    batch.start();
+
+    THEN( "each existing file can be waited for in any order, and the nonexistent one throws" ) {
+
+      for (size_t i : {3u, 2u, 0u}) {
+        InputSpan span = batch.wait(i);
+        REQUIRE( std::string(span.data, span.size) == read_file(test_files[i]) );
+        batch.release(i);
+      }
+
+      REQUIRE_THROWS_WITH( batch.wait(1), "InputFileBatch::open: Failed to open file datasets/jibberish.json" );
+
+    } // THEN
+
+    THEN( "the batch can be destroyed before its files have been waited for" ) {
+
+      REQUIRE_NOTHROW( batch.isUsingIoUring() );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "a source file can be read with different strategies", "[InputFile][strategy]" ) {
+
+  auto read_file = [](const std::string &path) {
+    std::ifstream file(path);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  };
+
+  const std::string test_file = "datasets/popu1009.json";
+
+  GIVEN( "InputFile instances with each strategy" ) {
+
+    THEN( "the stream contains the whole file, however it is read" ) {
+
+      for (auto strategy : {InputFile::ReadStrategy::Auto,
+                            InputFile::ReadStrategy::Stream,
+                            InputFile::ReadStrategy::WholeFile,
+                            InputFile::ReadStrategy::Buffered,
+                            InputFile::ReadStrategy::Direct}) {
+        InputFile input(test_file, strategy);
+        std::istream &stream = input.open();
+        std::string contents(std::istreambuf_iterator<char>(stream), {});
+
+        REQUIRE( contents == read_file(test_file) );
+        REQUIRE( input.getStrategy() != InputFile::ReadStrategy::Auto );
+
+        if (input.getStrategy() != InputFile::ReadStrategy::Stream) {
+          REQUIRE( input.getBytesRead() == contents.size() );
+        }
+      }
+
+    } // THEN
+
+    THEN( "a small file is read whole with the Auto strategy" ) {
+
+      InputFile input(test_file);
+      input.open();
+
+      REQUIRE( input.getStrategy() == InputFile::ReadStrategy::WholeFile );
+      REQUIRE( InputFile::strategyName(input.getStrategy()) == "whole-file" );
+
+    } // THEN
+
+    THEN( "a buffered file can be seeked" ) {
+
+      InputFile input(test_file, InputFile::ReadStrategy::Buffered);
+      std::istream &stream = input.open();
+      const std::string contents = read_file(test_file);
+
+      stream.seekg(100, stream.beg);
+      REQUIRE( stream.get() == contents[100] );
+
+      stream.seekg(-1, stream.end);
+      REQUIRE( stream.get() == contents.back() );
+
+      stream.seekg(0, stream.beg);
+      REQUIRE( stream.get() == contents[0] );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
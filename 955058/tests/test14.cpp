@@ -0,0 +1,121 @@
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <zlib.h>
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../input.h"
+
+SCENARIO( "a gzip compressed source file can be read", "[InputCompressedFile][gzip]" ) {
+
+  auto read_file = [](const std::string &path) {
+    std::ifstream file(path, std::ifstream::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  };
+
+  auto write_gzip = [](const std::string &path, const std::string &contents) {
+    gzFile file = gzopen(path.c_str(), "wb");
+    gzwrite(file, contents.data(), static_cast<unsigned int>(contents.size()));
+    gzclose(file);
+  };
+
+  const std::string original_file = "datasets/popu1009.json";
+  const std::string test_file     = "bin/test-popu1009.json.gz";
+  const std::string original      = read_file(original_file);
+
+  write_gzip(test_file, original);
+
+  GIVEN( "the path of a compressed file" ) {
+
+    THEN( "it is recognised as compressed from its extension" ) {
+
+      REQUIRE( InputCompressedFile::isCompressedFile(test_file) );
+      REQUIRE( InputCompressedFile::isCompressedFile("datasets/popu1009.json.zst") );
+      REQUIRE_FALSE( InputCompressedFile::isCompressedFile(original_file) );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a constructed InputCompressedFile instance" ) {
+
+    InputCompressedFile input(test_file);
+
+    THEN( "the stream contains the decompressed file" ) {
+
+      std::istream &stream = input.open();
+      std::string contents(std::istreambuf_iterator<char>(stream), {});
+
+      REQUIRE( contents == original );
+
+    } // THEN
+
+    THEN( "an Areas instance populated from it matches one populated from the uncompressed file" ) {
+
+      Areas fromCompressed = Areas();
+      fromCompressed.populate(input.open(), BethYw::InputFiles::POPDEN.PARSER, BethYw::InputFiles::POPDEN.COLS);
+
+      Areas fromOriginal = Areas();
+      std::ifstream stream(original_file);
+      fromOriginal.populate(stream, BethYw::InputFiles::POPDEN.PARSER, BethYw::InputFiles::POPDEN.COLS);
+
+      REQUIRE( fromCompressed.toJSON() == fromOriginal.toJSON() );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a truncated compressed file" ) {
+
+    const std::string truncated_file = "bin/test-truncated.json.gz";
+    std::string compressed = read_file(test_file);
+
+    std::ofstream(truncated_file, std::ofstream::binary) << compressed.substr(0, compressed.size() / 2);
+
+    InputCompressedFile input(truncated_file);
+
+    THEN( "reading it throws a std::runtime_error" ) {
+
+      std::istream &stream = input.open();
+      REQUIRE_THROWS_AS( std::string(std::istreambuf_iterator<char>(stream), {}), std::runtime_error );
+
+    } // THEN
+
+    std::remove(truncated_file.c_str());
+
+  } // GIVEN
+
+  GIVEN( "a nonexistent compressed file" ) {
+
+    InputCompressedFile input("datasets/jibberish.json.gz");
+
+    THEN( "a std::runtime_error is thrown when it is opened" ) {
+
+      REQUIRE_THROWS_AS( input.open(), std::runtime_error );
+      REQUIRE_THROWS_WITH( input.open(), "InputCompressedFile::open: Failed to open file datasets/jibberish.json.gz" );
+
+    } // THEN
+
+  } // GIVEN
+
+  std::remove(test_file.c_str());
+
+} // SCENARIO
@@ -0,0 +1,94 @@
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../bethyw.h"
+
+SCENARIO( "Areas instances populated separately can be combined", "[Areas][combineAreas]" ) {
+
+  GIVEN( "the areas.csv file and the popu1009.json file" ) {
+
+    const auto &AREAS  = BethYw::InputFiles::AREAS;
+    const auto &POPDEN = BethYw::InputFiles::POPDEN;
+
+    Areas serial = Areas();
+    std::ifstream areasStream("datasets/areas.csv");
+    serial.populate(areasStream, AREAS.PARSER, AREAS.COLS);
+
+    WHEN( "a copy without measures is populated and combined back" ) {
+
+      Areas part = serial.withoutMeasures();
+      REQUIRE( part.size() == serial.size() );
+
+      std::ifstream partStream("datasets/popu1009.json");
+      part.populate(partStream, POPDEN.PARSER, POPDEN.COLS);
+
+      Areas combined = serial.withoutMeasures();
+      combined.combineAreas(part);
+
+      std::ifstream serialStream("datasets/popu1009.json");
+      serial.populate(serialStream, POPDEN.PARSER, POPDEN.COLS);
+
+      THEN( "the result is the same as populating the original instance" ) {
+
+        REQUIRE( combined.toJSON() == serial.toJSON() );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "tasks can be run on several threads", "[thread_operations][parallelFor]" ) {
+
+  GIVEN( "a number of tasks" ) {
+
+    std::vector<int> results(100, 0);
+
+    THEN( "every task is run exactly once" ) {
+
+      thread_operations::parallelFor(results.size(), 4, [&](size_t i) {
+        results[i] += static_cast<int>(i);
+      });
+
+      for (size_t i = 0; i < results.size(); i++) {
+        REQUIRE( results[i] == static_cast<int>(i) );
+      }
+
+    } // THEN
+
+    THEN( "the exception of the first failing task is rethrown" ) {
+
+      auto failing = [](size_t i) {
+        if (i == 10 || i == 50) {
+          throw std::runtime_error("task " + std::to_string(i));
+        }
+      };
+
+      REQUIRE_THROWS_WITH( thread_operations::parallelFor(100, 4, failing), "task 10" );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,116 @@
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../input.h"
+
+SCENARIO( "the odata.nextLink of a StatsWales JSON page can be found", "[InputPagedFile][nextLink]" ) {
+
+  auto span_of = [](const std::string &str) {
+    return InputSpan{str.data(), str.size()};
+  };
+
+  GIVEN( "a page with a nextLink" ) {
+
+    const std::string page = "{\"value\":[{\"a\":\"odata.nextLink\"}],\"odata.nextLink\" : \"http:\\/\\/x\\/y?z=1\"}";
+
+    THEN( "the unescaped link is returned" ) {
+
+      REQUIRE( InputPagedFile::findNextLink(span_of(page)) == "http://x/y?z=1" );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a page without a nextLink" ) {
+
+    const std::string page = "{\"value\":[]}";
+
+    THEN( "an empty string is returned" ) {
+
+      REQUIRE( InputPagedFile::findNextLink(span_of(page)).empty() );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "a StatsWales JSON file can be followed across its pages", "[InputPagedFile][pages]" ) {
+
+  const std::string first_page  = "bin/test-pages.json";
+  const std::string second_page = "bin/test-pages.page-2.json";
+  const std::string third_page  = "bin/test-pages-last.json";
+
+  auto row = [](const std::string &year, const std::string &value) {
+    return "{\"Localauthority_Code\":\"W06000001\",\"Localauthority_ItemName_ENG\":\"Isle of Anglesey\","
+           "\"Measure_Code\":\"Pop\",\"Measure_ItemName_ENG\":\"Population\",\"Year_Code\":\"" + year + "\","
+           "\"Data\":" + value + "}";
+  };
+
+  std::ofstream(first_page) << "{\"value\":[" << row("2001", "1") << "],"
+                            << "\"odata.nextLink\":\"http://open.statswales.gov.wales/x?%24skiptoken=1\"}";
+  std::ofstream(second_page) << "{\"value\":[" << row("2002", "2") << "],"
+                             << "\"odata.nextLink\":\"test-pages-last.json\"}";
+  std::ofstream(third_page) << "{\"value\":[" << row("2003", "3") << "]}";
+
+  GIVEN( "a constructed InputPagedFile instance" ) {
+
+    InputPagedFile input(first_page);
+
+    THEN( "every page is read in order and populates the Areas instance" ) {
+
+      Areas areas = Areas();
+      unsigned int pages = 0;
+
+      while (input.nextPage()) {
+        pages++;
+        REQUIRE( input.getPageNumber() == pages );
+        areas.populate(input.page(), BethYw::WelshStatsJSON, BethYw::InputFiles::POPDEN.COLS);
+      }
+
+      REQUIRE( pages == 3 );
+      REQUIRE( areas.getArea("W06000001").getMeasure("pop").size() == 3 );
+      REQUIRE( areas.getArea("W06000001").getMeasure("pop").getValue(2003) == 3 );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a page whose next page is missing" ) {
+
+    std::remove(third_page.c_str());
+    InputPagedFile input(first_page);
+
+    THEN( "a std::runtime_error is thrown when moving to the missing page" ) {
+
+      REQUIRE( input.nextPage() );
+      REQUIRE( input.nextPage() );
+      REQUIRE_THROWS_AS( input.nextPage(), std::runtime_error );
+
+    } // THEN
+
+  } // GIVEN
+
+  std::remove(first_page.c_str());
+  std::remove(second_page.c_str());
+  std::remove(third_page.c_str());
+
+} // SCENARIO
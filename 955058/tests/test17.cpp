@@ -0,0 +1,205 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "../lib_cxxopts.hpp"
+#include "../lib_cxxopts_argv.hpp"
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../bethyw.h"
+#include "../input.h"
+
+SCENARIO( "the input program arguments can be parsed correctly", "[args][input]" ) {
+
+  GIVEN( "an --input argument formatted like a known dataset" ) {
+
+    Argv argv({"test", "--input", "-", "--input-like", "popden"});
+    auto** actual_argv = argv.argv();
+    auto argc          = argv.argc();
+
+    auto cxxopts = BethYw::cxxoptsSetup();
+    auto args    = cxxopts.parse(argc, actual_argv);
+
+    THEN( "the source has the dataset's data type and columns" ) {
+
+      auto input = BethYw::parseInputArgs(args);
+      REQUIRE( input.FILE == InputPipe::STANDARD_INPUT );
+      REQUIRE( input.PARSER == BethYw::InputFiles::POPDEN.PARSER );
+      REQUIRE( input.COLS == BethYw::InputFiles::POPDEN.COLS );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "an --input argument with a data type and some columns" ) {
+
+    Argv argv({"test", "--input", "data.fifo", "--input-type", "authority-code-csv",
+               "--input-cols", "auth_code=Code,AUTH_NAME_ENG=Name,auth_name_cym=Enw"});
+    auto** actual_argv = argv.argv();
+    auto argc          = argv.argc();
+
+    auto cxxopts = BethYw::cxxoptsSetup();
+    auto args    = cxxopts.parse(argc, actual_argv);
+
+    THEN( "the source has the given data type and columns" ) {
+
+      auto input = BethYw::parseInputArgs(args);
+      REQUIRE( input.FILE == "data.fifo" );
+      REQUIRE( input.PARSER == BethYw::SourceDataType::AuthorityCodeCSV );
+      REQUIRE( input.COLS.size() == 3 );
+      REQUIRE( input.COLS.at(BethYw::SourceColumn::AUTH_NAME_ENG) == "Name" );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "an --input argument without a data type" ) {
+
+    Argv argv({"test", "--input", "-", "--input-cols", "year=Year"});
+    auto** actual_argv = argv.argv();
+    auto argc          = argv.argc();
+
+    auto cxxopts = BethYw::cxxoptsSetup();
+    auto args    = cxxopts.parse(argc, actual_argv);
+
+    THEN( "a std::invalid_argument exception is thrown" ) {
+
+      REQUIRE_THROWS_WITH( BethYw::parseInputArgs(args), "Invalid input for input-type argument" );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "an --input argument with an unknown column" ) {
+
+    Argv argv({"test", "--input", "-", "--input-like", "trains", "--input-cols", "month=Month"});
+    auto** actual_argv = argv.argv();
+    auto argc          = argv.argc();
+
+    auto cxxopts = BethYw::cxxoptsSetup();
+    auto args    = cxxopts.parse(argc, actual_argv);
+
+    THEN( "a std::invalid_argument exception is thrown" ) {
+
+      REQUIRE_THROWS_WITH( BethYw::parseInputArgs(args), "Invalid input for input-cols argument" );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+#ifndef _WIN32
+SCENARIO( "a dataset can be streamed in through a named pipe", "[InputPipe]" ) {
+
+  auto read_file = [](const std::string &path) {
+    std::ifstream file(path);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  };
+
+  const std::string fifo = "bin/test17.fifo";
+  unlink(fifo.c_str());
+  REQUIRE( mkfifo(fifo.c_str(), 0600) == 0 );
+
+  GIVEN( "a program writing popu1009.json into the pipe" ) {
+
+    const std::string contents = read_file("datasets/popu1009.json");
+
+    std::thread writer([&]() {
+      std::ofstream pipe(fifo, std::ofstream::binary);
+      pipe << contents;
+    });
+
+    InputPipe input(fifo);
+    Areas streamed = Areas();
+    streamed.populate(input.open(), BethYw::InputFiles::POPDEN.PARSER, BethYw::InputFiles::POPDEN.COLS);
+    writer.join();
+
+    THEN( "the data imported is the same as from the file" ) {
+
+      Areas fromFile = Areas();
+      InputFile file("datasets/popu1009.json");
+      fromFile.populate(file.open(), BethYw::InputFiles::POPDEN.PARSER, BethYw::InputFiles::POPDEN.COLS);
+
+      REQUIRE( streamed.size() == fromFile.size() );
+      REQUIRE( streamed.toJSON() == fromFile.toJSON() );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a program writing a CSV file with a value that can't be parsed into the pipe" ) {
+
+    const BethYw::InputFileSource &dataset = BethYw::InputFiles::COMPLETE_POPDEN;
+    const BethYw::InputFileSource input = {dataset.CODE, dataset.NAME, fifo, dataset.PARSER, dataset.COLS};
+
+    const std::string header = "AuthorityCode,2015,2016\n";
+    const std::string expected = header + "W06000001,1.5,2.5\n";
+    const std::string malformed = header + "W06000002,x,3\n" + "W06000001,1.5,2.5\n";
+
+    std::thread writer([&]() {
+      std::ofstream pipe(fifo, std::ofstream::binary);
+      pipe << malformed;
+    });
+
+    BethYw::LoadOptions options;
+    options.maxErrors = 5;
+
+    std::ostringstream report;
+    std::streambuf *cerr = std::cerr.rdbuf(report.rdbuf());
+
+    Areas streamed = Areas();
+    BethYw::loadInput(streamed, input, StringFilterSet(), StringFilterSet(), YearFilterTuple(0, 0), options);
+    std::cerr.rdbuf(cerr);
+    writer.join();
+
+    THEN( "with --max-errors, the line is skipped and reported" ) {
+
+      Areas fromFile = Areas();
+      fromFile.populate(InputSpan{expected.data(), expected.size()}, dataset.PARSER, dataset.COLS);
+
+      REQUIRE( streamed.toJSON() == fromFile.toJSON() );
+      REQUIRE_THAT( report.str(), Catch::StartsWith(fifo + ": skipped 1 malformed record") );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a pipe that does not exist" ) {
+
+    InputPipe input("bin/jibberish.fifo");
+
+    THEN( "a std::runtime_error is thrown when it is opened" ) {
+
+      REQUIRE_THROWS_WITH( input.open(), "InputPipe::open: Failed to open bin/jibberish.fifo" );
+
+    } // THEN
+
+  } // GIVEN
+
+  unlink(fifo.c_str());
+
+} // SCENARIO
+#endif
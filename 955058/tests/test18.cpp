@@ -0,0 +1,445 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../bethyw.h"
+#include "../input.h"
+
+#ifndef _WIN32
+/*
+  A stand-in for a StatsWales-compatible web server, listening on a free port
+  on 127.0.0.1. It serves its files with an ETag, supports Range and
+  If-None-Match requests and keep-alive connections, and counts what it does.
+  Like a real server, it ignores an If-Range with a weak ETag (e.g. W/"v1").
+  It can also reply to a path with a raw response, e.g. a malformed one.
+*/
+class LocalHttpServer {
+private:
+  int listener;
+  std::thread acceptor;
+  std::vector<std::thread> handlers;
+  std::vector<int> clients;
+  std::mutex mutex;
+
+  std::map<std::string, std::pair<std::string, std::string>> files;
+  std::map<std::string, std::string> rawResponses;
+
+  void handle(int client) {
+    std::string received;
+    char buffer[4096];
+
+    while (true) {
+      size_t headersEnd;
+      while ((headersEnd = received.find("\r\n\r\n")) == std::string::npos) {
+        ssize_t count = recv(client, buffer, sizeof(buffer), 0);
+        if (count <= 0) {
+          return;
+        }
+        received.append(buffer, static_cast<size_t>(count));
+      }
+
+      std::string request = received.substr(0, headersEnd);
+      received.erase(0, headersEnd + 4);
+      requests++;
+
+      std::string target = request.substr(4, request.find(' ', 4) - 4);
+      auto header = [&request](const std::string& name) {
+        size_t start = request.find("\r\n" + name + ": ");
+        if (start == std::string::npos) {
+          return std::string();
+        }
+        start += name.size() + 4;
+        return request.substr(start, request.find("\r\n", start) - start);
+      };
+
+      std::string response;
+      std::string body;
+
+      std::unique_lock<std::mutex> lock(mutex);
+      auto file = files.find(target);
+      auto raw = rawResponses.find(target);
+
+      if (raw != rawResponses.end()) {
+        response = raw->second;
+      } else if (file == files.end()) {
+        body = "Not Found";
+        response = "HTTP/1.1 404 Not Found\r\n";
+      } else if (header("If-None-Match") == file->second.second) {
+        response = "HTTP/1.1 304 Not Modified\r\nETag: " + file->second.second + "\r\n\r\n";
+      } else if (!header("Range").empty() &&
+                 (header("If-Range").empty() ||
+                  (header("If-Range") == file->second.second && header("If-Range").compare(0, 2, "W/") != 0))) {
+        const std::string& contents = file->second.first;
+        unsigned long first = 0, last = 0;
+        std::sscanf(header("Range").c_str(), "bytes=%lu-%lu", &first, &last);
+        last = std::min(last, static_cast<unsigned long>(contents.size()) - 1);
+
+        body = contents.substr(first, last - first + 1);
+        response = "HTTP/1.1 206 Partial Content\r\nETag: " + file->second.second + "\r\n"
+                   "Content-Range: bytes " + std::to_string(first) + "-" + std::to_string(last) +
+                   "/" + std::to_string(contents.size()) + "\r\n";
+        rangeRequests++;
+      } else {
+        body = file->second.first;
+        response = "HTTP/1.1 200 OK\r\nETag: " + file->second.second + "\r\n";
+      }
+      lock.unlock();
+
+      if (response.find("\r\n\r\n") == std::string::npos) {
+        response += "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+        bodyBytesSent += body.size();
+      }
+
+      for (size_t sent = 0; sent < response.size();) {
+        ssize_t count = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (count <= 0) {
+          return;
+        }
+        sent += static_cast<size_t>(count);
+      }
+    }
+  }
+
+public:
+  std::atomic<unsigned int> connections;
+  std::atomic<unsigned int> requests;
+  std::atomic<unsigned int> rangeRequests;
+  std::atomic<size_t> bodyBytesSent;
+  unsigned short port;
+
+  LocalHttpServer() : listener(-1), connections(0), requests(0), rangeRequests(0), bodyBytesSent(0), port(0) {
+    listener = socket(AF_INET, SOCK_STREAM, 0);
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    listen(listener, 16);
+
+    socklen_t length = sizeof(address);
+    getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length);
+    port = ntohs(address.sin_port);
+
+    acceptor = std::thread([this]() {
+      while (true) {
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0) {
+          return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        connections++;
+        clients.push_back(client);
+        handlers.emplace_back(&LocalHttpServer::handle, this, client);
+      }
+    });
+  }
+
+  ~LocalHttpServer() {
+    shutdown(listener, SHUT_RDWR);
+    close(listener);
+    acceptor.join();
+
+    for (int client : clients) {
+      shutdown(client, SHUT_RDWR);
+    }
+    for (std::thread& handler : handlers) {
+      handler.join();
+    }
+    for (int client : clients) {
+      close(client);
+    }
+  }
+
+  void serve(const std::string& path, const std::string& contents, const std::string& etag) {
+    std::lock_guard<std::mutex> lock(mutex);
+    files[path] = {contents, etag};
+  }
+
+  void serveRaw(const std::string& path, const std::string& response) {
+    std::lock_guard<std::mutex> lock(mutex);
+    rawResponses[path] = response;
+  }
+
+  std::string url(const std::string& path) const {
+    return "http://127.0.0.1:" + std::to_string(port) + path;
+  }
+};
+
+SCENARIO( "a dataset can be fetched from a web server", "[InputHttpFile]" ) {
+
+  auto read_file = [](const std::string &path) {
+    std::ifstream file(path);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  };
+
+  const std::string contents = read_file("datasets/popu1009.json");
+  const std::string cache_dir = "bin";
+
+  LocalHttpServer server;
+  server.serve("/popu1009.json", contents, "\"v1\"");
+
+  GIVEN( "an InputHttpFile for a file that fits in one range" ) {
+
+    InputHttpFile input(server.url("/popu1009.json"));
+
+    THEN( "the file is fetched with a single request" ) {
+
+      InputSpan span = input.span();
+      REQUIRE( std::string(span.data, span.size) == contents );
+      REQUIRE( server.requests == 1 );
+      REQUIRE_FALSE( input.isFromCache() );
+
+    } // THEN
+
+    THEN( "the data imported is the same as from the file" ) {
+
+      Areas fromHttp = Areas();
+      fromHttp.populate(input.open(), BethYw::InputFiles::POPDEN.PARSER, BethYw::InputFiles::POPDEN.COLS);
+
+      Areas fromFile = Areas();
+      InputFile file("datasets/popu1009.json");
+      fromFile.populate(file.open(), BethYw::InputFiles::POPDEN.PARSER, BethYw::InputFiles::POPDEN.COLS);
+
+      REQUIRE( fromHttp.toJSON() == fromFile.toJSON() );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "an InputHttpFile for a file larger than its range size" ) {
+
+    InputHttpFile input(server.url("/popu1009.json"), "", 3, 64 * 1024);
+
+    THEN( "the file is fetched in ranges over several connections" ) {
+
+      InputSpan span = input.span();
+      REQUIRE( std::string(span.data, span.size) == contents );
+      REQUIRE( server.rangeRequests == (contents.size() + 64 * 1024 - 1) / (64 * 1024) );
+      REQUIRE( server.connections > 1 );
+      REQUIRE( server.connections <= 3 );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "several InputHttpFile instances fetching one after another" ) {
+
+    THEN( "the connection is kept alive between them" ) {
+
+      for (int i = 0; i < 3; i++) {
+        InputHttpFile input(server.url("/popu1009.json"));
+        REQUIRE( input.span().size == contents.size() );
+      }
+
+      REQUIRE( server.requests == 3 );
+      REQUIRE( server.connections == 1 );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "an InputHttpFile with a cache directory" ) {
+
+    std::remove((cache_dir + "/" + InputHttpFile::cacheKey(server.url("/popu1009.json")) + ".data").c_str());
+    std::remove((cache_dir + "/" + InputHttpFile::cacheKey(server.url("/popu1009.json")) + ".etag").c_str());
+
+    InputHttpFile first(server.url("/popu1009.json"), cache_dir);
+    REQUIRE( first.span().size == contents.size() );
+
+    WHEN( "the file is fetched again, unchanged" ) {
+
+      size_t bytesSentBefore = server.bodyBytesSent;
+
+      InputHttpFile second(server.url("/popu1009.json"), cache_dir);
+      InputSpan span = second.span();
+
+      THEN( "it is read from the cache, without downloading it again" ) {
+
+        REQUIRE( second.isFromCache() );
+        REQUIRE( std::string(span.data, span.size) == contents );
+        REQUIRE( server.bodyBytesSent == bytesSentBefore );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "the file is fetched again, after it has changed" ) {
+
+      server.serve("/popu1009.json", "changed", "\"v2\"");
+
+      InputHttpFile second(server.url("/popu1009.json"), cache_dir);
+      InputSpan span = second.span();
+
+      THEN( "it is downloaded again" ) {
+
+        REQUIRE_FALSE( second.isFromCache() );
+        REQUIRE( std::string(span.data, span.size) == "changed" );
+
+      } // THEN
+
+    } // WHEN
+
+    std::remove((cache_dir + "/" + InputHttpFile::cacheKey(server.url("/popu1009.json")) + ".data").c_str());
+    std::remove((cache_dir + "/" + InputHttpFile::cacheKey(server.url("/popu1009.json")) + ".etag").c_str());
+
+  } // GIVEN
+
+  GIVEN( "an InputHttpFile for a file with a weak ETag, larger than its range size" ) {
+
+    server.serve("/weak.json", contents, "W/\"v1\"");
+    InputHttpFile input(server.url("/weak.json"), "", 3, 64 * 1024);
+
+    THEN( "the file is fetched again with a single request, as If-Range can't be used" ) {
+
+      InputSpan span = input.span();
+      REQUIRE( std::string(span.data, span.size) == contents );
+      REQUIRE( server.rangeRequests == 1 );
+      REQUIRE( server.requests == 2 );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "an InputHttpFile for a URL the server replies to with a malformed length" ) {
+
+    server.serveRaw("/length.json", "HTTP/1.1 200 OK\r\nContent-Length: jibberish\r\n\r\n");
+    server.serveRaw("/chunked.json", "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nzz\r\n");
+
+    THEN( "a std::runtime_error is thrown naming the URL when it is opened" ) {
+
+      InputHttpFile length(server.url("/length.json"));
+      REQUIRE_THROWS_WITH( length.open(),
+                           "InputHttpFile: Invalid response from the server for " + server.url("/length.json") );
+
+      InputHttpFile chunked(server.url("/chunked.json"));
+      REQUIRE_THROWS_WITH( chunked.open(),
+                           "InputHttpFile: Invalid response from the server for " + server.url("/chunked.json") );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "an InputHttpFile for a file the server does not have" ) {
+
+    InputHttpFile input(server.url("/jibberish.json"));
+
+    THEN( "a std::runtime_error is thrown when it is opened" ) {
+
+      REQUIRE_THROWS_WITH( input.open(),
+                           "InputHttpFile::open: Failed to fetch " + server.url("/jibberish.json") + " (HTTP 404)" );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "a paged StatsWales JSON dataset can be fetched from a web server", "[InputHttpFile][InputPagedFile]" ) {
+
+  auto row = [](const std::string &year, const std::string &value) {
+    return "{\"Localauthority_Code\":\"W06000001\",\"Localauthority_ItemName_ENG\":\"Isle of Anglesey\","
+           "\"Measure_Code\":\"Pop\",\"Measure_ItemName_ENG\":\"Population\",\"Year_Code\":\"" + year + "\","
+           "\"Data\":" + value + "}";
+  };
+
+  LocalHttpServer server;
+  server.serve("/data/pages.json", "{\"value\":[" + row("2001", "1") + "],"
+               "\"odata.nextLink\":\"https://open.statswales.gov.wales/x?%24skiptoken=1\"}", "\"p1\"");
+  server.serve("/data/pages.page-2.json", "{\"value\":[" + row("2002", "2") + "],"
+               "\"odata.nextLink\":\"/data/pages-3.json\"}", "\"p2\"");
+  server.serve("/data/pages-3.json", "{\"value\":[" + row("2003", "3") + "],"
+               "\"odata.nextLink\":\"" + server.url("/data/pages-4.json") + "\"}", "\"p3\"");
+  server.serve("/data/pages-4.json", "{\"value\":[" + row("2004", "4") + "]}", "\"p4\"");
+
+  GIVEN( "an InputPagedFile for the URL of the first page" ) {
+
+    InputPagedFile input(server.url("/data/pages.json"));
+
+    THEN( "every page is fetched from the server in order" ) {
+
+      Areas areas = Areas();
+      unsigned int pages = 0;
+
+      while (input.nextPage()) {
+        pages++;
+        areas.populate(input.page(), BethYw::WelshStatsJSON, BethYw::InputFiles::POPDEN.COLS);
+      }
+
+      REQUIRE( pages == 4 );
+      REQUIRE( areas.getArea("W06000001").getMeasure("pop").size() == 4 );
+      REQUIRE( areas.getArea("W06000001").getMeasure("pop").getValue(2004) == 4 );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "the dataset loaded from an http:// directory with followNextLinks" ) {
+
+    const BethYw::InputFileSource &popden = BethYw::InputFiles::POPDEN;
+    std::vector<BethYw::InputFileSource> datasets = {{"pages", "Pages", "pages.json", popden.PARSER, popden.COLS}};
+
+    BethYw::LoadOptions options;
+    options.followNextLinks = true;
+    options.httpCacheDir = "";
+
+    THEN( "every page is imported" ) {
+
+      Areas areas = Areas();
+      BethYw::loadDatasets(areas, server.url("/data/"), datasets, StringFilterSet(), StringFilterSet(),
+                           YearFilterTuple(0, 0), options);
+
+      REQUIRE( areas.getArea("W06000001").getMeasure("pop").size() == 4 );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a page whose next page the server does not have" ) {
+
+    server.serve("/data/pages-3.json", "{\"value\":[" + row("2003", "3") + "],"
+                 "\"odata.nextLink\":\"" + server.url("/data/jibberish.json") + "\"}", "\"p3-2\"");
+    InputPagedFile input(server.url("/data/pages.json"));
+
+    THEN( "a std::runtime_error is thrown when moving to the missing page" ) {
+
+      REQUIRE( input.nextPage() );
+      REQUIRE( input.nextPage() );
+      REQUIRE( input.nextPage() );
+      REQUIRE_THROWS_WITH( input.nextPage(),
+                           "InputHttpFile::open: Failed to fetch " + server.url("/data/jibberish.json") + " (HTTP 404)" );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+#endif
@@ -0,0 +1,207 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../cache.h"
+#include "../input.h"
+
+SCENARIO( "parsed areas can be filtered after they are parsed", "[Areas][populateFromParsed]" ) {
+
+  auto import_areas_csv = [](Areas &areas, const StringFilterSet *areasFilter) {
+    InputFile input("datasets/" + BethYw::InputFiles::AREAS.FILE);
+    areas.populate(input.open(), BethYw::InputFiles::AREAS.PARSER, BethYw::InputFiles::AREAS.COLS, areasFilter);
+  };
+
+  const std::vector<StringFilterSet> areasFilters = {{}, {"W06000011"}, {"swan", "card"}, {"W06000999"}};
+  const std::vector<StringFilterSet> measuresFilters = {{}, {"pop"}, {"POP", "dens", "rail"}};
+  const std::vector<YearFilterTuple> yearsFilters = {YearFilterTuple(0, 0), YearFilterTuple(2010, 2014)};
+
+  GIVEN( "every dataset, parsed without filters" ) {
+
+    THEN( "filtering the parsed areas gives the same result as parsing with the filters" ) {
+
+      for (const BethYw::InputFileSource &dataset : BethYw::InputFiles::DATASETS) {
+        Areas parsed = Areas();
+        InputFile input("datasets/" + dataset.FILE);
+        parsed.populate(input.open(), dataset.PARSER, dataset.COLS);
+
+        for (const auto &areasFilter : areasFilters) {
+          for (const auto &measuresFilter : measuresFilters) {
+            for (const auto &yearsFilter : yearsFilters) {
+              Areas expected = Areas();
+              import_areas_csv(expected, &areasFilter);
+              InputFile file("datasets/" + dataset.FILE);
+              expected.populate(file.open(), dataset.PARSER, dataset.COLS, &areasFilter, &measuresFilter, &yearsFilter);
+
+              Areas actual = Areas();
+              import_areas_csv(actual, &areasFilter);
+              actual.populateFromParsed(parsed, dataset.PARSER, &areasFilter, &measuresFilter, &yearsFilter);
+
+              REQUIRE( actual.toJSON() == expected.toJSON() );
+            }
+          }
+        }
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "areas.csv, parsed without filters" ) {
+
+    Areas parsed = Areas();
+    import_areas_csv(parsed, nullptr);
+
+    THEN( "filtering the parsed areas gives the same result as parsing with the filters" ) {
+
+      for (const auto &areasFilter : areasFilters) {
+        Areas expected = Areas();
+        import_areas_csv(expected, &areasFilter);
+
+        Areas actual = Areas();
+        actual.populateFromParsed(parsed, BethYw::InputFiles::AREAS.PARSER, &areasFilter);
+
+        REQUIRE( actual.toJSON() == expected.toJSON() );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "parsed dataset files can be cached", "[ParseCache]" ) {
+
+  const std::string cache_dir = "bin";
+  const BethYw::InputFileSource &dataset = BethYw::InputFiles::POPDEN;
+  const std::string test_file = "datasets/" + dataset.FILE;
+
+  Areas parsed = Areas();
+  InputFile input(test_file);
+  parsed.populate(input.open(), dataset.PARSER, dataset.COLS);
+
+  GIVEN( "areas parsed from a file" ) {
+
+    THEN( "they are the same once encoded and decoded" ) {
+
+      std::string encoded = ParseCache::encode(parsed);
+      Areas decoded = Areas();
+
+      REQUIRE( ParseCache::decode({encoded.data(), encoded.size()}, decoded) );
+      REQUIRE( decoded.toJSON() == parsed.toJSON() );
+
+      AND_THEN( "truncated encoded areas can't be decoded" ) {
+
+        Areas truncated = Areas();
+        REQUIRE_FALSE( ParseCache::decode({encoded.data(), encoded.size() / 2}, truncated) );
+
+      } // AND_THEN
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a ParseCache for each key mode" ) {
+
+    const std::vector<ParseCache::KeyMode> modes = {ParseCache::KeyMode::ContentHash,
+                                                    ParseCache::KeyMode::ModificationTime};
+
+    THEN( "the key changes with the file, parser and column mapping" ) {
+
+      BethYw::SourceColumnMapping cols = dataset.COLS;
+      cols[BethYw::SourceColumn::VALUE] = "Other";
+
+      for (auto mode : modes) {
+        ParseCache cache(cache_dir, mode);
+        const std::string key = cache.key(test_file, dataset.PARSER, dataset.COLS);
+
+        REQUIRE( cache.key(test_file, dataset.PARSER, dataset.COLS) == key );
+        REQUIRE( cache.key(test_file, dataset.PARSER, cols) != key );
+        REQUIRE( cache.key(test_file, BethYw::SourceDataType::AuthorityByYearCSV, dataset.COLS) != key );
+        REQUIRE( cache.key("datasets/" + BethYw::InputFiles::TRAINS.FILE, dataset.PARSER, dataset.COLS) != key );
+      }
+
+    } // THEN
+
+    THEN( "stored areas can be loaded with the same key" ) {
+
+      for (auto mode : modes) {
+        ParseCache cache(cache_dir, mode);
+        const std::string key = cache.key(test_file, dataset.PARSER, dataset.COLS);
+        cache.store(key, parsed);
+
+        Areas loaded = Areas();
+        REQUIRE( cache.load(key, loaded) );
+        REQUIRE( loaded.toJSON() == parsed.toJSON() );
+
+        Areas missing = Areas();
+        REQUIRE_FALSE( cache.load(key + "x", missing) );
+
+        cache.erase(key);
+        Areas erased = Areas();
+        REQUIRE_FALSE( cache.load(key, erased) );
+      }
+
+    } // THEN
+
+    THEN( "the content key changes when any byte of the file changes" ) {
+
+      const std::string copy_file = "bin/test19-content.json";
+      auto write_file = [&copy_file](const std::string &contents) {
+        std::ofstream(copy_file, std::ofstream::binary | std::ofstream::trunc) << contents;
+      };
+
+      std::ifstream file(test_file, std::ifstream::binary);
+      const std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+      ParseCache cache(cache_dir, ParseCache::KeyMode::ContentHash);
+
+      write_file(contents);
+      const std::string key = cache.key(copy_file, dataset.PARSER, dataset.COLS);
+      REQUIRE( key == cache.key(test_file, dataset.PARSER, dataset.COLS) );
+
+      // Including bytes in the last, partial word
+      for (size_t position : {size_t(0), size_t(7), contents.size() / 2, contents.size() - 3, contents.size() - 1}) {
+        std::string changed = contents;
+        changed[position] ^= 0x01;
+        write_file(changed);
+        REQUIRE( cache.key(copy_file, dataset.PARSER, dataset.COLS) != key );
+      }
+
+      // A zero byte appended still changes the key
+      write_file(contents + '\0');
+      REQUIRE( cache.key(copy_file, dataset.PARSER, dataset.COLS) != key );
+
+      std::remove(copy_file.c_str());
+
+    } // THEN
+
+    THEN( "a missing file can't be keyed" ) {
+
+      for (auto mode : modes) {
+        ParseCache cache(cache_dir, mode);
+        REQUIRE_THROWS_AS( cache.key("datasets/jibberish.json", dataset.PARSER, dataset.COLS), std::runtime_error );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,305 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <clocale>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "../lib_json.hpp"
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../input.h"
+#include "../jsonscanner.h"
+
+SCENARIO( "a block of JSON can be classified with SIMD instructions", "[StatsWalesJSONScanner][classifyBlock]" ) {
+
+  GIVEN( "blocks of every byte value" ) {
+
+    THEN( "the masks match classifying one byte at a time" ) {
+
+      for (unsigned int start = 0; start < 256; start += 64) {
+        char block[64];
+        StatsWalesJSONScanner::BlockMasks expected{0, 0, 0, 0};
+
+        for (unsigned int i = 0; i < 64; i++) {
+          const unsigned char c = static_cast<unsigned char>(start + i);
+          block[i] = static_cast<char>(c);
+
+          const uint64_t bit = uint64_t(1) << i;
+          if (c == '"') {
+            expected.quotes |= bit;
+          } else if (c == '\\') {
+            expected.backslashes |= bit;
+          } else if (c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',') {
+            expected.structurals |= bit;
+          } else if (c < 0x20) {
+            expected.controls |= bit;
+          }
+        }
+
+        StatsWalesJSONScanner::BlockMasks actual;
+        StatsWalesJSONScanner::classifyBlock(block, actual);
+
+        REQUIRE( actual.quotes == expected.quotes );
+        REQUIRE( actual.backslashes == expected.backslashes );
+        REQUIRE( actual.structurals == expected.structurals );
+        REQUIRE( actual.controls == expected.controls );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "a StatsWales JSON document can be scanned for the keys of its records", "[StatsWalesJSONScanner][forEachRecord]" ) {
+
+  const std::vector<std::string> keys = {"Code", "Name", "Year", "Value"};
+
+  auto scan = [&keys](const std::string &document) {
+    std::vector<nlohmann::json> records;
+    StatsWalesJSONScanner scanner(InputSpan{document.data(), document.size()});
+    JSONColumnPlan plan(keys);
+    scanner.forEachRecord(plan, [&keys, &records](const JSONColumnPlan::Values &values) {
+      nlohmann::json record = nlohmann::json::object();
+      for (size_t i = 0; i < keys.size(); i++) {
+        record[keys[i]] = values[i];
+      }
+      records.push_back(record);
+    });
+    return records;
+  };
+
+  GIVEN( "a document with escapes, nesting and numbers at every offset of a block" ) {
+
+    std::string document = "\xEF\xBB\xBF{\"odata.metadata\": \"x\", \"value\" : [\n";
+
+    for (unsigned int offset = 0; offset < 130; offset++) {
+      if (offset > 0) {
+        document += ",\n";
+      }
+
+      document += "{\"Pad\": \"" + std::string(offset, 'a') + "\\\\\\\"\", ";
+      document += "\"Code\": \"W\\\\\\\"{[" + std::to_string(offset) + "\", ";
+      document += "\"Ignored\": {\"a\": \"\\\"}]\", \"b\": [1, -2.5e3, null, true, {}], \"c\": []}, ";
+      document += "\"Name\": \"Caerdydd \\u00e2 \\ud83d\\ude00 \xC3\xA2\", ";
+      document += "\"Year\": \"" + std::to_string(2000 + offset) + "\", ";
+
+      switch (offset % 5) {
+        case 0: document += "\"Value\": " + std::to_string(offset) + ".125"; break;
+        case 1: document += "\"Value\": -" + std::to_string(offset); break;
+        case 2: document += "\"Value\": \"1.5\""; break;
+        case 3: document += "\"Value\": 18446744073709551615"; break;
+        default: document += "\"Value\": 1.5E300"; break;
+      }
+
+      document += "}";
+    }
+
+    document += "], \"odata.nextLink\": \"http://example.com/?$skip=1000\"}\n";
+
+    THEN( "the records match those parsed by nlohmann::json, with only the keys asked for" ) {
+
+      const nlohmann::json parsed = nlohmann::json::parse(document);
+      std::vector<nlohmann::json> expected;
+
+      for (const auto &element : parsed["value"]) {
+        nlohmann::json record = nlohmann::json::object();
+        for (const auto &key : keys) {
+          record[key] = element[key];
+        }
+        expected.push_back(record);
+      }
+
+      const std::vector<nlohmann::json> actual = scan(document);
+      REQUIRE( actual.size() == expected.size() );
+
+      for (size_t i = 0; i < actual.size(); i++) {
+        REQUIRE( actual[i] == expected[i] );
+        REQUIRE( actual[i].dump() == expected[i].dump() );
+      }
+
+    } // THEN
+
+    THEN( "the records match when the document is longer than one chunk" ) {
+
+      std::string longDocument = "{\"value\": [";
+      while (longDocument.size() < 3 * StatsWalesJSONScanner::CHUNK_SIZE) {
+        longDocument += "{\"Code\": \"W06000015\", \"Skip\": \"]}\\\\\", \"Value\": 0.1},";
+      }
+      longDocument += "{\"Code\": \"last\"}]}";
+
+      const nlohmann::json parsed = nlohmann::json::parse(longDocument);
+      const std::vector<nlohmann::json> actual = scan(longDocument);
+      REQUIRE( actual.size() == parsed["value"].size() );
+      REQUIRE( actual.back()["Code"] == "last" );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "documents without a value array" ) {
+
+    THEN( "no records are found" ) {
+
+      REQUIRE( scan("{}").empty() );
+      REQUIRE( scan(" 42 ").empty() );
+      REQUIRE( scan("{\"value\": {\"Code\": \"W\"}, \"other\": [{\"Code\": \"W\"}]}").empty() );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "numbers that aren't read with the fast path, in a locale whose decimal point is a comma" ) {
+
+    const std::string document =
+            "{\"value\": [{\"Code\": \"W\", \"Value\": 0.1234567890123456789012345},"
+            "{\"Code\": \"W\", \"Value\": 1.5e-300, \"Skip\": 123456789012345678901234.5e-3},"
+            "{\"Code\": \"W\", \"Value\": 2.5e-320}]}";
+
+    // Not every system has one of these, but the numbers must be read the
+    // same in the locale that the tests run in either way
+    const std::string previous = std::setlocale(LC_NUMERIC, nullptr);
+    for (const char *name : {"de_DE.UTF-8", "de_DE.utf8", "fr_FR.UTF-8", "fr_FR.utf8", "nl_NL.UTF-8"}) {
+      if (std::setlocale(LC_NUMERIC, name) != nullptr) {
+        break;
+      }
+    }
+
+    std::vector<nlohmann::json> actual;
+    REQUIRE_NOTHROW( actual = scan(document) );
+    std::setlocale(LC_NUMERIC, previous.c_str());
+
+    THEN( "the values match those parsed by nlohmann::json" ) {
+
+      const nlohmann::json parsed = nlohmann::json::parse(document);
+      REQUIRE( actual.size() == parsed["value"].size() );
+
+      for (size_t i = 0; i < actual.size(); i++) {
+        REQUIRE( actual[i]["Value"] == parsed["value"][i]["Value"] );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "malformed documents" ) {
+
+    THEN( "a std::runtime_error exception is thrown" ) {
+
+      const std::vector<std::string> malformed = {
+        "",
+        "{\"value\": [{\"Code\": \"W\"}]",
+        "{\"value\": [{\"Code\": \"W\"}]} x",
+        "{\"value\": [{\"Code\" \"W\"}]}",
+        "{\"value\": [{\"Code\": \"W\",}]}",
+        "{\"value\": [{\"Code\": \"W\"}, ]}",
+        "{\"value\": [{\"Code\": \"W\", \"Skip\": tru}]}",
+        "{\"value\": [{\"Code\": \"W\", \"Skip\": 01}]}",
+        "{\"value\": [{\"Code\": \"W\", \"Skip\": 1.}]}",
+        "{\"value\": [{\"Code\": \"W\", \"Skip\": 1 2}]}",
+        "{\"value\": [{\"Code\": \"W\", \"Skip\": 1e400}]}",
+        "{\"value\": [{\"Code\": \"W\", \"Value\": -1e400}]}",
+        "{\"value\": [{\"Code\": \"W\", \"Skip\": \"\\x\"}]}",
+        "{\"value\": [{\"Code\": \"W\", \"Skip\": \"\\ud800\"}]}",
+        "{\"value\": [{\"Code\": \"W\", \"Skip\": \"a\tb\"}]}",
+        "{\"value\": [{\"Code\": \"W\", \"Skip\": \"\xC3\"}]}",
+        "{\"value\": [{\"Code\": \"W}]}"
+      };
+
+      for (const auto &document : malformed) {
+        REQUIRE_THROWS_AS( nlohmann::json::parse(document), nlohmann::json::exception );
+        REQUIRE_THROWS_AS( scan(document), std::runtime_error );
+      }
+
+    } // THEN
+
+    THEN( "a std::runtime_error exception is thrown for a document that is an array" ) {
+
+      REQUIRE_THROWS_WITH( scan("[{\"Code\": \"W\"}]"), "expected a JSON object with a value array" );
+
+    } // THEN
+
+    THEN( "a std::runtime_error exception is thrown for a record that isn't an object" ) {
+
+      REQUIRE_THROWS_WITH( scan("{\"value\": [{\"Code\": \"W\"}, 7]}"),
+                           "expected each record in the value array to be an object, but got number" );
+      REQUIRE_THROWS_WITH( scan("{\"value\": [[\"W\"]]}"),
+                           "expected each record in the value array to be an object, but got array" );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "a mapped StatsWales JSON file is imported the same way as a stream", "[Areas][StatsWalesJSONScanner]" ) {
+
+  const std::vector<StringFilterSet> areasFilters = {{}, {"W06000011", "card"}};
+  const std::vector<StringFilterSet> measuresFilters = {{}, {"pop", "rail"}};
+  const std::vector<YearFilterTuple> yearsFilters = {YearFilterTuple(0, 0), YearFilterTuple(2010, 2014)};
+
+  GIVEN( "every JSON dataset" ) {
+
+    THEN( "scanning the mapped file gives the same areas as parsing it as a stream" ) {
+
+      for (const BethYw::InputFileSource &dataset : BethYw::InputFiles::DATASETS) {
+        if (dataset.PARSER != BethYw::WelshStatsJSON) {
+          continue;
+        }
+
+        const std::string path = "datasets/" + dataset.FILE;
+
+        for (const auto &areasFilter : areasFilters) {
+          for (const auto &measuresFilter : measuresFilters) {
+            for (const auto &yearsFilter : yearsFilters) {
+              Areas fromStream = Areas();
+              std::ifstream stream(path);
+              fromStream.populate(stream, dataset.PARSER, dataset.COLS, &areasFilter, &measuresFilter, &yearsFilter);
+
+              Areas fromSpan = Areas();
+              InputMappedFile input(path);
+              fromSpan.populate(input.span(), dataset.PARSER, dataset.COLS, &areasFilter, &measuresFilter, &yearsFilter);
+
+              REQUIRE( fromSpan.toJSON() == fromStream.toJSON() );
+            }
+          }
+        }
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a malformed JSON document" ) {
+
+    const std::string document = "{\"value\": [{\"Localauthority_Code\": \"W06000011\",}]}";
+
+    THEN( "the same exception is thrown as when parsing it as a stream" ) {
+
+      Areas areas = Areas();
+      REQUIRE_THROWS_AS( areas.populate(InputSpan{document.data(), document.size()},
+                                        BethYw::WelshStatsJSON,
+                                        BethYw::InputFiles::DATASETS[0].COLS),
+                         std::runtime_error );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
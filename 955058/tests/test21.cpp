@@ -0,0 +1,137 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../lib_json.hpp"
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../input.h"
+#include "../jsonscanner.h"
+
+SCENARIO( "a JSONColumnPlan finds the columns of keys by their position", "[JSONColumnPlan]" ) {
+
+  auto columnsOf = [](JSONColumnPlan &plan, const std::vector<std::string> &keys) {
+    std::vector<int> columns;
+    plan.beginRecord();
+    for (const auto &key : keys) {
+      columns.push_back(plan.column(key.data(), key.size()));
+    }
+    plan.endRecord();
+    return columns;
+  };
+
+  const int SKIP = JSONColumnPlan::SKIP;
+
+  GIVEN( "a plan for three columns" ) {
+
+    JSONColumnPlan plan({"Code", "Year", "Data"});
+
+    REQUIRE( plan.size() == 3 );
+    REQUIRE( plan.getResolutions() == 0 );
+
+    THEN( "it is resolved once against records with their keys in the same order" ) {
+
+      const std::vector<std::string> keys = {"RowKey", "Data", "Code", "Notes", "Year"};
+      const std::vector<int> expected = {SKIP, 2, 0, SKIP, 1};
+
+      for (unsigned int i = 0; i < 5; i++) {
+        REQUIRE( columnsOf(plan, keys) == expected );
+      }
+      REQUIRE( plan.getResolutions() == 1 );
+
+      REQUIRE( columnsOf(plan, {"RowKey", "Data"}) == std::vector<int>({SKIP, 2}) );
+      REQUIRE( plan.getResolutions() == 1 );
+
+    } // THEN
+
+    THEN( "it is resolved again when the order of the keys changes" ) {
+
+      REQUIRE( columnsOf(plan, {"Code", "Year", "Data"}) == std::vector<int>({0, 1, 2}) );
+      REQUIRE( columnsOf(plan, {"Code", "Data", "Year"}) == std::vector<int>({0, 2, 1}) );
+      REQUIRE( plan.getResolutions() == 2 );
+
+      REQUIRE( columnsOf(plan, {"Code", "Data", "Year"}) == std::vector<int>({0, 2, 1}) );
+      REQUIRE( plan.getResolutions() == 2 );
+
+      REQUIRE( columnsOf(plan, {"Code", "Data", "Year", "Extra"}) == std::vector<int>({0, 2, 1, SKIP}) );
+      REQUIRE( columnsOf(plan, {"Data", "Data"}) == std::vector<int>({2, 2}) );
+      REQUIRE( plan.getResolutions() == 4 );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "StatsWales JSON records with their keys in different orders are imported", "[Areas][JSONColumnPlan]" ) {
+
+  GIVEN( "a dataset with the keys of every third record reversed" ) {
+
+    const BethYw::InputFileSource &dataset = BethYw::InputFiles::POPDEN;
+    const std::string path = "datasets/" + dataset.FILE;
+
+    std::ifstream original(path);
+    nlohmann::json document = nlohmann::json::parse(original);
+
+    std::ostringstream reordered;
+    reordered << "{\"value\": [";
+    for (size_t i = 0; i < document["value"].size(); i++) {
+      const nlohmann::json &record = document["value"][i];
+      std::vector<std::string> members;
+      for (auto member = record.begin(); member != record.end(); ++member) {
+        members.push_back(nlohmann::json(member.key()).dump() + ": " + member.value().dump());
+      }
+      if (i % 3 == 0) {
+        members = std::vector<std::string>(members.rbegin(), members.rend());
+      }
+
+      reordered << (i == 0 ? "{" : ", {");
+      for (size_t j = 0; j < members.size(); j++) {
+        reordered << (j == 0 ? "" : ", ") << members[j];
+      }
+      reordered << "}";
+    }
+    reordered << "]}";
+    const std::string text = reordered.str();
+
+    Areas expected = Areas();
+    InputFile input(path);
+    expected.populate(input.open(), dataset.PARSER, dataset.COLS);
+
+    THEN( "parsing it as a stream gives the same areas as the original" ) {
+
+      Areas actual = Areas();
+      std::istringstream stream(text);
+      actual.populate(stream, dataset.PARSER, dataset.COLS);
+
+      REQUIRE( actual.toJSON() == expected.toJSON() );
+
+    } // THEN
+
+    THEN( "scanning it as a span gives the same areas as the original" ) {
+
+      Areas actual = Areas();
+      actual.populate(InputSpan{text.data(), text.size()}, dataset.PARSER, dataset.COLS);
+
+      REQUIRE( actual.toJSON() == expected.toJSON() );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,250 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../bethyw.h"
+#include "../areas.h"
+#include "../csvscanner.h"
+#include "../datasets.h"
+#include "../input.h"
+
+SCENARIO( "the records of a CSV file can be read as described in RFC 4180", "[CSVReader]" ) {
+
+  typedef std::vector<std::vector<std::string>> Records;
+
+  auto toStrings = [](CSVReader &reader) {
+    Records records;
+    while (reader.next()) {
+      std::vector<std::string> fields;
+      for (const auto &field : reader.fields()) {
+        fields.emplace_back(field.data, field.size);
+      }
+      records.push_back(fields);
+    }
+    return records;
+  };
+
+  auto readSpan = [&toStrings](const std::string &text) {
+    CSVReader reader(InputSpan{text.data(), text.size()});
+    return toStrings(reader);
+  };
+
+  auto readStream = [&toStrings](const std::string &text, size_t bufferSize) {
+    std::istringstream stream(text);
+    CSVReader reader(stream, ',', bufferSize);
+    return toStrings(reader);
+  };
+
+  GIVEN( "files with quoted fields, escaped quotes, CRLF and a byte order mark" ) {
+
+    const std::vector<std::pair<std::string, Records>> files = {
+      {"", {}},
+      {"a", {{"a"}}},
+      {"a\n", {{"a"}}},
+      {"a,b\nc,d", {{"a", "b"}, {"c", "d"}}},
+      {"a,b\r\nc,d\r\n", {{"a", "b"}, {"c", "d"}}},
+      {"a,\n,b\n,\n", {{"a", ""}, {"", "b"}, {"", ""}}},
+      {"a\n\nb\r\n\r\n", {{"a"}, {}, {"b"}, {}}},
+      {"\xEF\xBB\xBF" "Code,Name\r\n", {{"Code", "Name"}}},
+      {"W06000011,\"Swansea, City of\",Abertawe", {{"W06000011", "Swansea, City of", "Abertawe"}}},
+      {"\"a \"\"quoted\"\" word\",\"\"\"\",\"\"\n", {{"a \"quoted\" word", "\"", ""}}},
+      {"\"two\r\nlines\",x\r\ny", {{"two\r\nlines", "x"}, {"y"}}},
+      {"\"\"\n", {{""}}},
+      {"a\"b,c\"\n", {{"a\"b", "c\""}}},
+      {"a\rb,c\r", {{"a\rb", "c"}}},
+      {"\"x\"\r", {{"x"}}}
+    };
+
+    THEN( "the records are the same from a span and from a stream with any buffer size" ) {
+
+      for (const auto &file : files) {
+        REQUIRE( readSpan(file.first) == file.second );
+
+        for (size_t bufferSize = 1; bufferSize <= 8; bufferSize++) {
+          REQUIRE( readStream(file.first, bufferSize) == file.second );
+        }
+        REQUIRE( readStream(file.first, CSVReader::BUFFER_SIZE) == file.second );
+      }
+
+    } // THEN
+
+    THEN( "fields without escaped quotes point into a span" ) {
+
+      const std::string text = "W06000011,\"Swansea, City of\",\"A\"\"b\"\n";
+      CSVReader reader(InputSpan{text.data(), text.size()});
+
+      REQUIRE( reader.next() );
+      REQUIRE( reader.fields().size() == 3 );
+      REQUIRE( reader.fields()[0].data == text.data() );
+      REQUIRE( reader.fields()[1].data == text.data() + 11 );
+      REQUIRE( std::string(reader.fields()[2].data, reader.fields()[2].size) == "A\"b" );
+      REQUIRE( reader.getLine() == 1 );
+      REQUIRE_FALSE( reader.next() );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "the lines that CSVScanner split, with empty fields and trailing delimiters" ) {
+
+    // As CSVScanner did, except that a trailing empty field is now kept
+    const std::vector<std::pair<std::string, std::vector<std::string>>> lines = {
+      {",", {"", ""}},
+      {",,", {"", "", ""}},
+      {"a", {"a"}},
+      {"a,", {"a", ""}},
+      {",a", {"", "a"}},
+      {"W06000011,Swansea,Abertawe", {"W06000011", "Swansea", "Abertawe"}},
+      {"W06000011,,Abertawe,", {"W06000011", "", "Abertawe", ""}},
+      {"AuthorityCode,1991,1992,1993,1994,1995,1996,1997,1998,1999,2000,2001,2002,2003\r",
+       {"AuthorityCode", "1991", "1992", "1993", "1994", "1995", "1996", "1997", "1998", "1999", "2000", "2001",
+        "2002", "2003"}}
+    };
+
+    THEN( "the fields are the same with every field quoted, after a byte order mark and with CRLF" ) {
+
+      REQUIRE( readSpan("").empty() );
+
+      for (const auto &line : lines) {
+        const Records expected = {line.second};
+
+        std::string quoted;
+        for (size_t i = 0; i < line.second.size(); i++) {
+          quoted += (i > 0 ? ",\"" : "\"") + line.second[i] + "\"";
+        }
+
+        for (const std::string &text : {line.first, line.first + "\n", quoted + "\r\n", "\xEF\xBB\xBF" + line.first,
+                                        "\xEF\xBB\xBF" + quoted + "\r\n"}) {
+          INFO( text );
+          REQUIRE( readSpan(text) == expected );
+          REQUIRE( readStream(text, 3) == expected );
+        }
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "unquoted lines with fields either side of 16 bytes" ) {
+
+    std::string text;
+    for (size_t length = 1; length < 40; length++) {
+      text += std::string(length, 'x') + "," + std::string(40 - length, 'y') + ",,z\n";
+    }
+
+    THEN( "the fields are the same as those from splitString" ) {
+
+      const Records records = readSpan(text);
+      REQUIRE( records.size() == 39 );
+
+      for (size_t i = 0; i < records.size(); i++) {
+        REQUIRE( records[i] == string_operations::splitString(string_operations::splitString(text, '\n')[i], ',') );
+      }
+
+      REQUIRE( readStream(text, 7) == records );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "malformed files" ) {
+
+    THEN( "a std::runtime_error exception is thrown" ) {
+
+      REQUIRE_THROWS_WITH( readSpan("a\n\"unterminated\nfield"), "CSV line 2: unterminated quoted field" );
+      REQUIRE_THROWS_WITH( readSpan("a\n\"a\"b,c"), "CSV line 2: unexpected character after a quoted field" );
+      REQUIRE_THROWS_WITH( readStream("\"a\"\rb", 2), "CSV line 1: unexpected character after a quoted field" );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "an areas.csv file exported with quoted names, CRLF and a byte order mark is imported", "[Areas][CSVReader]" ) {
+
+  GIVEN( "an areas file with a name that contains a comma" ) {
+
+    const std::string text = "\xEF\xBB\xBFLocal authority code,Name (eng),Name (cym)\r\n"
+                             "W06000011,\"Swansea, City and County of\",\"Dinas a Sir Abertawe\"\r\n"
+                             "\r\n"
+                             "W06000015,Cardiff,\"Caerdydd \"\"CDF\"\"\"\r\n";
+    const BethYw::InputFileSource &dataset = BethYw::InputFiles::AREAS;
+
+    THEN( "the names are imported whole, from both a span and a stream" ) {
+
+      Areas fromSpan = Areas();
+      fromSpan.populate(InputSpan{text.data(), text.size()}, dataset.PARSER, dataset.COLS);
+
+      Areas fromStream = Areas();
+      std::istringstream stream(text);
+      fromStream.populate(stream, dataset.PARSER, dataset.COLS);
+
+      REQUIRE( fromSpan.size() == 2 );
+      REQUIRE( fromSpan.getArea("W06000011").getName("eng") == "Swansea, City and County of" );
+      REQUIRE( fromSpan.getArea("W06000015").getName("cym") == "Caerdydd \"CDF\"" );
+      REQUIRE( fromStream.toJSON() == fromSpan.toJSON() );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "a wide-by-year CSV file is imported the same way from a stream and a span", "[Areas][CSVReader]" ) {
+
+  GIVEN( "a CSV file with many years and lines" ) {
+
+    std::ostringstream csv;
+    csv << "AuthorityCode";
+    for (int year = 1900; year < 2020; year++) {
+      csv << "," << year;
+    }
+    csv << "\n";
+
+    for (int area = 0; area < 200; area++) {
+      csv << "W" << (6000000 + area);
+      for (int year = 1900; year < 2020; year++) {
+        csv << ",";
+        if ((area + year) % 7 != 0) {
+          csv << (area * 1000 + year) << "." << (year % 10);
+        }
+      }
+      csv << "\n";
+    }
+
+    const std::string text = csv.str();
+    const BethYw::InputFileSource &dataset = BethYw::InputFiles::COMPLETE_POP;
+
+    THEN( "both give the same areas" ) {
+
+      Areas fromStream = Areas();
+      std::istringstream stream(text);
+      fromStream.populate(stream, dataset.PARSER, dataset.COLS);
+
+      Areas fromSpan = Areas();
+      fromSpan.populate(InputSpan{text.data(), text.size()}, dataset.PARSER, dataset.COLS);
+
+      REQUIRE( fromSpan.size() == 200 );
+      REQUIRE( fromSpan.toJSON() == fromStream.toJSON() );
+      REQUIRE( fromSpan.getArea("W6000199").getMeasure("pop").getValue(2019) == 201019.9 );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
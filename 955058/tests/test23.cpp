@@ -0,0 +1,177 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../bethyw.h"
+#include "../input.h"
+
+SCENARIO( "numbers can be parsed from spans without exceptions", "[string_operations][parseFloatingPointNumber]" ) {
+
+  using string_operations::ParseError;
+
+  // The result of std::stod, as an error code
+  auto stod = [](const std::string &str, double &value) {
+    try {
+      value = std::stod(str);
+      return ParseError::None;
+    }
+    catch (const std::invalid_argument &ex) {
+      return ParseError::Invalid;
+    }
+    catch (const std::out_of_range &ex) {
+      return ParseError::OutOfRange;
+    }
+  };
+
+  auto stoi = [](const std::string &str, int &value) {
+    try {
+      value = std::stoi(str);
+      return ParseError::None;
+    }
+    catch (const std::invalid_argument &ex) {
+      return ParseError::Invalid;
+    }
+    catch (const std::out_of_range &ex) {
+      return ParseError::OutOfRange;
+    }
+  };
+
+  auto sameBits = [](double a, double b) {
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+  };
+
+  GIVEN( "unusual strings" ) {
+
+    const std::vector<std::string> strings = {
+      "", " ", "-", "+", ".", "-.", "e5", "abc", "0", "-0", "+0", "0.0", "-0.0",
+      "  12.5", "\t\n-3", "12.5abc", "1e", "1e+", "1e-2x", "1.e3", ".5", "-.5e1",
+      "0x1p4", "0X10", "inf", "-INFINITY", "1e400", "-1e400", "1e-400", "4.9e-324",
+      "2.2250738585072014e-308", "1.7976931348623157e308", "9007199254740993",
+      "12345678901234567890", "0.000000000000000000000000012345", "1.5E22", "1.5E23",
+      "123456789012345678901234567890e-20", "2015", "2147483647", "2147483648",
+      "-2147483648", "-2147483649", "99999999999999999999", "0012", "1991\r"
+    };
+
+    THEN( "the same doubles and errors are given as std::stod" ) {
+
+      for (const auto &str : strings) {
+        double expected = 0;
+        double actual = 0;
+        const ParseError expectedError = stod(str, expected);
+        const ParseError actualError =
+                string_operations::parseFloatingPointNumber(InputSpan{str.data(), str.size()}, actual);
+
+        INFO( str );
+        REQUIRE( actualError == expectedError );
+        if (expectedError == ParseError::None) {
+          REQUIRE( sameBits(actual, expected) );
+        }
+      }
+
+      double nan = 0;
+      REQUIRE( string_operations::parseFloatingPointNumber(InputSpan{"nan", 3}, nan) == ParseError::None );
+      REQUIRE( std::isnan(nan) );
+
+    } // THEN
+
+    THEN( "numbers out of range are given what std::strtod rounds them to" ) {
+
+      for (const std::string str : {"1e400", "-1e400", "1e-400", "123456789012345678901234567890e300"}) {
+        double actual = 0;
+        const ParseError error =
+                string_operations::parseFloatingPointNumber(InputSpan{str.data(), str.size()}, actual);
+
+        INFO( str );
+        REQUIRE( error == ParseError::OutOfRange );
+        REQUIRE( sameBits(actual, std::strtod(str.c_str(), nullptr)) );
+      }
+
+    } // THEN
+
+    THEN( "the same integers and errors are given as std::stoi" ) {
+
+      for (const auto &str : strings) {
+        int expected = 0;
+        int actual = 0;
+        const ParseError expectedError = stoi(str, expected);
+        const ParseError actualError = string_operations::parseInteger(InputSpan{str.data(), str.size()}, actual);
+
+        INFO( str );
+        REQUIRE( actualError == expectedError );
+        if (expectedError == ParseError::None) {
+          REQUIRE( actual == expected );
+        }
+      }
+
+    } // THEN
+
+    THEN( "the throwing versions throw the same exceptions as std::stoi and std::stod" ) {
+
+      REQUIRE_THROWS_AS( string_operations::stringToNumber("abc"), std::invalid_argument );
+      REQUIRE_THROWS_AS( string_operations::stringToNumber("99999999999"), std::out_of_range );
+      REQUIRE_THROWS_AS( string_operations::stringToFloatingPointNumber(""), std::invalid_argument );
+      REQUIRE_THROWS_AS( string_operations::stringToFloatingPointNumber("1e999"), std::out_of_range );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "random decimal numbers of many lengths and exponents" ) {
+
+    std::mt19937_64 random(955058);
+    std::vector<std::string> strings;
+
+    for (unsigned int i = 0; i < 20000; i++) {
+      std::string str = (random() % 4 == 0) ? "-" : "";
+      const unsigned int integerDigits = random() % 12;
+      const unsigned int fractionDigits = random() % 12;
+
+      for (unsigned int d = 0; d < integerDigits; d++) {
+        str += static_cast<char>('0' + random() % 10);
+      }
+      if (fractionDigits > 0 || integerDigits == 0) {
+        str += ".";
+        for (unsigned int d = 0; d < fractionDigits + (integerDigits == 0 ? 1 : 0); d++) {
+          str += static_cast<char>('0' + random() % 10);
+        }
+      }
+      if (random() % 3 == 0) {
+        str += "e" + std::to_string(static_cast<int>(random() % 60) - 30);
+      }
+
+      strings.push_back(str);
+    }
+
+    THEN( "the doubles are exactly those given by std::stod" ) {
+
+      for (const auto &str : strings) {
+        double actual = 0;
+        REQUIRE( string_operations::parseFloatingPointNumber(InputSpan{str.data(), str.size()}, actual) ==
+                 ParseError::None );
+
+        INFO( str );
+        REQUIRE( sameBits(actual, std::stod(str)) );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,186 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "../lib_json.hpp"
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../input.h"
+#include "../jsonscanner.h"
+
+SCENARIO( "the records of a StatsWales JSON document can be split into ranges", "[StatsWalesJSONScanner][splitRecords]" ) {
+
+  const std::vector<std::string> keys = {"Code", "Value"};
+
+  auto scanRanges = [&keys](const std::string &document, size_t count) {
+    std::vector<nlohmann::json> records;
+    StatsWalesJSONScanner scanner(InputSpan{document.data(), document.size()});
+    for (const auto &range : scanner.splitRecords(count)) {
+      JSONColumnPlan plan(keys);
+      scanner.forEachRecord(range, plan, [&records](const JSONColumnPlan::Values &values) {
+        records.push_back(nlohmann::json::array({values[0], values[1]}));
+      });
+    }
+    return records;
+  };
+
+  GIVEN( "a document of records with brackets and commas inside their strings" ) {
+
+    std::string document = "{\"odata.metadata\": \"[{,\", \"value\": [";
+    for (unsigned int i = 0; i < 200; i++) {
+      document += (i == 0 ? "" : ",\n ");
+      document += "{\"Code\": \"W" + std::to_string(i) + "\\\",}]\", \"Nested\": [{\"a\": [1, 2]}, []], ";
+      document += "\"Value\": " + std::to_string(i) + "}";
+    }
+    document += "], \"odata.nextLink\": \"x\"}";
+
+    const nlohmann::json parsed = nlohmann::json::parse(document);
+
+    THEN( "the ranges are in order, and together have every record" ) {
+
+      for (size_t count = 1; count <= 9; count++) {
+        StatsWalesJSONScanner scanner(InputSpan{document.data(), document.size()});
+        const std::vector<StatsWalesJSONScanner::RecordRange> ranges = scanner.splitRecords(count);
+
+        REQUIRE( ranges.size() >= 1 );
+        REQUIRE( ranges.size() <= count );
+        for (size_t i = 1; i < ranges.size(); i++) {
+          REQUIRE( document[ranges[i - 1].end] == ',' );
+          REQUIRE( ranges[i].begin == ranges[i - 1].end + 1 );
+        }
+        REQUIRE( document[ranges.back().end] == ']' );
+
+        const std::vector<nlohmann::json> records = scanRanges(document, count);
+        REQUIRE( records.size() == parsed["value"].size() );
+        for (size_t i = 0; i < records.size(); i++) {
+          REQUIRE( records[i][0] == parsed["value"][i]["Code"] );
+          REQUIRE( records[i][1] == parsed["value"][i]["Value"] );
+        }
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "documents with empty or no value arrays" ) {
+
+    THEN( "there are no ranges" ) {
+
+      const std::vector<std::string> documents = {"{}", " 42 ", "{\"value\": []}", "{\"value\": {\"a\": [1]}}"};
+      for (const auto &document : documents) {
+        StatsWalesJSONScanner scanner(InputSpan{document.data(), document.size()});
+        REQUIRE( scanner.splitRecords(4).empty() );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "malformed documents" ) {
+
+    THEN( "a std::runtime_error exception is thrown when splitting or scanning them" ) {
+
+      const std::vector<std::string> malformed = {
+        "",
+        "{\"value\": [{\"Code\": \"W\"}]",
+        "{\"value\": [{\"Code\": \"W\"}]} x",
+        "{\"value\": [{\"Code\": \"W\"}}",
+        "{\"value\": [{\"Code\": \"W\"]]}",
+        "{\"value\": [{\"Code\": \"W\"}, ]}",
+        "{\"value\": [{\"Code\": \"W\"}, {\"Code\": \"W\"} {\"Code\": \"W\"}]}",
+        "{\"value\": [{\"Code\": \"W\"},, {\"Code\": \"W\"}]}",
+        "{\"value\": [{\"Code\": \"W\", \"Skip\": tru}, {\"Code\": \"W\"}]}",
+        "{\"value\": [{\"Code\": \"W\"}, {\"Code\": \"W\", \"Skip\": \"\xC3\"}]}",
+        "{\"value\": [{\"Code\": \"W\"}], \"x\": \"\xC3\"}",
+        "{\"value\": [{\"Code\": \"W}]}"
+      };
+
+      for (const auto &document : malformed) {
+        REQUIRE_THROWS_AS( nlohmann::json::parse(document), nlohmann::json::exception );
+        for (size_t count = 1; count <= 3; count++) {
+          REQUIRE_THROWS_AS( scanRanges(document, count), std::runtime_error );
+        }
+      }
+
+      REQUIRE_THROWS_WITH( scanRanges("[{\"Code\": \"W\"}]", 2), "expected a JSON object with a value array" );
+      REQUIRE_THROWS_WITH( scanRanges("{\"value\": [{\"Code\": \"W\"}, 7]}", 2),
+                           "expected each record in the value array to be an object, but got number" );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "a StatsWales JSON file is imported the same way by several threads as by one", "[Areas][populateFromWelshStatsJSONInParallel]" ) {
+
+  const std::vector<StringFilterSet> areasFilters = {{}, {"W06000011", "card"}};
+  const std::vector<StringFilterSet> measuresFilters = {{}, {"pop", "rail"}};
+  const std::vector<YearFilterTuple> yearsFilters = {YearFilterTuple(0, 0), YearFilterTuple(2010, 2014)};
+
+  GIVEN( "every JSON dataset" ) {
+
+    THEN( "the areas are the same for any number of threads" ) {
+
+      for (const BethYw::InputFileSource &dataset : BethYw::InputFiles::DATASETS) {
+        if (dataset.PARSER != BethYw::WelshStatsJSON) {
+          continue;
+        }
+
+        InputMappedFile input("datasets/" + dataset.FILE);
+
+        for (const auto &areasFilter : areasFilters) {
+          for (const auto &measuresFilter : measuresFilters) {
+            for (const auto &yearsFilter : yearsFilters) {
+              Areas expected = Areas();
+              expected.populate(input.span(), dataset.PARSER, dataset.COLS, &areasFilter, &measuresFilter, &yearsFilter);
+
+              for (unsigned int threads : {1u, 2u, 3u, 8u}) {
+                Areas actual = Areas();
+                actual.populateFromWelshStatsJSONInParallel(input.span(), dataset.COLS, threads,
+                                                            &areasFilter, &measuresFilter, &yearsFilter);
+
+                REQUIRE( actual.toJSON() == expected.toJSON() );
+              }
+            }
+          }
+        }
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a malformed JSON document" ) {
+
+    const std::string document = "{\"value\": [{\"Localauthority_Code\": \"W06000011\"}, "
+                                 "{\"Localauthority_Code\": \"W06000011\",}]}";
+
+    THEN( "a std::runtime_error exception is thrown" ) {
+
+      Areas areas = Areas();
+      REQUIRE_THROWS_AS( areas.populateFromWelshStatsJSONInParallel(InputSpan{document.data(), document.size()},
+                                                                    BethYw::InputFiles::DATASETS[0].COLS,
+                                                                    2, nullptr, nullptr, nullptr),
+                         std::runtime_error );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
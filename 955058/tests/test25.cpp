@@ -0,0 +1,68 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../bethyw.h"
+
+SCENARIO( "datasets loaded at the same time are merged in the order they were given", "[BethYw][loadDatasets]" ) {
+
+  const std::vector<StringFilterSet> areasFilters = {{}, {"W06000011", "card"}};
+  const std::vector<StringFilterSet> measuresFilters = {{}, {"pop", "rail"}};
+  const std::vector<YearFilterTuple> yearsFilters = {YearFilterTuple(0, 0), YearFilterTuple(2010, 2014)};
+
+  auto load = [](std::vector<BethYw::InputFileSource> datasets,
+                 const StringFilterSet &areasFilter,
+                 const StringFilterSet &measuresFilter,
+                 const YearFilterTuple &yearsFilter,
+                 unsigned int threads) {
+    BethYw::LoadOptions options;
+    options.threads = threads;
+
+    Areas areas = Areas();
+    BethYw::loadAreas(areas, "datasets/", areasFilter, options);
+    BethYw::loadDatasets(areas, "datasets/", datasets, areasFilter, measuresFilter, yearsFilter, options);
+    return areas.toJSON();
+  };
+
+  GIVEN( "all the datasets, forwards and backwards" ) {
+
+    const std::vector<BethYw::InputFileSource> forwards(BethYw::InputFiles::DATASETS,
+                                                        BethYw::InputFiles::DATASETS + BethYw::InputFiles::NUM_DATASETS);
+    const std::vector<BethYw::InputFileSource> backwards(forwards.rbegin(), forwards.rend());
+
+    THEN( "the areas are the same as loading them one after another, for any number of threads" ) {
+
+      for (const auto &datasets : {forwards, backwards}) {
+        for (const auto &areasFilter : areasFilters) {
+          for (const auto &measuresFilter : measuresFilters) {
+            for (const auto &yearsFilter : yearsFilters) {
+              const std::string expected = load(datasets, areasFilter, measuresFilter, yearsFilter, 1);
+
+              for (unsigned int threads : {0u, 2u, 3u, 16u}) {
+                REQUIRE( load(datasets, areasFilter, measuresFilter, yearsFilter, threads) == expected );
+              }
+            }
+          }
+        }
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,128 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "../lib_json.hpp"
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../input.h"
+#include "../jsonscanner.h"
+
+SCENARIO( "a JSONColumnPlan's filter rejects records before their values are built", "[JSONColumnPlan][setRecordFilter]" ) {
+
+  auto scan = [](const std::string &document, JSONColumnPlan &plan) {
+    std::vector<nlohmann::json> codes;
+    StatsWalesJSONScanner scanner(InputSpan{document.data(), document.size()});
+    scanner.forEachRecord(plan, [&codes](const JSONColumnPlan::Values &values) {
+      codes.push_back(values[0]);
+    });
+    return codes;
+  };
+
+  JSONColumnPlan plan({"Code", "Value"});
+  std::vector<std::string> seen;
+  plan.setRecordFilter([&seen](const JSONColumnPlan::Strings &strings) {
+    seen.push_back(strings[0].data == nullptr ? "-" : std::string(strings[0].data, strings[0].size));
+    return strings[0].data == nullptr || std::string(strings[0].data, strings[0].size) != "no";
+  });
+
+  REQUIRE( plan.hasRecordFilter() );
+
+  GIVEN( "a document with records to reject" ) {
+
+    const std::string document = "{\"value\": [{\"Code\": \"yes\", \"Value\": 1}, {\"Value\": 2, \"Code\": \"no\"}, "
+                                 "{\"Code\": \"\\u0079es\"}, {\"Code\": 7}, {\"Code\": \"no\", \"Skip\": [1]}]}";
+
+    THEN( "only the records it accepts are imported" ) {
+
+      const std::vector<nlohmann::json> codes = scan(document, plan);
+      REQUIRE( codes == std::vector<nlohmann::json>({"yes", "yes", 7}) );
+      REQUIRE( seen == std::vector<std::string>({"yes", "no", "yes", "-", "no"}) );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a malformed record that is rejected" ) {
+
+    const std::string document = "{\"value\": [{\"Code\": \"no\", \"Value\": \"\\x\"}]}";
+
+    THEN( "a std::runtime_error exception is still thrown" ) {
+
+      REQUIRE_THROWS_AS( scan(document, plan), std::runtime_error );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "filtered datasets are imported the same as filtering them after they are parsed", "[Areas][filters]" ) {
+
+  const std::vector<StringFilterSet> areasFilters = {{}, {"W06000024"}, {"W06000011", "card"}, {"w0600001"}, {"nowhere"}};
+  const std::vector<StringFilterSet> measuresFilters = {{}, {"POP", "rail"}, {"nothing"}};
+  const std::vector<YearFilterTuple> yearsFilters = {YearFilterTuple(0, 0), YearFilterTuple(2015, 2019), YearFilterTuple(2030, 2040)};
+
+  GIVEN( "every dataset, imported into empty areas and into all the areas" ) {
+
+    Areas allAreas = Areas();
+    {
+      InputFile input("datasets/" + BethYw::InputFiles::AREAS.FILE);
+      allAreas.populate(input.open(), BethYw::InputFiles::AREAS.PARSER, BethYw::InputFiles::AREAS.COLS);
+    }
+
+    std::vector<BethYw::InputFileSource> datasets(BethYw::InputFiles::DATASETS,
+                                                  BethYw::InputFiles::DATASETS + BethYw::InputFiles::NUM_DATASETS);
+    datasets.push_back(BethYw::InputFiles::AREAS);
+
+    THEN( "the areas are the same from both a stream and a span" ) {
+
+      for (const BethYw::InputFileSource &dataset : datasets) {
+        const std::string path = "datasets/" + dataset.FILE;
+        InputMappedFile mapped(path);
+
+        Areas parsed = Areas();
+        parsed.populate(mapped.span(), dataset.PARSER, dataset.COLS);
+
+        for (const Areas &start : {Areas(), allAreas.withoutMeasures()}) {
+          for (const auto &areasFilter : areasFilters) {
+            for (const auto &measuresFilter : measuresFilters) {
+              for (const auto &yearsFilter : yearsFilters) {
+                Areas expected = start;
+                expected.populateFromParsed(parsed, dataset.PARSER, &areasFilter, &measuresFilter, &yearsFilter);
+
+                Areas fromSpan = start;
+                fromSpan.populate(mapped.span(), dataset.PARSER, dataset.COLS, &areasFilter, &measuresFilter, &yearsFilter);
+                REQUIRE( fromSpan.toJSON() == expected.toJSON() );
+
+                Areas fromStream = start;
+                std::ifstream stream(path);
+                fromStream.populate(stream, dataset.PARSER, dataset.COLS, &areasFilter, &measuresFilter, &yearsFilter);
+                REQUIRE( fromStream.toJSON() == expected.toJSON() );
+              }
+            }
+          }
+        }
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,100 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <string>
+
+#include "../areas.h"
+#include "../area.h"
+#include "../measure.h"
+
+SCENARIO( "an Area's measures can be updated in place", "[Area][upsertMeasure]" ) {
+
+  GIVEN( "an Area with a measure" ) {
+
+    Area area("W06000023");
+    Measure measure("Pop", "Population");
+    measure.setValue(1999, 1.5);
+    area.setMeasure("Pop", measure);
+
+    THEN( "upserting the measure in any case finds it and sets its label" ) {
+
+      Measure& found = area.upsertMeasure("POP", "People");
+      found.setValue(2000, 2.5);
+
+      REQUIRE( area.size() == 1 );
+      REQUIRE( &found == &area.getMeasure("pop") );
+      REQUIRE( found.getCodename() == "pop" );
+      REQUIRE( found.getLabel() == "People" );
+      REQUIRE( found.getValue(1999) == 1.5 );
+      REQUIRE( found.getValue(2000) == 2.5 );
+
+    } // THEN
+
+    THEN( "upserting another measure creates it, the same as setMeasure would" ) {
+
+      Area expected = area;
+      expected.setMeasure("Dens", Measure("Dens", "Density"));
+
+      Measure& created = area.upsertMeasure("Dens", "Density");
+
+      REQUIRE( area.size() == 2 );
+      REQUIRE( created.size() == 0 );
+      REQUIRE( area == expected );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "Areas can be updated in place", "[Areas][upsertArea]" ) {
+
+  GIVEN( "an Areas instance with an area" ) {
+
+    Areas areas = Areas();
+    Area area("w06000023");
+    area.setName("eng", "Powys");
+    areas.setArea("w06000023", area);
+
+    THEN( "upserting the area in any case finds it and sets its code" ) {
+
+      Area& found = areas.upsertArea("W06000023");
+
+      REQUIRE( areas.size() == 1 );
+      REQUIRE( &found == &areas.getArea("w06000023") );
+      REQUIRE( found.getLocalAuthorityCode() == "W06000023" );
+      REQUIRE( found.getName("eng") == "Powys" );
+
+    } // THEN
+
+    THEN( "upserting another area creates it, the same as setArea would" ) {
+
+      Areas expected = areas;
+      Area other("W06000011");
+      other.setName("eng", "Swansea");
+      other.setMeasure("pop", Measure("pop", "Population"));
+      other.getMeasure("pop").setValue(2011, 239023);
+      expected.setArea("W06000011", other);
+
+      Area& created = areas.upsertArea("W06000011");
+      created.setName("eng", "Swansea");
+      created.upsertMeasure("pop", "Population").setValue(2011, 239023);
+
+      REQUIRE( areas.size() == 2 );
+      REQUIRE( areas.toJSON() == expected.toJSON() );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
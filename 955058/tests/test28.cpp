@@ -0,0 +1,403 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../lib_cxxopts_argv.hpp"
+#include "../lib_json.hpp"
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../bethyw.h"
+#include "../cache.h"
+#include "../input.h"
+
+namespace {
+  /*
+    The records of a dataset file, as text, and how to join the first few of
+    them back into a file that more records can be appended to.
+  */
+  struct DatasetRecords {
+    std::string header;
+    std::vector<std::string> records;
+    std::string separator;
+    std::string footer;
+
+    std::string file(size_t count) const {
+      std::string text = header;
+      for (size_t i = 0; i < count; i++) {
+        text += (i == 0 ? "" : separator) + records[i];
+      }
+      return text + footer;
+    }
+  };
+
+  DatasetRecords readDatasetRecords(const BethYw::InputFileSource &dataset) {
+    std::ifstream file("datasets/" + dataset.FILE);
+    DatasetRecords records;
+
+    if (dataset.PARSER == BethYw::WelshStatsJSON) {
+      const nlohmann::json document = nlohmann::json::parse(file);
+      for (const auto &record : document["value"]) {
+        records.records.push_back(record.dump());
+      }
+      records.header = "{\"value\": [";
+      records.separator = ",\n";
+      records.footer = "], \"odata.nextLink\": null}\n";
+      return records;
+    }
+
+    std::string line;
+    std::getline(file, line);
+    records.header = line + "\n";
+    while (std::getline(file, line)) {
+      records.records.push_back(line + "\n");
+    }
+    return records;
+  }
+} // end of anonymous namespace
+
+SCENARIO( "records appended to a dataset file can be parsed on their own", "[Areas][populateIncrementally]" ) {
+
+  std::vector<BethYw::InputFileSource> datasets(BethYw::InputFiles::DATASETS,
+                                                BethYw::InputFiles::DATASETS + BethYw::InputFiles::NUM_DATASETS);
+  datasets.push_back(BethYw::InputFiles::AREAS);
+
+  GIVEN( "every dataset file, and areas.csv, with only some of its records" ) {
+
+    THEN( "parsing the records appended after the watermark gives the same areas as parsing the whole file" ) {
+
+      for (const auto &dataset : datasets) {
+        const DatasetRecords records = ::readDatasetRecords(dataset);
+        const size_t count = records.records.size();
+        REQUIRE( count > 2 );
+
+        const std::string whole = records.file(count);
+        Areas expected = Areas();
+        expected.populate(InputSpan{whole.data(), whole.size()}, dataset.PARSER, dataset.COLS);
+
+        for (size_t first : {size_t(0), size_t(1), count / 2, count - 1, count}) {
+          const std::string part = records.file(first);
+
+          Areas actual = Areas();
+          const size_t watermark = actual.populateIncrementally(InputSpan{part.data(), part.size()},
+                                                                dataset.PARSER, dataset.COLS);
+          if (watermark > 0) {
+            REQUIRE( ParseCache::Watermark::of(InputSpan{part.data(), part.size()}, watermark)
+                             .matches(InputSpan{whole.data(), whole.size()}) );
+          }
+
+          const size_t next = actual.populateIncrementally(InputSpan{whole.data(), whole.size()},
+                                                           dataset.PARSER, dataset.COLS, watermark);
+          REQUIRE( next >= watermark );
+          REQUIRE( actual.toJSON() == expected.toJSON() );
+
+          // Nothing more has been appended
+          REQUIRE( actual.populateIncrementally(InputSpan{whole.data(), whole.size()},
+                                                dataset.PARSER, dataset.COLS, next) == next );
+          REQUIRE( actual.toJSON() == expected.toJSON() );
+        }
+      }
+
+    } // THEN
+
+    THEN( "a CSV file whose last line didn't end with a newline yet is parsed the same way" ) {
+
+      for (const auto &dataset : datasets) {
+        if (dataset.PARSER == BethYw::WelshStatsJSON) {
+          continue;
+        }
+
+        const DatasetRecords records = ::readDatasetRecords(dataset);
+        const std::string whole = records.file(records.records.size());
+        std::string part = records.file(records.records.size() / 2);
+        part.pop_back();
+
+        Areas expected = Areas();
+        expected.populate(InputSpan{whole.data(), whole.size()}, dataset.PARSER, dataset.COLS);
+
+        Areas actual = Areas();
+        const size_t watermark = actual.populateIncrementally(InputSpan{part.data(), part.size()},
+                                                              dataset.PARSER, dataset.COLS);
+        actual.populateIncrementally(InputSpan{whole.data(), whole.size()}, dataset.PARSER, dataset.COLS, watermark);
+
+        REQUIRE( actual.toJSON() == expected.toJSON() );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a malformed record appended to a file" ) {
+
+    const BethYw::InputFileSource &popden = BethYw::InputFiles::POPDEN;
+    const BethYw::InputFileSource ndjson = {"ndjson", "NDJSON", "popu1009.ndjson", BethYw::WelshStatsNDJSON,
+                                            popden.COLS};
+    const BethYw::InputFileSource &csv = BethYw::InputFiles::COMPLETE_POPDEN;
+
+    THEN( "it is reported with its line and offset in the whole file" ) {
+
+      std::vector<std::pair<BethYw::InputFileSource, std::string>> files;
+
+      std::string lines;
+      for (const auto &record : ::readDatasetRecords(popden).records) {
+        lines += record + "\n";
+      }
+      files.push_back({ndjson, lines});
+      files.push_back({csv, ::readDatasetRecords(csv).file(10)});
+
+      for (const auto &file : files) {
+        const BethYw::InputFileSource &dataset = file.first;
+        const std::string &part = file.second;
+
+        // A value that isn't a number, after the records parsed already
+        std::string whole = part;
+        if (dataset.PARSER == BethYw::WelshStatsNDJSON) {
+          nlohmann::json record = nlohmann::json::parse(part.substr(0, part.find('\n')));
+          record[popden.COLS.at(BethYw::SourceColumn::VALUE)] = "n/a";
+          whole += record.dump() + "\n";
+        } else {
+          const std::string lastLine = part.substr(part.rfind('\n', part.size() - 2) + 1);
+          const size_t codeEnd = lastLine.find(',');
+          whole += lastLine.substr(0, codeEnd) + ",n/a" + lastLine.substr(lastLine.find(',', codeEnd + 1));
+        }
+
+        const size_t lines = static_cast<size_t>(std::count(part.begin(), part.end(), '\n'));
+
+        Areas areas = Areas();
+        const size_t watermark = areas.populateIncrementally(InputSpan{part.data(), part.size()},
+                                                             dataset.PARSER, dataset.COLS);
+        REQUIRE( watermark > 0 );
+
+        ParseErrors errors(10);
+        areas.populateIncrementally(InputSpan{whole.data(), whole.size()}, dataset.PARSER, dataset.COLS, watermark,
+                                    &errors);
+
+        INFO( dataset.FILE );
+        REQUIRE( errors.size() == 1 );
+        REQUIRE( errors.getErrors()[0].unit == "line" );
+        REQUIRE( errors.getErrors()[0].position == lines + 1 );
+        REQUIRE( errors.getErrors()[0].offset == part.size() );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "files that have changed before their watermark" ) {
+
+    const BethYw::InputFileSource &json = BethYw::InputFiles::POPDEN;
+    const BethYw::InputFileSource &csv = BethYw::InputFiles::COMPLETE_POPDEN;
+
+    THEN( "the watermark doesn't match them" ) {
+
+      const DatasetRecords records = ::readDatasetRecords(json);
+      const std::string part = records.file(10);
+      Areas areas = Areas();
+      const size_t watermark = areas.populateIncrementally(InputSpan{part.data(), part.size()},
+                                                           json.PARSER, json.COLS);
+
+      std::string changed = records.file(20);
+      changed[records.header.size() + 2] = 'X';
+
+      const ParseCache::Watermark mark = ParseCache::Watermark::of(InputSpan{part.data(), part.size()}, watermark);
+      REQUIRE( mark.matches(InputSpan{part.data(), part.size()}) );
+      REQUIRE_FALSE( mark.matches(InputSpan{changed.data(), changed.size()}) );
+      REQUIRE_FALSE( mark.matches(InputSpan{part.data(), watermark - 1}) );
+
+    } // THEN
+
+    THEN( "a std::runtime_error exception is thrown for a watermark that isn't the end of their records" ) {
+
+      const std::string jsonText = ::readDatasetRecords(json).file(10);
+      const std::string csvText = ::readDatasetRecords(csv).file(10);
+      Areas areas = Areas();
+
+      REQUIRE_THROWS_AS( areas.populateIncrementally(InputSpan{jsonText.data(), jsonText.size()},
+                                                     json.PARSER, json.COLS, 5),
+                         std::runtime_error );
+      REQUIRE_THROWS_AS( areas.populateIncrementally(InputSpan{csvText.data(), csvText.size()},
+                                                     csv.PARSER, csv.COLS, 5),
+                         std::runtime_error );
+      REQUIRE_THROWS_AS( areas.populateIncrementally(InputSpan{csvText.data(), csvText.size()},
+                                                     csv.PARSER, csv.COLS, csvText.size()),
+                         std::runtime_error );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "dataset files that are appended to can be loaded incrementally", "[BethYw][ParseCache][incremental]" ) {
+
+  const std::string dir = "bin/";
+  const BethYw::InputFileSource &popden = BethYw::InputFiles::POPDEN;
+  const BethYw::InputFileSource dataset = {"incremental", "Incremental", "incremental-popu1009.json",
+                                           popden.PARSER, popden.COLS};
+  const DatasetRecords records = ::readDatasetRecords(popden);
+  const size_t count = records.records.size();
+
+  auto write = [&dir, &dataset](const std::string &text) {
+    std::ofstream file(dir + dataset.FILE, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+    file << text;
+  };
+
+  auto load = [&dir, &dataset](bool incremental, const StringFilterSet &areasFilter) {
+    BethYw::LoadOptions options;
+    options.parseCacheDir = incremental ? "bin" : "";
+    options.incremental = incremental;
+
+    std::vector<BethYw::InputFileSource> datasets = {dataset};
+    Areas areas = Areas();
+    BethYw::loadDatasets(areas, dir, datasets, areasFilter, StringFilterSet(), YearFilterTuple(0, 0), options);
+    return areas.toJSON();
+  };
+
+  GIVEN( "a file that has records appended to it between loads" ) {
+
+    THEN( "each load gives the same areas as loading it without the cache" ) {
+
+      for (const StringFilterSet &areasFilter : {StringFilterSet(), StringFilterSet({"W06000011"})}) {
+        for (size_t first : {count / 4, count / 2, count}) {
+          write(records.file(first));
+          REQUIRE( load(true, areasFilter) == load(false, areasFilter) );
+        }
+      }
+
+    } // THEN
+
+    THEN( "a file that was rewritten is parsed again" ) {
+
+      write(records.file(count));
+      load(true, StringFilterSet());
+
+      DatasetRecords rewritten = records;
+      rewritten.records.erase(rewritten.records.begin());
+      write(rewritten.file(count - 1));
+
+      REQUIRE( load(true, StringFilterSet()) == load(false, StringFilterSet()) );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a newline-delimited JSON file that hasn't changed since it was loaded" ) {
+
+    const BethYw::InputFileSource ndjson = {"incremental", "Incremental", "incremental-popu1009.ndjson",
+                                            BethYw::WelshStatsNDJSON, popden.COLS};
+
+    std::string text;
+    for (const auto &record : records.records) {
+      text += record + "\n";
+    }
+
+    {
+      std::ofstream file(dir + ndjson.FILE, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+      file << text;
+    }
+
+    auto loadNDJSON = [&dir, &ndjson]() {
+      BethYw::LoadOptions options;
+      options.parseCacheDir = "bin";
+      options.incremental = true;
+
+      std::vector<BethYw::InputFileSource> datasets = {ndjson};
+      Areas areas = Areas();
+      BethYw::loadDatasets(areas, dir, datasets, StringFilterSet(), StringFilterSet(), YearFilterTuple(0, 0),
+                           options);
+      return areas.toJSON();
+    };
+
+    const ParseCache cache("bin");
+    const std::string key = cache.incrementalKey(dir + ndjson.FILE, ndjson.PARSER, ndjson.COLS);
+    cache.erase(key);
+
+    THEN( "its entry is used the second time, without parsing the file again" ) {
+
+      Areas expected = Areas();
+      expected.populate(InputSpan{text.data(), text.size()}, ndjson.PARSER, ndjson.COLS);
+      REQUIRE( loadNDJSON() == expected.toJSON() );
+
+      Areas parsed = Areas();
+      ParseCache::Watermark watermark{0, 0};
+      REQUIRE( cache.loadIncremental(key, parsed, watermark) );
+      REQUIRE( watermark.offset == text.size() );
+      REQUIRE( watermark.matches(InputSpan{text.data(), text.size()}) );
+
+      // Were the file parsed again, its areas would be loaded instead
+      cache.storeIncremental(key, Areas(), watermark);
+      REQUIRE( loadNDJSON() == Areas().toJSON() );
+
+    } // THEN
+
+    cache.erase(key);
+    std::remove((dir + ndjson.FILE).c_str());
+
+  } // GIVEN
+
+  const ParseCache cache("bin");
+  cache.erase(cache.incrementalKey(dir + dataset.FILE, dataset.PARSER, dataset.COLS));
+  std::remove((dir + dataset.FILE).c_str());
+
+} // SCENARIO
+
+SCENARIO( "the incremental program argument can be parsed correctly", "[args][incremental]" ) {
+
+  auto parse = [](std::initializer_list<const char*> arguments) {
+    Argv argv(arguments);
+    auto** actual_argv = argv.argv();
+    auto argc          = argv.argc();
+
+    auto cxxopts = BethYw::cxxoptsSetup();
+    auto args    = cxxopts.parse(argc, actual_argv);
+    return BethYw::parseLoadOptionsArgs(args);
+  };
+
+  GIVEN( "a --parse-cache argument" ) {
+
+    THEN( "--incremental turns incremental loading on" ) {
+
+      REQUIRE( parse({"test", "--parse-cache", "bin", "--incremental"}).incremental );
+      REQUIRE( parse({"test", "--parse-cache", "bin", "--incremental=true"}).incremental );
+
+    } // THEN
+
+    THEN( "--incremental=false, or leaving it out, leaves incremental loading off" ) {
+
+      REQUIRE_FALSE( parse({"test", "--parse-cache", "bin", "--incremental=false"}).incremental );
+      REQUIRE_FALSE( parse({"test", "--parse-cache", "bin"}).incremental );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "no --parse-cache argument" ) {
+
+    THEN( "a std::invalid_argument exception is thrown for --incremental" ) {
+
+      REQUIRE_THROWS_WITH( parse({"test", "--incremental"}), "Invalid input for incremental argument" );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
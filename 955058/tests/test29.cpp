@@ -0,0 +1,264 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../lib_json.hpp"
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../input.h"
+
+SCENARIO( "malformed records can be skipped up to a budget", "[ParseErrors]" ) {
+
+  GIVEN( "a budget of two records" ) {
+
+    ParseErrors errors(2);
+
+    THEN( "two records can be skipped, but not three" ) {
+
+      errors.skip("line", 4, "bad value");
+      errors.skip("line", 9, "too few fields");
+      REQUIRE( errors.size() == 2 );
+      REQUIRE( errors.getErrors()[1].position == 9 );
+
+      REQUIRE_THROWS_WITH( errors.skip("line", 12, "bad value"),
+                           "More than 2 malformed records, the last at line 12: bad value" );
+
+    } // THEN
+
+    THEN( "records skipped in another part of the file are renumbered" ) {
+
+      ParseErrors part(2);
+      part.skip("record", 3, "bad value");
+
+      errors.skip("record", 1, "bad value");
+      errors.append(part, 100);
+
+      REQUIRE( errors.size() == 2 );
+      REQUIRE( errors.getErrors()[1].position == 103 );
+      REQUIRE_THROWS_AS( errors.append(part, 200), std::runtime_error );
+
+    } // THEN
+
+    THEN( "records are described with their offset and field, if known" ) {
+
+      errors.skip("record", 4, "\"n/a\" is not a number", 1298, "Data");
+      errors.skip("line", 9, "too few fields", 512);
+
+      REQUIRE( ParseErrors::describe(errors.getErrors()[0]) == "record 4 (byte 1298): Data: \"n/a\" is not a number" );
+      REQUIRE( ParseErrors::describe(errors.getErrors()[1]) == "line 9 (byte 512): too few fields" );
+      REQUIRE_THROWS_WITH( errors.skip("line", 12, "\"x\" is not a number", 640, "2015"),
+                           "More than 2 malformed records, the last at line 12 (byte 640): 2015: \"x\" is not a number" );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "dataset files with malformed records can be parsed leniently", "[Areas][ParseErrors]" ) {
+
+  GIVEN( "an authority-by-year CSV file with a value that can't be parsed" ) {
+
+    const BethYw::InputFileSource &dataset = BethYw::InputFiles::COMPLETE_POPDEN;
+
+    std::ifstream file("datasets/" + dataset.FILE);
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(file, line)) {
+      lines.push_back(line + "\n");
+    }
+
+    std::string malformed, expected, malformedValue;
+    size_t malformedOffset = 0;
+    for (size_t i = 0; i < lines.size(); i++) {
+      if (i == 3) {
+        const size_t value = lines[i].find(',') + 1;
+        malformedOffset = malformed.size();
+        malformedValue = "x" + lines[i].substr(value, lines[i].find(',', value) - value);
+        malformed += lines[i].substr(0, value) + "x" + lines[i].substr(value);
+      } else {
+        malformed += lines[i];
+        expected += lines[i];
+      }
+    }
+
+    THEN( "it can't be parsed strictly" ) {
+
+      Areas areas = Areas();
+      REQUIRE_THROWS_AS( areas.populate(InputSpan{malformed.data(), malformed.size()}, dataset.PARSER, dataset.COLS),
+                         std::runtime_error );
+
+    } // THEN
+
+    THEN( "the line is skipped when it is parsed leniently, from a span or a stream" ) {
+
+      Areas expectedAreas = Areas();
+      expectedAreas.populate(InputSpan{expected.data(), expected.size()}, dataset.PARSER, dataset.COLS);
+
+      ParseErrors spanErrors(1);
+      Areas fromSpan = Areas();
+      fromSpan.populate(InputSpan{malformed.data(), malformed.size()}, dataset.PARSER, dataset.COLS,
+                        nullptr, nullptr, nullptr, &spanErrors);
+
+      ParseErrors streamErrors(1);
+      Areas fromStream = Areas();
+      std::istringstream stream(malformed);
+      fromStream.populate(stream, dataset.PARSER, dataset.COLS, nullptr, nullptr, nullptr, &streamErrors);
+
+      REQUIRE( fromSpan.toJSON() == expectedAreas.toJSON() );
+      REQUIRE( fromStream.toJSON() == expectedAreas.toJSON() );
+
+      REQUIRE( spanErrors.size() == 1 );
+      REQUIRE( spanErrors.getErrors()[0].unit == "line" );
+      REQUIRE( spanErrors.getErrors()[0].position == 4 );
+      REQUIRE( streamErrors.getErrors()[0].position == 4 );
+
+      // The first year column is named after its year
+      const std::string firstYear = lines[0].substr(lines[0].find(',') + 1, 4);
+      for (const ParseErrors *errors : {&spanErrors, &streamErrors}) {
+        REQUIRE( errors->getErrors()[0].offset == malformedOffset );
+        REQUIRE( errors->getErrors()[0].field == firstYear );
+        REQUIRE( errors->getErrors()[0].what == "\"" + malformedValue + "\" is not a number" );
+      }
+
+    } // THEN
+
+    THEN( "a budget of none still fails" ) {
+
+      ParseErrors errors(0);
+      Areas areas = Areas();
+      REQUIRE_THROWS_AS( areas.populate(InputSpan{malformed.data(), malformed.size()}, dataset.PARSER, dataset.COLS,
+                                        nullptr, nullptr, nullptr, &errors),
+                         std::runtime_error );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "an areas.csv file with a line with too many fields" ) {
+
+    const BethYw::InputFileSource &dataset = BethYw::InputFiles::AREAS;
+    const std::string text = "Local authority code,Name (eng),Name (cym)\n"
+                             "W06000011,Swansea,Abertawe\n"
+                             "W06000015,Cardiff,Caerdydd,Extra\n"
+                             "W06000001,Isle of Anglesey,Ynys Mon\n";
+
+    THEN( "the line is skipped when it is parsed leniently" ) {
+
+      ParseErrors errors(10);
+      Areas areas = Areas();
+      areas.populate(InputSpan{text.data(), text.size()}, dataset.PARSER, dataset.COLS, nullptr, nullptr, nullptr,
+                     &errors);
+
+      REQUIRE( areas.size() == 2 );
+      REQUIRE( errors.size() == 1 );
+      REQUIRE( errors.getErrors()[0].position == 3 );
+      REQUIRE( errors.getErrors()[0].offset == text.find("W06000015") );
+      REQUIRE( errors.getErrors()[0].field.empty() );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a StatsWales JSON file with records whose values can't be parsed" ) {
+
+    const BethYw::InputFileSource &dataset = BethYw::InputFiles::POPDEN;
+
+    std::ifstream file("datasets/" + dataset.FILE);
+    nlohmann::json document = nlohmann::json::parse(file);
+    nlohmann::json expectedDocument = document;
+    expectedDocument["value"] = nlohmann::json::array();
+
+    const std::vector<size_t> corrupted = {3, 500, document["value"].size() - 1};
+    for (size_t i = 0; i < document["value"].size(); i++) {
+      if (std::find(corrupted.begin(), corrupted.end(), i) != corrupted.end()) {
+        document["value"][i]["Data"] = "not a number";
+      } else {
+        expectedDocument["value"].push_back(document["value"][i]);
+      }
+    }
+
+    const std::string malformed = document.dump();
+    const std::string expected = expectedDocument.dump();
+
+    THEN( "the records are skipped, however the file is parsed" ) {
+
+      Areas expectedAreas = Areas();
+      expectedAreas.populate(InputSpan{expected.data(), expected.size()}, dataset.PARSER, dataset.COLS);
+
+      ParseErrors spanErrors(3);
+      Areas fromSpan = Areas();
+      fromSpan.populate(InputSpan{malformed.data(), malformed.size()}, dataset.PARSER, dataset.COLS,
+                        nullptr, nullptr, nullptr, &spanErrors);
+
+      ParseErrors streamErrors(3);
+      Areas fromStream = Areas();
+      std::istringstream stream(malformed);
+      fromStream.populate(stream, dataset.PARSER, dataset.COLS, nullptr, nullptr, nullptr, &streamErrors);
+
+      ParseErrors parallelErrors(3);
+      Areas inParallel = Areas();
+      inParallel.populateFromWelshStatsJSONInParallel(InputSpan{malformed.data(), malformed.size()}, dataset.COLS, 4,
+                                                      nullptr, nullptr, nullptr, &parallelErrors);
+
+      REQUIRE( fromSpan.toJSON() == expectedAreas.toJSON() );
+      REQUIRE( fromStream.toJSON() == expectedAreas.toJSON() );
+      REQUIRE( inParallel.toJSON() == expectedAreas.toJSON() );
+
+      for (const ParseErrors *errors : {&spanErrors, &streamErrors, &parallelErrors}) {
+        REQUIRE( errors->size() == corrupted.size() );
+        for (size_t i = 0; i < corrupted.size(); i++) {
+          REQUIRE( errors->getErrors()[i].unit == "record" );
+          REQUIRE( errors->getErrors()[i].position == corrupted[i] + 1 );
+          REQUIRE( errors->getErrors()[i].field == "Data" );
+          REQUIRE( errors->getErrors()[i].what == "\"not a number\" is not a number" );
+        }
+      }
+
+      // Only the records of a span start at a known offset, which is the
+      // record's opening brace
+      for (const ParseErrors *errors : {&spanErrors, &parallelErrors}) {
+        for (size_t i = 0; i < corrupted.size(); i++) {
+          const size_t offset = errors->getErrors()[i].offset;
+          REQUIRE( offset < malformed.size() );
+          REQUIRE( nlohmann::json::parse(malformed.substr(offset, malformed.find('}', offset) - offset + 1)) ==
+                   document["value"][corrupted[i]] );
+        }
+      }
+
+      for (const auto &error : streamErrors.getErrors()) {
+        REQUIRE( error.offset == ParseErrors::UNKNOWN_OFFSET );
+      }
+
+    } // THEN
+
+    THEN( "more records than the budget allows can't be skipped" ) {
+
+      ParseErrors errors(2);
+      Areas areas = Areas();
+      REQUIRE_THROWS_AS( areas.populate(InputSpan{malformed.data(), malformed.size()}, dataset.PARSER, dataset.COLS,
+                                        nullptr, nullptr, nullptr, &errors),
+                         std::runtime_error );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,196 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../lib_json.hpp"
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../bethyw.h"
+#include "../snapshot.h"
+
+namespace {
+  // Every measure that is saved has readings, so the measures left without
+  // any are those the years filter excluded, which aren't loaded
+  std::string withoutEmptyMeasures(const std::string& areasJSON) {
+    nlohmann::json areas = nlohmann::json::parse(areasJSON);
+
+    for (auto& area : areas) {
+      if (area.count("measures") == 0) {
+        continue;
+      }
+
+      auto& measures = area["measures"];
+      for (auto measure = measures.begin(); measure != measures.end();) {
+        measure = measure->empty() ? measures.erase(measure) : std::next(measure);
+      }
+
+      if (measures.empty()) {
+        area.erase("measures");
+      }
+    }
+
+    return areas.dump();
+  }
+} // end of anonymous namespace
+
+SCENARIO( "the areas imported from every dataset can be saved to and loaded from a snapshot", "[Snapshot]" ) {
+
+  const std::string path = "bin/test30.snapshot";
+
+  std::vector<BethYw::InputFileSource> datasets(BethYw::InputFiles::DATASETS,
+                                                BethYw::InputFiles::DATASETS + BethYw::InputFiles::NUM_DATASETS);
+
+  Areas imported = Areas();
+  BethYw::loadAreas(imported, "datasets/", StringFilterSet());
+  BethYw::loadDatasets(imported, "datasets/", datasets, StringFilterSet(), StringFilterSet(), YearFilterTuple(0, 0));
+
+  Snapshot::save(path, imported);
+
+  GIVEN( "a snapshot of every area, measure and reading" ) {
+
+    Snapshot snapshot(path);
+
+    THEN( "loading it without filters gives the areas that were saved" ) {
+
+      REQUIRE( snapshot.size() == imported.size() );
+
+      Areas loaded = Areas();
+      loaded.populateFromSnapshot(snapshot);
+      REQUIRE( loaded.toJSON() == imported.toJSON() );
+
+    } // THEN
+
+    THEN( "loading it with filters gives the same areas as applying them to the areas that were saved" ) {
+
+      const std::vector<StringFilterSet> areasFilters = {StringFilterSet(), {"W06000011"}, {"swan", "CARDIFF"},
+                                                         {"nowhere"}};
+      const std::vector<StringFilterSet> measuresFilters = {StringFilterSet(), {"pop"}, {"DENS", "area"}};
+      const std::vector<YearFilterTuple> yearsFilters = {YearFilterTuple(0, 0), YearFilterTuple(2010, 2015),
+                                                         YearFilterTuple(2015, 2010), YearFilterTuple(1900, 1950),
+                                                         YearFilterTuple(1991, 1991)};
+
+      for (const auto& areasFilter : areasFilters) {
+        for (const auto& measuresFilter : measuresFilters) {
+          for (const auto& yearsFilter : yearsFilters) {
+            Areas expected = Areas();
+            expected.populateFromParsed(imported, BethYw::AuthorityCodeCSV,
+                                        &areasFilter, &measuresFilter, &yearsFilter);
+
+            Areas loaded = Areas();
+            loaded.populateFromSnapshot(snapshot, &areasFilter, &measuresFilter, &yearsFilter);
+
+            REQUIRE( loaded.toJSON() == ::withoutEmptyMeasures(expected.toJSON()) );
+          }
+        }
+      }
+
+    } // THEN
+
+    THEN( "loading it with a years filter that excludes every reading gives the areas without measures" ) {
+
+      const StringFilterSet areasFilter = {"W06000011"};
+      const YearFilterTuple yearsFilter(1900, 1901);
+
+      Areas loaded = Areas();
+      loaded.populateFromSnapshot(snapshot, &areasFilter, nullptr, &yearsFilter);
+
+      REQUIRE( loaded.size() == 1 );
+      REQUIRE( loaded.getArea("W06000011").size() == 0 );
+
+      Areas parsed = Areas();
+      std::vector<BethYw::InputFileSource> popden = {BethYw::InputFiles::POPDEN};
+      BethYw::loadAreas(parsed, "datasets/", areasFilter);
+      BethYw::loadDatasets(parsed, "datasets/", popden, areasFilter, StringFilterSet(), yearsFilter);
+      REQUIRE( parsed.getArea("W06000011").size() == 0 );
+
+    } // THEN
+
+    THEN( "each series has the statistics of its readings" ) {
+
+      for (size_t areaIdx = 0; areaIdx < snapshot.size(); areaIdx++) {
+        const Snapshot::AreaEntry area = snapshot.getArea(areaIdx);
+
+        for (uint32_t i = area.firstSeries; i < area.firstSeries + area.seriesCount; i++) {
+          const Snapshot::SeriesEntry series = snapshot.getSeries(i);
+          REQUIRE( series.readingCount > 0 );
+
+          for (uint32_t reading = series.firstReading; reading < series.firstReading + series.readingCount; reading++) {
+            REQUIRE( snapshot.getYear(reading) >= series.minYear );
+            REQUIRE( snapshot.getYear(reading) <= series.maxYear );
+            REQUIRE( snapshot.getValue(reading) >= series.minValue );
+            REQUIRE( snapshot.getValue(reading) <= series.maxValue );
+          }
+        }
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a snapshot that has been changed or cut short" ) {
+
+    std::string contents;
+    {
+      std::ifstream file(path, std::ifstream::in | std::ifstream::binary);
+      contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    auto write = [&path](const std::string& text) {
+      std::ofstream file(path, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+      file << text;
+    };
+
+    THEN( "a std::runtime_error exception is thrown when it is opened" ) {
+
+      std::string changed = contents;
+      changed[changed.size() / 2] ^= 1;
+      write(changed);
+      REQUIRE_THROWS_WITH( Snapshot(path), "Snapshot: " + path + " is corrupt" );
+
+      write(contents.substr(0, contents.size() - 1));
+      REQUIRE_THROWS_AS( Snapshot(path), std::runtime_error );
+
+      write("Local authority code,Name (eng),Name (cym)\n");
+      REQUIRE_THROWS_WITH( Snapshot(path), "Snapshot: " + path + " is not a snapshot file" );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a snapshot of no areas" ) {
+
+    Snapshot::save(path, Areas());
+
+    THEN( "it can be loaded" ) {
+
+      Snapshot snapshot(path);
+      REQUIRE( snapshot.size() == 0 );
+
+      Areas loaded = Areas();
+      loaded.populateFromSnapshot(snapshot);
+      REQUIRE( loaded.size() == 0 );
+
+    } // THEN
+
+  } // GIVEN
+
+  std::remove(path.c_str());
+
+} // SCENARIO
@@ -0,0 +1,249 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../lib_json.hpp"
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../bethyw.h"
+#include "../input.h"
+#include "../schema.h"
+
+namespace {
+  std::string readFile(const std::string& filePath) {
+    std::ifstream file(filePath, std::ifstream::in | std::ifstream::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+
+  DatasetSchema detectFile(const std::string& contents, const std::string& measureCode) {
+    return DatasetSchema::detect({contents.data(), std::min(contents.size(), DatasetSchema::SAMPLE_BYTES)},
+                                 measureCode);
+  }
+} // end of anonymous namespace
+
+SCENARIO( "the schema of a dataset file can be detected from its first records", "[DatasetSchema]" ) {
+
+  using SC = BethYw::SourceColumn;
+
+  GIVEN( "the built-in dataset files" ) {
+
+    THEN( "the data type and the columns of the areas, years and values are detected" ) {
+
+      for (const auto& dataset : BethYw::InputFiles::DATASETS) {
+        const DatasetSchema schema = ::detectFile(::readFile("datasets/" + dataset.FILE), dataset.CODE);
+
+        REQUIRE( schema.parser == dataset.PARSER );
+        REQUIRE( schema.cols.at(SC::AUTH_CODE) == dataset.COLS.at(SC::AUTH_CODE) );
+
+        if (dataset.PARSER == BethYw::WelshStatsJSON) {
+          REQUIRE( schema.cols.at(SC::AUTH_NAME_ENG) == dataset.COLS.at(SC::AUTH_NAME_ENG) );
+          REQUIRE( schema.cols.at(SC::YEAR) == dataset.COLS.at(SC::YEAR) );
+          REQUIRE( schema.cols.at(SC::VALUE) == dataset.COLS.at(SC::VALUE) );
+          REQUIRE( schema.cols.count(SC::MEASURE_CODE) == dataset.COLS.count(SC::MEASURE_CODE) );
+        } else {
+          REQUIRE( schema.cols.at(SC::SINGLE_MEASURE_CODE) == dataset.CODE );
+        }
+      }
+
+      const auto& areas = BethYw::InputFiles::AREAS;
+      const DatasetSchema schema = ::detectFile(::readFile("datasets/" + areas.FILE), areas.CODE);
+      REQUIRE( schema.parser == areas.PARSER );
+      REQUIRE( schema.cols == areas.COLS );
+
+    } // THEN
+
+    THEN( "popu1009.json is detected as it is described in datasets.h" ) {
+
+      const auto& dataset = BethYw::InputFiles::POPDEN;
+      const DatasetSchema schema = ::detectFile(::readFile("datasets/" + dataset.FILE), dataset.CODE);
+      REQUIRE( schema.cols == dataset.COLS );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a StatsWales JSON file whose dimensions are named differently" ) {
+
+    nlohmann::json document = nlohmann::json::parse(::readFile("datasets/popu1009.json"));
+    for (auto& record : document["value"]) {
+      nlohmann::json renamed;
+      for (const auto& member : record.items()) {
+        std::string key = member.key();
+        if (key.compare(0, 15, "Localauthority_") == 0) {
+          key = "Area_" + key.substr(15);
+        } else if (key.compare(0, 8, "Measure_") == 0) {
+          key = "Variable_" + key.substr(8);
+        }
+        renamed[key] = member.value();
+      }
+      record = renamed;
+    }
+
+    const std::string contents = document.dump();
+
+    THEN( "its columns are found by their shape, not their names" ) {
+
+      const DatasetSchema schema = ::detectFile(contents, "popden");
+      REQUIRE( schema.parser == BethYw::WelshStatsJSON );
+      REQUIRE( schema.cols.at(SC::AUTH_CODE) == "Area_Code" );
+      REQUIRE( schema.cols.at(SC::AUTH_NAME_ENG) == "Area_ItemName_ENG" );
+      REQUIRE( schema.cols.at(SC::MEASURE_CODE) == "Variable_Code" );
+      REQUIRE( schema.cols.at(SC::MEASURE_NAME) == "Variable_ItemName_ENG" );
+      REQUIRE( schema.cols.at(SC::YEAR) == "Year_Code" );
+
+      Areas detected = Areas();
+      detected.populate(InputSpan{contents.data(), contents.size()}, schema.parser, schema.cols);
+
+      Areas expected = Areas();
+      const std::string original = ::readFile("datasets/popu1009.json");
+      expected.populate(InputSpan{original.data(), original.size()}, BethYw::WelshStatsJSON,
+                        BethYw::InputFiles::POPDEN.COLS);
+
+      REQUIRE( detected.toJSON() == expected.toJSON() );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "CSV files with blank lines" ) {
+
+    THEN( "the blank lines are skipped" ) {
+
+      const auto& areas = BethYw::InputFiles::AREAS;
+      const DatasetSchema names = ::detectFile("\r\nLocal authority code,Name (eng),Name (cym)\n\n"
+                                               "W06000001,Isle of Anglesey,Ynys M\xC3\xB4n\n\r\n"
+                                               "W06000002,Gwynedd,Gwynedd\n\n", areas.CODE);
+      REQUIRE( names.parser == areas.PARSER );
+      REQUIRE( names.cols == areas.COLS );
+
+      const DatasetSchema years = ::detectFile("AuthorityCode,2015,2016\n\nW06000001,1,2\n", "test");
+      REQUIRE( years.parser == BethYw::SourceDataType::AuthorityByYearCSV );
+      REQUIRE( years.cols.at(SC::AUTH_CODE) == "AuthorityCode" );
+
+      REQUIRE_THROWS_AS( ::detectFile("\n\r\n\n", "test"), std::runtime_error );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "files that aren't datasets" ) {
+
+    THEN( "a std::runtime_error exception is thrown" ) {
+
+      const std::vector<std::string> files = {
+        "Name,Population,Area\nSwansea,246993,380\n",
+        "{\"odata.metadata\": \"\", \"value\": []}",
+        "{\"value\": [{\"Data\": 1, \"Area_Code\": \"W06000011\"}]}",
+        ""
+      };
+
+      for (const std::string& contents : files) {
+        REQUIRE_THROWS_AS( ::detectFile(contents, "test"), std::runtime_error );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "a detected schema is kept in a sidecar next to its dataset file", "[DatasetSchema][BethYw]" ) {
+
+  using SC = BethYw::SourceColumn;
+
+  const std::string dir = "bin/";
+  const std::string file = "detected1009.json";
+  const std::string sidecarPath = dir + file + ".schema";
+  std::remove(sidecarPath.c_str());
+
+  {
+    std::ofstream copy(dir + file, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
+    copy << ::readFile("datasets/popu1009.json");
+  }
+
+  GIVEN( "a dataset file that isn't built in" ) {
+
+    THEN( "its schema is detected, saved, and imports the same areas as the built-in dataset" ) {
+
+      const BethYw::InputFileSource detected = BethYw::detectDataset(dir, file);
+      REQUIRE( detected.CODE == "detected1009" );
+      REQUIRE( detected.FILE == file );
+      REQUIRE( detected.COLS == BethYw::InputFiles::POPDEN.COLS );
+
+      DatasetSchema saved;
+      REQUIRE( DatasetSchema::load(sidecarPath, saved) );
+      REQUIRE( saved.parser == detected.PARSER );
+      REQUIRE( saved.cols == detected.COLS );
+
+      std::vector<BethYw::InputFileSource> detectedDatasets = {detected};
+      Areas fromDetected = Areas();
+      BethYw::loadDatasets(fromDetected, dir, detectedDatasets, StringFilterSet(), StringFilterSet(),
+                           YearFilterTuple(0, 0));
+
+      std::vector<BethYw::InputFileSource> builtInDatasets = {BethYw::InputFiles::POPDEN};
+      Areas fromBuiltIn = Areas();
+      BethYw::loadDatasets(fromBuiltIn, "datasets/", builtInDatasets, StringFilterSet(), StringFilterSet(),
+                           YearFilterTuple(0, 0));
+
+      REQUIRE( fromDetected.toJSON() == fromBuiltIn.toJSON() );
+
+    } // THEN
+
+    THEN( "an edited sidecar is used instead of detecting the schema again" ) {
+
+      DatasetSchema edited(BethYw::WelshStatsJSON, BethYw::InputFiles::POPDEN.COLS);
+      edited.cols.erase(SC::MEASURE_CODE);
+      edited.cols.erase(SC::MEASURE_NAME);
+      edited.cols[SC::SINGLE_MEASURE_CODE] = "popden";
+      edited.cols[SC::SINGLE_MEASURE_NAME] = "Population density";
+      edited.save(sidecarPath);
+
+      REQUIRE( BethYw::detectDataset(dir, file).COLS == edited.cols );
+
+    } // THEN
+
+    THEN( "an invalid sidecar is reported" ) {
+
+      const std::vector<std::string> sidecars = {
+        "{\"parser\": \"xml\", \"columns\": {}}",
+        "{\"parser\": \"welsh-stats-json\", \"columns\": {\"auth_code\": \"Area_Code\"}}",
+        "{\"parser\": \"authority-code-csv\", \"columns\": {\"area\": \"Area_Code\"}}",
+        "not json"
+      };
+
+      for (const std::string& sidecar : sidecars) {
+        {
+          std::ofstream file(sidecarPath, std::ofstream::out | std::ofstream::trunc);
+          file << sidecar;
+        }
+
+        DatasetSchema schema;
+        REQUIRE_THROWS_AS( DatasetSchema::load(sidecarPath, schema), std::runtime_error );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+  std::remove(sidecarPath.c_str());
+  std::remove((dir + file).c_str());
+
+} // SCENARIO
@@ -0,0 +1,267 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../lib_json.hpp"
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../input.h"
+#include "../schema.h"
+
+namespace {
+  std::string readDocument(const std::string& filePath) {
+    std::ifstream file(filePath, std::ifstream::in | std::ifstream::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+
+  // The records of the value array of a StatsWales JSON file, one to a line
+  std::vector<std::string> toLines(const std::string& document) {
+    const nlohmann::json parsed = nlohmann::json::parse(document);
+    std::vector<std::string> lines;
+    for (const auto& record : parsed.at("value")) {
+      lines.push_back(record.dump());
+    }
+    return lines;
+  }
+
+  std::string joinLines(const std::vector<std::string>& lines, const std::string& lineEnding) {
+    std::string joined;
+    for (const std::string& line : lines) {
+      joined += line + lineEnding;
+    }
+    return joined;
+  }
+} // end of anonymous namespace
+
+SCENARIO( "a newline-delimited StatsWales JSON file can be imported", "[Areas][NDJSON]" ) {
+
+  const auto& dataset = BethYw::InputFiles::POPDEN;
+  const std::string document = ::readDocument("datasets/" + dataset.FILE);
+  const std::vector<std::string> lines = ::toLines(document);
+
+  Areas expected = Areas();
+  expected.populate(InputSpan{document.data(), document.size()}, BethYw::WelshStatsJSON, dataset.COLS);
+
+  GIVEN( "the records of popu1009.json, one to a line" ) {
+
+    const std::string ndjson = ::joinLines(lines, "\n");
+    const InputSpan span{ndjson.data(), ndjson.size()};
+
+    THEN( "the same areas are imported as from popu1009.json, from a span or a stream" ) {
+
+      Areas fromSpan = Areas();
+      fromSpan.populate(span, BethYw::WelshStatsNDJSON, dataset.COLS);
+      REQUIRE( fromSpan.toJSON() == expected.toJSON() );
+
+      std::istringstream is(ndjson);
+      Areas fromStream = Areas();
+      fromStream.populate(is, BethYw::WelshStatsNDJSON, dataset.COLS);
+      REQUIRE( fromStream.toJSON() == expected.toJSON() );
+
+    } // THEN
+
+    THEN( "the same areas are imported when the lines are split between threads" ) {
+
+      for (unsigned int threads : {1u, 2u, 3u, 8u, 1000u}) {
+        Areas parallel = Areas();
+        parallel.populateFromWelshStatsNDJSONInParallel(span, dataset.COLS, threads, nullptr, nullptr, nullptr);
+        REQUIRE( parallel.toJSON() == expected.toJSON() );
+      }
+
+    } // THEN
+
+    THEN( "the same areas are imported with filters as from popu1009.json" ) {
+
+      const StringFilterSet areasFilter = {"W06000011", "cardiff"};
+      const StringFilterSet measuresFilter = {"dens"};
+      const YearFilterTuple yearsFilter(2010, 2015);
+
+      Areas filteredExpected = Areas();
+      filteredExpected.populate(InputSpan{document.data(), document.size()}, BethYw::WelshStatsJSON, dataset.COLS,
+                                &areasFilter, &measuresFilter, &yearsFilter);
+
+      Areas filtered = Areas();
+      filtered.populate(span, BethYw::WelshStatsNDJSON, dataset.COLS, &areasFilter, &measuresFilter, &yearsFilter);
+      REQUIRE( filtered.toJSON() == filteredExpected.toJSON() );
+
+      Areas parallel = Areas();
+      parallel.populateFromWelshStatsNDJSONInParallel(span, dataset.COLS, 4, &areasFilter, &measuresFilter,
+                                                      &yearsFilter);
+      REQUIRE( parallel.toJSON() == filteredExpected.toJSON() );
+
+    } // THEN
+
+    THEN( "only what has been appended is parsed incrementally" ) {
+
+      const std::string start = ::joinLines(std::vector<std::string>(lines.begin(), lines.begin() + 100), "\n");
+      const std::string partial = start + lines[100].substr(0, 20);
+
+      Areas incremental = Areas();
+      size_t watermark = incremental.populateIncrementally(InputSpan{start.data(), start.size()},
+                                                           BethYw::WelshStatsNDJSON, dataset.COLS);
+      REQUIRE( watermark == start.size() );
+
+      ParseErrors errors(1);
+      watermark = incremental.populateIncrementally(InputSpan{partial.data(), partial.size()},
+                                                    BethYw::WelshStatsNDJSON, dataset.COLS, watermark, &errors);
+      REQUIRE( watermark == start.size() );
+      REQUIRE( errors.size() == 1 );
+
+      watermark = incremental.populateIncrementally(span, BethYw::WelshStatsNDJSON, dataset.COLS, watermark);
+      REQUIRE( watermark == ndjson.size() );
+      REQUIRE( incremental.toJSON() == expected.toJSON() );
+
+      REQUIRE_THROWS_AS( incremental.populateIncrementally(span, BethYw::WelshStatsNDJSON, dataset.COLS, 10),
+                         std::runtime_error );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "the records of popu1009.json with Windows line endings, blank lines and no final line ending" ) {
+
+    std::string ndjson = "\r\n" + ::joinLines(lines, "\r\n\r\n");
+    ndjson.resize(ndjson.size() - 4);
+
+    THEN( "the same areas are imported" ) {
+
+      Areas fromSpan = Areas();
+      fromSpan.populate(InputSpan{ndjson.data(), ndjson.size()}, BethYw::WelshStatsNDJSON, dataset.COLS);
+      REQUIRE( fromSpan.toJSON() == expected.toJSON() );
+
+      std::istringstream is(ndjson);
+      Areas fromStream = Areas();
+      fromStream.populate(is, BethYw::WelshStatsNDJSON, dataset.COLS);
+      REQUIRE( fromStream.toJSON() == expected.toJSON() );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "the records of popu1009.json with malformed lines" ) {
+
+    std::vector<std::string> malformed = lines;
+    malformed[2] = malformed[2].substr(0, malformed[2].size() / 2);
+    malformed[499] = "[]";
+    malformed.back() = "{\"Data\": \"not a number\"" + malformed.back().substr(malformed.back().find(','));
+
+    const std::string ndjson = ::joinLines(malformed, "\n");
+    const InputSpan span{ndjson.data(), ndjson.size()};
+
+    THEN( "a std::runtime_error exception is thrown with the line of the first" ) {
+
+      Areas areas = Areas();
+      REQUIRE_THROWS_AS( areas.populate(span, BethYw::WelshStatsNDJSON, dataset.COLS), std::runtime_error );
+
+      try {
+        areas.populate(span, BethYw::WelshStatsNDJSON, dataset.COLS);
+      } catch (const std::runtime_error& ex) {
+        REQUIRE( std::string(ex.what()).find("line 3: ") != std::string::npos );
+      }
+
+    } // THEN
+
+    THEN( "the line is numbered from the start of the file when the lines are split between threads" ) {
+
+      std::vector<std::string> lastMalformed = lines;
+      lastMalformed.back() = malformed.back();
+      const std::string lastNDJSON = ::joinLines(lastMalformed, "\n");
+
+      for (unsigned int threads : {1u, 4u}) {
+        Areas areas = Areas();
+        REQUIRE_THROWS_WITH( areas.populateFromWelshStatsNDJSONInParallel(
+                                     InputSpan{lastNDJSON.data(), lastNDJSON.size()}, dataset.COLS, threads,
+                                     nullptr, nullptr, nullptr),
+                             Catch::Contains("line " + std::to_string(lines.size()) + ": ") );
+      }
+
+    } // THEN
+
+    THEN( "they are skipped and reported by line, within the budget, however they are read" ) {
+
+      std::vector<std::string> expectedLines = lines;
+      expectedLines.erase(expectedLines.end() - 1);
+      expectedLines.erase(expectedLines.begin() + 499);
+      expectedLines.erase(expectedLines.begin() + 2);
+      const std::string remaining = ::joinLines(expectedLines, "\n");
+
+      Areas skippedExpected = Areas();
+      skippedExpected.populate(InputSpan{remaining.data(), remaining.size()}, BethYw::WelshStatsNDJSON,
+                               dataset.COLS);
+
+      const std::vector<size_t> expectedPositions = {3, 500, malformed.size()};
+
+      for (unsigned int threads : {0u, 1u, 4u}) {
+        ParseErrors errors(3);
+        Areas areas = Areas();
+
+        if (threads == 0) {
+          std::istringstream is(ndjson);
+          areas.populate(is, BethYw::WelshStatsNDJSON, dataset.COLS, nullptr, nullptr, nullptr, &errors);
+        } else {
+          areas.populateFromWelshStatsNDJSONInParallel(span, dataset.COLS, threads, nullptr, nullptr, nullptr,
+                                                       &errors);
+        }
+
+        REQUIRE( areas.toJSON() == skippedExpected.toJSON() );
+        REQUIRE( errors.size() == expectedPositions.size() );
+        for (size_t i = 0; i < expectedPositions.size(); i++) {
+          REQUIRE( errors.getErrors()[i].unit == "line" );
+          REQUIRE( errors.getErrors()[i].position == expectedPositions[i] );
+
+          // The offset of the start of the line, from the start of the file
+          size_t lineOffset = 0;
+          for (size_t line = 1; line < expectedPositions[i]; line++) {
+            lineOffset = ndjson.find('\n', lineOffset) + 1;
+          }
+          REQUIRE( errors.getErrors()[i].offset == lineOffset );
+        }
+      }
+
+      ParseErrors tooFew(2);
+      Areas areas = Areas();
+      REQUIRE_THROWS_AS( areas.populate(span, BethYw::WelshStatsNDJSON, dataset.COLS, nullptr, nullptr, nullptr,
+                                        &tooFew),
+                         std::runtime_error );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a newline-delimited StatsWales JSON file that isn't built in" ) {
+
+    const std::string ndjson = ::joinLines(lines, "\n");
+
+    THEN( "its schema is detected as newline-delimited, with the columns of popu1009.json" ) {
+
+      const DatasetSchema schema = DatasetSchema::detect(
+              {ndjson.data(), std::min(ndjson.size(), DatasetSchema::SAMPLE_BYTES)}, dataset.CODE);
+      REQUIRE( schema.parser == BethYw::WelshStatsNDJSON );
+      REQUIRE( schema.cols == dataset.COLS );
+
+      REQUIRE( DatasetSchema::parserFromName("welsh-stats-ndjson") == BethYw::WelshStatsNDJSON );
+      REQUIRE( DatasetSchema::parserName(BethYw::WelshStatsNDJSON) == "welsh-stats-ndjson" );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,135 @@
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 955058
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "../datasets.h"
+#include "../areas.h"
+#include "../input.h"
+
+SCENARIO( "a StatsWales JSON document can be streamed through the SAX parser", "[Areas][WelshStatsJSON][SAX]" ) {
+
+  const BethYw::InputFileSource &dataset = BethYw::InputFiles::POPDEN;
+
+  auto row = [](const std::string &code, const std::string &year, const std::string &value,
+                const std::string &extra) {
+    return "{\"Localauthority_Code\":\"" + code + "\",\"Localauthority_ItemName_ENG\":\"Name of " + code + "\","
+           "\"Measure_Code\":\"Pop\",\"Measure_ItemName_ENG\":\"Population\"" + extra + ","
+           "\"Year_Code\":\"" + year + "\",\"Data\":" + value + "}";
+  };
+
+  const std::string plain = "{\"value\":[" + row("W06000001", "2001", "1", "") + "," +
+                            row("W06000002", "2002", "2.5", "") + "]}";
+
+  auto fromStream = [&dataset](const std::string &document) {
+    std::istringstream is(document);
+    Areas areas = Areas();
+    areas.populate(is, dataset.PARSER, dataset.COLS);
+    return areas;
+  };
+
+  auto fromSpan = [&dataset](const std::string &document) {
+    Areas areas = Areas();
+    areas.populate(InputSpan{document.data(), document.size()}, dataset.PARSER, dataset.COLS);
+    return areas;
+  };
+
+  const std::string expected = fromStream(plain).toJSON();
+
+  GIVEN( "a document with members and nested values that aren't imported" ) {
+
+    // Neither the value array nested in another member, nor the objects and
+    // arrays in the records' other keys, are records
+    const std::string document =
+            "{\"odata.metadata\":\"http://open.statswales.gov.wales/$metadata\","
+            "\"meta\":{\"value\":[" + row("W06000099", "1999", "9", "") + "],\"count\":[1,{\"a\":null}]},"
+            "\"value\":[" + row("W06000001", "2001", "1", ",\"Notes\":{\"a\":[1,{\"b\":[true,false]}],\"c\":{}}") +
+            "," + row("W06000002", "2002", "2.5", ",\"Tags\":[[],[{\"d\":\"e\"}],\"f\"]") + "],"
+            "\"odata.nextLink\":null}";
+
+    THEN( "they are skipped, and only the records of the value array are imported" ) {
+
+      REQUIRE( fromStream(document).toJSON() == expected );
+      REQUIRE( fromSpan(document).toJSON() == expected );
+
+      REQUIRE_THROWS_AS( fromStream(document).getArea("W06000099"), std::out_of_range );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a document followed by whitespace" ) {
+
+    const std::string document = plain + "\n \r\n\t";
+
+    THEN( "it is imported" ) {
+
+      REQUIRE( fromStream(document).toJSON() == expected );
+      REQUIRE( fromSpan(document).toJSON() == expected );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a document followed by anything else" ) {
+
+    THEN( "a std::runtime_error exception is thrown" ) {
+
+      for (const char *trailing : {"x", "\n{}", "]", "  null"}) {
+        const std::string document = plain + trailing;
+
+        REQUIRE_THROWS_AS( fromStream(document), std::runtime_error );
+        REQUIRE_THROWS_WITH( fromStream(document), Catch::StartsWith("Failure parsing JSON file: ") );
+        REQUIRE_THROWS_AS( fromSpan(document), std::runtime_error );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a truncated document" ) {
+
+    THEN( "a std::runtime_error exception is thrown wherever it ends" ) {
+
+      for (size_t size : {size_t(1), size_t(10), plain.find("[") + 1, plain.size() / 2, plain.size() - 2,
+                          plain.size() - 1}) {
+        const std::string document = plain.substr(0, size);
+
+        REQUIRE_THROWS_AS( fromStream(document), std::runtime_error );
+        REQUIRE_THROWS_WITH( fromStream(document), Catch::StartsWith("Failure parsing JSON file: ") &&
+                                                   Catch::Contains("[json.exception.parse_error.101]") );
+        REQUIRE_THROWS_AS( fromSpan(document), std::runtime_error );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a document with a number too large for a double" ) {
+
+    const std::string document = "{\"value\":[" + row("W06000001", "2001", "1e400", "") + "]}";
+
+    THEN( "a std::runtime_error exception is thrown, with nlohmann::json's error" ) {
+
+      REQUIRE_THROWS_AS( fromStream(document), std::runtime_error );
+      REQUIRE_THROWS_WITH( fromStream(document), Catch::StartsWith("Failure parsing JSON file: ") &&
+                                                 Catch::Contains("[json.exception.out_of_range.406]") );
+      REQUIRE_THROWS_AS( fromSpan(document), std::runtime_error );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO